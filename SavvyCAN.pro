@@ -8,7 +8,7 @@
     error("Current version of Qt ($${QT_VERSION}) is too old, this project requires Qt 5.14 or newer")
 }
 
-QT = core gui printsupport qml serialbus serialport widgets help network opengl
+QT = core gui printsupport qml serialbus serialport widgets help network opengl concurrent
 
 CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
 
@@ -47,8 +47,11 @@ SOURCES += main.cpp\
     re/dbccomparatorwindow.cpp \
     mainwindow.cpp \
     canframemodel.cpp \
+    canframestore.cpp \
     simplecrypt.cpp \
     triggerdialog.cpp \
+    mergefilesdialog.cpp \
+    signalexportdialog.cpp \
     utility.cpp \
     qcustomplot.cpp \
     frameplaybackwindow.cpp \
@@ -105,12 +108,22 @@ SOURCES += main.cpp\
     connections/newconnectiondialog.cpp \
     re/temporalgraphwindow.cpp \
     filterutility.cpp \
-    pcaplite.cpp
+    pcaplite.cpp \
+    nativebinaryfile.cpp \
+    utils/chunkedtextloader.cpp \
+    utils/filesniff.cpp \
+    utils/frameexporter.cpp \
+    utils/capturepager.cpp \
+    utils/capturemerger.cpp \
+    utils/parquetwriter.cpp \
+    utils/signalexporter.cpp \
+    continuouslogwriter.cpp
 
 HEADERS  += mainwindow.h \
     can_structs.h \
     canbridgewindow.h \
     canframemodel.h \
+    canframestore.h \
     connections/canlogserver.h \
     connections/canserver.h \
     connections/lawicel_serial.h \
@@ -142,6 +155,8 @@ HEADERS  += mainwindow.h \
     re/dbccomparatorwindow.h \
     simplecrypt.h \
     triggerdialog.h \
+    mergefilesdialog.h \
+    signalexportdialog.h \
     utility.h \
     qcustomplot.h \
     frameplaybackwindow.h \
@@ -156,6 +171,14 @@ HEADERS  += mainwindow.h \
     scriptcontainer.h \
     canfilter.h \
     utils/lfqueue.h \
+    utils/parallelsort.h \
+    utils/chunkedtextloader.h \
+    utils/filesniff.h \
+    utils/frameexporter.h \
+    utils/capturepager.h \
+    utils/capturemerger.h \
+    utils/parquetwriter.h \
+    utils/signalexporter.h \
     motorcontrollerconfigwindow.h \
     connections/canconnection.h \
     connections/serialbusconnection.h \
@@ -200,7 +223,9 @@ HEADERS  += mainwindow.h \
     connections/newconnectiondialog.h \
     re/temporalgraphwindow.h \
     filterutility.h \
-    pcaplite.h
+    pcaplite.h \
+    nativebinaryfile.h \
+    continuouslogwriter.h
 
 FORMS    += ui/candatagrid.ui \
     triggerdialog.ui \
@@ -236,7 +261,9 @@ FORMS    += ui/candatagrid.ui \
     ui/signalviewerwindow.ui \
     ui/helpwindow.ui \
     ui/newconnectiondialog.ui \
-    ui/temporalgraphwindow.ui
+    ui/temporalgraphwindow.ui \
+    ui/mergefilesdialog.ui \
+    ui/signalexportdialog.ui
     
 RESOURCES += \
     icons.qrc \
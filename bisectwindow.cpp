@@ -8,7 +8,7 @@
 #include <QDebug>
 #include <algorithm>
 
-BisectWindow::BisectWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+BisectWindow::BisectWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::BisectWindow)
 {
@@ -101,7 +101,7 @@ void BisectWindow::refreshIDList()
     ui->cbIDUpper->clear();
     for (int i = 0; i < modelFrames->count(); i++)
     {
-        id = modelFrames->at(i).frameId();
+        id = modelFrames->frameIdAt(i);
         if (!foundID.contains(id))
         {
             foundID.append(id);
@@ -152,11 +152,11 @@ void BisectWindow::handleCalculateButton()
         qDebug() << "Target frame num " << targetFrameNum;
         if (saveLower)
         {
-            for (int i = 0; i < targetFrameNum; i++) splitFrames.append(modelFrames->at(i));
+            for (int i = 0; i < targetFrameNum; i++) splitFrames.append(*modelFrames, i);
         }
         else
         {
-            for (int i = targetFrameNum; i < modelFrames->count(); i++) splitFrames.append(modelFrames->at(i));
+            for (int i = targetFrameNum; i < modelFrames->count(); i++) splitFrames.append(*modelFrames, i);
         }
     }
     else if (ui->rbIDRange->isChecked())
@@ -165,13 +165,14 @@ void BisectWindow::handleCalculateButton()
         uint32_t upperID = Utility::ParseStringToNum2(ui->cbIDUpper->currentText());
         for (int i = 0; i < modelFrames->count(); i++)
         {
-            if (modelFrames->at(i).frameId() >= lowerID && modelFrames->at(i).frameId() <= upperID)
+            uint32_t id = modelFrames->frameIdAt(i);
+            if (id >= lowerID && id <= upperID)
             {
-                if (saveLower) splitFrames.append(modelFrames->at(i));
+                if (saveLower) splitFrames.append(*modelFrames, i);
             }
             else
             {
-                if (!saveLower) splitFrames.append(modelFrames->at(i));
+                if (!saveLower) splitFrames.append(*modelFrames, i);
             }
         }
     }
@@ -180,13 +181,13 @@ void BisectWindow::handleCalculateButton()
         int targetBus = Utility::ParseStringToNum(ui->editBusNum->text());
         for (int i = 0; i < modelFrames->count(); i++)
         {
-            if (modelFrames->at(i).bus == targetBus)
+            if (modelFrames->busAt(i) == targetBus)
             {
-                if (saveLower) splitFrames.append(modelFrames->at(i));
+                if (saveLower) splitFrames.append(*modelFrames, i);
             }
             else
             {
-                if (!saveLower) splitFrames.append(modelFrames->at(i));
+                if (!saveLower) splitFrames.append(*modelFrames, i);
             }
         }
     }
@@ -198,7 +199,7 @@ void BisectWindow::handleReplaceButton()
     CANFrameModel *model;
     model = MainWindow::getReference()->getCANFrameModel();
     model->clearFrames();
-    model->insertFrames(splitFrames);
+    model->insertFrames(splitFrames.toVector());
     refreshFrameNumbers();
     refreshIDList();
 }
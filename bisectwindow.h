@@ -3,6 +3,7 @@
 
 #include <QDialog>
 #include "can_structs.h"
+#include "canframestore.h"
 
 namespace Ui {
 class BisectWindow;
@@ -13,7 +14,7 @@ class BisectWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit BisectWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit BisectWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~BisectWindow();
     void showEvent(QShowEvent*);
 
@@ -34,8 +35,8 @@ private slots:
 
 private:
     Ui::BisectWindow *ui;
-    const QVector<CANFrame> *modelFrames;
-    QVector<CANFrame> splitFrames;
+    const CANFrameStore *modelFrames;
+    CANFrameStore splitFrames; //copied over packed, only unpacked if it replaces the main list
     QList<int> foundID;
 
     void refreshIDList();
@@ -3,12 +3,17 @@
 #include <QFile>
 #include <QString>
 #include <QtEndian>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cstddef>
 
 #define BLF_REMOTE_FLAG 0x80
 
+int BLFHandler::containersPerWindow = 0;
+
 BLFHandler::BLFHandler()
 {
-
+    pendingSkip = 0;
 }
 
 /*
@@ -21,150 +26,280 @@ two source repos.
 */
 bool BLFHandler::loadBLF(QString filename, QVector<CANFrame>* frames)
 {
-    BLF_OBJ_HEADER objHeader;
-    QByteArray fileData;
-    QByteArray uncompressedData;
-    QByteArray junk;
-    BLF_OBJECT obj;
-    uint32_t pos;
-    BLF_CAN_OBJ canObject;
-    BLF_CAN_OBJ2 canObject2;
+    QFile inFile(filename);
 
-    QFile *inFile = new QFile(filename);
+    if (!inFile.open(QIODevice::ReadOnly)) return false;
 
-    if (!inFile->open(QIODevice::ReadOnly))
-    {
-        delete inFile;
-        return false;
-    }
-    inFile->read((char *)&header, sizeof(header));
+    if (inFile.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)) return false;
     if (qFromLittleEndian(header.sig) == 0x47474F4C)
     {
         qDebug() << "Proper BLF file header token";
     }
     else return false;
 
-    while (!inFile->atEnd())
+    QVector<BLF_CONTAINER_INFO> containers;
+    if (!scanContainers(inFile, containers)) return false;
+    qDebug() << "BLF file holds" << containers.count() << "containers";
+
+    int window = containersPerWindow;
+    if (window < 1) window = qMax(4, QThread::idealThreadCount() * 2);
+
+    carry.clear();
+    pendingSkip = 0;
+
+    //read and inflate window n + 1 while window n is decoded
+    QVector<ContainerSlot> windows[2];
+    QFuture<void> inflating[2];
+    int cur = 0;
+    int next = readWindow(inFile, containers, 0, window, windows[cur]);
+    inflating[cur] = QtConcurrent::map(windows[cur], inflateContainer);
+
+    bool ok = true;
+    while (ok && !windows[cur].isEmpty())
     {
-        qDebug() << "Position within file: " << inFile->pos();
-        inFile->read((char *)&objHeader.base, sizeof(BLF_OBJ_HEADER_BASE));
-        if (qFromLittleEndian(objHeader.base.sig) == 0x4A424F4C)
+        int other = cur ^ 1;
+        next = readWindow(inFile, containers, next, window, windows[other]);
+        if (!windows[other].isEmpty()) inflating[other] = QtConcurrent::map(windows[other], inflateContainer);
+
+        inflating[cur].waitForFinished();
+        for (int i = 0; i < windows[cur].count() && ok; i++)
         {
-            int readSize = objHeader.base.objSize - sizeof(BLF_OBJ_HEADER_BASE);
-            qDebug() << "Proper object header token. Read Size: " << readSize;
-            fileData = inFile->read(readSize);
-            junk = inFile->read(readSize % 4); //file is padded so sizes must always end up on even multiple of 4
-            //qDebug() << "Fudge bytes in readSize: " << (readSize % 4);
+            ok = decodeContainer(windows[cur].at(i).data, frames);
+        }
+        cur = other; //its slots, buffers included, get reused by the read after next
 
-            switch (objHeader.base.objType)
-            {
-                case BLF_CONTAINER:
-                qDebug() << "Object is a container.";
-                memcpy(&objHeader.containerObj, fileData.constData(), sizeof(BLF_OBJ_HEADER_CONTAINER));
-                fileData.remove(0, sizeof(BLF_OBJ_HEADER_CONTAINER));
-                if (objHeader.containerObj.compressionMethod == BLF_CONT_NO_COMPRESSION)
-                {
-                    qDebug() << "Container is not compressed";
-                    uncompressedData = fileData;
-                }
-                else if (objHeader.containerObj.compressionMethod == BLF_CONT_ZLIB_COMPRESSION)
-                {
-                    qDebug() << "Compressed container. Unpacking it.";
-                    fileData.prepend(objHeader.containerObj.uncompressedSize & 0xFF);
-                    fileData.prepend((objHeader.containerObj.uncompressedSize >> 8) & 0xFF);
-                    fileData.prepend((objHeader.containerObj.uncompressedSize >> 16) & 0xFF);
-                    fileData.prepend((objHeader.containerObj.uncompressedSize >> 24) & 0xFF);
-                    uncompressedData += qUncompress(fileData);
-                }
-                else
-                {
-                    qDebug() << "Dunno what this is... " << objHeader.containerObj.compressionMethod;
-                }
-                qDebug() << "Uncompressed size: " << uncompressedData.count();
-                qDebug() << "Currently loaded frames at this point: " << frames->count();
-                pos = 0;
-                //bool foundHeader = false;
-                //first skip forward to find a header signature - usually not necessary
-                while ( (int)(pos + sizeof(BLF_OBJ_HEADER)) < uncompressedData.count())
-                {
-                    int32_t *headerSig = (int32_t *)(uncompressedData.constData() + pos);
-                    if (*headerSig == 0x4A424F4C) break;
-                    pos += 4;
-                }
-                //then process all the objects
-                while ( (int)(pos + sizeof(BLF_OBJ_HEADER)) < uncompressedData.count())
-                {
-                    memcpy(&obj.header.base, (uncompressedData.constData() + pos), sizeof(BLF_OBJ_HEADER_BASE));
-                    memcpy(&obj.header.v1Obj, (uncompressedData.constData() + pos) + sizeof(BLF_OBJ_HEADER_BASE), sizeof(BLF_OBJ_HEADER_V1));
-                    //if (obj.header.base.objType != 1)
-                        //qDebug() << "Pos: " << pos << " Type: " << obj.header.base.objType << "Obj Size: " << obj.header.base.objSize;
-                    if (qFromLittleEndian(objHeader.base.sig) == 0x4A424F4C)
-                    {
-                        fileData = uncompressedData.mid(pos + sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_V1), obj.header.base.objSize - sizeof(BLF_OBJ_HEADER_BASE) - sizeof(BLF_OBJ_HEADER_V1));
-                        if (obj.header.base.objType == BLF_CAN_MSG)
-                        {
-                            memcpy(&canObject, fileData.constData(), sizeof(BLF_CAN_OBJ));
-                            CANFrame frame;
-                            frame.bus = canObject.channel;
-                            frame.setExtendedFrameFormat((canObject.id & 0x80000000ull)?true:false);
-                            frame.setFrameId(canObject.id & 0x1FFFFFFFull);
-                            frame.isReceived = true;
-                            QByteArray bytes(canObject.dlc, 0);
-
-                            if (canObject.flags & BLF_REMOTE_FLAG) {
-                                frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-                            } else {
-                                frame.setFrameType(QCanBusFrame::DataFrame);
-                                for (int i = 0; i < canObject.dlc; i++) bytes[i] = canObject.data[i];
-                            }
-                            frame.setPayload(bytes);
-                            //Should we divide by a thousand or a million? Unsure here. It appears some logs are stamped in microseconds and some in milliseconds?
-                            frame.setTimeStamp(QCanBusFrame::TimeStamp(0, obj.header.v1Obj.uncompSize / 1000.0)); //uncompsize field also used for timestamp oddly enough
-                            frames->append(frame);
-                        }
-                        else if (obj.header.base.objType == BLF_CAN_MSG2)
-                        {
-                            memcpy(&canObject2, fileData.constData(), sizeof(BLF_CAN_OBJ2));
-                            CANFrame frame;
-                            frame.bus = canObject2.channel;
-                            frame.setExtendedFrameFormat((canObject2.id & 0x80000000ull)?true:false);
-                            frame.setFrameId(canObject2.id & 0x1FFFFFFFull);
-                            frame.isReceived = true;
-                            QByteArray bytes(canObject2.dlc, 0);
-
-                            if (canObject2.flags & BLF_REMOTE_FLAG) {
-                                frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-                            } else {
-                                frame.setFrameType(QCanBusFrame::DataFrame);
-                                for (int i = 0; i < canObject2.dlc; i++) bytes[i] = canObject2.data[i];
-                            }
-                            frame.setPayload(bytes);
-                            //Should we divide by a thousand or a million? Unsure here. It appears some logs are stamped in microseconds and some in milliseconds?
-                            frame.setTimeStamp(QCanBusFrame::TimeStamp(0, obj.header.v1Obj.uncompSize / 1000.0)); //uncompsize field also used for timestamp oddly enough
-                            frames->append(frame);
-                        }
-                        else
-                        {
-                            qDebug() << "Not a can frame! ObjType: " << obj.header.base.objType;
-                            if (obj.header.base.objType > 0xFFFF)
-                                return false;
-                        }
-                        pos += obj.header.base.objSize + (obj.header.base.objSize % 4);
-                    }
-                    else
-                    {
-                        qDebug() << "Unexpected object header signature, aborting";
-                        return false;
-                    }
-                }
-                uncompressedData.remove(0, pos);
-                qDebug() << "After removing used data uncompressedData is now this big: " << uncompressedData.count();
+    }
+    inflating[0].waitForFinished(); //never leave a worker writing into a window that's going away
+    inflating[1].waitForFinished();
+
+    if (!carry.isEmpty()) qDebug() << carry.count() << "bytes of an incomplete object at the end of the file ignored";
+    carry.clear();
+    return ok;
+}
+
+//walk the top level objects collecting where each container is. Nothing is decompressed yet
+bool BLFHandler::scanContainers(QFile &file, QVector<BLF_CONTAINER_INFO> &containers)
+{
+    BLF_OBJ_HEADER objHeader;
+    qint64 fileSize = file.size();
+    qint64 pos = qMax(static_cast<qint64>(qFromLittleEndian(header.headerSize)), static_cast<qint64>(sizeof(header)));
+
+    while (pos + static_cast<qint64>(sizeof(BLF_OBJ_HEADER_BASE)) <= fileSize)
+    {
+        file.seek(pos);
+        if (file.read(reinterpret_cast<char *>(&objHeader.base), sizeof(BLF_OBJ_HEADER_BASE)) != sizeof(BLF_OBJ_HEADER_BASE)) break;
+        if (qFromLittleEndian(objHeader.base.sig) != 0x4A424F4C)
+        {
+            qDebug() << "Bad object header signature at" << pos;
+            return false;
+        }
+        uint32_t objSize = qFromLittleEndian(objHeader.base.objSize);
+        if (objSize < sizeof(BLF_OBJ_HEADER_BASE)) return false;
 
+        if (qFromLittleEndian(objHeader.base.objType) == BLF_CONTAINER)
+        {
+            if (objSize < sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_CONTAINER)) return false;
+            if (pos + objSize > fileSize)
+            {
+                qDebug() << "Last container is cut short, stopping at" << pos;
                 break;
             }
+            file.read(reinterpret_cast<char *>(&objHeader.containerObj), sizeof(BLF_OBJ_HEADER_CONTAINER));
+            BLF_CONTAINER_INFO info;
+            info.dataOffset = pos + sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_CONTAINER);
+            info.compressedSize = objSize - sizeof(BLF_OBJ_HEADER_BASE) - sizeof(BLF_OBJ_HEADER_CONTAINER);
+            info.uncompressedSize = qFromLittleEndian(objHeader.containerObj.uncompressedSize);
+            info.compressionMethod = qFromLittleEndian(objHeader.containerObj.compressionMethod);
+            containers.append(info);
+        }
+
+        pos += objSize + (objSize % 4); //file is padded so sizes must always end up on even multiple of 4
+    }
+    return true;
+}
+
+//read the raw bytes of up to count containers starting at first. Returns the container to read next
+int BLFHandler::readWindow(QFile &file, const QVector<BLF_CONTAINER_INFO> &containers, int first, int count, QVector<ContainerSlot> &window)
+{
+    int num = qMin(count, containers.count() - first);
+    window.resize(qMax(num, 0));
+    for (int i = 0; i < num; i++)
+    {
+        ContainerSlot &slot = window[i];
+        slot.info = containers.at(first + i);
+        uint32_t size = slot.info.compressedSize;
+        //qUncompress wants the uncompressed size in front of the zlib stream. Leave room for it
+        //here rather than prepending later and copying the whole container again.
+        slot.raw.resize(static_cast<int>(size) + 4);
+        char *dest = slot.raw.data();
+        qToBigEndian(slot.info.uncompressedSize, reinterpret_cast<uchar *>(dest));
+        file.seek(slot.info.dataOffset);
+        if (file.read(dest + 4, size) != static_cast<qint64>(size))
+        {
+            qDebug() << "Could not read container at" << slot.info.dataOffset;
+            slot.raw.resize(4);
+            slot.info.compressionMethod = 0xFFFF; //decodes to nothing
+        }
+    }
+    return first + qMax(num, 0);
+}
+
+void BLFHandler::inflateContainer(ContainerSlot &slot)
+{
+    if (slot.info.compressionMethod == BLF_CONT_NO_COMPRESSION)
+    {
+        slot.data = slot.raw.mid(4);
+    }
+    else if (slot.info.compressionMethod == BLF_CONT_ZLIB_COMPRESSION)
+    {
+        slot.data = qUncompress(slot.raw);
+        if (slot.data.isEmpty()) qDebug() << "Container at" << slot.info.dataOffset << "would not inflate";
+    }
+    else
+    {
+        qDebug() << "Dunno what this is... " << slot.info.compressionMethod;
+        slot.data.clear();
+    }
+}
+
+bool BLFHandler::decodeContainer(const QByteArray &data, QVector<CANFrame> *frames)
+{
+    const char *buf;
+    qint64 len;
+    qint64 skip = 0;
+
+    if (carry.isEmpty())
+    {
+        skip = qMin(pendingSkip, static_cast<qint64>(data.count()));
+        pendingSkip -= skip;
+        buf = data.constData() + skip;
+        len = data.count() - skip;
+    }
+    else
+    {
+        carry.append(data);
+        buf = carry.constData();
+        len = carry.count();
+    }
+
+    qint64 consumed = 0;
+    if (!decodeObjects(buf, len, consumed, frames)) return false;
+    if (consumed > len)
+    {
+        pendingSkip += consumed - len;
+        consumed = len;
+    }
+    carry = QByteArray(buf + consumed, static_cast<int>(len - consumed));
+    return true;
+}
+
+bool BLFHandler::decodeObjects(const char *data, qint64 len, qint64 &consumed, QVector<CANFrame> *frames)
+{
+    BLF_OBJ_HEADER_BASE base;
+    qint64 pos = 0;
+
+    //first skip forward to find a header signature - usually not necessary
+    while (pos + static_cast<qint64>(sizeof(BLF_OBJ_HEADER_BASE)) <= len)
+    {
+        memcpy(&base, data + pos, sizeof(BLF_OBJ_HEADER_BASE));
+        if (qFromLittleEndian(base.sig) == 0x4A424F4C) break;
+        pos += 4;
+    }
+    //then process all the objects
+    while (pos + static_cast<qint64>(sizeof(BLF_OBJ_HEADER_BASE)) <= len)
+    {
+        memcpy(&base, data + pos, sizeof(BLF_OBJ_HEADER_BASE));
+        if (qFromLittleEndian(base.sig) != 0x4A424F4C)
+        {
+            qDebug() << "Unexpected object header signature, aborting";
+            return false;
         }
-        else return false;
+        uint32_t objSize = qFromLittleEndian(base.objSize);
+        if (objSize < sizeof(BLF_OBJ_HEADER_BASE))
+        {
+            qDebug() << "Impossible object size" << objSize << ", aborting";
+            return false;
+        }
+        if (pos + objSize > len) break; //the rest of it is in the next container
+        if (!decodeObject(data + pos, objSize, frames)) return false;
+        pos += objSize + (objSize % 4);
+    }
+    consumed = pos;
+    return true;
+}
+
+bool BLFHandler::decodeObject(const char *obj, uint32_t objSize, QVector<CANFrame> *frames)
+{
+    BLF_OBJ_HEADER objHeader;
+    memcpy(&objHeader.base, obj, sizeof(BLF_OBJ_HEADER_BASE));
+    uint32_t objType = qFromLittleEndian(objHeader.base.objType);
+
+    if (objType != BLF_CAN_MSG && objType != BLF_CAN_MSG2 && objType != BLF_CAN_FD_MSG)
+    {
+        qDebug() << "Not a can frame! ObjType: " << objType;
+        return (objType <= 0xFFFF);
+    }
+
+    if (objSize < sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_V1)) return true;
+    memcpy(&objHeader.v1Obj, obj + sizeof(BLF_OBJ_HEADER_BASE), sizeof(BLF_OBJ_HEADER_V1));
+    uint32_t headerSize = qFromLittleEndian(objHeader.base.headerSize);
+    if (headerSize < sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_V1) || headerSize > objSize)
+        headerSize = sizeof(BLF_OBJ_HEADER_BASE) + sizeof(BLF_OBJ_HEADER_V1);
+    const char *body = obj + headerSize;
+    uint32_t bodySize = objSize - headerSize;
+
+    //uncompsize field also used for timestamp oddly enough. Flag bit 0 says it counts 10us steps, otherwise nanoseconds
+    uint64_t stamp = qFromLittleEndian(objHeader.v1Obj.uncompSize);
+    int64_t micros = (qFromLittleEndian(objHeader.v1Obj.flags) & 1) ? static_cast<int64_t>(stamp * 10) : static_cast<int64_t>(stamp / 1000);
+
+    CANFrame frame;
+    frame.isReceived = true;
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, micros));
+    QByteArray bytes;
+    uint8_t flags;
+    uint32_t id;
+
+    if (objType == BLF_CAN_FD_MSG)
+    {
+        BLF_CANFD_OBJ canFDObject;
+        if (bodySize < offsetof(BLF_CANFD_OBJ, data)) return true;
+        memset(&canFDObject, 0, sizeof(canFDObject));
+        memcpy(&canFDObject, body, qMin(static_cast<size_t>(bodySize), sizeof(BLF_CANFD_OBJ)));
+        frame.bus = qFromLittleEndian(canFDObject.channel);
+        flags = canFDObject.flags;
+        id = qFromLittleEndian(canFDObject.id);
+        int len = qMin(static_cast<int>(canFDObject.validDataBytes), static_cast<int>(bodySize - offsetof(BLF_CANFD_OBJ, data)));
+        len = qMin(qMax(len, 0), 64);
+        if (canFDObject.fdFlags & 1)
+        {
+            frame.setFlexibleDataRateFormat(true);
+            frame.setBitrateSwitch(canFDObject.fdFlags & 2);
+            frame.setErrorStateIndicator(canFDObject.fdFlags & 4);
+        }
+        bytes = QByteArray(reinterpret_cast<const char *>(canFDObject.data), len);
+    }
+    else
+    {
+        //CAN_MSG2 only adds fields after the data so both read the same way
+        BLF_CAN_OBJ canObject;
+        if (bodySize < sizeof(BLF_CAN_OBJ)) return true;
+        memcpy(&canObject, body, sizeof(BLF_CAN_OBJ));
+        frame.bus = qFromLittleEndian(canObject.channel);
+        flags = canObject.flags;
+        id = qFromLittleEndian(canObject.id);
+        bytes = QByteArray(reinterpret_cast<const char *>(canObject.data), qMin(static_cast<int>(canObject.dlc), 8));
+    }
+
+    frame.setExtendedFrameFormat((id & 0x80000000ull)?true:false);
+    frame.setFrameId(id & 0x1FFFFFFFull);
+    if (flags & BLF_REMOTE_FLAG) {
+        frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        bytes.fill(0);
+    } else {
+        frame.setFrameType(QCanBusFrame::DataFrame);
     }
+    frame.setPayload(bytes);
+    frames->append(frame);
     return true;
 }
 
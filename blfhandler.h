@@ -3,7 +3,9 @@
 
 #include <Qt>
 #include <QByteArray>
+#include <QFile>
 #include <QList>
+#include <QVector>
 #include "can_structs.h"
 
 enum
@@ -175,6 +177,21 @@ struct BLF_GLOBAL_MARKER
     uint8_t ignore2[12];
 };
 
+//where one LOGG container sits in the file. All of these are gathered before anything is inflated
+struct BLF_CONTAINER_INFO
+{
+    qint64 dataOffset;
+    uint32_t compressedSize;
+    uint32_t uncompressedSize;
+    uint16_t compressionMethod;
+};
+
+/*
+ * Loading streams through the file a window of containers at a time. While one window is being
+ * decoded into frames the next one is read and inflated on the thread pool, so only two windows
+ * of container data are ever held no matter how large the trace is. Objects are allowed to span
+ * containers; whatever is left over at the end of one is carried into the next.
+ */
 class BLFHandler
 {
 public:
@@ -182,9 +199,27 @@ public:
     bool loadBLF(QString filename, QVector<CANFrame>* frames);
     bool saveBLF(QString filename, QVector<CANFrame>* frames);
 
+    static int containersPerWindow; //0 picks a window based on the number of cores
+
 private:
+    struct ContainerSlot
+    {
+        BLF_CONTAINER_INFO info;
+        QByteArray raw;  //as read from the file, room for qUncompress' size prefix up front
+        QByteArray data; //inflated contents
+    };
+
+    bool scanContainers(QFile &file, QVector<BLF_CONTAINER_INFO> &containers);
+    int readWindow(QFile &file, const QVector<BLF_CONTAINER_INFO> &containers, int first, int count, QVector<ContainerSlot> &window);
+    static void inflateContainer(ContainerSlot &slot);
+    bool decodeContainer(const QByteArray &data, QVector<CANFrame> *frames);
+    bool decodeObjects(const char *data, qint64 len, qint64 &consumed, QVector<CANFrame> *frames);
+    bool decodeObject(const char *obj, uint32_t objSize, QVector<CANFrame> *frames);
+
     BLF_FILE_HEADER header;
     QList<BLF_OBJECT> objects;
+    QByteArray carry;   //start of an object that continues in the next container
+    qint64 pendingSkip; //padding of the last object that fell past the end of its container
 };
 
 #endif // BLFHANDLER_H
@@ -5,6 +5,7 @@
 #include <QDebug>
 #include <QTimer>
 #include "can_structs.h"
+#include "canframestore.h"
 #include "mainwindow.h"
 #include "canframemodel.h"
 #include "isotp_message.h"
@@ -39,7 +40,7 @@ private:
     QHash<uint32_t, ISOTP_MESSAGE> messageBuffer;
     QList<CANFrame> sendingFrames;
     QList<CANFilter> filters;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     bool useExtendedAddressing;
     bool isReceiving;
     bool waitingForFlow;
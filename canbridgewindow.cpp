@@ -5,7 +5,7 @@
 #include "filterutility.h"
 #include "mainwindow.h"
 
-CANBridgeWindow::CANBridgeWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+CANBridgeWindow::CANBridgeWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::CANBridgeWindow)
 {
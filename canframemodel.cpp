@@ -7,7 +7,15 @@
 #include <QBrush>
 #include <QDateTime>
 #include <QSettings>
+#include <QProgressDialog>
+#include <QThread>
+#include <QSet>
+#include <QtConcurrent>
+#include <atomic>
+#include <algorithm>
 #include "utility.h"
+#include "utils/capturepager.h"
+#include "utils/parallelsort.h"
 
 CANFrameModel::~CANFrameModel()
 {
@@ -15,27 +23,22 @@ CANFrameModel::~CANFrameModel()
     filteredFrames.clear();
     filters.clear();
     busFilters.clear();
+    overwriteIndex.clear();
+    delete pagedSource;
 }
 
 int CANFrameModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    if (filteredFrames.data())
-    {
-        int rows = filteredFrames.count();
-        return rows;
-    }
-
-     //just in case somehow data is invalid which I have seen before.
-    //But, this should not happen so issue a debugging message too
-    qDebug() << "Invalid data for filteredFrames. Returning 0.";
-    return 0;
+    //Only report the rows the view has been told about. Frames appended since the last
+    //bulk refresh are announced with beginInsertRows on the next GUI tick.
+    return rowCountAtLastRefresh;
 }
 
 int CANFrameModel::totalFrameCount()
 {
     int count;
-    count = frames.count();
+    count = pagedSource ? pagedSource->frameCount() : frames.count();
     return count;
 }
 
@@ -47,49 +50,156 @@ int CANFrameModel::columnCount(const QModelIndex &index) const
 
 CANFrameModel::CANFrameModel(QObject *parent)
     : QAbstractTableModel(parent)
+{
+    preallocSize = 0;
+    captureMemoryBytes = 0;
+    dbcHandler = DBCHandler::getReference();
+    pagedSource = nullptr;
+    interpretFrames = false;
+    overwriteDups = false;
+    filtersPersistDuringClear = false;
+    useHexMode = true;
+    useColorsByCanId = false;
+    timeStyle = TS_MICROS;
+    timeOffset = 0;
+    needFilterRefresh = false;
+    lastUpdateNumFrames = 0;
+    overwriteDirtyFirst = -1;
+    overwriteDirtyLast = -1;
+    rowCountAtLastRefresh = 0;
+    filterCacheDirty = true;
+    filtersConfigured = false;
+    busFiltersConfigured = false;
+    timeFormat =  "MMM-dd HH:mm:ss.zzz";
+    sortDirAsc = false;
+    bytesPerLine = 8;
+
+    rowCache.setMaxCost(20000);
+    rowCacheHits = 0;
+    rowCacheMisses = 0;
+    rowCacheDbcGeneration = -1;
+    rowLayoutGeneration = 0;
+    rowsInAgeOrder = true;
+    //every display setting change, sort, filter refresh or clear goes through a model reset and
+    //trimming old frames removes rows. Either way cached rows no longer line up.
+    connect(this, &QAbstractItemModel::modelAboutToBeReset, this, &CANFrameModel::invalidateRowCache);
+    connect(this, &QAbstractItemModel::rowsAboutToBeRemoved, this, &CANFrameModel::invalidateRowCache);
+    connect(this, &QAbstractItemModel::modelAboutToBeReset, this, &CANFrameModel::rowsRearranged);
+
+    readCaptureSettings();
+}
+
+//the frame limit Main/MaximumFrames and Main/CaptureMemoryMB work out to together
+static uint32_t framesForLimits(int maxFrames, quint64 memoryBytes)
+{
+    uint32_t limit = static_cast<uint32_t>(qMax(maxFrames, 1));
+    //Every frame takes a 24 byte record in both stores and up to 16 bytes of overwrite stats, which caps
+    //the frame count. FD payloads are on top of that and are checked against the ceiling as they come in
+    if (memoryBytes > 0)
+    {
+        quint64 ceilingFrames = memoryBytes / (2 * sizeof(PackedCANFrame) + 16);
+        if (ceilingFrames < limit) limit = static_cast<uint32_t>(qMax(ceilingFrames, 1ull));
+    }
+    return limit;
+}
+
+/*
+ * Size the capture from Main/MaximumFrames, Main/CaptureMemoryMB and Main/RingBufferCapture. Runs
+ * at startup and again whenever the settings change, so a running capture picks up new limits
+ * straight away.
+ */
+void CANFrameModel::readCaptureSettings()
 {
     int maxFramesDefault;
     if (QSysInfo::WordSize > 32)
     {
-        qDebug() << "64 bit OS detected. Requesting a large preallocation";
         maxFramesDefault = 10000000;
     }
     else //if compiling for 32 bit you can't ask for gigabytes of preallocation so tone it down.
     {
-        qDebug() << "32 bit OS detected. Requesting a much restricted prealloc";
         maxFramesDefault = 2000000;
     }
 
     QSettings settings;
-    preallocSize = settings.value("Main/MaximumFrames", maxFramesDefault).toInt();
+    //optional memory ceiling for the capture, 0 for none
+    quint64 memoryBytes = static_cast<quint64>(qMax(settings.value("Main/CaptureMemoryMB", 0).toInt(), 0)) * 1048576ull;
+    uint32_t newSize = framesForLimits(settings.value("Main/MaximumFrames", maxFramesDefault).toInt(), memoryBytes);
 
-    //Each CANFrame object takes up 56 bytes and we're allocating two arrays here so take the
-    //# of pre-alloc frames and multiply by 112 to get the RAM usage. This is around 1GiB for the default.
+    setCaptureLimits(newSize, settings.value("Main/RingBufferCapture", false).toBool(), memoryBytes);
+}
 
-    //the goal is to prevent a reallocation from ever happening
-    frames.reserve(preallocSize);
-    //this is pretty wasteful. We're storing all frames twice. It may be better for filteredFrames to be a list of pointers.
-    //Pointers take up 8 bytes instead of 56 so this is quite a savings for RAM usage. But, then filteredFrames would
-    //work differently from frames above so the two could not be used interchangeably. Still think about what can be done.
-    filteredFrames.reserve(preallocSize);
+//Would these Main/MaximumFrames and Main/CaptureMemoryMB values throw away frames already captured?
+bool CANFrameModel::captureLimitsDropFrames(int maxFrames, int captureMemoryMB)
+{
+    quint64 memoryBytes = static_cast<quint64>(qMax(captureMemoryMB, 0)) * 1048576ull;
+    int limit = static_cast<int>(framesForLimits(maxFrames, memoryBytes));
 
-    dbcHandler = DBCHandler::getReference();
-    interpretFrames = false;
-    overwriteDups = false;
-    filtersPersistDuringClear = false;
-    useHexMode = true;
-    useColorsByCanId = false;
-    timeStyle = TS_MICROS;
-    timeOffset = 0;
-    needFilterRefresh = false;
-    lastUpdateNumFrames = 0;
-    timeFormat =  "MMM-dd HH:mm:ss.zzz";
-    sortDirAsc = false;
-    bytesPerLine = 8;
+    mutex.lock();
+    bool drops = (frames.count() > limit) || (filteredFrames.count() > limit);
+    if (memoryBytes > 0 && frames.bytesUsed() + filteredFrames.bytesUsed() > memoryBytes) drops = true;
+    mutex.unlock();
+    return drops;
+}
+
+//Lowering the limit or turning the ring on drops the oldest frames on the spot
+void CANFrameModel::setCaptureLimits(uint32_t maxFrames, bool ringBuffer, quint64 memoryBytes)
+{
+    if (maxFrames < 1) maxFrames = 1;
+    //In ring buffer mode the stores never grow past preallocSize. Each new frame past that point
+    //overwrites the oldest one instead of the 5% trim that addFrames otherwise does.
+    int newRing = ringBuffer ? static_cast<int>(maxFrames) : 0;
+    if (maxFrames == preallocSize && newRing == frames.ringCapacity() && memoryBytes == captureMemoryBytes) return;
+    qDebug() << "Capture limit" << maxFrames << "frames, ring buffer" << ringBuffer << "memory ceiling" << memoryBytes;
+
+    mutex.lock();
+    captureMemoryBytes = memoryBytes;
+    //a sorted capture has to lose its oldest frames here too, not whatever sorted to the top
+    if (!rowsInAgeOrder) evictOldestByTime(filteredFrames.count() - static_cast<int>(maxFrames));
+    beginResetModel();
+    preallocSize = maxFrames;
+    frames.setRingCapacity(newRing);
+    filteredFrames.setRingCapacity(newRing);
+    if (newRing == 0)
+    {
+        int excess = frames.count() - static_cast<int>(preallocSize);
+        if (excess > 0) frames.remove(0, excess);
+        excess = filteredFrames.count() - static_cast<int>(preallocSize);
+        if (excess > 0) filteredFrames.remove(0, excess);
+
+        //Both lists are CANFrameStore objects which pack a classic CAN frame into 24 bytes. We're allocating two
+        //of them here so take the # of pre-alloc frames and multiply by 48 to get the RAM usage. This is around
+        //480MiB for the default. The goal is to prevent a reallocation from ever happening.
+        frames.reserve(preallocSize);
+        filteredFrames.reserve(preallocSize);
+    }
+    rebuildOverwriteIndex();
+    rowLayoutGeneration++;
+    rowCountAtLastRefresh = filteredFrames.count();
+    endResetModel();
+    trimToMemoryCeiling(); //after the stores are laid out for the new limits, a shrunk ring no longer counts its old size
+    mutex.unlock();
+}
+
+void CANFrameModel::invalidateRowCache()
+{
+    rowCache.clear();
+}
+
+void CANFrameModel::getRowCacheStats(quint64 &hits, quint64 &misses, int &entries) const
+{
+    hits = rowCacheHits;
+    misses = rowCacheMisses;
+    entries = rowCache.count();
+}
+
+quint64 CANFrameModel::getTrimmedFrames() const
+{
+    return frames.evictedCount();
 }
 
 void CANFrameModel::setBytesPerLine(int bpl)
 {
+    if (bytesPerLine != bpl) invalidateRowCache();
     bytesPerLine = bpl;
 }
 
@@ -166,34 +276,34 @@ void CANFrameModel::setIgnoreDBCColors(bool mode)
 void CANFrameModel::normalizeTiming()
 {
     mutex.lock();
-    if (frames.count() == 0) 
+    if (frames.count() == 0 || pagedSource) 
     {
         mutex.unlock();
         return;
     }
-    timeOffset = frames[0].timeStamp().microSeconds();
+    timeOffset = frames.timeStampAt(0);
     qint64 prevStamp = 0;
 
     //find the absolute lowest timestamp in the whole time. Needed because maybe timestamp was reset in the middle.
     for (int j = 0; j < frames.count(); j++)
     {
-        if (frames[j].timeStamp().microSeconds() < timeOffset) timeOffset = frames[j].timeStamp().microSeconds();
+        if (frames.timeStampAt(j) < timeOffset) timeOffset = frames.timeStampAt(j);
     }
 
     for (int i = 0; i < frames.count(); i++)
     {
-        qint64 thisStamp = frames[i].timeStamp().microSeconds() - timeOffset;
+        qint64 thisStamp = frames.timeStampAt(i) - timeOffset;
         if (thisStamp <= prevStamp)
         {
             timeOffset -= prevStamp;
         }
-        frames[i].setTimeStamp(QCanBusFrame::TimeStamp(0, thisStamp));
+        frames.setTimeStampAt(i, thisStamp);
     }
 
     this->beginResetModel();
     for (int i = 0; i < filteredFrames.count(); i++)
     {
-        filteredFrames[i].setTimeStamp(QCanBusFrame::TimeStamp(0, filteredFrames[i].timeStamp().microSeconds() - timeOffset));
+        filteredFrames.setTimeStampAt(i, filteredFrames.timeStampAt(i) - timeOffset);
     }
     this->endResetModel();
 
@@ -217,6 +327,7 @@ void CANFrameModel::setFilterState(unsigned int ID, bool state)
 {
     if (!filters.contains(ID)) return;
     filters[ID] = state;
+    filterCacheDirty = true;
     sendRefresh();
 }
 
@@ -224,6 +335,7 @@ void CANFrameModel::setBusFilterState(unsigned int BusID, bool state)
 {
     if (!busFilters.contains(BusID)) return;
     busFilters[BusID] = state;
+    filterCacheDirty = true;
     sendRefresh();
 }
 
@@ -234,130 +346,187 @@ void CANFrameModel::setAllFilters(bool state)
     {
         it.value() = state;
     }
+    filterCacheDirty = true;
     sendRefresh();
 }
 
 /*
- * There is probably a more correct way to have done this but below are several functions that collectively implement
- * quicksort on the columns and interpret the columns numerically. But, correct or not, this implementation is quite fast
- * and sorts the columns properly.
-*/
-uint64_t CANFrameModel::getCANFrameVal(QVector<CANFrame> *frames, int row, Column col)
+ * Sorting works on (key, row) pairs rather than on the frames themselves. Every frame's key is
+ * pulled out once, straight from the packed record, the pairs get a parallel stable sort and then
+ * the frames are copied into their new order in a single pass. The old in place quicksort unpacked
+ * a full CANFrame for each comparison and swapped frames through replace() which made sorting a
+ * big capture take minutes.
+ */
+uint64_t CANFrameModel::sortKeyAt(const CANFrameStore &store, int row, Column col, bool overwriteMode)
 {
-    uint64_t temp = 0;
-    if (row >= frames->count()) return 0;
-    CANFrame frame = frames->at(row);
+    const PackedCANFrame &rec = store.recordAt(row);
     switch (col)
     {
     case Column::TimeStamp:
-        if (overwriteDups) return frame.timedelta;
-        return frame.timeStamp().microSeconds();
+        if (overwriteMode) return store.timeDeltaAt(row);
+        return static_cast<uint64_t>(rec.timeStamp);
     case Column::FrameId:
-        return frame.frameId();
+        return rec.frameId;
     case Column::Extended:
-        if (frame.hasExtendedFrameFormat()) return 1;
-        return 0;
+        return rec.extended;
     case Column::Remote:
-        if (overwriteDups) return frame.frameCount;
-        if (frame.frameType() == QCanBusFrame::RemoteRequestFrame) return 1;
+        if (overwriteMode) return store.frameCountAt(row);
+        if (rec.frameType == QCanBusFrame::RemoteRequestFrame) return 1;
         return 0;
     case Column::Direction:
-        if (frame.isReceived) return 1;
-        return 0;
+        return rec.received;
     case Column::Bus:
-        return static_cast<uint64_t>(frame.bus);
+        return rec.bus;
     case Column::Length:
-        return static_cast<uint64_t>(frame.payload().length());
+        return rec.length;
     case Column::ASCII: //sort both the same for now
     case Column::Data:
-        for (int i = 0; i < std::min(frame.payload().length(), 8); i++) temp += (static_cast<uint64_t>(frame.payload()[i]) << (56 - (8 * i)));
-        //qDebug() << temp;
+    {
+        //first 8 bytes big endian style so the sort goes byte by byte. Bytes must be unsigned here
+        //or anything 0x80 and up sign extends over the bytes before it
+        uint64_t temp = 0;
+        const uint8_t *data = store.payloadAt(row);
+        int len = std::min(static_cast<int>(rec.length), 8);
+        for (int i = 0; i < len; i++) temp |= (static_cast<uint64_t>(data[i]) << (56 - (8 * i)));
         return temp;
+    }
     case Column::NUM_COLUMN:
         return 0;
     }
     return 0;
 }
 
-void CANFrameModel::qSortCANFrameAsc(QVector<CANFrame> *frames, Column column, int lowerBound, int upperBound)
+struct SortKey
 {
-    int p, i, j;
-    qDebug() << "Lower " << lowerBound << " Upper" << upperBound;
-    if (lowerBound < upperBound)
-    {
-        uint64_t piv = getCANFrameVal(frames, lowerBound + (upperBound - lowerBound) / 2, column);
-        i = lowerBound - 1;
-        j = upperBound + 1;
-        for (;;){
-            do {
-                i++;
-            } while ((i < upperBound) && getCANFrameVal(frames, i, column) < piv);
-
-            do
-            {
-                j--;
-            } while ((j > lowerBound) && getCANFrameVal(frames, j, column) > piv);
-            if (i < j) {
-                CANFrame temp = frames->at(i);
-                frames->replace(i, frames->at(j));
-                frames->replace(j, temp);
-            }
-            else {p = j; break;}
-        }
+    uint64_t key;
+    int row;
+};
 
-        qSortCANFrameAsc(frames, column, lowerBound, p);
-        qSortCANFrameAsc(frames, column, p+1, upperBound);
-    }
-}
-
-void CANFrameModel::qSortCANFrameDesc(QVector<CANFrame> *frames, Column column, int lowerBound, int upperBound)
+void CANFrameModel::rowsRearranged()
 {
-    int p, i, j;
-    qDebug() << "Lower " << lowerBound << " Upper" << upperBound;
-    if (lowerBound < upperBound)
-    {
-        uint64_t piv = getCANFrameVal(frames, lowerBound + (upperBound - lowerBound) / 2, column);
-        i = lowerBound - 1;
-        j = upperBound + 1;
-        for (;;){
-            do {
-                i++;
-            } while ((i < upperBound) && getCANFrameVal(frames, i, column) > piv);
-
-            do
-            {
-                j--;
-            } while ((j > lowerBound) && getCANFrameVal(frames, j, column) < piv);
-            if (i < j) {
-                CANFrame temp = frames->at(i);
-                frames->replace(i, frames->at(j));
-                frames->replace(j, temp);
-            }
-            else {p = j; break;}
-        }
-
-        qSortCANFrameDesc(frames, column, lowerBound, p);
-        qSortCANFrameDesc(frames, column, p+1, upperBound);
-    }
+    rowLayoutGeneration++;
 }
 
 void CANFrameModel::sortByColumn(int column)
 {
+    //below this the sort is over before a progress dialog would even show up
+    const int backgroundSortThreshold = 200000;
+
+    if (pagedSource) return; //rows are in file order and stay that way
+
     sortDirAsc = !sortDirAsc;
-    if (sortDirAsc) qSortCANFrameAsc(&filteredFrames, Column(column), 0, filteredFrames.count()-1);
-    else qSortCANFrameDesc(&filteredFrames, Column(column), 0, filteredFrames.count()-1);
+    bool ascending = sortDirAsc;
+    Column col = Column(column);
+
+    mutex.lock();
+    int count = filteredFrames.count();
+    int startGeneration = rowLayoutGeneration;
+    QVector<SortKey> keys(count);
+    SortKey *keyData = keys.data();
+    const CANFrameStore &store = filteredFrames;
+    bool overwriteMode = overwriteDups;
+    const int keyChunk = 65536;
+    QVector<int> chunkStarts;
+    for (int i = 0; i < count; i += keyChunk) chunkStarts.append(i);
+    QtConcurrent::blockingMap(chunkStarts, [&](int first)
+    {
+        int last = std::min(first + keyChunk, count);
+        for (int i = first; i < last; i++) keyData[i] = SortKey{sortKeyAt(store, i, col, overwriteMode), i};
+    });
+    mutex.unlock();
+
+    auto lessThan = [ascending](const SortKey &a, const SortKey &b)
+    {
+        return ascending ? (a.key < b.key) : (b.key < a.key);
+    };
+
+    std::atomic<bool> cancel(false);
+    std::atomic<int> progress(0);
+    bool finished;
+    if (count < backgroundSortThreshold)
+    {
+        finished = ParallelSort::stableSort(keys, lessThan);
+    }
+    else
+    {
+        //the keys are a private copy so the sort can run off the GUI thread while frames keep coming in
+        QFuture<bool> future = QtConcurrent::run([&]()
+        {
+            return ParallelSort::stableSort(keys, lessThan, &cancel, &progress);
+        });
+        QProgressDialog progressDlg(tr("Sorting frames..."), tr("Cancel"), 0, ParallelSort::stepCount(count), qApp->activeWindow());
+        progressDlg.setWindowModality(Qt::WindowModal);
+        progressDlg.setMinimumDuration(250);
+        while (!future.isFinished())
+        {
+            if (progressDlg.wasCanceled()) cancel = true;
+            progressDlg.setValue(progress);
+            qApp->processEvents();
+            QThread::msleep(10);
+        }
+        finished = future.result();
+    }
 
     mutex.lock();
+    if (!finished || rowLayoutGeneration != startGeneration)
+    {
+        //cancelled, or rows were trimmed, cleared or reordered while sorting so the row numbers in keys are stale
+        qDebug() << "Sort abandoned" << (finished ? "as rows changed underneath it" : "by the user");
+        sortDirAsc = !sortDirAsc;
+        mutex.unlock();
+        return;
+    }
+
     beginResetModel();
+    CANFrameStore sorted;
+    sorted.setRingCapacity(filteredFrames.ringCapacity());
+    sorted.reserve(std::max(filteredFrames.count(), static_cast<int>(preallocSize)));
+    for (int i = 0; i < count; i++) sorted.append(filteredFrames, keys.at(i).row);
+    //frames that arrived while the sort ran stay at the end in arrival order
+    for (int i = count; i < filteredFrames.count(); i++) sorted.append(filteredFrames, i);
+    sorted.setEvictedCount(filteredFrames.evictedCount());
+    filteredFrames = sorted;
+    rowsInAgeOrder = false; //the first rows aren't the oldest any more, trimming has to go by time stamp
+    rebuildOverwriteIndex(); //rows moved so the slot index is stale
     endResetModel();
     mutex.unlock();
 }
 
 //End of custom sorting code
 
+//id in lower 29 bits, bus number shifted up 29 bits
+uint64_t CANFrameModel::overwriteKey(const CANFrame &frame)
+{
+    return static_cast<uint64_t>(frame.frameId()) + (static_cast<uint64_t>(frame.bus) << 29ull);
+}
+
+uint64_t CANFrameModel::overwriteKey(const CANFrameStore &store, int idx)
+{
+    return static_cast<uint64_t>(store.frameIdAt(idx)) + (static_cast<uint64_t>(store.busAt(idx)) << 29ull);
+}
+
+/*
+ * Rebuild the (bus, ID) -> row lookup used by addFrame in overwrite mode. Must be called
+ * any time the rows of filteredFrames get reordered, removed or replaced wholesale.
+ * Caller is expected to hold the mutex.
+*/
+void CANFrameModel::rebuildOverwriteIndex()
+{
+    overwriteIndex.clear();
+    overwriteDirtyFirst = -1;
+    overwriteDirtyLast = -1;
+    if (!overwriteDups) return;
+
+    overwriteIndex.reserve(filteredFrames.count());
+    for (int i = 0; i < filteredFrames.count(); i++)
+    {
+        overwriteIndex.insert(overwriteKey(filteredFrames, i), i);
+    }
+}
+
 void CANFrameModel::recalcOverwrite()
 {
-    if (!overwriteDups) return; //no need to do a thing if mode is disabled
+    if (!overwriteDups || pagedSource) return; //no need to do a thing if mode is disabled
 
     qDebug() << "recalcOverwrite called in model";
 
@@ -373,7 +542,7 @@ void CANFrameModel::recalcOverwrite()
 
         idAugmented = frame.frameId();
         idAugmented = idAugmented + (frame.bus << 29ull);
-        if (filters[frame.frameId()] && busFilters[frame.bus])
+        if (frameIsShown(frame.frameId(), frame.bus))
         {
             if (!overWriteFrames.contains(idAugmented))
             {
@@ -397,6 +566,9 @@ void CANFrameModel::recalcOverwrite()
     filteredFrames.clear();
     filteredFrames.append(overWriteFrames.values().toVector());
     filteredFrames.reserve(preallocSize);
+    rowsInAgeOrder = false; //rows come out in hash order
+    rebuildOverwriteIndex();
+    rowCountAtLastRefresh = filteredFrames.count();
 
     /*for (int i = 0; i < frames.count(); i++)
     {
@@ -412,20 +584,37 @@ void CANFrameModel::recalcOverwrite()
 
 QVariant CANFrameModel::data(const QModelIndex &index, int role) const
 {
-    QString tempString;
     CANFrame thisFrame;
-    QVariant ts;
 
     if (!index.isValid())
         return QVariant();
 
-    if (index.row() >= (filteredFrames.count()))
+    if (index.row() >= (pagedSource ? pagedSource->frameCount() : filteredFrames.count()))
         return QVariant();
 
-    thisFrame = filteredFrames.at(index.row());
+    //Formatted cell text is cached. Not in overwrite mode though, rows get replaced in place there all the time.
+    //Anything that changes how cells look resets the model which empties the cache (see invalidateRowCache)
+    quint64 cacheKey = (static_cast<quint64>(index.row()) << 8) | static_cast<quint64>(index.column());
+    bool useRowCache = (role == Qt::DisplayRole) && !overwriteDups;
+    if (useRowCache)
+    {
+        //DBC files can be edited or swapped out without the model knowing
+        if (interpretFrames && rowCacheDbcGeneration != DBCMessageHandler::lookupGeneration())
+        {
+            rowCache.clear();
+            rowCacheDbcGeneration = DBCMessageHandler::lookupGeneration();
+        }
+        QVariant *cached = rowCache.object(cacheKey);
+        if (cached)
+        {
+            rowCacheHits++;
+            return *cached;
+        }
+        rowCacheMisses++;
+    }
 
-    const unsigned char *data = reinterpret_cast<const unsigned char *>(thisFrame.payload().constData());
-    int dataLen = thisFrame.payload().count();
+    if (pagedSource) thisFrame = pagedSource->frameAt(index.row());
+    else thisFrame = filteredFrames.at(index.row());
 
     if (role == Qt::BackgroundRole)
     {
@@ -482,125 +671,142 @@ QVariant CANFrameModel::data(const QModelIndex &index, int role) const
         }
     }
 
-    if (role == Qt::DisplayRole) {
-        switch (Column(index.column()))
+    if (role == Qt::DisplayRole)
+    {
+        QVariant cell = formatCell(thisFrame, Column(index.column()));
+        if (useRowCache) rowCache.insert(cacheKey, new QVariant(cell));
+        return cell;
+    }
+
+    return QVariant();
+}
+
+/*
+ * The display text of one cell. With interpreted mode on this means a DBC lookup and decoding every
+ * signal in the frame which is why data() keeps the results around in rowCache.
+ */
+QVariant CANFrameModel::formatCell(const CANFrame &thisFrame, Column column) const
+{
+    QString tempString;
+    QVariant ts;
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(thisFrame.payload().constData());
+    int dataLen = thisFrame.payload().count();
+
+    switch (column)
+    {
+    case Column::TimeStamp:            
+        //Reformatting the output a bit with custom code
+        if (overwriteDups)
         {
-        case Column::TimeStamp:            
-            //Reformatting the output a bit with custom code
-            if (overwriteDups)
-            {
-                if (timeStyle == TS_SECONDS) return QString::number(thisFrame.timedelta / 1000000.0, 'f', 5);
-                return QString::number(thisFrame.timedelta);
-            }
-            else ts = Utility::formatTimestamp(thisFrame.timeStamp().microSeconds());
-            if (ts.type() == QVariant::Double) return QString::number(ts.toDouble(), 'f', 5); //never scientific notation, 5 decimal places
-            if (ts.type() == QVariant::LongLong) return QString::number(ts.toLongLong()); //never scientific notion, all digits shown
-            if (ts.type() == QVariant::DateTime) return ts.toDateTime().toString(timeFormat); //custom set format for dates and times
-            return Utility::formatTimestamp(thisFrame.timeStamp().microSeconds());
-        case Column::FrameId:
-            return Utility::formatCANID(thisFrame.frameId(), thisFrame.hasExtendedFrameFormat());
-        case Column::Extended:
-            return QString::number(thisFrame.hasExtendedFrameFormat());
-        case Column::Remote:
-            if (!overwriteDups) return QString::number(thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame);
-            return QString::number(thisFrame.frameCount);
-        case Column::Direction:
-            if (thisFrame.isReceived) return QString(tr("Rx"));
-            return QString(tr("Tx"));
-        case Column::Bus:
-            return QString::number(thisFrame.bus);
-        case Column::Length:
-            return QString::number(dataLen);
-        case Column::ASCII:
-            if (thisFrame.frameId() >= 0x7FFFFFF0ull)
-            {
-                tempString.append("MARK ");
-                tempString.append(QString::number(thisFrame.frameId() & 0x7));
-                return tempString;
-            }
-            if (thisFrame.frameType() == QCanBusFrame::DataFrame) {
-                if (dataLen < 0) dataLen = 0;
-                //if (dLen > 8) dLen = 8;
-                for (int i = 0; i < dataLen; i++)
-                {
-                    char byt = thisFrame.payload()[i];
-                    //0x20 through 0x7E are printable characters. Outside of that range they aren't. So use dots instead
-                    if (byt < 0x20) byt = 0x2E; //dot character
-                    if (byt > 0x7E) byt = 0x2E;
-                    tempString.append(QString::fromUtf8(&byt, 1));
-                    if (!((i+1) % bytesPerLine) && (i != (dataLen - 1))) tempString.append("\n");
-                }
-            }
-            if (thisFrame.frameType() == QCanBusFrame::ErrorFrame)
-            {
-                 tempString = "ERROR";
-            }
+            if (timeStyle == TS_SECONDS) return QString::number(thisFrame.timedelta / 1000000.0, 'f', 5);
+            return QString::number(thisFrame.timedelta);
+        }
+        else ts = Utility::formatTimestamp(thisFrame.timeStamp().microSeconds());
+        if (ts.type() == QVariant::Double) return QString::number(ts.toDouble(), 'f', 5); //never scientific notation, 5 decimal places
+        if (ts.type() == QVariant::LongLong) return QString::number(ts.toLongLong()); //never scientific notion, all digits shown
+        if (ts.type() == QVariant::DateTime) return ts.toDateTime().toString(timeFormat); //custom set format for dates and times
+        return Utility::formatTimestamp(thisFrame.timeStamp().microSeconds());
+    case Column::FrameId:
+        return Utility::formatCANID(thisFrame.frameId(), thisFrame.hasExtendedFrameFormat());
+    case Column::Extended:
+        return QString::number(thisFrame.hasExtendedFrameFormat());
+    case Column::Remote:
+        if (!overwriteDups) return QString::number(thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame);
+        return QString::number(thisFrame.frameCount);
+    case Column::Direction:
+        if (thisFrame.isReceived) return QString(tr("Rx"));
+        return QString(tr("Tx"));
+    case Column::Bus:
+        return QString::number(thisFrame.bus);
+    case Column::Length:
+        return QString::number(dataLen);
+    case Column::ASCII:
+        if (thisFrame.frameId() >= 0x7FFFFFF0ull)
+        {
+            tempString.append("MARK ");
+            tempString.append(QString::number(thisFrame.frameId() & 0x7));
             return tempString;
-        case Column::Data:
+        }
+        if (thisFrame.frameType() == QCanBusFrame::DataFrame) {
             if (dataLen < 0) dataLen = 0;
-            //if (useHexMode) tempString.append("0x ");
-            if (thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame) {
-                return tempString;
-            }
+            //if (dLen > 8) dLen = 8;
             for (int i = 0; i < dataLen; i++)
             {
-                if (useHexMode) tempString.append( QString::number(data[i], 16).toUpper().rightJustified(2, '0'));
-                else tempString.append(QString::number(data[i], 10));
+                char byt = thisFrame.payload()[i];
+                //0x20 through 0x7E are printable characters. Outside of that range they aren't. So use dots instead
+                if (byt < 0x20) byt = 0x2E; //dot character
+                if (byt > 0x7E) byt = 0x2E;
+                tempString.append(QString::fromUtf8(&byt, 1));
                 if (!((i+1) % bytesPerLine) && (i != (dataLen - 1))) tempString.append("\n");
-                else tempString.append(" ");
-            }
-            if (thisFrame.frameType() == thisFrame.ErrorFrame)
-            {
-                if (thisFrame.error() & thisFrame.TransmissionTimeoutError) tempString.append("\nTX Timeout");
-                if (thisFrame.error() & thisFrame.LostArbitrationError) tempString.append("\nLost Arbitration");
-                if (thisFrame.error() & thisFrame.ControllerError) tempString.append("\nController Error");
-                if (thisFrame.error() & thisFrame.ProtocolViolationError) tempString.append("\nProtocol Violation");
-                if (thisFrame.error() & thisFrame.TransceiverError) tempString.append("\nTransceiver Error");
-                if (thisFrame.error() & thisFrame.MissingAcknowledgmentError) tempString.append("\nMissing ACK");
-                if (thisFrame.error() & thisFrame.BusOffError) tempString.append("\nBus OFF");
-                if (thisFrame.error() & thisFrame.BusError) tempString.append("\nBus ERR");
-                if (thisFrame.error() & thisFrame.ControllerRestartError) tempString.append("\nController restart err");
-                if (thisFrame.error() & thisFrame.UnknownError) tempString.append("\nUnknown error type");
             }
-            //TODO: technically the actual returned bytes for an error frame encode some more info. Not interpreting it yet.
+        }
+        if (thisFrame.frameType() == QCanBusFrame::ErrorFrame)
+        {
+             tempString = "ERROR";
+        }
+        return tempString;
+    case Column::Data:
+        if (dataLen < 0) dataLen = 0;
+        //if (useHexMode) tempString.append("0x ");
+        if (thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame) {
+            return tempString;
+        }
+        for (int i = 0; i < dataLen; i++)
+        {
+            if (useHexMode) tempString.append( QString::number(data[i], 16).toUpper().rightJustified(2, '0'));
+            else tempString.append(QString::number(data[i], 10));
+            if (!((i+1) % bytesPerLine) && (i != (dataLen - 1))) tempString.append("\n");
+            else tempString.append(" ");
+        }
+        if (thisFrame.frameType() == thisFrame.ErrorFrame)
+        {
+            if (thisFrame.error() & thisFrame.TransmissionTimeoutError) tempString.append("\nTX Timeout");
+            if (thisFrame.error() & thisFrame.LostArbitrationError) tempString.append("\nLost Arbitration");
+            if (thisFrame.error() & thisFrame.ControllerError) tempString.append("\nController Error");
+            if (thisFrame.error() & thisFrame.ProtocolViolationError) tempString.append("\nProtocol Violation");
+            if (thisFrame.error() & thisFrame.TransceiverError) tempString.append("\nTransceiver Error");
+            if (thisFrame.error() & thisFrame.MissingAcknowledgmentError) tempString.append("\nMissing ACK");
+            if (thisFrame.error() & thisFrame.BusOffError) tempString.append("\nBus OFF");
+            if (thisFrame.error() & thisFrame.BusError) tempString.append("\nBus ERR");
+            if (thisFrame.error() & thisFrame.ControllerRestartError) tempString.append("\nController restart err");
+            if (thisFrame.error() & thisFrame.UnknownError) tempString.append("\nUnknown error type");
+        }
+        //TODO: technically the actual returned bytes for an error frame encode some more info. Not interpreting it yet.
 
-            //now, if we're supposed to interpret the data and the DBC handler is loaded then use it
-            if ( (dbcHandler != nullptr) && interpretFrames && (thisFrame.frameType() == thisFrame.DataFrame) )
+        //now, if we're supposed to interpret the data and the DBC handler is loaded then use it
+        if ( (dbcHandler != nullptr) && interpretFrames && (thisFrame.frameType() == thisFrame.DataFrame) )
+        {
+            DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
+            if (msg != nullptr)
             {
-                DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
-                if (msg != nullptr)
+                tempString.append("   <" + msg->name + ">\n");
+                if (msg->comment.length() > 1) tempString.append(msg->comment + "\n");
+                //one pass over the message's decode plan. Multiplexed signals come right after their multiplexor
+                QVector<DBC_SIGNAL_VALUE> decoded;
+                msg->decodeFrame(thisFrame, decoded);
+                for (int j = 0; j < decoded.count(); j++)
                 {
-                    tempString.append("   <" + msg->name + ">\n");
-                    if (msg->comment.length() > 1) tempString.append(msg->comment + "\n");
-                    for (int j = 0; j < msg->sigHandler->getCount(); j++)
-                    {                        
-                        QString sigString;
-                        DBC_SIGNAL* sig = msg->sigHandler->findSignalByIdx(j);
-
-                        if ( (sig->multiplexParent == nullptr) && sig->processAsText(thisFrame, sigString))
-                        {
-                            tempString.append(sigString);
-                            tempString.append("\n");
-                            if (sig->isMultiplexor)
-                            {
-                                qDebug() << "Multiplexor. Diving into the tree";
-                                tempString.append(sig->processSignalTree(thisFrame));
-                            }
-                        }
-                        else if (sig->isMultiplexed && overwriteDups) //wasn't in this exact frame but is in the message. Use cached value
-                        {
-                            bool isInteger = false;
-                            if (sig->valType == UNSIGNED_INT || sig->valType == SIGNED_INT) isInteger = true;
-                            tempString.append(sig->makePrettyOutput(sig->cachedValue.toDouble(), sig->cachedValue.toLongLong(), true, isInteger));
-                            tempString.append("\n");
-                        }
+                    const DBC_SIGNAL_VALUE &val = decoded.at(j);
+                    DBC_SIGNAL* sig = val.sig;
+
+                    if (val.present)
+                    {
+                        tempString.append(val.text());
+                        tempString.append("\n");
+                    }
+                    else if (sig->isMultiplexed && overwriteDups) //wasn't in this exact frame but is in the message. Use cached value
+                    {
+                        bool isInteger = false;
+                        if (sig->valType == UNSIGNED_INT || sig->valType == SIGNED_INT) isInteger = true;
+                        tempString.append(sig->makePrettyOutput(sig->cachedValue.toDouble(), sig->cachedValue.toLongLong(), true, isInteger));
+                        tempString.append("\n");
                     }
                 }
             }
-            return tempString;
-        default:
-            return tempString;
         }
+        return tempString;
+    default:
+        return tempString;
     }
 
     return QVariant();
@@ -641,8 +847,9 @@ QVariant CANFrameModel::headerData(int section, Qt::Orientation orientation,
         }
     }
 
-    else
-        return QString::number(section + 1);
+    //number rows by their place in the capture so they keep their number as the oldest rows are dropped
+    else if (pagedSource) return QString::number(section + 1);
+    else return QString::number(filteredFrames.evictedCount() + static_cast<quint64>(section) + 1);
 
     return QVariant();
 }
@@ -671,39 +878,99 @@ bool CANFrameModel::any_busfilters_are_configured(void)
     return false;
 }
 
+/*
+ * The filters and busFilters maps are what the rest of the program sees but looking things up in a QMap
+ * for every incoming frame is slow. Ingest instead goes through a hash of ID states, a flat array of bus
+ * states and cached "any filter configured" bits. Anything that edits the maps directly just sets
+ * filterCacheDirty and the cache gets rebuilt the next time it's needed.
+*/
+void CANFrameModel::rebuildFilterCache()
+{
+    filterLookup.clear();
+    filterLookup.reserve(filters.count());
+    for (QMap<int, bool>::const_iterator it = filters.constBegin(); it != filters.constEnd(); ++it)
+    {
+        filterLookup.insert(static_cast<uint32_t>(it.key()), it.value());
+    }
 
-void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
+    busFilterLookup.fill(-1, 256);
+    for (QMap<int, bool>::const_iterator it = busFilters.constBegin(); it != busFilters.constEnd(); ++it)
+    {
+        if (it.key() >= 0 && it.key() < busFilterLookup.count()) busFilterLookup[it.key()] = it.value() ? 1 : 0;
+    }
+
+    filtersConfigured = any_filters_are_configured();
+    busFiltersConfigured = any_busfilters_are_configured();
+    filterCacheDirty = false;
+}
+
+//Same result as filters[id] && busFilters[bus] including the side effect of unknown entries getting added as hidden
+bool CANFrameModel::frameIsShown(uint32_t id, int bus)
 {
-    /*TODO: remove mutex */
-    mutex.lock();
-    CANFrame tempFrame;
-    tempFrame = frame;
+    if (filterCacheDirty) rebuildFilterCache();
 
-    tempFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, tempFrame.timeStamp().microSeconds() - timeOffset));
+    QHash<uint32_t, bool>::const_iterator it = filterLookup.constFind(id);
+    if (it == filterLookup.constEnd())
+    {
+        filters.insert(static_cast<int>(id), false);
+        filterLookup.insert(id, false);
+        return false;
+    }
+    if (!it.value()) return false;
 
-    lastUpdateNumFrames++;
+    if (bus < 0 || bus >= busFilterLookup.count()) return busFilters[bus];
+    if (busFilterLookup[bus] < 0)
+    {
+        busFilters.insert(bus, false);
+        busFilterLookup[bus] = 0;
+    }
+    return busFilterLookup[bus] == 1;
+}
 
-    //if this ID isn't found in the filters list then add it and show it by default
-    if (!filters.contains(tempFrame.frameId()))
+//register a newly seen ID and bus with the filter lists. Shown by default unless the user has already hidden something
+void CANFrameModel::learnFilters(uint32_t id, int bus)
+{
+    if (filterCacheDirty) rebuildFilterCache();
+
+    if (!filterLookup.contains(id))
     {
         // if there are any filters already configured, leave the new filter disabled
-        if (any_filters_are_configured())
-            filters.insert(tempFrame.frameId(), false);
-        else
-            filters.insert(tempFrame.frameId(), true);
+        filters.insert(static_cast<int>(id), !filtersConfigured);
+        filterLookup.insert(id, !filtersConfigured);
         needFilterRefresh = true;
     }
 
-    //if this BusID isn't found in the busFilters list then add it and show it by default
-    if (!busFilters.contains(tempFrame.bus))
+    bool knownBus;
+    if (bus >= 0 && bus < busFilterLookup.count()) knownBus = (busFilterLookup[bus] >= 0);
+    else knownBus = busFilters.contains(bus);
+    if (!knownBus)
     {
         // if there are any busFilters already configured, leave the new filter disabled
-        if (any_busfilters_are_configured())
-            busFilters.insert(tempFrame.bus, false);
-        else
-            busFilters.insert(tempFrame.bus, true);
+        busFilters.insert(bus, !busFiltersConfigured);
+        if (bus >= 0 && bus < busFilterLookup.count()) busFilterLookup[bus] = busFiltersConfigured ? 0 : 1;
         needFilterRefresh = true;
     }
+}
+
+void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
+{
+    if (pagedSource) return;
+    mutex.lock();
+    addFrameLocked(frame, autoRefresh);
+    lastUpdateNumFrames++;
+    mutex.unlock();
+}
+
+//does the actual work of addFrame. The caller must already hold the mutex
+void CANFrameModel::addFrameLocked(const CANFrame& frame, bool autoRefresh)
+{
+    CANFrame tempFrame;
+    tempFrame = frame;
+
+    tempFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, tempFrame.timeStamp().microSeconds() - timeOffset));
+
+    learnFilters(tempFrame.frameId(), tempFrame.bus);
+    bool shown = frameIsShown(tempFrame.frameId(), tempFrame.bus);
 
     if (!overwriteDups)
     {
@@ -711,12 +978,18 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
         {
             frames.append(tempFrame);
 
-            if (filters[tempFrame.frameId()] && busFilters[tempFrame.bus])
+            if (shown)
             {
-                if (autoRefresh) beginInsertRows(QModelIndex(), filteredFrames.count(), filteredFrames.count());
+                makeRoomForFrames(1);
+                //any rows still waiting for the bulk refresh are announced along with this one
+                if (autoRefresh) beginInsertRows(QModelIndex(), rowCountAtLastRefresh, filteredFrames.count());
                 tempFrame.frameCount = 1;
                 filteredFrames.append(tempFrame);
-                if (autoRefresh) endInsertRows();
+                if (autoRefresh)
+                {
+                    rowCountAtLastRefresh = filteredFrames.count();
+                    endInsertRows();
+                }
             }
         }
         catch (const std::exception& ex)
@@ -726,93 +999,229 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
     }
     else //yes, overwrite dups
     {
-        bool found = false;
-//        for (int i = 0; i < frames.count(); i++)
-//        {
-//            if ( (frames[i].frameId() == tempFrame.frameId()) && (frames[i].bus == tempFrame.bus) )
-//            {
-//                tempFrame.frameCount = frames[i].frameCount + 1;
-//                tempFrame.timedelta = tempFrame.timeStamp().microSeconds() - frames[i].timeStamp().microSeconds();
-//                frames.replace(i, tempFrame);
-//                found = true;
-//                break;
-//            }
-//        }
-        for (int i = 0; i < filteredFrames.count(); i++)
+        uint64_t key = overwriteKey(tempFrame);
+        QHash<uint64_t, int>::const_iterator slot = overwriteIndex.constFind(key);
+        if (slot != overwriteIndex.constEnd())
         {
-            if ( (filteredFrames[i].frameId() == tempFrame.frameId()) && (filteredFrames[i].bus == tempFrame.bus) )
-            {
-                tempFrame.frameCount = filteredFrames[i].frameCount + 1;
-                tempFrame.timedelta = tempFrame.timeStamp().microSeconds() - filteredFrames[i].timeStamp().microSeconds();
-                filteredFrames.replace(i, tempFrame);
-                found = true;
-                break;
-            }
+            int i = slot.value();
+            CANFrame prevFrame = filteredFrames.at(i);
+            tempFrame.frameCount = prevFrame.frameCount + 1;
+            tempFrame.timedelta = tempFrame.timeStamp().microSeconds() - prevFrame.timeStamp().microSeconds();
+            filteredFrames.replace(i, tempFrame);
+            //the view is told about in-place replacements in one dataChanged range by sendBulkRefresh
+            if (overwriteDirtyFirst < 0 || i < overwriteDirtyFirst) overwriteDirtyFirst = i;
+            if (i > overwriteDirtyLast) overwriteDirtyLast = i;
+            frames.append(tempFrame);
         }
-        frames.append(tempFrame);
-        if (!found)
+        else
         {
-            //frames.append(tempFrame);
-            if (filters[tempFrame.frameId()] && busFilters[tempFrame.bus])
+            frames.append(tempFrame);
+            if (shown)
             {
-                if (autoRefresh) beginInsertRows(QModelIndex(), filteredFrames.count(), filteredFrames.count());
+                makeRoomForFrames(1);
+                if (autoRefresh) beginInsertRows(QModelIndex(), rowCountAtLastRefresh, filteredFrames.count());
                 tempFrame.frameCount = 1;
                 tempFrame.timedelta = 0;
+                overwriteIndex.insert(key, filteredFrames.count());
                 filteredFrames.append(tempFrame);
-                if (autoRefresh) endInsertRows();
-            }
-        }
-        else
-        {
-            for (int j = 0; j < filteredFrames.count(); j++)
-            {
-                if ( (filteredFrames[j].frameId() == tempFrame.frameId()) && (filteredFrames[j].bus == tempFrame.bus) )
+                if (autoRefresh)
                 {
-                    if (autoRefresh) beginResetModel();
-                    filteredFrames.replace(j, tempFrame);
-                    if (autoRefresh) endResetModel();
+                    rowCountAtLastRefresh = filteredFrames.count();
+                    endInsertRows();
                 }
             }
         }
     }
 
-    mutex.unlock();
 }
 
 
 void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFrames)
 {
-    if(frames.length() > frames.capacity() * 0.99)
+    if (pagedSource) return; //the view belongs to the paged file until it is cleared
+
+    //ring buffer stores recycle their oldest slots on their own so the trimming below doesn't apply
+    if(frames.ringCapacity() == 0 && frames.length() > preallocSize * 0.99)
     {
         mutex.lock();
-        qDebug() << "Frames count: " << frames.length() << " of " << frames.capacity() << " capacity, removing first " << (int)(frames.capacity() * 0.05) << " frames";
-        frames.remove(0, (int)(frames.capacity() * 0.05));
+        int numToTrim = (int)(preallocSize * 0.05);
+        qDebug() << "Frames count: " << frames.length() << " of " << preallocSize << " capacity, removing first " << numToTrim << " frames";
+        frames.remove(0, numToTrim);
         qDebug() << "Frames removed, new count: " << frames.length();
         mutex.unlock();
     }
 
-    if(filteredFrames.length() > filteredFrames.capacity() * 0.99)
+    if(filteredFrames.ringCapacity() == 0 && filteredFrames.length() > preallocSize * 0.99)
     {
         mutex.lock();
-        qDebug() << "filteredFrames count: " << filteredFrames.length() << " of " << filteredFrames.capacity() << " capacity, removing first " << (int)(filteredFrames.capacity() * 0.05) << " frames";
-        filteredFrames.remove(0, (int)(filteredFrames.capacity() * 0.05));
+        int numToRemove = (int)(preallocSize * 0.05);
+        qDebug() << "filteredFrames count: " << filteredFrames.length() << " of " << preallocSize << " capacity, removing first " << numToRemove << " frames";
+        dropOldestRows(numToRemove);
         qDebug() << "filteredFrames removed, new count: " << filteredFrames.length();
         mutex.unlock();
     }
 
-    foreach(const CANFrame& frame, pFrames)
+    //one lock and one reservation for the whole batch instead of per frame
+    mutex.lock();
+    trimToMemoryCeiling();
+    if (frames.count() + pFrames.count() > frames.capacity()) frames.reserve(frames.count() + pFrames.count());
+    makeRoomForFrames(countNewRows(pFrames));
+    for (int i = 0; i < pFrames.count(); i++)
+    {
+        addFrameLocked(pFrames.at(i), false);
+    }
+    lastUpdateNumFrames += pFrames.count();
+    mutex.unlock();
+}
+
+/*
+ * How many of these frames will end up as new rows in filteredFrames. Frames hidden by the ID or
+ * bus filters and, in overwrite mode, frames that replace an existing row don't need any room.
+ * Only worked out when a full ring is about to evict rows. Expects the mutex to be held.
+ */
+int CANFrameModel::countNewRows(const QVector<CANFrame> &pFrames)
+{
+    int ringCapacity = filteredFrames.ringCapacity();
+    if (ringCapacity == 0 || filteredFrames.count() + pFrames.count() <= ringCapacity) return 0;
+
+    int newRows = 0;
+    QSet<uint64_t> newKeys;
+    for (int i = 0; i < pFrames.count(); i++)
+    {
+        const CANFrame &frame = pFrames.at(i);
+        learnFilters(frame.frameId(), frame.bus);
+        if (!frameIsShown(frame.frameId(), frame.bus)) continue;
+        if (overwriteDups)
+        {
+            uint64_t key = overwriteKey(frame);
+            if (overwriteIndex.contains(key) || newKeys.contains(key)) continue;
+            newKeys.insert(key);
+        }
+        newRows++;
+    }
+    return newRows;
+}
+
+/*
+ * In ring buffer mode, drop enough of the oldest filtered rows that the next 'incoming' frames fit.
+ * Letting the store evict on its own would shift every row out from under the view without it
+ * being told, so the eviction is done here where the removal can be announced first. Expects the
+ * mutex to be held.
+ */
+void CANFrameModel::makeRoomForFrames(int incoming)
+{
+    int ringCapacity = filteredFrames.ringCapacity();
+    if (ringCapacity == 0) return;
+    int numToRemove = filteredFrames.count() + incoming - ringCapacity;
+    if (numToRemove <= 0) return;
+    //once rows are sorted finding the oldest takes a pass over all of them, so take 5% while at it
+    if (!rowsInAgeOrder) numToRemove = std::max(numToRemove, ringCapacity / 20);
+    dropOldestRows(numToRemove);
+}
+
+/*
+ * Remove the oldest numToRemove filtered rows, telling the view about the ones it already shows.
+ * Anything past rowCountAtLastRefresh is still pending and gets inserted on the next bulk refresh.
+ * Expects the mutex to be held.
+ */
+void CANFrameModel::dropOldestRows(int numToRemove)
+{
+    if (!rowsInAgeOrder)
     {
-        addFrame(frame);
+        evictOldestByTime(numToRemove);
+        return;
     }
-    if (overwriteDups) //if in overwrite mode we'll update every time frames come in
+    if (numToRemove > filteredFrames.count()) numToRemove = filteredFrames.count();
+    if (numToRemove <= 0) return;
+
+    int numVisibleRemoved = std::min(numToRemove, rowCountAtLastRefresh);
+    if (numVisibleRemoved > 0) beginRemoveRows(QModelIndex(), 0, numVisibleRemoved - 1);
+    filteredFrames.remove(0, numToRemove);
+    rowLayoutGeneration++;
+    rowCountAtLastRefresh -= numVisibleRemoved;
+    if (overwriteDups)
     {
-        beginResetModel();
-        endResetModel();
+        rebuildOverwriteIndex();
+        //rows replaced in place since the last refresh have moved up along with everything else
+        if (overwriteDirtyLast >= numToRemove)
+        {
+            overwriteDirtyFirst = std::max(overwriteDirtyFirst - numToRemove, 0);
+            overwriteDirtyLast -= numToRemove;
+        }
+        else
+        {
+            overwriteDirtyFirst = -1;
+            overwriteDirtyLast = -1;
+        }
+    }
+    if (numVisibleRemoved > 0) endRemoveRows();
+}
+
+/*
+ * Hold the capture to Main/CaptureMemoryMB by what the stores really take up. The frame limit
+ * already leaves room for the records and overwrite stats, but FD payloads come on top of that and
+ * would otherwise run well past the ceiling. Drops the oldest 5% at a time until both stores fit.
+ * Checked once per batch so a batch can overshoot by its own size. Expects the mutex to be held.
+ */
+void CANFrameModel::trimToMemoryCeiling()
+{
+    if (captureMemoryBytes == 0) return;
+    quint64 used = frames.bytesUsed() + filteredFrames.bytesUsed();
+    while (used > captureMemoryBytes)
+    {
+        qDebug() << "Capture holds" << used << "bytes, over the" << captureMemoryBytes << "byte ceiling. Removing the oldest 5%";
+        if (!frames.isEmpty()) frames.remove(0, std::max(frames.count() / 20, 1));
+        if (!filteredFrames.isEmpty()) dropOldestRows(std::max(filteredFrames.count() / 20, 1));
+        quint64 nowUsed = frames.bytesUsed() + filteredFrames.bytesUsed();
+        if (nowUsed >= used) break; //nothing left that removing frames frees
+        used = nowUsed;
     }
 }
 
+/*
+ * Once rows are sorted the first ones aren't the oldest frames, so drop the numToRemove rows with the
+ * oldest time stamps instead and keep the rest in their sorted order. The rows removed are spread
+ * all over the view so it gets a reset. Expects the mutex to be held.
+ */
+void CANFrameModel::evictOldestByTime(int numToRemove)
+{
+    int count = filteredFrames.count();
+    if (numToRemove > count) numToRemove = count;
+    if (numToRemove <= 0) return;
+
+    QVector<int64_t> stamps(count);
+    for (int i = 0; i < count; i++) stamps[i] = filteredFrames.timeStampAt(i);
+    std::nth_element(stamps.begin(), stamps.begin() + (numToRemove - 1), stamps.end());
+    int64_t cutoff = stamps.at(numToRemove - 1);
+    //frames stamped exactly at the cutoff only go until numToRemove is reached
+    int atCutoff = numToRemove;
+    for (int i = 0; i < numToRemove; i++) if (stamps.at(i) < cutoff) atCutoff--;
+
+    beginResetModel();
+    CANFrameStore kept;
+    kept.setRingCapacity(filteredFrames.ringCapacity());
+    kept.reserve(std::max(count, static_cast<int>(preallocSize)));
+    for (int i = 0; i < count; i++)
+    {
+        int64_t stamp = filteredFrames.timeStampAt(i);
+        if (stamp < cutoff) continue;
+        if (stamp == cutoff && atCutoff > 0)
+        {
+            atCutoff--;
+            continue;
+        }
+        kept.append(filteredFrames, i);
+    }
+    kept.setEvictedCount(filteredFrames.evictedCount() + static_cast<quint64>(numToRemove));
+    filteredFrames = kept;
+    rebuildOverwriteIndex();
+    rowCountAtLastRefresh = filteredFrames.count();
+    endResetModel();
+}
+
 void CANFrameModel::sendRefresh()
 {
+    if (pagedSource) return;
     qDebug() << "Sending mass refresh";    
 
     if(overwriteDups)
@@ -821,22 +1230,24 @@ void CANFrameModel::sendRefresh()
     }
     else
     {
-        QVector<CANFrame> tempContainer;
+        CANFrameStore tempContainer;
+        tempContainer.setRingCapacity(filteredFrames.ringCapacity());
+        tempContainer.reserve(preallocSize);
         int count = frames.count();
         for (int i = 0; i < count; i++)
         {
-            if (filters[frames[i].frameId()] && busFilters[frames[i].bus])
+            if (frameIsShown(frames.frameIdAt(i), frames.busAt(i)))
             {
-                tempContainer.append(frames[i]);
+                tempContainer.append(frames, i);
             }
         }
 
         mutex.lock();
         beginResetModel();
-        filteredFrames.clear();
-        filteredFrames.append(tempContainer);
-        filteredFrames.reserve(preallocSize);
+        filteredFrames = tempContainer;
+        rowsInAgeOrder = true;
         lastUpdateNumFrames = 0;
+        rowCountAtLastRefresh = filteredFrames.count();
         endResetModel();
         mutex.unlock();
     }
@@ -853,6 +1264,20 @@ void CANFrameModel::sendRefresh(int pos)
 //have to send thousands of messages per second
 int CANFrameModel::sendBulkRefresh()
 {
+    if (pagedSource)
+    {
+        //rows show up as the background indexer works through the file. They aren't newly
+        //received frames so nobody else gets told about them
+        int rows = pagedSource->frameCount();
+        if (rows > rowCountAtLastRefresh)
+        {
+            beginInsertRows(QModelIndex(), rowCountAtLastRefresh, rows - 1);
+            rowCountAtLastRefresh = rows;
+            endInsertRows();
+        }
+        return 0;
+    }
+
     //int num = filteredFrames.count() - lastUpdateNumFrames;
     if (lastUpdateNumFrames <= 0) return 0;
 
@@ -861,10 +1286,39 @@ int CANFrameModel::sendBulkRefresh()
 
     //qDebug() << "Bulk refresh of " << lastUpdateNumFrames;
 
-    beginResetModel();
-    endResetModel();
+    mutex.lock();
+    int rows = filteredFrames.count();
+    if (rows > rowCountAtLastRefresh)
+    {
+        //the common case, frames were only appended. Tell the view about just the new range
+        //so it can keep its layout and selection.
+        beginInsertRows(QModelIndex(), rowCountAtLastRefresh, rows - 1);
+        rowCountAtLastRefresh = rows;
+        endInsertRows();
+    }
+    else if (rows < rowCountAtLastRefresh)
+    {
+        //rows went away without going through one of the paths that notify the view. Can't
+        //know what changed so fall back to a full reset.
+        beginResetModel();
+        rowCountAtLastRefresh = rows;
+        overwriteDirtyFirst = -1;
+        overwriteDirtyLast = -1;
+        endResetModel();
+    }
+
+    //In overwrite mode most traffic just replaces existing rows in place. A single dataChanged
+    //over the touched rows is enough for those.
+    if (overwriteDirtyFirst >= 0)
+    {
+        emit dataChanged(index(overwriteDirtyFirst, 0), index(overwriteDirtyLast, columnCount(QModelIndex()) - 1));
+    }
+    overwriteDirtyFirst = -1;
+    overwriteDirtyLast = -1;
+    mutex.unlock();
 
-    int num = lastUpdateNumFrames;
+    //a ring can wrap between refreshes. Only report the new frames that are still there to be read
+    int num = std::min(lastUpdateNumFrames, frames.count());
     lastUpdateNumFrames = 0;
 
     return num;
@@ -874,6 +1328,8 @@ void CANFrameModel::clearFrames()
 {
     mutex.lock();
     this->beginResetModel();
+    delete pagedSource;
+    pagedSource = nullptr;
     frames.clear();
     filteredFrames.clear();
     if(filtersPersistDuringClear == false)
@@ -881,8 +1337,12 @@ void CANFrameModel::clearFrames()
         filters.clear();
         busFilters.clear();
     }
+    filterCacheDirty = true;
     frames.reserve(preallocSize);
     filteredFrames.reserve(preallocSize);
+    rowsInAgeOrder = true;
+    rebuildOverwriteIndex();
+    rowCountAtLastRefresh = 0;
     this->endResetModel();
     lastUpdateNumFrames = 0;
     mutex.unlock();
@@ -890,6 +1350,24 @@ void CANFrameModel::clearFrames()
     emit updatedFiltersList();
 }
 
+void CANFrameModel::setPagedSource(CapturePager *pager)
+{
+    mutex.lock();
+    beginResetModel();
+    delete pagedSource;
+    pagedSource = pager;
+    frames.clear();
+    filteredFrames.clear();
+    frames.reserve(preallocSize);
+    filteredFrames.reserve(preallocSize);
+    rowsInAgeOrder = true;
+    rebuildOverwriteIndex();
+    lastUpdateNumFrames = 0;
+    rowCountAtLastRefresh = pager ? pager->frameCount() : 0;
+    endResetModel();
+    mutex.unlock();
+}
+
 /*
  * Since the getListReference function returns readonly
  * you can't insert frames with it. Instead this function
@@ -902,10 +1380,11 @@ void CANFrameModel::insertFrames(const QVector<CANFrame> &newFrames)
     //double the number of frames.
     //beginResetModel();
     mutex.lock();
+    //learn the filters first so a ring knows how many rows to make room for. Leaving the eviction
+    //to the store would drop rows the view already shows without telling it
     int insertedFiltered = 0;
     for (int i = 0; i < newFrames.count(); i++)
     {
-        frames.append(newFrames[i]);
         if (!filters.contains(newFrames[i].frameId()))
         {
             filters.insert(newFrames[i].frameId(), true);
@@ -916,13 +1395,17 @@ void CANFrameModel::insertFrames(const QVector<CANFrame> &newFrames)
             busFilters.insert(newFrames[i].bus, true);
             needFilterRefresh = true;
         }
-        if (filters[newFrames[i].frameId()] && busFilters[newFrames[i].bus])
-        {
-            insertedFiltered++;
-            filteredFrames.append(newFrames[i]);
-        }
+        if (filters[newFrames[i].frameId()] && busFilters[newFrames[i].bus]) insertedFiltered++;
+    }
+    trimToMemoryCeiling();
+    makeRoomForFrames(insertedFiltered);
+    for (int i = 0; i < newFrames.count(); i++)
+    {
+        frames.append(newFrames[i]);
+        if (filters[newFrames[i].frameId()] && busFilters[newFrames[i].bus]) filteredFrames.append(newFrames[i]);
     }
     lastUpdateNumFrames = newFrames.count();
+    filterCacheDirty = true;
     mutex.unlock();
     //endResetModel();
     //beginInsertRows(QModelIndex(), filteredFrames.count() + 1, filteredFrames.count() + insertedFiltered);
@@ -936,9 +1419,9 @@ int CANFrameModel::getIndexFromTimeID(unsigned int ID, double timestamp)
     int64_t intTimeStamp = static_cast<int64_t> (timestamp * 1000000l);
     for (int i = 0; i < frames.count(); i++)
     {
-        if ((frames[i].frameId() == ID))
+        if ((frames.frameIdAt(i) == ID))
         {
-            if (frames[i].timeStamp().microSeconds() <= intTimeStamp) bestIndex = i;
+            if (frames.timeStampAt(i) <= intTimeStamp) bestIndex = i;
             else break; //drop out of loop as soon as we pass the proper timestamp
         }
     }
@@ -956,6 +1439,7 @@ void CANFrameModel::loadFilterFile(QString filename)
 
     filters.clear();
     busFilters.clear();
+    filterCacheDirty = true;
 
     while (!inFile->atEnd()) {
         line = inFile->readLine().simplified();
@@ -1007,12 +1491,12 @@ bool CANFrameModel::needsFilterRefresh()
  * external code that needs to access frames directly and doesn't care about
  * this model's normal output mechanism.
  */
-const QVector<CANFrame>* CANFrameModel::getListReference() const
+const CANFrameStore* CANFrameModel::getListReference() const
 {
     return &frames;
 }
 
-const QVector<CANFrame>* CANFrameModel::getFilteredListReference() const
+const CANFrameStore* CANFrameModel::getFilteredListReference() const
 {
     return &filteredFrames;
 }
@@ -4,13 +4,18 @@
 #include <QAbstractTableModel>
 #include <QList>
 #include <QVector>
+#include <QHash>
 #include <QDebug>
 #include <QMutex>
+#include <QCache>
 #include "can_structs.h"
+#include "canframestore.h"
 #include "dbc/dbchandler.h"
 #include "connections/canconnection.h"
 #include "utility.h"
 
+class CapturePager;
+
 enum class Column {
     TimeStamp = 0, ///< The timestamp when the frame was transmitted or received
     FrameId   = 1, ///< The frames CAN identifier (Standard: 11 or Extended: 29 bit)
@@ -62,31 +67,71 @@ public:
     void recalcOverwrite();
     bool needsFilterRefresh();
     void insertFrames(const QVector<CANFrame> &newFrames);
+    //Show a huge capture file a page at a time instead of the frames in memory. The model takes
+    //ownership and frees it on the next clearFrames. Filters, sorting and overwrite mode don't apply
+    //to a paged file and live frames aren't added to it.
+    void setPagedSource(CapturePager *pager);
+    CapturePager *getPagedSource() const { return pagedSource; }
     void sortByColumn(int column);
     int getIndexFromTimeID(unsigned int ID, double timestamp);
-    const QVector<CANFrame> *getListReference() const; //thou shalt not modify these frames externally!
-    const QVector<CANFrame> *getFilteredListReference() const; //Thus saith the Lord, NO.
+    const CANFrameStore *getListReference() const; //thou shalt not modify these frames externally!
+    const CANFrameStore *getFilteredListReference() const; //Thus saith the Lord, NO.
     const QMap<int, bool> *getFiltersReference() const; //this neither
     const QMap<int, bool> *getBusFiltersReference() const; //this neither
+    void getRowCacheStats(quint64 &hits, quint64 &misses, int &entries) const;
+    void readCaptureSettings();
+    void setCaptureLimits(uint32_t maxFrames, bool ringBuffer, quint64 memoryBytes = 0); //memoryBytes 0 for no ceiling
+    bool captureLimitsDropFrames(int maxFrames, int captureMemoryMB);
+    quint64 getTrimmedFrames() const; //captured frames thrown away to stay under the frame limit since the last clear
 
 public slots:
     void addFrame(const CANFrame&, bool);
     void addFrames(const CANConnection*, const QVector<CANFrame>&);
+    void invalidateRowCache();
+
+private slots:
+    void rowsRearranged();
 
 signals:
     void updatedFiltersList();
 
 private:
-    void qSortCANFrameAsc(QVector<CANFrame>* frames, Column column, int lowerBound, int upperBound);
-    void qSortCANFrameDesc(QVector<CANFrame>* frames, Column column, int lowerBound, int upperBound);
-    uint64_t getCANFrameVal(QVector<CANFrame> *frames, int row, Column col);
+    static uint64_t sortKeyAt(const CANFrameStore &store, int row, Column col, bool overwriteMode);
     bool any_filters_are_configured(void);
     bool any_busfilters_are_configured(void);
+    void rebuildFilterCache();
+    bool frameIsShown(uint32_t id, int bus);
+    void learnFilters(uint32_t id, int bus);
+    void addFrameLocked(const CANFrame &frame, bool autoRefresh);
+    static uint64_t overwriteKey(const CANFrame &frame);
+    static uint64_t overwriteKey(const CANFrameStore &store, int idx);
+    void rebuildOverwriteIndex();
+    int countNewRows(const QVector<CANFrame> &pFrames);
+    void makeRoomForFrames(int incoming);
+    void dropOldestRows(int numToRemove);
+    void trimToMemoryCeiling();
+    void evictOldestByTime(int numToRemove);
+    QVariant formatCell(const CANFrame &thisFrame, Column column) const;
 
-    QVector<CANFrame> frames;
-    QVector<CANFrame> filteredFrames;
+    CANFrameStore frames;
+    CANFrameStore filteredFrames;
+    CapturePager *pagedSource; //not null while a huge file is shown straight from disk
     QMap<int, bool> filters;
     QMap<int, bool> busFilters;
+    QHash<uint32_t, bool> filterLookup; //fast mirror of filters used during ingest
+    QVector<int8_t> busFilterLookup; //fast mirror of busFilters. -1 = unknown bus, 0 = hidden, 1 = shown
+    bool filterCacheDirty;
+    bool filtersConfigured; //cached any_filters_are_configured()
+    bool busFiltersConfigured;
+    QHash<uint64_t, int> overwriteIndex; //(bus, ID) -> row in filteredFrames. Only maintained in overwrite mode
+    int overwriteDirtyFirst; //range of rows replaced in place since the last bulk refresh
+    int overwriteDirtyLast;
+    mutable QCache<quint64, QVariant> rowCache; //(row << 8 | column) -> formatted display text, least recently used dropped first
+    mutable quint64 rowCacheHits;
+    mutable quint64 rowCacheMisses;
+    mutable int rowCacheDbcGeneration; //DBCMessageHandler::lookupGeneration() the cached text was decoded against
+    int rowLayoutGeneration; //bumped whenever rows are removed or reordered. Lets a long sort notice it went stale
+    bool rowsInAgeOrder; //false once filteredFrames is sorted or rebuilt out of arrival order, until the next refresh
     DBCHandler *dbcHandler;
     QMutex mutex;
     bool interpretFrames; //should we use the dbcHandler?
@@ -100,7 +145,9 @@ private:
     bool ignoreDBCColors;
     int64_t timeOffset;
     int lastUpdateNumFrames;
+    int rowCountAtLastRefresh; //filteredFrames.count() as of the last time the view was brought up to date
     uint32_t preallocSize;
+    quint64 captureMemoryBytes; //Main/CaptureMemoryMB, what both stores may take up together. 0 = no ceiling
     bool sortDirAsc;
     int bytesPerLine;
 };
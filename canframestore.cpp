@@ -0,0 +1,299 @@
+#include "canframestore.h"
+
+#include <cstring>
+#include <algorithm>
+
+CANFrameStore::CANFrameStore()
+{
+    hasStats = false;
+    ringSize = 0;
+    head = 0;
+    used = 0;
+    evicted = 0;
+}
+
+CANFrameStore::CANFrameStore(const QVector<CANFrame> &frames)
+{
+    hasStats = false;
+    ringSize = 0;
+    head = 0;
+    used = 0;
+    evicted = 0;
+    append(frames);
+}
+
+void CANFrameStore::pack(const CANFrame &frame, PackedCANFrame &rec)
+{
+    const QByteArray payload = frame.payload();
+    int len = payload.length();
+    if (len > 64) len = 64;
+
+    rec.timeStamp = frame.timeStamp().seconds() * 1000000ll + frame.timeStamp().microSeconds();
+    rec.frameId = frame.frameId();
+    rec.bus = static_cast<uint32_t>(frame.bus);
+    rec.length = static_cast<uint32_t>(len);
+    rec.frameType = static_cast<uint32_t>(frame.frameType());
+    rec.extended = frame.hasExtendedFrameFormat();
+    rec.received = frame.isReceived;
+    rec.fd = frame.hasFlexibleDataRateFormat();
+    rec.brs = frame.hasBitrateSwitch();
+    rec.esi = frame.hasErrorStateIndicator();
+    rec.localEcho = frame.hasLocalEcho();
+    rec.reserved = 0;
+
+    if (len <= 8)
+    {
+        memset(rec.payload.data, 0, 8);
+        memcpy(rec.payload.data, payload.constData(), static_cast<size_t>(len));
+    }
+    else
+    {
+        int slab = allocateSlab();
+        memcpy(fdSlabs[slab].data, payload.constData(), static_cast<size_t>(len));
+        rec.payload.slab = static_cast<uint32_t>(slab);
+    }
+}
+
+CANFrame CANFrameStore::at(int idx) const
+{
+    int phys = physical(idx);
+    const PackedCANFrame &rec = records.at(phys);
+    CANFrame frame;
+
+    frame.setFrameId(rec.frameId);
+    frame.setFrameType(static_cast<QCanBusFrame::FrameType>(rec.frameType));
+    frame.setExtendedFrameFormat(rec.extended);
+    frame.setFlexibleDataRateFormat(rec.fd);
+    frame.setBitrateSwitch(rec.brs);
+    frame.setErrorStateIndicator(rec.esi);
+    frame.setLocalEcho(rec.localEcho);
+    frame.setPayload(QByteArray(reinterpret_cast<const char *>(payloadAt(idx)), static_cast<int>(rec.length)));
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, rec.timeStamp));
+    frame.bus = static_cast<int>(rec.bus);
+    frame.isReceived = rec.received;
+    if (hasStats)
+    {
+        frame.timedelta = stats.at(phys).timedelta;
+        frame.frameCount = stats.at(phys).frameCount;
+    }
+    return frame;
+}
+
+const uint8_t *CANFrameStore::payloadAt(int idx) const
+{
+    const PackedCANFrame &rec = records.at(physical(idx));
+    if (rec.length <= 8) return rec.payload.data;
+    return fdSlabs.at(static_cast<int>(rec.payload.slab)).data;
+}
+
+/*
+ * Find the physical slot the next appended frame goes into. In ring mode a full store hands back
+ * the slot of the oldest frame, which is thereby evicted in O(1).
+ */
+int CANFrameStore::nextSlot()
+{
+    int n = records.count();
+    if (ringSize == 0 || (head == 0 && used == n && n < ringSize))
+    {
+        records.append(PackedCANFrame());
+        if (hasStats) stats.append(OverwriteStats{0, 1});
+        used++;
+        return n;
+    }
+
+    if (used < n) //space left over from an earlier remove()
+    {
+        int slot = (head + used) % n;
+        used++;
+        return slot;
+    }
+
+    if (n < ringSize) //not full yet but wrapped around. Straighten things out and grow normally
+    {
+        linearize();
+        return nextSlot();
+    }
+
+    //full ring, overwrite the oldest frame
+    int slot = head;
+    releaseSlab(records.at(slot));
+    head = (head + 1) % n;
+    evicted++;
+    return slot;
+}
+
+void CANFrameStore::append(const CANFrame &frame)
+{
+    int slot = nextSlot();
+    pack(frame, records[slot]);
+    storeStats(slot, frame.timedelta, frame.frameCount);
+}
+
+void CANFrameStore::append(const QVector<CANFrame> &frames)
+{
+    if (ringSize == 0)
+    {
+        int needed = records.count() + frames.count();
+        if (needed > records.capacity()) records.reserve(qMax(needed, records.capacity() * 2));
+    }
+    for (int i = 0; i < frames.count(); i++) append(frames.at(i));
+}
+
+void CANFrameStore::append(const CANFrameStore &other, int idx)
+{
+    int otherPhys = other.physical(idx);
+    PackedCANFrame rec = other.records.at(otherPhys);
+    int slot = nextSlot();
+    if (rec.length > 8)
+    {
+        int slab = allocateSlab();
+        fdSlabs[slab] = other.fdSlabs.at(static_cast<int>(rec.payload.slab));
+        rec.payload.slab = static_cast<uint32_t>(slab);
+    }
+    records[slot] = rec;
+    if (other.hasStats) storeStats(slot, other.stats.at(otherPhys).timedelta, other.stats.at(otherPhys).frameCount);
+    else storeStats(slot, 0, 1);
+}
+
+void CANFrameStore::replace(int idx, const CANFrame &frame)
+{
+    int phys = physical(idx);
+    releaseSlab(records.at(phys));
+    pack(frame, records[phys]);
+    storeStats(phys, frame.timedelta, frame.frameCount);
+}
+
+//the side array only comes into existence the first time a frame carries non-default values
+void CANFrameStore::storeStats(int phys, uint64_t timedelta, uint32_t frameCount)
+{
+    if (!hasStats)
+    {
+        if (timedelta == 0 && frameCount == 1) return;
+        stats.fill(OverwriteStats{0, 1}, records.count());
+        hasStats = true;
+    }
+    stats[phys].timedelta = timedelta;
+    stats[phys].frameCount = frameCount;
+}
+
+void CANFrameStore::remove(int idx, int num)
+{
+    if (idx + num > used) num = used - idx;
+    if (num <= 0) return;
+    if (idx == 0) evicted += static_cast<quint64>(num);
+
+    if (ringSize > 0 && idx == 0)
+    {
+        //dropping the oldest frames of a ring is just moving the head forward
+        for (int i = 0; i < num; i++) releaseSlab(records.at(physical(i)));
+        head = (head + num) % records.count();
+        used -= num;
+        if (used == 0) head = 0;
+        return;
+    }
+
+    linearize();
+    records.remove(idx, num);
+    if (hasStats) stats.remove(idx, num);
+    used = records.count();
+    if (!fdSlabs.isEmpty()) compactSlabs();
+}
+
+void CANFrameStore::clear()
+{
+    records.clear();
+    fdSlabs.clear();
+    freeSlabs.clear();
+    stats.clear();
+    hasStats = false;
+    head = 0;
+    used = 0;
+    evicted = 0;
+}
+
+void CANFrameStore::reserve(int num)
+{
+    if (ringSize > 0 && num > ringSize) num = ringSize;
+    records.reserve(num);
+}
+
+int CANFrameStore::capacity() const
+{
+    if (ringSize > 0) return ringSize;
+    return records.capacity();
+}
+
+/*
+ * Turn the store into a ring holding at most maxFrames frames, or back into a plain growable
+ * list when maxFrames is 0. Shrinking below the current count drops the oldest frames.
+ */
+void CANFrameStore::setRingCapacity(int maxFrames)
+{
+    if (maxFrames < 0) maxFrames = 0;
+    linearize();
+    ringSize = 0; //so the remove below really shrinks the records instead of just moving the head
+    if (maxFrames > 0 && used > maxFrames) remove(0, used - maxFrames);
+    ringSize = maxFrames;
+    if (ringSize > 0) records.reserve(ringSize);
+}
+
+QVector<CANFrame> CANFrameStore::toVector() const
+{
+    QVector<CANFrame> out;
+    out.reserve(used);
+    for (int i = 0; i < used; i++) out.append(at(i));
+    return out;
+}
+
+quint64 CANFrameStore::bytesUsed() const
+{
+    return static_cast<quint64>(records.count()) * sizeof(PackedCANFrame)
+         + static_cast<quint64>(fdSlabs.count() - freeSlabs.count()) * sizeof(CANFDPayloadSlab)
+         + static_cast<quint64>(stats.count()) * sizeof(OverwriteStats);
+}
+
+int CANFrameStore::allocateSlab()
+{
+    if (!freeSlabs.isEmpty())
+    {
+        int slab = freeSlabs.last();
+        freeSlabs.removeLast();
+        return slab;
+    }
+    fdSlabs.append(CANFDPayloadSlab());
+    return fdSlabs.count() - 1;
+}
+
+void CANFrameStore::releaseSlab(const PackedCANFrame &rec)
+{
+    if (rec.length > 8) freeSlabs.append(static_cast<int>(rec.payload.slab));
+}
+
+//rotate the ring so that logical index 0 sits at physical index 0 and drop any unused slots
+void CANFrameStore::linearize()
+{
+    if (head == 0 && used == records.count()) return;
+    std::rotate(records.begin(), records.begin() + head, records.end());
+    records.resize(used);
+    if (hasStats)
+    {
+        std::rotate(stats.begin(), stats.begin() + head, stats.end());
+        stats.resize(used);
+    }
+    head = 0;
+}
+
+//drop FD payload slabs that no record points at any longer
+void CANFrameStore::compactSlabs()
+{
+    QVector<CANFDPayloadSlab> newSlabs;
+    for (int i = 0; i < records.count(); i++)
+    {
+        PackedCANFrame &rec = records[i];
+        if (rec.length <= 8) continue;
+        newSlabs.append(fdSlabs.at(static_cast<int>(rec.payload.slab)));
+        rec.payload.slab = static_cast<uint32_t>(newSlabs.count() - 1);
+    }
+    fdSlabs = newSlabs;
+    freeSlabs.clear();
+}
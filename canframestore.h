@@ -0,0 +1,148 @@
+#ifndef CANFRAMESTORE_H
+#define CANFRAMESTORE_H
+
+#include <QVector>
+#include <stdint.h>
+#include "can_structs.h"
+
+/*
+ * Packed representation of a single frame. A CANFrame drags around a heap allocated QByteArray
+ * for the payload plus a bunch of bookkeeping which puts it well over 100 bytes per frame once
+ * the allocation is counted. This record is 24 bytes for classic CAN. Payloads over 8 bytes
+ * (CAN-FD) are stored in a separate slab of 64 byte blocks and the record keeps the slab index.
+ */
+struct PackedCANFrame
+{
+    int64_t timeStamp; //microseconds
+    uint32_t frameId;
+    uint32_t bus       : 8;
+    uint32_t length    : 7; //payload length, 0 - 64
+    uint32_t frameType : 3; //QCanBusFrame::FrameType
+    uint32_t extended  : 1;
+    uint32_t received  : 1;
+    uint32_t fd        : 1;
+    uint32_t brs       : 1;
+    uint32_t esi       : 1;
+    uint32_t localEcho : 1;
+    uint32_t reserved  : 8;
+    union
+    {
+        uint8_t data[8]; //inline payload when length <= 8
+        uint32_t slab;   //index into the FD slab otherwise
+    } payload;
+};
+static_assert(sizeof(PackedCANFrame) == 24, "PackedCANFrame is expected to stay at 24 bytes per frame");
+
+struct CANFDPayloadSlab
+{
+    uint8_t data[64];
+};
+
+/*
+ * Compact frame container used as the backing store for captures. It deliberately mirrors the
+ * read side of QVector<CANFrame> (count, at, operator[], iteration) so code that used to be handed
+ * a QVector pointer can read from it unchanged. at() unpacks into a full CANFrame so prefer the
+ * field accessors (timeStampAt, frameIdAt, busAt) in tight loops that only need one field.
+ *
+ * The timedelta and frameCount fields only mean something in overwrite mode. They are kept in a
+ * side array that stays empty until some frame actually uses them.
+ *
+ * With setRingCapacity() the store becomes a circular buffer. Once full, every append evicts the
+ * oldest frame in O(1) and removing from the front only moves the head. Logical indexes always run
+ * from 0 (oldest still held) to count() - 1 (newest). evictedCount() says how many frames have
+ * fallen off the front since the last clear(), whether by eviction or remove(0, n), so
+ * evictedCount() + idx is the absolute number of a frame and stays put as older frames go.
+ */
+class CANFrameStore
+{
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator(const CANFrameStore *store, int idx) : mStore(store), mIdx(idx) {}
+        CANFrame operator*() const { return mStore->at(mIdx); }
+        const_iterator &operator++() { mIdx++; return *this; }
+        bool operator!=(const const_iterator &other) const { return mIdx != other.mIdx; }
+        bool operator==(const const_iterator &other) const { return mIdx == other.mIdx; }
+    private:
+        const CANFrameStore *mStore;
+        int mIdx;
+    };
+    typedef const_iterator iterator;
+
+    CANFrameStore();
+    explicit CANFrameStore(const QVector<CANFrame> &frames);
+
+    int count() const { return used; }
+    int size() const { return used; }
+    int length() const { return used; }
+    bool isEmpty() const { return used == 0; }
+    int capacity() const;
+
+    CANFrame at(int idx) const;
+    CANFrame operator[](int idx) const { return at(idx); }
+    CANFrame first() const { return at(0); }
+    CANFrame last() const { return at(used - 1); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, used); }
+
+    int64_t timeStampAt(int idx) const { return records.at(physical(idx)).timeStamp; }
+    uint32_t frameIdAt(int idx) const { return records.at(physical(idx)).frameId; }
+    int busAt(int idx) const { return records.at(physical(idx)).bus; }
+    int payloadLengthAt(int idx) const { return records.at(physical(idx)).length; }
+    const uint8_t *payloadAt(int idx) const;
+    const PackedCANFrame &recordAt(int idx) const { return records.at(physical(idx)); }
+    void setTimeStampAt(int idx, int64_t timeStamp) { records[physical(idx)].timeStamp = timeStamp; }
+    uint64_t timeDeltaAt(int idx) const { return hasStats ? stats.at(physical(idx)).timedelta : 0; }
+    uint32_t frameCountAt(int idx) const { return hasStats ? stats.at(physical(idx)).frameCount : 1; }
+
+    void append(const CANFrame &frame);
+    void append(const QVector<CANFrame> &frames);
+    void append(const CANFrameStore &other, int idx); //copy one frame over without unpacking it
+    void replace(int idx, const CANFrame &frame);
+    void remove(int idx, int num);
+    void clear();
+    void reserve(int num);
+    QVector<CANFrame> toVector() const;
+
+    void setRingCapacity(int maxFrames); //0 turns ring mode off
+    int ringCapacity() const { return ringSize; }
+    quint64 evictedCount() const { return evicted; }
+    void setEvictedCount(quint64 count) { evicted = count; } //for a store rebuilt out of another that keeps its numbering
+
+    quint64 bytesUsed() const; //memory actually occupied by the stored frames
+
+private:
+    struct OverwriteStats
+    {
+        uint64_t timedelta;
+        uint32_t frameCount;
+    };
+
+    int physical(int idx) const
+    {
+        if (head == 0) return idx;
+        int phys = head + idx;
+        if (phys >= records.count()) phys -= records.count();
+        return phys;
+    }
+    int nextSlot();
+    void pack(const CANFrame &frame, PackedCANFrame &rec);
+    int allocateSlab();
+    void releaseSlab(const PackedCANFrame &rec);
+    void linearize();
+    void compactSlabs();
+    void storeStats(int phys, uint64_t timedelta, uint32_t frameCount);
+
+    QVector<PackedCANFrame> records;
+    QVector<CANFDPayloadSlab> fdSlabs;
+    QVector<int> freeSlabs; //FD slabs whose frames were evicted or replaced, ready for reuse
+    QVector<OverwriteStats> stats; //parallel to records once hasStats is set
+    bool hasStats;
+    int ringSize; //maximum frames held in ring mode, 0 when not a ring
+    int head;     //physical index of logical frame 0
+    int used;     //number of frames currently held
+    quint64 evicted;
+};
+
+#endif // CANFRAMESTORE_H
@@ -1,6 +1,7 @@
 #ifndef CANBus_H
 #define CANBus_H
 #include <QDataStream>
+#include <QHash>
 #include "can_structs.h"
 
 class CANBus
@@ -39,10 +40,17 @@ QDataStream& operator>>(QDataStream & pStream, CANBus& pCanBus);
 
 Q_DECLARE_METATYPE(CANBus);
 
+//the targetted frame filters that share a mask, keyed on the ID they match once a frame ID is masked
+struct TargetGroup {
+    quint32 mask;
+    QHash<quint32, QVector<QObject *>> observers;
+};
+
 struct BusData {
     CANBus             mBus;
     bool               mConfigured = {};
     QVector<CANFltObserver>    mTargettedFrames;
+    QVector<TargetGroup>       mTargetIndex; //mTargettedFrames grouped by mask, what frames are checked against
 };
 
 #endif // CANBus_H
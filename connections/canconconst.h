@@ -1,6 +1,8 @@
 #ifndef CANCONCONST_H
 #define CANCONCONST_H
 
+#include <QtGlobal>
+
 namespace CANCon {
 
     /**
@@ -34,4 +36,19 @@ public:
     int numHardwareBuses;
 };
 
+//what went through a connection since it was created or its stats were reset, see CANConnection::getStats()
+class CANConStats
+{
+public:
+    quint64 framesReceived; //everything the device produced, whether there was room for it or not
+    quint64 framesQueued;
+    quint64 framesDropped;  //no room left in the queue
+    int queueDepth;         //frames waiting right now
+    int queueHighWater;     //most frames that were ever waiting at once
+    int queueCapacity;
+    quint64 bytesParsed;    //raw bytes taken in by devices that decode a byte stream or datagrams themselves
+    quint64 parseErrors;    //data those devices couldn't make sense of and skipped
+    quint64 decodeNanos;    //time spent turning device data into frames
+};
+
 #endif // CANCONCONST_H
@@ -1,11 +1,14 @@
 #include <QDateTime>
 #include <QSettings>
 #include <QCoreApplication>
+#include <algorithm>
 
 #include "canconmanager.h"
 #include "canconfactory.h"
 
 CANConManager* CANConManager::mInstance = nullptr;
+int CANConManager::minDeliveryInterval = 5;
+int CANConManager::latencyWindow = 1024;
 
 CANConManager* CANConManager::getInstance()
 {
@@ -18,11 +21,18 @@ CANConManager* CANConManager::getInstance()
 CANConManager::CANConManager(QObject *parent): QObject(parent)
 {
     connect(&mTimer, SIGNAL(timeout()), this, SLOT(refreshCanList()));
-    mTimer.setInterval(20); /*Tick 50 times per second to allow for good resolution in reception where needed. GUI updates *MUCH* more slowly*/
+    mTimer.setInterval(100); /*Housekeeping only, frames are handed off as the connections signal them*/
     mTimer.setSingleShot(false);
     mTimer.start();
 
+    connect(&mDeliveryTimer, &QTimer::timeout, this, &CANConManager::deliverWaiting);
+    mDeliveryTimer.setSingleShot(true);
+    mDeliveryTimer.setTimerType(Qt::PreciseTimer);
+
     mNumActiveBuses = 0;
+    mLastDelivery = 0;
+    mLatencyPos = 0;
+    mDelivering = false;
 
     resetTimeBasis();
 
@@ -58,22 +68,44 @@ void CANConManager::stopAllConnections()
 void CANConManager::add(CANConnection* pConn_p)
 {
     mConns.append(pConn_p);
+    connect(pConn_p, &CANConnection::framesQueued, this, &CANConManager::handleFramesQueued);
+    connect(pConn_p, &CANConnection::status, this, &CANConManager::rebuildBusBases);
+    rebuildBusBases();
 }
 
 
 void CANConManager::remove(CANConnection* pConn_p)
 {
-    //disconnect(pConn_p, 0, this, 0);
+    disconnect(pConn_p, nullptr, this, nullptr);
     mConns.removeOne(pConn_p);
+    mWaiting.removeAll(pConn_p);
+    rebuildBusBases();
 }
 
 void CANConManager::replace(int idx, CANConnection* pConn_p)
 {
     CANConnection *original = mConns[idx];
     mConns.replace(idx, pConn_p);
+    mWaiting.removeAll(original);
+    connect(pConn_p, &CANConnection::framesQueued, this, &CANConManager::handleFramesQueued);
+    connect(pConn_p, &CANConnection::status, this, &CANConManager::rebuildBusBases);
+    rebuildBusBases();
     delete original; original = NULL;
 }
 
+//bus numbers only move when connections come and go or a device reports a different bus count
+//(which comes with a status signal), so the offsets are worked out then and not for every hand-off
+void CANConManager::rebuildBusBases()
+{
+    mBusBases.clear();
+    int busBase = 0;
+    foreach (CANConnection* conn_p, mConns)
+    {
+        mBusBases.insert(conn_p, busBase);
+        busBase += conn_p->getNumBuses();
+    }
+}
+
 //Get total number of buses currently registered with the program
 int CANConManager::getNumBuses()
 {
@@ -96,34 +128,73 @@ int CANConManager::getBusBase(CANConnection *which)
     return -1;
 }
 
+//housekeeping tick: bus counts, frames sent with no connection around and a drain of every
+//connection in case one queued frames without signalling
 void CANConManager::refreshCanList()
 {
-    QObject* sender_p = QObject::sender();
-
     if (mConns.count() == 0)
     {
-        tempFrames.clear();
-        //TODO: Seems to crash under heavy load. Find out why.
-        if(buslessFrames.size()) {            
-            tempFrames = buslessFrames; //make a copy and pass that copy
-            buslessFrames.clear(); //delete all frames from the original
-            emit framesReceived(nullptr, tempFrames);
-        }
+        deliverBuslessFrames();
         return;
     }
 
-    if( sender_p != &mTimer)
+    rebuildBusBases();
+    unsigned int buses = 0;
+    foreach(CANConnection* conn_p, mConns)
     {
-        /* if we are not the sender, the signal is coming from a connection */
-        /* refresh only the given connection */
-        if(mConns.contains((CANConnection*) sender_p))
-            refreshConnection((CANConnection*)sender_p);
+        if (conn_p->getStatus() == CANCon::CONNECTED) buses += conn_p->getNumBuses();
     }
-    else
+    if (buses != mNumActiveBuses)
+    {
+        mNumActiveBuses = buses;
+        emit connectionStatusUpdated(buses);
+    }
+
+    foreach (CANConnection* conn_p, mConns)
+        refreshConnection(conn_p);
+}
+
+//a connection's queue went from empty to not. Hand its frames off now unless the last hand-off was
+//too recent, then it waits for the delivery timer along with anything else that comes in meanwhile
+void CANConManager::handleFramesQueued()
+{
+    CANConnection* conn_p = qobject_cast<CANConnection*>(QObject::sender());
+    if (!conn_p || !mConns.contains(conn_p)) return;
+
+    if (mDeliveryTimer.isActive())
     {
-        foreach (CANConnection* conn_p, mConns)
-            refreshConnection((CANConnection*)conn_p);
+        if (!mWaiting.contains(conn_p)) mWaiting.append(conn_p);
+        return;
     }
+
+    qint64 wait = mLastDelivery + minDeliveryInterval * 1000ll - CANConnection::steadyMicros();
+    if (wait <= 0)
+    {
+        refreshConnection(conn_p);
+        return;
+    }
+    mWaiting.append(conn_p);
+    mDeliveryTimer.start(static_cast<int>((wait + 999) / 1000));
+}
+
+void CANConManager::deliverWaiting()
+{
+    QList<CANConnection*> waiting = mWaiting;
+    mWaiting.clear();
+    foreach (CANConnection* conn_p, waiting)
+        refreshConnection(conn_p);
+}
+
+void CANConManager::deliverBuslessFrames()
+{
+    if (buslessFrames.isEmpty() || mDelivering) return;
+
+    //receivers may send more frames, those go into the emptied buffer for next time
+    tempFrames.resize(0);
+    tempFrames.swap(buslessFrames);
+    mDelivering = true;
+    emit framesReceived(nullptr, tempFrames);
+    mDelivering = false;
 }
 
 uint64_t CANConManager::getTimeBasis()
@@ -151,44 +222,79 @@ CANConnection* CANConManager::getByName(const QString& pName) const
 
 void CANConManager::refreshConnection(CANConnection* pConn_p)
 {
-    unsigned int buses = 0;
-    foreach(CANConnection* conn_p, mConns)
+    //a receiver spinning the event loop mustn't get tempFrames pulled out from under it
+    if (mDelivering)
     {
-        if (conn_p->getStatus() == CANCon::CONNECTED) buses += conn_p->getNumBuses();
-    }
-    if (buses != mNumActiveBuses)
-    {
-        mNumActiveBuses = buses;
-        emit connectionStatusUpdated(buses);
+        if (!mWaiting.contains(pConn_p)) mWaiting.append(pConn_p);
+        if (!mDeliveryTimer.isActive()) mDeliveryTimer.start(minDeliveryInterval);
+        return;
     }
 
+    //rearm the connection's signal before draining so nothing queued from now on goes unnoticed
+    qint64 queuedAt = pConn_p->takeFramesPending();
     if (pConn_p->getQueue().peek() == nullptr) return;
 
     CANFrame* frame_p = nullptr;
-    QVector<CANFrame> frames;
 
     //Each connection only knows about its own bus numbers
     //so this variable is used to fix that up to turn local bus numbers
     //into system global bus numbers for display.
-    int busBase = 0;
+    int busBase = mBusBases.value(pConn_p, 0);
 
-    foreach (CANConnection* conn, mConns)
-    {
-        if (conn != pConn_p) busBase += conn->getNumBuses();
-        else break;
+    //qDebug() << "Bus fixup number: " << busBase;
+
+    //the ring gives frames back in runs up to where it wraps, each run goes over in one go
+    tempFrames.resize(0);
+    int available;
+    while( (frame_p = pConn_p->getQueue().peekSpan(available) ) ) {
+        int start = tempFrames.count();
+        tempFrames.resize(start + available);
+        for (int i = 0; i < available; i++) {
+            frame_p[i].bus += busBase;
+            tempFrames[start + i] = frame_p[i];
+        }
+        pConn_p->getQueue().consume(available);
     }
 
-    //qDebug() << "Bus fixup number: " << busBase;
+    mDelivering = true;
+    emit framesReceived(pConn_p, tempFrames);
+    mDelivering = false;
+
+    mLastDelivery = CANConnection::steadyMicros();
+    if (queuedAt >= 0) recordLatency(mLastDelivery - queuedAt);
+}
 
-    while( (frame_p = pConn_p->getQueue().peek() ) ) {
-        frame_p->bus += busBase;
-        //qDebug() << "Rx of frame from bus: " << frame_p->bus;
-        frames.append(*frame_p);
-        pConn_p->getQueue().dequeue();
+void CANConManager::recordLatency(qint64 micros)
+{
+    if (mLatencies.count() < latencyWindow) mLatencies.append(micros);
+    else
+    {
+        if (mLatencyPos >= mLatencies.count()) mLatencyPos = 0;
+        mLatencies[mLatencyPos++] = micros;
     }
+}
 
-    if(frames.size())
-        emit framesReceived(pConn_p, frames);
+CANConManager::LatencyStats CANConManager::getLatencyStats() const
+{
+    LatencyStats stats;
+    stats.samples = mLatencies.count();
+    stats.p50 = 0;
+    stats.p99 = 0;
+    stats.max = 0;
+    if (mLatencies.isEmpty()) return stats;
+
+    QVector<qint64> sorted = mLatencies;
+    std::sort(sorted.begin(), sorted.end());
+    stats.p50 = sorted.at((sorted.count() - 1) / 2);
+    stats.p99 = sorted.at(((sorted.count() - 1) * 99) / 100);
+    stats.max = sorted.last();
+    return stats;
+}
+
+void CANConManager::resetLatencyStats()
+{
+    mLatencies.clear();
+    mLatencyPos = 0;
 }
 
 /*
@@ -209,6 +315,8 @@ bool CANConManager::sendFrame(const CANFrame& pFrame)
 
     if (mConns.count() == 0)
     {
+        //handed back as received frames once control gets back to the event loop
+        if (buslessFrames.isEmpty()) QTimer::singleShot(0, this, &CANConManager::deliverBuslessFrames);
         buslessFrames.append(pFrame);
         return true;
     }
@@ -4,14 +4,38 @@
 #include <QObject>
 #include <QTimer>
 #include <QElapsedTimer>
+#include <QHash>
 
 #include "canconnection.h"
 
+/*
+ * Owns the connections and hands the frames they receive to the rest of the program.
+ *
+ * A connection emits framesQueued when frames land in its empty queue and the queue is drained
+ * right away, so a quiet bus gets its frames through with next to no delay. While a connection
+ * stays busy the drains are spaced at least minDeliveryInterval apart so the frames go out in
+ * batches instead of one signal per frame. The slow housekeeping tick keeps the bus counts up to
+ * date and drains anything a connection didn't signal.
+ *
+ * The time from a frame being queued by a connection until framesReceived has returned (so the
+ * model has it) is tracked for the last latencyWindow hand-offs, see getLatencyStats.
+ */
 class CANConManager : public QObject
 {
     Q_OBJECT
 
 public:
+    struct LatencyStats
+    {
+        int samples;
+        qint64 p50; //microseconds
+        qint64 p99;
+        qint64 max;
+    };
+
+    static int minDeliveryInterval; //ms between hand-offs while frames keep coming
+    static int latencyWindow;       //hand-offs the latency percentiles are taken over
+
     static CANConManager* getInstance();
     virtual ~CANConManager();
 
@@ -62,26 +86,42 @@ public:
 
     bool removeAllTargettedFrames(QObject *receiver);
 
+    //ingest to model latency of the frame hand-offs, the oldest frame of each batch counts
+    LatencyStats getLatencyStats() const;
+    void resetLatencyStats();
+
 signals:
     void framesReceived(CANConnection* pConn_p, QVector<CANFrame>& pFrames);
     void connectionStatusUpdated(int conns);
 
 private slots:
     void refreshCanList();
+    void handleFramesQueued();
+    void deliverWaiting();
+    void deliverBuslessFrames();
+    void rebuildBusBases();
 
 private:
     explicit CANConManager(QObject *parent = 0);
     void refreshConnection(CANConnection* pConn_p);
+    void recordLatency(qint64 micros);
 
     static CANConManager*  mInstance;
     QList<CANConnection*>  mConns;
     QTimer                 mTimer;
+    QTimer                 mDeliveryTimer; //single shot for connections that have to wait their turn
+    QList<CANConnection*>  mWaiting;
+    qint64                 mLastDelivery;
+    bool                   mDelivering; //inside a framesReceived emit
+    QHash<CANConnection*, int> mBusBases; //first global bus number of each connection
+    QVector<qint64>        mLatencies; //ring of the last latencyWindow hand-offs
+    int                    mLatencyPos;
     QElapsedTimer          mElapsedTimer;
     uint64_t               mTimestampBasis;
     uint32_t               mNumActiveBuses;
     bool                   useSystemTime;
     QVector<CANFrame>      buslessFrames;
-    QVector<CANFrame>      tempFrames;
+    QVector<CANFrame>      tempFrames; //reused for every hand-off so it stays allocated
 };
 
 #endif // CANCONNECTIONMODEL_H
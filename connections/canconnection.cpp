@@ -1,5 +1,8 @@
 #include <QSettings>
 #include <QThread>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <chrono>
 #include "canconnection.h"
 
 CANConnection::CANConnection(QString pPort,
@@ -13,6 +16,7 @@ CANConnection::CANConnection(QString pPort,
                              int pQueueLen,
                              bool pUseThread) :
     mNumBuses(pNumBuses),
+    mConsoleOutput(0),
     mSerialSpeed(pSerialSpeed),
     mQueue(),
     mPort(pPort),
@@ -20,17 +24,31 @@ CANConnection::CANConnection(QString pPort,
     mType(pType),
     mIsCapSuspended(false),
     mStatus(CANCon::NOT_CONNECTED),
+    mFramesPending(0),
+    mPendingSince(0),
+    mFramesQueued(0),
+    mQueueHighWater(0),
+    mBytesParsed(0),
+    mParseErrors(0),
+    mDecodeNanos(0),
     mStarted(false),
-    mThread_p(nullptr)
+    mThread_p(nullptr),
+    mTargetCount(0)
 {
     /* register types */
     qRegisterMetaType<CANBus>("CANBus");
     qRegisterMetaType<CANFrame>("CANFrame");
+    qRegisterMetaType<QVector<CANFrame>>("QVector<CANFrame>");
     qRegisterMetaType<CANConStatus>("CANConStatus");
     qRegisterMetaType<CANFltObserver>("CANFlt");
 
-    /* set queue size */
-    mQueue.setSize(pQueueLen); /*TODO add check on returned value */
+    /* set queue size, the setting overrides the device's default for tuning against real traffic */
+    int queueLen = QSettings().value("Main/ConnectionQueueLength", pQueueLen).toInt();
+    //0 would free the ring and drop everything, so it's as invalid as a negative length
+    if (queueLen <= 0 || !mQueue.setSize(queueLen)) {
+        qDebug() << "Invalid queue length" << queueLen << "using" << pQueueLen;
+        mQueue.setSize(pQueueLen);
+    }
 
     /* allocate buses */
     /* TODO: change those tables for a vector */
@@ -186,9 +204,12 @@ bool CANConnection::sendFrame(const CANFrame& pFrame)
     txFrame = getQueue().get();
     if (txFrame)
     {
-        *txFrame = pFrame;        
-    }    
-    getQueue().queue();
+        *txFrame = pFrame;
+        getQueue().queue();
+        notifyFramesQueued();
+    }
+    else
+        getQueue().countDrop();
 
     return piSendFrame(pFrame);
 }
@@ -264,6 +285,33 @@ LFQueue<CANFrame>& CANConnection::getQueue() {
     return mQueue;
 }
 
+quint64 CANConnection::getDroppedFrames() const {
+    return mQueue.dropped();
+}
+
+CANConStats CANConnection::getStats() const {
+    CANConStats stats;
+    stats.framesQueued = mFramesQueued.loadRelaxed();
+    stats.framesDropped = mQueue.dropped();
+    stats.framesReceived = stats.framesQueued + stats.framesDropped;
+    stats.queueDepth = mQueue.count();
+    stats.queueHighWater = qMax(mQueueHighWater.loadRelaxed(), stats.queueDepth);
+    stats.queueCapacity = mQueue.capacity();
+    stats.bytesParsed = mBytesParsed.loadRelaxed();
+    stats.parseErrors = mParseErrors.loadRelaxed();
+    stats.decodeNanos = mDecodeNanos.loadRelaxed();
+    return stats;
+}
+
+void CANConnection::resetStats() {
+    mFramesQueued.fetchAndStoreRelaxed(0);
+    mQueue.resetDropped();
+    mQueueHighWater.storeRelaxed(mQueue.count());
+    mBytesParsed.fetchAndStoreRelaxed(0);
+    mParseErrors.fetchAndStoreRelaxed(0);
+    mDecodeNanos.fetchAndStoreRelaxed(0);
+}
+
 
 CANCon::type CANConnection::getType() {
     return mType;
@@ -286,6 +334,25 @@ void CANConnection::setCapSuspended(bool pIsSuspended) {
     mIsCapSuspended = pIsSuspended;
 }
 
+void CANConnection::setConsoleOutput(bool state) {
+    mConsoleOutput.storeRelaxed(state ? 1 : 0);
+}
+
+bool CANConnection::isConsoleOutput() const {
+    return mConsoleOutput.loadRelaxed() != 0;
+}
+
+qint64 CANConnection::takeFramesPending() {
+    qint64 since = mPendingSince.loadRelaxed();
+    //anything queued from here on has to signal again since this drain may already be past it
+    if (mFramesPending.fetchAndStoreOrdered(0) == 0) return -1;
+    return since;
+}
+
+qint64 CANConnection::steadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void CANConnection::debugInput(QByteArray bytes) {
     Q_UNUSED(bytes)
 }
@@ -314,11 +381,14 @@ bool CANConnection::addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QO
     target.id = ID;
     target.mask = mask;
     target.observer = receiver;
-    if (pBusId > -1)
-        mBusData[pBusId].mTargettedFrames.append(target);
-    else
+
+    QMutexLocker lock(&mTargetMutex);
+    for (int i = 0; i < mBusData.count(); i++)
     {
-        for (int i = 0; i < mBusData.count(); i++) mBusData[i].mTargettedFrames.append(target);
+        if (pBusId > -1 && i != pBusId) continue;
+        mBusData[i].mTargettedFrames.append(target);
+        mTargetCount.fetchAndAddRelaxed(1);
+        rebuildTargetIndex(mBusData[i]);
     }
 
     return true;
@@ -347,42 +417,102 @@ bool CANConnection::removeTargettedFrame(int pBusId, uint32_t ID, uint32_t mask,
     target.id = ID;
     target.mask = mask;
     target.observer = receiver;
-    mBusData[pBusId].mTargettedFrames.removeAll(target);
+
+    QMutexLocker lock(&mTargetMutex);
+    for (int i = 0; i < mBusData.count(); i++)
+    {
+        if (pBusId > -1 && i != pBusId) continue;
+        int removed = mBusData[i].mTargettedFrames.removeAll(target);
+        if (!removed) continue;
+        mTargetCount.fetchAndAddRelaxed(-removed);
+        rebuildTargetIndex(mBusData[i]);
+    }
 
     return true;
 }
 
 bool CANConnection::removeAllTargettedFrames(QObject *receiver)
 {
-    for (int i = 0; i < getNumBuses(); i++) {
-        foreach (const CANFltObserver filt, mBusData[i].mTargettedFrames)
+    QMutexLocker lock(&mTargetMutex);
+    for (int i = 0; i < mBusData.count(); i++) {
+        QVector<CANFltObserver> &targets = mBusData[i].mTargettedFrames;
+        int before = targets.count();
+        for (int j = targets.count() - 1; j >= 0; j--)
         {
-            if (filt.observer == receiver) mBusData[i].mTargettedFrames.removeOne(filt);
+            if (targets.at(j).observer == receiver) targets.remove(j);
         }
+        if (targets.count() == before) continue;
+        mTargetCount.fetchAndAddRelaxed(targets.count() - before);
+        rebuildTargetIndex(mBusData[i]);
     }
+    //the receiver is usually about to be deleted, nothing may be sent to it from here on
+    mTargetPending.remove(receiver);
 
     return true;
 }
 
+//called with mTargetMutex held
+void CANConnection::rebuildTargetIndex(BusData &bus)
+{
+    bus.mTargetIndex.clear();
+    foreach (const CANFltObserver &filt, bus.mTargettedFrames)
+    {
+        //an ID with bits outside its mask can never match
+        if ((filt.id & filt.mask) != filt.id) continue;
+
+        int group = 0;
+        while (group < bus.mTargetIndex.count() && bus.mTargetIndex.at(group).mask != filt.mask) group++;
+        if (group == bus.mTargetIndex.count())
+        {
+            TargetGroup newGroup;
+            newGroup.mask = filt.mask;
+            bus.mTargetIndex.append(newGroup);
+        }
+        QVector<QObject *> &observers = bus.mTargetIndex[group].observers[filt.id];
+        if (!observers.contains(filt.observer)) observers.append(filt.observer);
+    }
+}
+
+//One hash lookup per distinct mask instead of a compare per filter. Most filters are for one
+//exact ID and share the same full mask so that's usually a single lookup whatever the number of filters
 void CANConnection::checkTargettedFrame(CANFrame &frame)
 {
-    unsigned int maskedID;
-    //qDebug() << "Got frame with ID " << frame.ID << " on bus " << frame.bus;
-    if (mBusData.count() == 0) return;
+    if (mTargetCount.loadRelaxed() == 0) return;
 
-    int bus = frame.bus;
-    if (bus > (mBusData.length() - 1)) bus = mBusData.length() - 1;
+    QMutexLocker lock(&mTargetMutex);
+    if (frame.bus < 0 || frame.bus >= mBusData.count()) return; //not one of ours, nobody filtered for it
+    const QVector<TargetGroup> &groups = mBusData.at(frame.bus).mTargetIndex;
 
-    if (mBusData[bus].mTargettedFrames.length() == 0) return;
-    foreach (const CANFltObserver filt, mBusData[frame.bus].mTargettedFrames)
+    bool flushQueued = !mTargetPending.isEmpty();
+    QVarLengthArray<QObject *, 8> matched; //a receiver gets each frame once however many of its filters match
+    for (int g = 0; g < groups.count(); g++)
     {
-        //qDebug() << "Checking filter with id " << filt.id << " mask " << filt.mask;
-        maskedID = frame.frameId() & filt.mask;
-        if (maskedID == filt.id) {
-            qDebug() << "In connection object I got a targetted frame. Forwarding it.";
-            QMetaObject::invokeMethod(filt.observer, "gotTargettedFrame",Qt::QueuedConnection, Q_ARG(CANFrame, frame));
+        const TargetGroup &group = groups.at(g);
+        QHash<quint32, QVector<QObject *>>::const_iterator it = group.observers.constFind(frame.frameId() & group.mask);
+        if (it == group.observers.constEnd()) continue;
+        foreach (QObject *observer, it.value())
+        {
+            if (std::find(matched.begin(), matched.end(), observer) != matched.end()) continue;
+            matched.append(observer);
+            mTargetPending[observer].append(frame);
         }
     }
+
+    //whatever else this pass of the event loop matches goes out with it
+    if (!flushQueued && !matched.isEmpty())
+        QMetaObject::invokeMethod(this, "flushTargettedFrames", Qt::QueuedConnection);
+}
+
+void CANConnection::flushTargettedFrames()
+{
+    //the lock is held while posting so a receiver can't be removed and deleted in between
+    QMutexLocker lock(&mTargetMutex);
+    QHash<QObject *, QVector<CANFrame>>::const_iterator it;
+    for (it = mTargetPending.constBegin(); it != mTargetPending.constEnd(); ++it)
+    {
+        QMetaObject::invokeMethod(it.key(), "gotTargettedFrames", Qt::QueuedConnection, Q_ARG(QVector<CANFrame>, it.value()));
+    }
+    mTargetPending.clear();
 }
 
 bool CANConnection::piSendFrames(const QList<CANFrame>& pFrames)
@@ -3,6 +3,7 @@
 
 #include <Qt>
 #include <QObject>
+#include <QMutex>
 #include "utils/lfqueue.h"
 #include "can_structs.h"
 #include "canbus.h"
@@ -77,6 +78,23 @@ public:
      */
     LFQueue<CANFrame>& getQueue();
 
+    /**
+     * @brief getDroppedFrames
+     * @return frames the device couldn't queue because the queue was full, since it was last started
+     */
+    quint64 getDroppedFrames() const;
+
+    /**
+     * @brief getStats
+     * @return counters on the frames that went through this connection. Safe to call from any thread
+     */
+    CANConStats getStats() const;
+
+    /**
+     * @brief resetStats - zeroes the counters, the queue high water mark starts over from what is waiting now
+     */
+    void resetStats();
+
     /**
      * @brief getType
      * @return the @ref CANCon::type of the device
@@ -95,6 +113,23 @@ public:
      */
     void setConsoleOutput(bool state);
 
+    /**
+     * @brief isConsoleOutput
+     * @return true if someone is watching the debugging output. Devices should skip building debug text otherwise
+     */
+    bool isConsoleOutput() const;
+
+    /**
+     * @brief takeFramesPending - called by the consumer right before it drains the queue, rearms framesQueued
+     * @return steady clock time in microseconds the first undrained frame was queued, -1 if nothing was signalled
+     */
+    qint64 takeFramesPending();
+
+    /**
+     * @brief monotonic time in microseconds that frame hand-off latency is measured in
+     */
+    static qint64 steadyMicros();
+
 
 signals:
     /*not implemented yet */
@@ -118,6 +153,12 @@ signals:
      */
     void status(CANConStatus pStatus);
 
+    /**
+     * @brief emitted when frames land in an empty queue. Nothing more is emitted until takeFramesPending
+     * is called so a busy device sends one of these per drain, not one per frame
+     */
+    void framesQueued();
+
     /**
       * @brief Event sent when device has done something worthy of debugging output.
       * @param debugString: String based output to show for debugging purposes
@@ -181,7 +222,8 @@ public slots:
     bool sendFrames(const QList<CANFrame>& pFrames);
 
     /**
-     * @brief Add a new filter for the targetted frames. If a frame matches it will immediately be sent via the targettedFrameReceived signal
+     * @brief Add a new filter for the targetted frames. Frames that match are handed to the receiver's
+     * gotTargettedFrames(const QVector<CANFrame> &) slot, everything one pass of the device's event loop matched in one call
      * @param pBusId - Which bus to bond to. -1 for any, otherwise a bitfield of buses (but 0 = first bus, etc)
      * @param ID - 11 or 29 bit ID to match against
      * @param mask - 11 or 29 bit mask used for filter
@@ -212,12 +254,32 @@ public slots:
 protected:
     int mNumBuses; //protected to allow connected device to figure out how many buses are available
     QVector<BusData> mBusData;
-    bool mConsoleOutput; //send debugging info to the console?
+    QAtomicInt mConsoleOutput; //send debugging info to the console? Set from the GUI thread, read from the device thread
     int mSerialSpeed;
 
-    //determine if the passed frame is part of a filter or not.
+    //determine if the passed frame is part of a filter or not. Matches are collected per receiver and
+    //sent on once the device is done with what it's processing now
     void checkTargettedFrame(CANFrame &frame);
 
+    //call after getQueue().queue(), wakes up the consumer if it isn't already on its way
+    void notifyFramesQueued()
+    {
+        mFramesQueued.fetchAndAddRelaxed(1);
+        int depth = mQueue.count();
+        if (depth > mQueueHighWater.loadRelaxed()) mQueueHighWater.storeRelaxed(depth);
+
+        if (mFramesPending.loadRelaxed() == 0 && mFramesPending.testAndSetOrdered(0, 1))
+        {
+            mPendingSince.storeRelaxed(steadyMicros());
+            emit framesQueued();
+        }
+    }
+
+    //bookkeeping for getStats() by devices that decode the raw data themselves
+    void countBytesParsed(int bytes) { mBytesParsed.fetchAndAddRelaxed(static_cast<quint64>(bytes)); }
+    void countParseError() { mParseErrors.fetchAndAddRelaxed(1); }
+    void addDecodeTime(qint64 nanos) { mDecodeNanos.fetchAndAddRelaxed(static_cast<quint64>(nanos)); }
+
     /**
      * @brief setStatus
      * @param pStatus: the status to set
@@ -320,15 +382,30 @@ protected:
      */
     virtual bool piSendFrames(const QList<CANFrame>&);
 
+private slots:
+    void flushTargettedFrames();
+
 private:
+    void rebuildTargetIndex(BusData &bus);
+
     LFQueue<CANFrame>   mQueue;
     const QString       mPort;
     const QString       mDriver;
     const CANCon::type  mType;
     bool                mIsCapSuspended;
     QAtomicInt          mStatus;
+    QAtomicInt          mFramesPending; //framesQueued has been emitted and the queue not drained since
+    QAtomicInteger<qint64> mPendingSince;
+    QAtomicInteger<quint64> mFramesQueued;
+    QAtomicInt          mQueueHighWater;
+    QAtomicInteger<quint64> mBytesParsed;
+    QAtomicInteger<quint64> mParseErrors;
+    QAtomicInteger<quint64> mDecodeNanos;
     bool                mStarted;
     QThread*            mThread_p;
+    QMutex              mTargetMutex; //filters are changed from the GUI thread while the device thread checks frames against them
+    QAtomicInt          mTargetCount; //filters on all buses, lets checkTargettedFrame skip the lock when there are none
+    QHash<QObject *, QVector<CANFrame>> mTargetPending; //matched frames not yet sent to each receiver
 };
 
 #endif // CANCONNECTION_H
@@ -16,7 +16,10 @@ enum class Column {
     Subtype    = 1, ///< Mostly used by SerialBus devices to pick the sub type
     Port       = 2, ///< The CAN hardware port, e.g. can0 for socketcan
     NumBuses   = 3, ///< Number of buses exposed by this device. Usually non-GVRET devices will just have one
-    Status     = 4  ///< The bus status as text message
+    Status     = 4, ///< The bus status as text message
+    Received   = 5, ///< Frames the device produced since its stats were last reset
+    Dropped    = 6, ///< Frames lost because the device's queue was full
+    QueuePeak  = 7  ///< Most frames that were waiting in the queue at once, against its capacity
 };
 
 QVariant CANConnectionModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -38,6 +41,12 @@ QVariant CANConnectionModel::headerData(int section, Qt::Orientation orientation
             return QString(tr("Buses"));
         case Column::Status:
             return QString(tr("Status"));
+        case Column::Received:
+            return QString(tr("Received"));
+        case Column::Dropped:
+            return QString(tr("Dropped"));
+        case Column::QueuePeak:
+            return QString(tr("Queue Peak"));
         }
     }
 
@@ -50,7 +59,7 @@ QVariant CANConnectionModel::headerData(int section, Qt::Orientation orientation
 int CANConnectionModel::columnCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return 5;
+    return 8;
 }
 
 
@@ -105,6 +114,15 @@ QVariant CANConnectionModel::data(const QModelIndex &index, int role) const
                 break;
             case Column::Status:
                  return (conn_p->getStatus()==CANCon::CONNECTED) ? "Connected" : "Not Connected";
+            case Column::Received:
+                return conn_p->getStats().framesReceived;
+            case Column::Dropped:
+                return conn_p->getDroppedFrames();
+            case Column::QueuePeak:
+            {
+                CANConStats stats = conn_p->getStats();
+                return QString::number(stats.queueHighWater) + " / " + QString::number(stats.queueCapacity);
+            }
         }
     }
     return QVariant();
@@ -149,6 +167,13 @@ CANConnection* CANConnectionModel::getAtIdx(int pIdx) const
     return conns.at(pIdx);
 }
 
+//the counters change all the time, only their cells are redrawn so the selection stays put
+void CANConnectionModel::refreshStats()
+{
+    if (rowCount() == 0) return;
+    emit dataChanged(index(0, int(Column::Received)), index(rowCount() - 1, int(Column::QueuePeak)), QVector<int>() << Qt::DisplayRole);
+}
+
 void CANConnectionModel::refresh(int pIndex)
 {
     Q_UNUSED(pIndex)
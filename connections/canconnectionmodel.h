@@ -29,6 +29,7 @@ public:
 
     CANConnection* getAtIdx(int) const;
     void refresh(int pIndex=-1);
+    void refreshStats();
 };
 
 #endif // CANCONNECTIONMODEL_H
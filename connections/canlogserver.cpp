@@ -1,5 +1,6 @@
 #include <QObject>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QCanBusFrame>
 #include <QSettings>
 #include <QStringBuilder>
@@ -50,9 +51,14 @@ void CanLogServer::readNetworkData()
     if(isCapSuspended())
         return;
 
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+
     while (m_ptcpSocket->canReadLine()) {
         // Get a complete line and remove whitespace at the start and at the end of the string
-        QString data = QString(m_ptcpSocket->readLine()).trimmed();
+        QByteArray line = m_ptcpSocket->readLine();
+        countBytesParsed(line.length());
+        QString data = QString(line).trimmed();
         // Split to space (obtain "<(time)> <canID> <msgId#data>")
         QStringList lstData = data.split(" ");
         // Expect 3 item in list
@@ -93,12 +99,19 @@ void CanLogServer::readNetworkData()
                         checkTargettedFrame(*frame_p);
                         /* enqueue frame */
                         getQueue().queue();
+                        notifyFramesQueued();
                     }
+                    else
+                        getQueue().countDrop();
                     qDebug() << data << "---" << qstrTs << " - " << qstrId << " + " << qstrPayload;
+                    continue;
                 }
             }
         }
+        // Anything that didn't make a frame
+        countParseError();
     }
+    addDecodeTime(decodeTimer.nsecsElapsed());
 }
 
 void CanLogServer::networkConnected()
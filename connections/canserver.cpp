@@ -7,6 +7,7 @@
 
 #include <QObject>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QCanBusFrame>
 #include <QSettings>
 #include <QStringBuilder>
@@ -156,6 +157,10 @@ void CANserver::readNetworkData()
     if(isCapSuspended())
         return;
 
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+    countBytesParsed(datagram.length());
+    if (datagram.length() % 16) countParseError(); //a partial packet at the end is ignored
     
     uint16_t packetCount = datagram.length() / 16;
     //qDebug() << "Processing " << packetCount << " packets";
@@ -222,9 +227,12 @@ void CANserver::readNetworkData()
 
             /* enqueue frame */
             getQueue().queue();
+            notifyFramesQueued();
         }
+        else
+            getQueue().countDrop();
     }
-
+    addDecodeTime(decodeTimer.nsecsElapsed());
 }
 
 void CANserver::heartbeatTimerSlot()
@@ -1,4 +1,9 @@
 #include <QCanBus>
+#include <QDateTime>
+#include <QFileDialog>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QNetworkDatagram>
 #include <QThread>
 
@@ -33,7 +38,9 @@ ConnectionWindow::ConnectionWindow(QWidget *parent) :
     ui->tableConnections->setColumnWidth(1, 100);
     ui->tableConnections->setColumnWidth(2, 130);
     ui->tableConnections->setColumnWidth(3, 70);
-    ui->tableConnections->setColumnWidth(4, 200);
+    ui->tableConnections->setColumnWidth(4, 100);
+    ui->tableConnections->setColumnWidth(5, 90);
+    ui->tableConnections->setColumnWidth(6, 70);
     QHeaderView *HorzHdr = ui->tableConnections->horizontalHeader();
     HorzHdr->setStretchLastSection(true); //causes the data column to automatically fill the tableview
 
@@ -61,6 +68,16 @@ ConnectionWindow::ConnectionWindow(QWidget *parent) :
     connect(ui->btnSaveBus, &QPushButton::clicked, this, &ConnectionWindow::saveBusSettings);
     connect(ui->btnMoveUp, &QPushButton::clicked, this, &ConnectionWindow::moveConnUp);
     connect(ui->btnMoveDown, &QPushButton::clicked, this, &ConnectionWindow::moveConnDown);
+    connect(ui->btnResetStats, &QPushButton::clicked, this, &ConnectionWindow::handleResetStats);
+
+    //the window lives as long as the program does so the stats log keeps going while it's hidden
+    if (settings.value("ConnWindow/StatsLog", false).toBool())
+    {
+        if (openStatsFile(settings.value("ConnWindow/StatsLogFile").toString())) ui->ckStatsLog->setChecked(true);
+    }
+    connect(ui->ckStatsLog, &QCheckBox::toggled, this, &ConnectionWindow::statsLogChanged);
+    connect(&statsTimer, &QTimer::timeout, this, &ConnectionWindow::updateStats);
+    statsTimer.start(qMax(settings.value("ConnWindow/StatsIntervalMS", 1000).toInt(), 100));
 
     ui->cbBusSpeed->addItem("33333");
     ui->cbBusSpeed->addItem("50000");
@@ -200,6 +217,154 @@ bool ConnectionWindow::eventFilter(QObject *obj, QEvent *event)
     //return false;
 }
 
+//the selected device's counters go on screen while the window is up, every device's go to the log
+void ConnectionWindow::updateStats()
+{
+    if (isVisible())
+    {
+        connModel->refreshStats();
+        showStats();
+    }
+    if (statsFile.isOpen()) writeStatsLine();
+}
+
+void ConnectionWindow::showStats()
+{
+    QString text;
+    int selIdx = ui->tableConnections->currentIndex().row();
+    CANConnection *conn_p = (selIdx >= 0) ? connModel->getAtIdx(selIdx) : nullptr;
+    if (conn_p)
+    {
+        CANConStats stats = conn_p->getStats();
+        text = tr("Received %1 frames, %2 queued and %3 dropped for lack of room\n").arg(stats.framesReceived).arg(stats.framesQueued).arg(stats.framesDropped);
+        text += tr("Queue holds %1 of %2 frames, at most %3 so far\n").arg(stats.queueDepth).arg(stats.queueCapacity).arg(stats.queueHighWater);
+        text += tr("Parsed %1 bytes, %2 parse errors\n").arg(stats.bytesParsed).arg(stats.parseErrors);
+        text += tr("Decoding took %1 ms").arg(stats.decodeNanos / 1000000.0, 0, 'f', 1);
+        if (stats.framesReceived) text += tr(", %1 us per frame").arg(stats.decodeNanos / 1000.0 / stats.framesReceived, 0, 'f', 2);
+        text += "\n";
+    }
+    else text = tr("No device selected\n");
+
+    CANConManager::LatencyStats latency = CANConManager::getInstance()->getLatencyStats();
+    text += tr("Delivery latency of the last %1 batches: median %2 us, p99 %3 us, worst %4 us").arg(latency.samples).arg(latency.p50).arg(latency.p99).arg(latency.max);
+
+    CANFrameModel *model = MainWindow::getReference() ? MainWindow::getReference()->getCANFrameModel() : nullptr;
+    if (model)
+    {
+        text += tr("\nFrame list trimmed %1 frames to stay under the frame limit").arg(model->getTrimmedFrames());
+        quint64 hits, misses;
+        int entries;
+        model->getRowCacheStats(hits, misses, entries);
+        if (hits + misses) text += tr("\nFrame list text cache: %1% hits, %2 cells held").arg(hits * 100.0 / (hits + misses), 0, 'f', 1).arg(entries);
+    }
+
+    ui->lblStats->setText(text);
+}
+
+void ConnectionWindow::writeStatsLine()
+{
+    QJsonObject line;
+    line["time"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+
+    QJsonArray devices;
+    QList<CANConnection*>& conns = CANConManager::getInstance()->getConnections();
+    for (int i = 0; i < conns.count(); i++)
+    {
+        CANConnection *conn_p = conns.at(i);
+        CANConStats stats = conn_p->getStats();
+        QJsonObject dev;
+        dev["index"] = i;
+        dev["type"] = connModel->data(connModel->index(i, 0)).toString();
+        dev["port"] = conn_p->getPort();
+        dev["connected"] = conn_p->getStatus() == CANCon::CONNECTED;
+        dev["framesReceived"] = static_cast<double>(stats.framesReceived);
+        dev["framesQueued"] = static_cast<double>(stats.framesQueued);
+        dev["framesDropped"] = static_cast<double>(stats.framesDropped);
+        dev["queueDepth"] = stats.queueDepth;
+        dev["queueHighWater"] = stats.queueHighWater;
+        dev["queueCapacity"] = stats.queueCapacity;
+        dev["bytesParsed"] = static_cast<double>(stats.bytesParsed);
+        dev["parseErrors"] = static_cast<double>(stats.parseErrors);
+        dev["decodeMicros"] = static_cast<double>(stats.decodeNanos / 1000);
+        devices.append(dev);
+    }
+    line["devices"] = devices;
+
+    CANConManager::LatencyStats latency = CANConManager::getInstance()->getLatencyStats();
+    QJsonObject delivery;
+    delivery["samples"] = latency.samples;
+    delivery["p50Micros"] = static_cast<double>(latency.p50);
+    delivery["p99Micros"] = static_cast<double>(latency.p99);
+    delivery["maxMicros"] = static_cast<double>(latency.max);
+    line["delivery"] = delivery;
+
+    CANFrameModel *model = MainWindow::getReference() ? MainWindow::getReference()->getCANFrameModel() : nullptr;
+    if (model)
+    {
+        QJsonObject frameList;
+        frameList["frames"] = model->totalFrameCount();
+        frameList["trimmed"] = static_cast<double>(model->getTrimmedFrames());
+        quint64 hits, misses;
+        int entries;
+        model->getRowCacheStats(hits, misses, entries);
+        frameList["cacheHits"] = static_cast<double>(hits);
+        frameList["cacheMisses"] = static_cast<double>(misses);
+        frameList["cacheEntries"] = entries;
+        line["frameList"] = frameList;
+    }
+
+    QByteArray text = QJsonDocument(line).toJson(QJsonDocument::Compact);
+    text.append('\n');
+    if (statsFile.write(text) != text.length())
+    {
+        qDebug() << "Could not write statistics to" << statsFile.fileName() << ":" << statsFile.errorString();
+        ui->ckStatsLog->setChecked(false);
+        return;
+    }
+    statsFile.flush();
+}
+
+bool ConnectionWindow::openStatsFile(const QString &filename)
+{
+    if (filename.isEmpty()) return false;
+    statsFile.close();
+    statsFile.setFileName(filename);
+    if (!statsFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        qDebug() << "Could not open" << filename << "for the statistics log";
+        return false;
+    }
+    return true;
+}
+
+void ConnectionWindow::statsLogChanged(bool checked)
+{
+    QSettings settings;
+    if (checked && !statsFile.isOpen())
+    {
+        QString filename = QFileDialog::getSaveFileName(this, tr("Log Statistics To"), settings.value("ConnWindow/StatsLogFile").toString(),
+                                                        tr("JSON Lines (*.jsonl)"), nullptr, QFileDialog::DontConfirmOverwrite);
+        if (!openStatsFile(filename))
+        {
+            ui->ckStatsLog->setChecked(false);
+            return;
+        }
+        settings.setValue("ConnWindow/StatsLogFile", filename);
+        writeStatsLine(); //a first line right away shows it's working
+    }
+    else if (!checked) statsFile.close();
+    settings.setValue("ConnWindow/StatsLog", checked);
+}
+
+void ConnectionWindow::handleResetStats()
+{
+    QList<CANConnection*>& conns = CANConManager::getInstance()->getConnections();
+    foreach(CANConnection* conn_p, conns)
+        conn_p->resetStats();
+    CANConManager::getInstance()->resetLatencyStats();
+    updateStats();
+}
+
 void ConnectionWindow::readSettings()
 {
     QSettings settings;
@@ -235,6 +400,7 @@ void ConnectionWindow::consoleEnableChanged(bool checked) {
 
     CANConnection* conn_p = connModel->getAtIdx(selIdx);
 
+    conn_p->setConsoleOutput(checked);
     if (checked) { //enable console
         connect(conn_p, &CANConnection::debugOutput, this, &ConnectionWindow::getDebugText, Qt::UniqueConnection);
         connect(this, &ConnectionWindow::sendDebugData, conn_p, &CANConnection::debugInput, Qt::UniqueConnection);
@@ -456,8 +622,12 @@ void ConnectionWindow::currentRowChanged(const QModelIndex &current, const QMode
     int selIdx = current.row();
     CANConnection* prevConn = connModel->getAtIdx(previous.row());
     if(prevConn != nullptr)
+    {
+        prevConn->setConsoleOutput(false);
         disconnect(prevConn, &CANConnection::debugOutput, nullptr, nullptr);
+    }
     disconnect(this, &ConnectionWindow::sendDebugData, nullptr, nullptr);
+    showStats();
 
     /* set parameters */
     if (selIdx == -1) {
@@ -487,6 +657,7 @@ void ConnectionWindow::currentRowChanged(const QModelIndex &current, const QMode
         populateBusDetails(0);
         if (ui->ckEnableConsole->isChecked())
         {
+            conn_p->setConsoleOutput(true);
             connect(conn_p, &CANConnection::debugOutput, this, &ConnectionWindow::getDebugText, Qt::UniqueConnection);
             connect(this, &ConnectionWindow::sendDebugData, conn_p, &CANConnection::debugInput, Qt::UniqueConnection);
         }
@@ -530,6 +701,7 @@ CANConnection* ConnectionWindow::create(CANCon::type pTye, QString pPortName, QS
         if (ui->ckEnableConsole->isChecked())
         {            
             //set up the debug console to operate if we've selected it. Doing so here allows debugging right away during set up
+            conn_p->setConsoleOutput(true);
             connect(conn_p, &CANConnection::debugOutput, this, &ConnectionWindow::getDebugText, Qt::UniqueConnection);
         }
         /*TODO add return value and checks */
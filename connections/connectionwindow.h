@@ -8,6 +8,7 @@
 #include <QDebug>
 #include <QSettings>
 #include <QTimer>
+#include <QFile>
 #include <QItemSelection>
 #include <QCanBusDeviceInfo>
 #include <QUdpSocket>
@@ -55,6 +56,9 @@ private slots:
     void moveConnDown();
     void connectionStatus(CANConStatus);
     void readPendingDatagrams();
+    void updateStats();
+    void statsLogChanged(bool checked);
+    void handleResetStats();
 
 private:
     Ui::ConnectionWindow *ui;    
@@ -64,9 +68,14 @@ private:
     QUdpSocket *rxBroadcastKayak;
     QVector<QString> remoteDeviceIPGVRET;
     QVector<QString> remoteDeviceKayak;
+    QTimer statsTimer;
+    QFile statsFile; //JSON Lines, one object per tick while statistics logging is on
 
     CANConnection* create(CANCon::type pTye, QString pPortName, QString pDriver, int pSerialSpeed, int pBusSpeed, bool pCanFd, int pDataRate);
     void populateBusDetails(int offset);
+    void showStats();
+    void writeStatsLine();
+    bool openStatsFile(const QString &filename);
     void loadConnections();
     void saveConnections();
     void showEvent(QShowEvent *);
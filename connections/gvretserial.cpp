@@ -1,10 +1,13 @@
 #include <QObject>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QCanBusFrame>
 #include <QSerialPortInfo>
 #include <QSettings>
 #include <QStringBuilder>
 #include <QtNetwork>
+#include <QtEndian>
+#include <cstring>
 
 #include "gvretserial.h"
 
@@ -70,13 +73,7 @@ void GVRetSerial::sendToSerial(const QByteArray &bytes)
         return;
     }
 
-    QString buildDebug;
-    buildDebug = "Write to serial -> ";
-    foreach (int byt, bytes) {
-        byt = (unsigned char)byt;
-        buildDebug = buildDebug % QString::number(byt, 16) % " ";
-    }
-    sendDebug(buildDebug);
+    if (isConsoleOutput()) sendDebug("Write to serial -> " % QString::fromLatin1(bytes.toHex(' ')));
 
     if (serial) serial->write(bytes);
     if (tcpClient) tcpClient->write(bytes);
@@ -574,23 +571,132 @@ void GVRetSerial::connectionTimeout()
 void GVRetSerial::readSerialData()
 {
     QByteArray data;
-    unsigned char c;
-    QString debugBuild;
 
     if (serial) data = serial->readAll();
     if (tcpClient) data = tcpClient->readAll();
     if (udpClient) data = udpClient->readAll();
 
-    sendDebug("Got data from serial. Len = " % QString::number(data.length()));
-    for (int i = 0; i < data.length(); i++)
+    //building the hex dump costs more than parsing, only do it when the console is showing it
+    if (isConsoleOutput())
+    {
+        debugOutput("Got data from serial. Len = " % QString::number(data.length()));
+        debugOutput(QString::fromLatin1(data.toHex(' ')));
+    }
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+    procRXData(reinterpret_cast<const unsigned char *>(data.constData()), data.length());
+    addDecodeTime(decodeTimer.nsecsElapsed());
+    countBytesParsed(data.length());
+}
+
+//GVRET frames as the firmware sends them, multi byte values are little endian:
+//  CAN     F1 00 time(4) id(4) length|bus<<4 data checksum
+//  CAN-FD  F1 14 time(4) id(4) length bus data checksum
+//The checksum is always sent as 0 so it just gets skipped over like anything else outside a command
+void GVRetSerial::procRXData(const unsigned char *data, int length)
+{
+    const unsigned char *pos = data;
+    const unsigned char *end = data + length;
+    while (pos < end)
+    {
+        if (rx_state == IDLE)
+        {
+            //nothing but the start of a command matters when idle so jump right to the next one
+            pos = static_cast<const unsigned char *>(memchr(pos, 0xF1, static_cast<size_t>(end - pos)));
+            if (!pos) return;
+            int used;
+            if (procRXFrame(pos, static_cast<int>(end - pos), used))
+            {
+                pos += used;
+                continue;
+            }
+        }
+        //replies to commands and frames split between two reads go through the state machine
+        procRXChar(*pos++);
+    }
+}
+
+//a frame that is all there in this read gets decoded in one go right into the queue
+bool GVRetSerial::procRXFrame(const unsigned char *msg, int avail, int &used)
+{
+    int headerLen;
+    int dataLen;
+    int bus;
+    bool fd;
+
+    if (avail < 11) return false;
+    if (msg[1] == 0)
+    {
+        headerLen = 11;
+        dataLen = msg[10] & 0xF;
+        bus = (msg[10] & 0xF0) >> 4;
+        fd = false;
+    }
+    else if (msg[1] == 20 && avail >= 12)
+    {
+        headerLen = 12;
+        dataLen = msg[10];
+        bus = msg[11];
+        fd = true;
+    }
+    else return false;
+    if (avail < headerLen + dataLen) return false;
+    used = headerLen + dataLen;
+
+    if (isCapSuspended()) return true;
+    CANFrame* frame_p = getQueue().get();
+    if (!frame_p)
+    {
+        getQueue().countDrop();
+        return true;
+    }
+
+    quint32 id = qFromLittleEndian<quint32>(msg + 6);
+    if (useSystemTime)
     {
-        c = data.at(i);
-        //qDebug() << c << "    " << QString::number(c, 16) << "     " << QString(c);
-        debugBuild = debugBuild % QString::number(c, 16).rightJustified(2,'0') % " ";
-        procRXChar(c);
+        frame_p->setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(QDateTime::currentMSecsSinceEpoch() * 1000ul));
+    } else {
+        frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, static_cast<qint64>(qFromLittleEndian<quint32>(msg + 2)) + timeBasis));
     }
-    debugOutput(debugBuild);
-    //qDebug() << debugBuild;
+    frame_p->setExtendedFrameFormat((id & 0x80000000u) != 0);
+    frame_p->setFrameId(id & 0x7FFFFFFF);
+    frame_p->setFrameType(QCanBusFrame::FrameType::DataFrame);
+    frame_p->setFlexibleDataRateFormat(fd);
+    frame_p->setPayload(QByteArray(reinterpret_cast<const char *>(msg + headerLen), dataLen));
+    frame_p->bus = bus;
+    frame_p->isReceived = true;
+    frame_p->timedelta = 0;
+    frame_p->frameCount = 1;
+    checkTargettedFrame(*frame_p);
+    getQueue().queue();
+    notifyFramesQueued();
+    return true;
+}
+
+void GVRetSerial::queueBuiltFrame()
+{
+    rx_state = IDLE;
+    rx_step = 0;
+    buildFrame.isReceived = true;
+    buildFrame.setPayload(buildData);
+    buildFrame.setFrameType(QCanBusFrame::FrameType::DataFrame);
+    if (isCapSuspended()) return;
+
+    /* get frame from queue */
+    CANFrame* frame_p = getQueue().get();
+    if(frame_p) {
+        /* copy frame */
+        *frame_p = buildFrame;
+        checkTargettedFrame(buildFrame);
+        /* enqueue frame */
+        getQueue().queue();
+        notifyFramesQueued();
+    }
+    else
+        getQueue().countDrop();
+
+    //take the time the frame came in and try to resync the time base.
+    //if (continuousTimeSync) txTimestampBasis = QDateTime::currentMSecsSinceEpoch() - (buildFrame.timestamp / 1000);
 }
 
 //Debugging data sent from connection window. Inject it into Comm traffic.
@@ -665,6 +771,9 @@ void GVRetSerial::procRXChar(unsigned char c)
             rx_step = 0;
             qDebug() << "Got FD settings reply";
             break;
+        default: //not a command we know, keep looking for one
+            countParseError();
+            break;
         }
         break;
     case BUILD_CAN_FRAME:
@@ -712,6 +821,12 @@ void GVRetSerial::procRXChar(unsigned char c)
         case 8:
             buildData.resize(c & 0xF);
             buildFrame.bus = (c & 0xF0) >> 4;
+            buildFrame.setFlexibleDataRateFormat(false);
+            if (buildData.isEmpty()) //no data bytes to wait for
+            {
+                queueBuiltFrame();
+                return;
+            }
             break;
         default:
             if (rx_step < buildData.length() + 9)
@@ -719,29 +834,8 @@ void GVRetSerial::procRXChar(unsigned char c)
                 buildData[rx_step - 9] = c;
                 if (rx_step == buildData.length() + 8) //it's the last data byte so immediately process the frame
                 {
-                    rx_state = IDLE;
-                    rx_step = 0;
-                    buildFrame.isReceived = true;
-                    buildFrame.setPayload(buildData);
-                    buildFrame.setFrameType(QCanBusFrame::FrameType::DataFrame);
-                    if (!isCapSuspended())
-                    {
-                        /* get frame from queue */
-                        CANFrame* frame_p = getQueue().get();
-                        if(frame_p) {
-                            //qDebug() << "GVRET got frame on bus " << frame_p->bus;
-                            /* copy frame */
-                            *frame_p = buildFrame;
-                            checkTargettedFrame(buildFrame);
-                            /* enqueue frame */
-                            getQueue().queue();
-                        }
-                        else
-                            qDebug() << "can't get a frame, ERROR";
-
-                        //take the time the frame came in and try to resync the time base.
-                        //if (continuousTimeSync) txTimestampBasis = QDateTime::currentMSecsSinceEpoch() - (buildFrame.timestamp / 1000);
-                    }
+                    queueBuiltFrame();
+                    return;
                 }
             }
             else //should never get here! But, just in case, reset the comm
@@ -796,41 +890,23 @@ void GVRetSerial::procRXChar(unsigned char c)
             buildFrame.setFrameId(buildId);
             break;
         case 8:
-            buildData.resize(c & 0x3F);
+            buildData.resize(c); //all eight bits, 64 doesn't fit in six
+            buildFrame.setFlexibleDataRateFormat(true);
             break;
         case 9:
             buildFrame.bus = c;
-            break;
-        default:
-            if (rx_step < buildData.length() + 10)
+            if (buildData.isEmpty())
             {
-                buildData[rx_step - 9] = c;
+                queueBuiltFrame();
+                return;
             }
-            else
+            break;
+        default:
+            buildData[rx_step - 10] = c; //data starts after the bus byte
+            if (rx_step == buildData.length() + 9)
             {
-                rx_state = IDLE;
-                rx_step = 0;
-                buildFrame.isReceived = true;
-                buildFrame.setPayload(buildData);
-                buildFrame.setFrameType(QCanBusFrame::FrameType::DataFrame);
-                if (!isCapSuspended())
-                {
-                    /* get frame from queue */
-                    CANFrame* frame_p = getQueue().get();
-                    if(frame_p) {
-                        //qDebug() << "GVRET got frame on bus " << frame_p->bus;
-                        /* copy frame */
-                        *frame_p = buildFrame;
-                        checkTargettedFrame(buildFrame);
-                        /* enqueue frame */
-                        getQueue().queue();
-                    }
-                    else
-                        qDebug() << "can't get a frame, ERROR";
-
-                    //take the time the frame came in and try to resync the time base.
-                    //if (continuousTimeSync) txTimestampBasis = QDateTime::currentMSecsSinceEpoch() - (buildFrame.timestamp / 1000);
-                }
+                queueBuiltFrame();
+                return;
             }
             break;
         }
@@ -59,6 +59,9 @@ protected:
 
     void disconnectDevice();
 
+    //feeds everything one read returned through the parser. Protected so recorded streams can be replayed
+    void procRXData(const unsigned char *data, int length);
+
 public slots:
     void debugInput(QByteArray bytes);
 
@@ -73,6 +76,8 @@ private slots:
 private:
     void readSettings();
     void procRXChar(unsigned char);
+    bool procRXFrame(const unsigned char *msg, int avail, int &used);
+    void queueBuiltFrame();
     void sendCommValidation();
     void rebuildLocalTimeBasis();
     void sendToSerial(const QByteArray &bytes);
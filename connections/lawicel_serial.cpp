@@ -1,5 +1,6 @@
 #include <QObject>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QCanBusFrame>
 #include <QSerialPortInfo>
 #include <QSettings>
@@ -487,6 +488,9 @@ void LAWICELSerial::readSerialData()
 
     if (serial) data = serial->readAll();
 
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+    countBytesParsed(data.length());
     sendDebug("Got data from serial. Len = " % QString::number(data.length()));
     for (int i = 0; i < data.length(); i++)
     {
@@ -569,9 +573,10 @@ void LAWICELSerial::readSerialData()
                         checkTargettedFrame(buildFrame);
                         /* enqueue frame */
                         getQueue().queue();
+                        notifyFramesQueued();
                     }
                     else
-                        qDebug() << "can't get a frame, ERROR";
+                        getQueue().countDrop();
                 }
                 break;
             case 'T': //extended frame
@@ -597,9 +602,10 @@ void LAWICELSerial::readSerialData()
                         checkTargettedFrame(buildFrame);
                         /* enqueue frame */
                         getQueue().queue();
+                        notifyFramesQueued();
                     }
                     else
-                        qDebug() << "can't get a frame, ERROR";
+                        getQueue().countDrop();
                 }
                 break;
             case 'b':
@@ -628,9 +634,10 @@ void LAWICELSerial::readSerialData()
                         checkTargettedFrame(buildFrame);
                         /* enqueue frame */
                         getQueue().queue();
+                        notifyFramesQueued();
                     }
                     else
-                        qDebug() << "can't get a frame, ERROR";
+                        getQueue().countDrop();
                 }
                 break;
             case 'B':
@@ -661,15 +668,17 @@ void LAWICELSerial::readSerialData()
                         checkTargettedFrame(buildFrame);
                         /* enqueue frame */
                         getQueue().queue();
+                        notifyFramesQueued();
                     }
                     else
-                        qDebug() << "can't get a frame, ERROR";
+                        getQueue().countDrop();
                 }
                 break;
             }
             mBuildLine.clear();
         }
     }
+    addDecodeTime(decodeTimer.nsecsElapsed());
     debugOutput(debugBuild);
     //qDebug() << debugBuild;
 }
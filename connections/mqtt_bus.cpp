@@ -285,6 +285,7 @@ void MQTT_BUS::clientMessageReceived(const QMQTT::Message& message)
     if(isCapSuspended())
         return;
 
+    countBytesParsed(message.payload().length());
     CANFrame* frame_p = getQueue().get();
     if(frame_p)
     {
@@ -310,7 +311,10 @@ void MQTT_BUS::clientMessageReceived(const QMQTT::Message& message)
 
         /* enqueue frame */
         getQueue().queue();
+        notifyFramesQueued();
     }
+    else
+        getQueue().countDrop();
 }
 
 void MQTT_BUS::clientConnected()
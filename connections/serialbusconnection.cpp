@@ -6,6 +6,7 @@
 #include <QCanBusFrame>
 #include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
 
 /***********************************/
 /****    class definition       ****/
@@ -173,6 +174,9 @@ void SerialBusConnection::framesReceived()
     if(!mDev_p)
         return;
 
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+
     /* read frame */
     while(true)
     {
@@ -219,11 +223,13 @@ void SerialBusConnection::framesReceived()
 
                 /* enqueue frame */
                 getQueue().queue();
+                notifyFramesQueued();
             }
             else
-                qDebug() << "can't get a frame, ERROR";
+                getQueue().countDrop();
         }
     }
+    addDecodeTime(decodeTimer.nsecsElapsed());
 }
 
 
@@ -1,5 +1,6 @@
 #include <QObject>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QCanBusFrame>
 #include <QSerialPortInfo>
 #include <QSettings>
@@ -320,7 +321,10 @@ QString SocketCANd::decodeFrames(QString data, int busNum)
             checkTargettedFrame(buildFrame);
             /* enqueue frame */
             getQueue().queue();
+            notifyFramesQueued();
         }
+        else
+            getQueue().countDrop();
     }
     //else
     //    qDebug() << "can't get a frame, capture suspended";
@@ -367,13 +371,17 @@ void SocketCANd::invokeReadTCPData()
 
 void SocketCANd::readTCPData(int busNum)
 {
-    QString data;
+    QByteArray bytes;
 
     if (QTcpSocket* socket = tcpClient.value(busNum))
-        data = QString(socket->readAll());
-    //sendDebug("Got data from TCP. Len = " % QString::number(data.length()));
+        bytes = socket->readAll();
+    //sendDebug("Got data from TCP. Len = " % QString::number(bytes.length()));
     //qDebug() << "Received datagramm: " << data;
-    procRXData(data, busNum);
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+    procRXData(QString(bytes), busNum);
+    addDecodeTime(decodeTimer.nsecsElapsed());
+    countBytesParsed(bytes.length());
 }
 
 void SocketCANd::procRXData(QString data, int busNum)
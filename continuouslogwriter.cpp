@@ -0,0 +1,294 @@
+#include "continuouslogwriter.h"
+
+#include <QDebug>
+#include <cstring>
+#include "utility.h"
+
+static const char csvHeader[] = "Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n";
+static const char hexDigits[] = "0123456789ABCDEF";
+
+ContinuousLogWriter::ContinuousLogWriter()
+{
+    mThread_p = new QThread();
+    drainTimer = nullptr;
+    useGzip = false;
+    maxFileBytes = 0;
+    maxFileSeconds = 0;
+    fileNumber = 0;
+    fileOk = false;
+    fileBytes = 0;
+    bytesSinceStats = 0;
+}
+
+ContinuousLogWriter::~ContinuousLogWriter()
+{
+    stop();
+    delete mThread_p;
+}
+
+bool ContinuousLogWriter::start(const QString &filename, bool gzip, qint64 rotateBytes, int rotateSeconds)
+{
+    baseName = filename;
+    useGzip = gzip;
+    maxFileBytes = rotateBytes;
+    maxFileSeconds = rotateSeconds;
+    fileNumber = 0;
+
+    text.reserve(batchBytes + 1024);
+    if (!openFile()) return false;
+    queue.setSize(queueSize);
+
+    moveToThread(mThread_p);
+    connect(mThread_p, SIGNAL(started()), this, SLOT(initialize()));
+    mThread_p->start(QThread::LowPriority);
+    return true;
+}
+
+void ContinuousLogWriter::stop()
+{
+    if (mThread_p->isRunning())
+    {
+        //drains and closes in the worker, then the thread can go
+        QMetaObject::invokeMethod(this, "finalize", Qt::BlockingQueuedConnection);
+        mThread_p->quit();
+        if (!mThread_p->wait()) qDebug() << "can't stop continuous log thread";
+    }
+    else if (fileOk) closeFile(); //never got as far as starting the thread
+}
+
+//single producer, only ever call this from the thread frames are delivered on (the GUI thread)
+void ContinuousLogWriter::queueFrames(const QVector<CANFrame> &frames)
+{
+    int queued = 0;
+    while (queued < frames.count())
+    {
+        //as many records as fit in one go, the ring hands them out up to where it wraps around
+        int granted;
+        ContinuousLogRecord *recs = queue.reserve(frames.count() - queued, granted);
+        if (!recs) break;
+        for (int r = 0; r < granted; r++)
+        {
+            ContinuousLogRecord *rec = recs + r;
+            const CANFrame &frame = frames.at(queued + r);
+            const QByteArray payload = frame.payload();
+            int len = qMin(payload.length(), 64);
+            rec->timeStamp = (static_cast<int64_t>(frame.timeStamp().seconds()) * 1000000) + frame.timeStamp().microSeconds();
+            rec->frameId = frame.frameId();
+            rec->bus = static_cast<uint8_t>(frame.bus);
+            rec->length = static_cast<uint8_t>(len);
+            rec->extended = frame.hasExtendedFrameFormat();
+            rec->received = frame.isReceived;
+            memcpy(rec->data, payload.constData(), static_cast<size_t>(len));
+        }
+        queue.commit(recs, granted);
+        queued += granted;
+    }
+    quint64 dropped = static_cast<quint64>(frames.count() - queued);
+    if (queued) framesQueued.fetchAndAddRelease(queued);
+    if (dropped)
+    {
+        framesDropped.fetchAndAddRelease(dropped);
+        qDebug() << "Continuous log queue full," << dropped << "frames dropped";
+    }
+}
+
+QString ContinuousLogWriter::currentFileName() const
+{
+    QMutexLocker lock(&nameMutex);
+    return openName;
+}
+
+void ContinuousLogWriter::initialize()
+{
+    drainTimer = new QTimer();
+    drainTimer->setInterval(20);
+    connect(drainTimer, &QTimer::timeout, this, &ContinuousLogWriter::drainQueue);
+    sinceWrite.start();
+    sinceStats.start();
+    drainTimer->start();
+}
+
+void ContinuousLogWriter::finalize()
+{
+    if (drainTimer)
+    {
+        drainTimer->stop();
+        delete drainTimer;
+        drainTimer = nullptr;
+    }
+    drainQueue();
+    writeBatch();
+    closeFile();
+    qDebug() << "Continuous log closed," << framesWritten.loadAcquire() << "frames written," << framesDropped.loadAcquire() << "dropped";
+}
+
+void ContinuousLogWriter::drainQueue()
+{
+    quint64 taken = 0;
+    ContinuousLogRecord *recs;
+    int available;
+    while ((recs = queue.peekSpan(available)) != nullptr)
+    {
+        for (int r = 0; r < available; r++)
+        {
+            formatRecord(recs[r]);
+            if (text.length() >= batchBytes) writeBatch();
+        }
+        queue.consume(available);
+        taken += static_cast<quint64>(available);
+    }
+    if (taken) framesWritten.fetchAndAddRelease(taken);
+
+    //anything less than a full batch still goes out once a second so the file never lags far behind
+    if (sinceWrite.elapsed() >= 1000) writeBatch();
+
+    if (fileOk && ((maxFileBytes > 0 && fileBytes >= maxFileBytes) ||
+                   (maxFileSeconds > 0 && fileAge.elapsed() >= maxFileSeconds * 1000ll)))
+    {
+        writeBatch();
+        closeFile();
+        fileNumber++;
+        openFile();
+    }
+
+    qint64 statsElapsed = sinceStats.elapsed();
+    if (statsElapsed >= 1000)
+    {
+        bytesRate.storeRelease((bytesSinceStats * 10000) / statsElapsed);
+        bytesSinceStats = 0;
+        sinceStats.restart();
+    }
+}
+
+//same layout saveNativeCSVFile writes, built by hand since this runs for every frame logged
+void ContinuousLogWriter::formatRecord(const ContinuousLogRecord &rec)
+{
+    char line[320];
+    char *p = line;
+
+    int64_t ts = rec.timeStamp;
+    if (ts < 0)
+    {
+        *p++ = '-';
+        ts = -ts;
+    }
+    char digits[20];
+    int numDigits = 0;
+    do
+    {
+        digits[numDigits++] = static_cast<char>('0' + (ts % 10));
+        ts /= 10;
+    } while (ts > 0);
+    while (numDigits > 0) *p++ = digits[--numDigits];
+    *p++ = ',';
+
+    for (int shift = 28; shift >= 0; shift -= 4) *p++ = hexDigits[(rec.frameId >> shift) & 0xF];
+    *p++ = ',';
+
+    if (rec.extended)
+    {
+        memcpy(p, "true,", 5);
+        p += 5;
+    }
+    else
+    {
+        memcpy(p, "false,", 6);
+        p += 6;
+    }
+    memcpy(p, rec.received ? "Rx," : "Tx,", 3);
+    p += 3;
+
+    if (rec.bus >= 100) *p++ = static_cast<char>('0' + (rec.bus / 100));
+    if (rec.bus >= 10) *p++ = static_cast<char>('0' + ((rec.bus / 10) % 10));
+    *p++ = static_cast<char>('0' + (rec.bus % 10));
+    *p++ = ',';
+
+    if (rec.length >= 10) *p++ = static_cast<char>('0' + (rec.length / 10));
+    *p++ = static_cast<char>('0' + (rec.length % 10));
+    *p++ = ',';
+
+    int columns = qMax(static_cast<int>(rec.length), 8);
+    for (int i = 0; i < columns; i++)
+    {
+        uint8_t byte = (i < rec.length) ? rec.data[i] : 0;
+        *p++ = hexDigits[byte >> 4];
+        *p++ = hexDigits[byte & 0xF];
+        *p++ = ',';
+    }
+    *p++ = '\n';
+
+    text.append(line, static_cast<int>(p - line));
+}
+
+void ContinuousLogWriter::writeBatch()
+{
+    sinceWrite.restart();
+    if (text.isEmpty() || !fileOk) return;
+
+    const QByteArray *out = &text;
+    if (useGzip)
+    {
+        //each batch becomes a gzip member that gunzip and zcat read back like any other .gz file
+        compressed.resize(0);
+        if (!Utility::appendGzip(text, compressed))
+        {
+            qDebug() << "Continuous log compression failed, dropping" << text.length() << "bytes";
+            text.resize(0);
+            return;
+        }
+        out = &compressed;
+    }
+
+    qint64 written = file.write(*out);
+    if (written != out->length())
+    {
+        qDebug() << "Continuous log write to" << file.fileName() << "failed:" << file.errorString();
+    }
+    else
+    {
+        file.flush();
+        fileBytes += written;
+        bytesSinceStats += written;
+    }
+    text.resize(0); //capacity was reserved so this keeps the buffer around for the next batch
+}
+
+QString ContinuousLogWriter::rotatedName(int number) const
+{
+    if (number == 0) return baseName;
+
+    int dirEnd = baseName.lastIndexOf('/');
+    int suffixStart;
+    if (baseName.endsWith(".csv.gz", Qt::CaseInsensitive)) suffixStart = baseName.length() - 7;
+    else suffixStart = baseName.lastIndexOf('.');
+    if (suffixStart <= dirEnd) suffixStart = baseName.length();
+
+    return baseName.left(suffixStart) + QString("_%1").arg(number, 3, 10, QChar('0')) + baseName.mid(suffixStart);
+}
+
+bool ContinuousLogWriter::openFile()
+{
+    QString name = rotatedName(fileNumber);
+    file.setFileName(name);
+    fileOk = file.open(QIODevice::WriteOnly);
+    if (!fileOk)
+    {
+        qDebug() << "Could not open continuous log" << name << file.errorString();
+        return false;
+    }
+    {
+        QMutexLocker lock(&nameMutex);
+        openName = name;
+    }
+    fileBytes = 0;
+    fileAge.start();
+    text.append(csvHeader, static_cast<int>(sizeof(csvHeader) - 1)); //every rotated file stands on its own
+    return true;
+}
+
+void ContinuousLogWriter::closeFile()
+{
+    if (!fileOk) return;
+    file.close();
+    fileOk = false;
+}
@@ -0,0 +1,100 @@
+#ifndef CONTINUOUSLOGWRITER_H
+#define CONTINUOUSLOGWRITER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+#include <QMutex>
+#include "can_structs.h"
+#include "utils/lfqueue.h"
+
+//one frame as it sits in the hand off queue. Fixed size so queueing never allocates
+struct ContinuousLogRecord
+{
+    int64_t timeStamp; //microseconds
+    uint32_t frameId;
+    uint8_t bus;
+    uint8_t length;
+    bool extended;
+    bool received;
+    uint8_t data[64];
+};
+
+/*
+ * Continuous logging to GVRET CSV off the GUI thread. Incoming frames are copied into a lock free
+ * queue as they arrive from the connections. A worker thread drains the
+ * queue on a timer, formats whole batches into a reused buffer and writes each batch with a single
+ * write call. Optionally every batch is written as a gzip member (concatenated members are still
+ * one valid .gz file) and the log can roll over to a new file by size and/or by time.
+ *
+ * If the writer ever falls behind far enough to fill the queue new frames are counted as dropped
+ * rather than stalling the GUI.
+ */
+class ContinuousLogWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int queueSize = 65536; //frames
+    static const int batchBytes = 1048576;
+
+    ContinuousLogWriter();
+    ~ContinuousLogWriter();
+
+    //rotateBytes and rotateSeconds of 0 turn that kind of rotation off
+    bool start(const QString &filename, bool gzip, qint64 rotateBytes, int rotateSeconds);
+    void stop(); //writes out everything still queued and closes the file
+
+    void queueFrames(const QVector<CANFrame> &frames); //never blocks, frames that don't fit are dropped
+
+    //safe to call from any thread
+    int queueDepth() const { return static_cast<int>(framesQueued.loadAcquire() - framesWritten.loadAcquire()); }
+    quint64 writtenCount() const { return framesWritten.loadAcquire(); }
+    quint64 droppedCount() const { return framesDropped.loadAcquire(); }
+    double bytesPerSecond() const { return bytesRate.loadAcquire() / 10.0; }
+    QString currentFileName() const;
+
+private slots:
+    void initialize();
+    void finalize();
+    void drainQueue();
+
+private:
+    bool openFile();
+    void closeFile();
+    void formatRecord(const ContinuousLogRecord &rec);
+    void writeBatch();
+    QString rotatedName(int number) const;
+
+    QThread *mThread_p;
+    QTimer *drainTimer;
+    LFQueue<ContinuousLogRecord> queue;
+
+    QString baseName;
+    bool useGzip;
+    qint64 maxFileBytes;
+    int maxFileSeconds;
+    int fileNumber;
+    mutable QMutex nameMutex;
+    QString openName;
+
+    QFile file;
+    bool fileOk;
+    qint64 fileBytes;
+    QElapsedTimer fileAge;
+    QElapsedTimer sinceWrite;
+    QElapsedTimer sinceStats;
+    qint64 bytesSinceStats;
+    QByteArray text;       //formatted batch, capacity is kept between batches
+    QByteArray compressed; //gzip member being built, also reused
+
+    QAtomicInteger<quint64> framesQueued;
+    QAtomicInteger<quint64> framesWritten; //taken off the queue and formatted
+    QAtomicInteger<quint64> framesDropped;
+    QAtomicInteger<qint64> bytesRate; //bytes per second to disk, times 10
+};
+
+#endif // CONTINUOUSLOGWRITER_H
@@ -2,6 +2,7 @@
 #include "dbchandler.h"
 #include "utility.h"
 #include <QtMath>
+#include <cstring>
 
 DBC_MESSAGE::DBC_MESSAGE()
 {
@@ -10,6 +11,8 @@ DBC_MESSAGE::DBC_MESSAGE()
     len = 0;
     multiplexorSignal = nullptr;
     sender = nullptr;
+    decodePlanValid = false;
+    decodePlanGeneration = 0;
 }
 
 void DBC_SIGNAL::addMultiplexRange(int min, int max)
@@ -481,3 +484,187 @@ DBC_ATTRIBUTE_VALUE *DBC_NODE::findAttrValByIdx(int idx)
     if (idx >= attributes.count()) return nullptr;
     return &attributes[idx];
 }
+
+void DBC_MESSAGE::invalidateDecodePlan()
+{
+    decodePlanValid = false;
+}
+
+/*
+ * The plan is built on first use after the message was loaded or edited. Editing code marks the
+ * DBC file dirty which drops every plan, and adding or removing signals changes the signal handler
+ * generation, so a stale plan never gets used.
+ */
+const QVector<DBC_DECODE_STEP> &DBC_MESSAGE::decodePlan()
+{
+    if (!decodePlanValid || decodePlanGeneration != sigHandler->getGeneration()) compileDecodePlan();
+    return decodeSteps;
+}
+
+void DBC_MESSAGE::compileDecodePlan()
+{
+    decodeSteps.clear();
+    decodeStepIndex.clear();
+    for (int i = 0; i < sigHandler->getCount(); i++)
+    {
+        DBC_SIGNAL *sig = sigHandler->findSignalByIdx(i);
+        if (sig->multiplexParent == nullptr) addDecodeSteps(sig, -1, 0);
+    }
+    decodePlanGeneration = sigHandler->getGeneration();
+    decodePlanValid = true;
+}
+
+void DBC_MESSAGE::addDecodeSteps(DBC_SIGNAL *sig, int parent, int depth)
+{
+    if (depth > 32) return; //a multiplex tree this deep has to be a loop in a broken file
+
+    DBC_DECODE_STEP step;
+    step.sig = sig;
+    step.parent = parent;
+    step.valType = sig->valType;
+    step.isSigned = (sig->valType == SIGNED_INT);
+    step.isInteger = (sig->factor == qFloor(sig->factor));
+    step.factor = sig->factor;
+    step.bias = sig->bias;
+    int bits = sig->signalSize;
+    if (sig->valType == SP_FLOAT) bits = 32;
+    else if (sig->valType == DP_FLOAT) bits = 64;
+    step.location = Utility::locateSignal(sig->startBit, bits, sig->intelByteOrder);
+
+    int idx = decodeSteps.count();
+    decodeSteps.append(step);
+    if (!decodeStepIndex.contains(sig)) decodeStepIndex.insert(sig, idx);
+
+    if (sig->isMultiplexor)
+    {
+        foreach (DBC_SIGNAL *child, sig->multiplexedChildren) addDecodeSteps(child, idx, depth + 1);
+    }
+}
+
+//Same results (and same cachedValue side effect) as processAsText plus processAsInt for multiplexors
+bool DBC_MESSAGE::decodeStep(const DBC_DECODE_STEP &step, const QByteArray &payload, DBC_SIGNAL_VALUE &outValue) const
+{
+    if (!evaluateStep(step, payload, outValue)) return false;
+    if (step.valType == STRING) step.sig->cachedValue = outValue.stringValue;
+    else step.sig->cachedValue = outValue.value;
+    return true;
+}
+
+//the decoding alone, only writes to outValue
+bool DBC_MESSAGE::evaluateStep(const DBC_DECODE_STEP &step, const QByteArray &payload, DBC_SIGNAL_VALUE &outValue)
+{
+    outValue.sig = step.sig;
+    outValue.present = false;
+    outValue.muxValid = false;
+    outValue.isInteger = false;
+
+    if (step.valType == STRING)
+    {
+        QString buildString;
+        int startByte = step.sig->startBit / 8;
+        int bytes = step.sig->signalSize / 8;
+        for (int x = 0; x < bytes && (startByte + x) < payload.length(); x++) buildString.append(payload.at(startByte + x));
+        outValue.stringValue = buildString;
+        outValue.present = true;
+        return true;
+    }
+
+    int64_t raw;
+    if (step.valType == SIGNED_INT || step.valType == UNSIGNED_INT)
+    {
+        raw = Utility::extractSignal(payload, step.location, step.isSigned);
+        outValue.value = ((double)raw * step.factor) + step.bias;
+        outValue.intValue = (int64_t)outValue.value;
+        outValue.isInteger = step.isInteger;
+        outValue.muxValue = static_cast<int32_t>((static_cast<int32_t>(raw) * step.factor) + step.bias);
+        outValue.muxValid = true;
+    }
+    else if (step.valType == SP_FLOAT)
+    {
+        raw = Utility::extractSignal(payload, step.location, false);
+        float floatVal;
+        uint32_t rawBits = static_cast<uint32_t>(raw);
+        memcpy(&floatVal, &rawBits, sizeof(floatVal));
+        outValue.value = (floatVal * step.factor) + step.bias;
+        outValue.intValue = raw;
+    }
+    else //double precision float
+    {
+        if (payload.length() < 8) return false;
+        raw = Utility::extractSignal(payload, step.location, false);
+        double doubleVal;
+        memcpy(&doubleVal, &raw, sizeof(doubleVal));
+        outValue.value = (doubleVal * step.factor) + step.bias;
+        outValue.intValue = raw;
+    }
+
+    outValue.present = true;
+    return true;
+}
+
+/*
+ * Decode every signal in the message in one pass over the plan. outValues lines up with
+ * decodePlan(). A multiplexed signal is present if its multiplexor is present and the
+ * multiplexor value falls in one of the signal's ranges.
+ */
+void DBC_MESSAGE::decodeFrame(const CANFrame &frame, QVector<DBC_SIGNAL_VALUE> &outValues)
+{
+    const QVector<DBC_DECODE_STEP> &plan = decodePlan();
+    const QByteArray payload = frame.payload();
+
+    outValues.resize(plan.count());
+    for (int i = 0; i < plan.count(); i++)
+    {
+        const DBC_DECODE_STEP &step = plan.at(i);
+        DBC_SIGNAL_VALUE &val = outValues[i];
+        if (step.parent >= 0)
+        {
+            const DBC_SIGNAL_VALUE &parentVal = outValues.at(step.parent);
+            if (!parentVal.present || !parentVal.muxValid || !step.sig->isValueMatchingMultiplex(parentVal.muxValue))
+            {
+                val.sig = step.sig;
+                val.present = false;
+                continue;
+            }
+        }
+        decodeStep(step, payload, val);
+    }
+}
+
+//Decode a single signal, only evaluating the multiplexors it depends on
+bool DBC_MESSAGE::decodeSignal(const CANFrame &frame, const DBC_SIGNAL *sig, DBC_SIGNAL_VALUE &outValue)
+{
+    decodePlan();
+    int idx = decodeStepIndex.value(sig, -1);
+    outValue.present = false;
+    if (idx < 0) return false;
+    return decodeChain(idx, frame.payload(), outValue, true);
+}
+
+bool DBC_MESSAGE::evaluateSignal(const CANFrame &frame, const DBC_SIGNAL *sig, DBC_SIGNAL_VALUE &outValue) const
+{
+    outValue.present = false;
+    if (!decodePlanValid || decodePlanGeneration != sigHandler->getGeneration()) return false;
+    int idx = decodeStepIndex.value(sig, -1);
+    if (idx < 0) return false;
+    return decodeChain(idx, frame.payload(), outValue, false);
+}
+
+bool DBC_MESSAGE::decodeChain(int stepIdx, const QByteArray &payload, DBC_SIGNAL_VALUE &outValue, bool updateCache) const
+{
+    const DBC_DECODE_STEP &step = decodeSteps.at(stepIdx);
+    if (step.parent >= 0)
+    {
+        DBC_SIGNAL_VALUE parentVal;
+        if (!decodeChain(step.parent, payload, parentVal, updateCache)) return false;
+        if (!parentVal.muxValid || !step.sig->isValueMatchingMultiplex(parentVal.muxValue)) return false;
+    }
+    return updateCache ? decodeStep(step, payload, outValue) : evaluateStep(step, payload, outValue);
+}
+
+QString DBC_SIGNAL_VALUE::text(bool outputName) const
+{
+    if (sig == nullptr) return QString();
+    if (sig->valType == STRING) return stringValue;
+    return sig->makePrettyOutput(value, intValue, outputName, isInteger);
+}
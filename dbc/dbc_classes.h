@@ -5,7 +5,10 @@
 #include <QString>
 #include <QStringList>
 #include <QVariant>
+#include <QVector>
+#include <QHash>
 #include "can_structs.h"
+#include "utility.h"
 
 /*classes to encapsulate data from a DBC file. Really, the stuff of interest
   are the nodes, messages, signals, attributes, and comments.
@@ -153,6 +156,41 @@ private:
     QList<QPair<int, int>> multiplexLowAndHighValues;
 };
 
+/*
+ * One entry of a message's decode plan. Everything processAsText would otherwise work out on every
+ * call (bit location, signedness, whether the factor is integral) is settled when the plan is built.
+ * Steps are stored depth first through the multiplex tree so a multiplexor always comes before the
+ * signals it selects. parent is the index of that multiplexor step or -1 for top level signals.
+ */
+class DBC_DECODE_STEP
+{
+public:
+    DBC_SIGNAL *sig;
+    int parent;
+    DBC_SIG_VAL_TYPE valType;
+    bool isSigned;
+    bool isInteger;
+    SignalLocation location;
+    double factor;
+    double bias;
+};
+
+//Result of decoding one step of a plan against a frame
+class DBC_SIGNAL_VALUE
+{
+public:
+    DBC_SIGNAL *sig = nullptr;
+    bool present = false; //false if multiplexing says the signal isn't in this frame or it couldn't be decoded
+    double value = 0.0;
+    int64_t intValue = 0;
+    bool isInteger = false;
+    bool muxValid = false; //muxValue is only meaningful for integer signals
+    int32_t muxValue = 0; //value as processAsInt would return it, used to pick multiplexed children
+    QString stringValue; //only for STRING signals
+
+    QString text(bool outputName = true) const;
+};
+
 class DBCSignalHandler; //forward declaration to keep from having to include dbchandler.h in this file and thus create a loop
 
 class DBC_MESSAGE
@@ -175,10 +213,29 @@ public:
     DBC_ATTRIBUTE_VALUE *findAttrValByName(QString name);
     DBC_ATTRIBUTE_VALUE *findAttrValByIdx(int idx);
 
+    const QVector<DBC_DECODE_STEP> &decodePlan();
+    void invalidateDecodePlan();
+    void decodeFrame(const CANFrame &frame, QVector<DBC_SIGNAL_VALUE> &outValues);
+    bool decodeSignal(const CANFrame &frame, const DBC_SIGNAL *sig, DBC_SIGNAL_VALUE &outValue);
+    //decodeSignal without the cachedValue side effect, safe to call from several threads at once.
+    //The plan has to be built beforehand with decodePlan(), with a stale one nothing is decoded
+    bool evaluateSignal(const CANFrame &frame, const DBC_SIGNAL *sig, DBC_SIGNAL_VALUE &outValue) const;
+
     friend bool operator<(const DBC_MESSAGE& l, const DBC_MESSAGE& r)
     {
         return (l.name.toLower() < r.name.toLower());
     }
+private:
+    QVector<DBC_DECODE_STEP> decodeSteps;
+    QHash<const DBC_SIGNAL *, int> decodeStepIndex; //first step for each signal
+    bool decodePlanValid;
+    quint32 decodePlanGeneration; //DBCSignalHandler generation the plan was built against
+
+    void compileDecodePlan();
+    void addDecodeSteps(DBC_SIGNAL *sig, int parent, int depth);
+    bool decodeStep(const DBC_DECODE_STEP &step, const QByteArray &payload, DBC_SIGNAL_VALUE &outValue) const;
+    static bool evaluateStep(const DBC_DECODE_STEP &step, const QByteArray &payload, DBC_SIGNAL_VALUE &outValue);
+    bool decodeChain(int stepIdx, const QByteArray &payload, DBC_SIGNAL_VALUE &outValue, bool updateCache) const;
 };
 
 
@@ -63,6 +63,7 @@ DBC_SIGNAL* DBCSignalHandler::findSignalByName(QString name)
 bool DBCSignalHandler::addSignal(DBC_SIGNAL &sig)
 {
     sigs.append(sig);
+    generation++;
     return true;
 }
 
@@ -74,6 +75,7 @@ bool DBCSignalHandler::removeSignal(DBC_SIGNAL *sig)
         if (sigs[i].name == sig->name)
         {
             sigs.removeAt(i);
+            generation++;
             qDebug() << "Removed signal at idx " << i;
         }
     }
@@ -86,6 +88,7 @@ bool DBCSignalHandler::removeSignal(int idx)
     if (idx < 0) return false;
     if (idx >= sigs.count()) return false;
     sigs.removeAt(idx);
+    generation++;
     return true;
 }
 
@@ -98,6 +101,7 @@ bool DBCSignalHandler::removeSignal(QString name)
         if (sigs[i].name.compare(name, Qt::CaseInsensitive) == 0)
         {
             sigs.removeAt(i);
+            generation++;
             foundSome = true;
         }
     }
@@ -107,6 +111,7 @@ bool DBCSignalHandler::removeSignal(QString name)
 void DBCSignalHandler::removeAllSignals()
 {
     sigs.clear();
+    generation++;
 }
 
 int DBCSignalHandler::getCount()
@@ -117,20 +122,31 @@ int DBCSignalHandler::getCount()
 void DBCSignalHandler::sort()
 {
     std::sort(sigs.begin(), sigs.end());
+    generation++;
 }
 
+quint32 DBCSignalHandler::getGeneration()
+{
+    return generation;
+}
+
+QAtomicInt DBCMessageHandler::lookupGenerationCounter;
+
+/*
+ * Exact ID matches always win. Failing that J1939 mode matches on the PGN and GMLAN mode on the
+ * arbitration ID, in both cases taking the last message in the list that matches. The hashes below
+ * give the same answers as walking the message list but without doing it for every frame.
+ */
 DBC_MESSAGE* DBCMessageHandler::findMsgByID(uint32_t id)
 {
     if (messages.count() == 0) return nullptr;
-    DBC_MESSAGE *bestMatch = nullptr;
 
-    for (int i = 0; i < messages.count(); i++)
-    {
-        if ( messages[i].ID == id )
-        {
-            return &messages[i];
-        }
+    QMutexLocker locker(&indexMutex);
+    if (indexesDirty) rebuildIndexes();
 
+    int idx = exactIndex.value(id, -1);
+    if (idx < 0)
+    {
         if (matchingCriteria == J1939)
         {
             // include data page and extended data page in the pgn
@@ -139,29 +155,59 @@ DBC_MESSAGE* DBCMessageHandler::findMsgByID(uint32_t id)
             {
                 // PDU1 format
                 pgn &= 0x3FF00;
-                if ((messages[i].ID & 0x3FF0000) == (pgn << 8))
-                {
-                    bestMatch = &messages[i];
-                }
+                idx = j1939Pdu1Index.value(pgn << 8, -1);
             }
             else
             {
                 // PDU2 format
-                if ((messages[i].ID & 0x3FFFF00) == (pgn << 8))
-                {
-                    bestMatch = &messages[i];
-                }
+                idx = j1939Pdu2Index.value(pgn << 8, -1);
             }
         }
         else if (matchingCriteria == GMLAN)
         {
             // Match the bits 14-26 (Arbitration Id) of GMLAN 29bit header
-            uint32_t arbId = id &0x3FFE000;
-            if ( (arbId != 0) && (messages[i].ID & 0x3FFE000) == arbId )
-                bestMatch = &messages[i];
+            uint32_t arbId = id & 0x3FFE000;
+            if (arbId != 0) idx = gmlanIndex.value(arbId, -1);
         }
     }
-    return bestMatch;
+    if (idx < 0) return nullptr;
+    return &messages[idx];
+}
+
+void DBCMessageHandler::rebuildIndexes()
+{
+    exactIndex.clear();
+    j1939Pdu1Index.clear();
+    j1939Pdu2Index.clear();
+    gmlanIndex.clear();
+    exactIndex.reserve(messages.count());
+    for (int i = 0; i < messages.count(); i++)
+    {
+        uint32_t id = messages[i].ID;
+        if (!exactIndex.contains(id)) exactIndex.insert(id, i);
+        j1939Pdu1Index.insert(id & 0x3FF0000, i);
+        j1939Pdu2Index.insert(id & 0x3FFFF00, i);
+        gmlanIndex.insert(id & 0x3FFE000, i);
+    }
+    indexesDirty = false;
+}
+
+void DBCMessageHandler::invalidateIndexes()
+{
+    indexMutex.lock();
+    indexesDirty = true;
+    indexMutex.unlock();
+    invalidateLookups();
+}
+
+int DBCMessageHandler::lookupGeneration()
+{
+    return lookupGenerationCounter.loadAcquire();
+}
+
+void DBCMessageHandler::invalidateLookups()
+{
+    lookupGenerationCounter.ref();
 }
 
 DBC_MESSAGE* DBCMessageHandler::findMsgByIdx(int idx)
@@ -220,6 +266,7 @@ QList<DBC_MESSAGE*> DBCMessageHandler::findMsgsByNode(DBC_NODE* node)
 bool DBCMessageHandler::addMessage(DBC_MESSAGE &msg)
 {
     messages.append(msg);
+    invalidateIndexes();
     return true;
 }
 
@@ -231,6 +278,7 @@ bool DBCMessageHandler::removeMessage(DBC_MESSAGE *msg)
         if (messages[i].name == msg->name)
         {
             messages.removeAt(i);
+            invalidateIndexes();
             qDebug() << "Removed message at idx " << i;
             break;
         }
@@ -244,6 +292,7 @@ bool DBCMessageHandler::removeMessageByIndex(int idx)
     if (idx < 0) return false;
     if (idx >= messages.count()) return false;
     messages.removeAt(idx);
+    invalidateIndexes();
     return true;
 }
 
@@ -259,6 +308,7 @@ bool DBCMessageHandler::removeMessage(uint32_t ID)
             foundSome = true;
         }
     }
+    if (foundSome) invalidateIndexes();
     return foundSome;
 }
 
@@ -274,12 +324,14 @@ bool DBCMessageHandler::removeMessage(QString name)
             foundSome = true;
         }
     }
+    if (foundSome) invalidateIndexes();
     return foundSome;
 }
 
 void DBCMessageHandler::removeAllMessages()
 {
     messages.clear();
+    invalidateIndexes();
 }
 
 int DBCMessageHandler::getCount()
@@ -294,6 +346,16 @@ void DBCMessageHandler::sort()
     {
         messages[i].sigHandler->sort();
     }
+    invalidateDecodePlans();
+    invalidateIndexes();
+}
+
+void DBCMessageHandler::invalidateDecodePlans()
+{
+    for (int i = 0; i < messages.count(); i++)
+    {
+        messages[i].invalidateDecodePlan();
+    }
 }
 
 bool DBCMessageHandler::filterLabeling()
@@ -314,6 +376,7 @@ MatchingCriteria_t DBCMessageHandler::getMatchingCriteria()
 void DBCMessageHandler::setMatchingCriteria(MatchingCriteria_t _matchingCriteria)
 {
     matchingCriteria = _matchingCriteria;
+    invalidateLookups();
 }
 
 DBCFile::DBCFile()
@@ -453,6 +516,7 @@ void DBCFile::setAssocBus(int bus)
     //int numBuses = CANConManager::getInstance()->getNumBuses();
     //if (bus >= numBuses) return;
     assocBuses = bus;
+    DBCMessageHandler::invalidateLookups();
 }
 
 DBC_ATTRIBUTE *DBCFile::findAttributeByName(QString name, DBC_ATTRIBUTE_TYPE type)
@@ -485,9 +549,13 @@ void DBCFile::findAttributesByType(DBC_ATTRIBUTE_TYPE typ, QList<DBC_ATTRIBUTE>
     }
 }
 
+//anything that marks the file dirty may have edited message IDs or signal definitions so the
+//lookup indexes and decode plans go stale too
 void DBCFile::setDirtyFlag()
 {
     isDirty = true;
+    messageHandler->invalidateDecodePlans();
+    messageHandler->invalidateIndexes();
 }
 
 //BE CAREFUL HERE. Do not clear the dirty flag unless you're absolutely sure nothing has changed.
@@ -1305,6 +1373,7 @@ bool DBCFile::loadFile(QString fileName)
     this->fileName = fileList[fileList.length() - 1]; //whoops... same name as parameter in this function.
     filePath = fileName.left(fileName.length() - this->fileName.length());
     assocBuses = -1;
+    messageHandler->invalidateDecodePlans(); //signal details get patched up after the signals are added
     isDirty = false;
     return true;
 }
@@ -1882,6 +1951,7 @@ int DBCHandler::createBlankFile()
     newFile.setAssocBus(-1);
 
     loadedFiles.append(newFile);
+    DBCMessageHandler::invalidateLookups();
     return loadedFiles.count();
 }
 
@@ -1891,6 +1961,7 @@ DBCFile* DBCHandler::loadDBCFile(QString filename)
     if (newFile.loadFile(filename))
     {
         loadedFiles.append(newFile);
+        DBCMessageHandler::invalidateLookups();
     }
     else
     {
@@ -2274,11 +2345,13 @@ void DBCHandler::removeDBCFile(int idx)
     if (idx < 0) return;
     if (idx >= loadedFiles.count()) return;
     loadedFiles.removeAt(idx);
+    DBCMessageHandler::invalidateLookups();
 }
 
 void DBCHandler::removeAllFiles()
 {
     loadedFiles.clear();
+    DBCMessageHandler::invalidateLookups();
 }
 
 void DBCHandler::swapFiles(int pos1, int pos2)
@@ -2290,6 +2363,7 @@ void DBCHandler::swapFiles(int pos1, int pos2)
     if (pos2 >= loadedFiles.count()) return;
 
     loadedFiles.swapItemsAt(pos1, pos2);
+    DBCMessageHandler::invalidateLookups();
 }
 
 /*
@@ -2298,17 +2372,38 @@ void DBCHandler::swapFiles(int pos1, int pos2)
  * interpret that frame for you.
  * Returns nullptr if there is no message definition that matches.
 */
+/*
+ * This gets called for every displayed cell and every decoded frame so the answer for each
+ * (bus, ID) pair is remembered. Any change to the loaded files, their messages, bus associations
+ * or matching modes bumps the lookup generation which throws the whole cache away.
+ */
 DBC_MESSAGE* DBCHandler::findMessage(const CANFrame &frame)
 {
+    quint64 key = (static_cast<quint64>(static_cast<uint32_t>(frame.bus)) << 32) | frame.frameId();
+
+    QMutexLocker locker(&messageCacheMutex);
+    int generation = DBCMessageHandler::lookupGeneration();
+    //random IDs (fuzzing for instance) could grow this without bound
+    if (generation != messageCacheGeneration || messageCache.count() > 100000)
+    {
+        messageCache.clear();
+        messageCacheGeneration = generation;
+    }
+
+    QHash<quint64, DBC_MESSAGE*>::const_iterator cached = messageCache.constFind(key);
+    if (cached != messageCache.constEnd()) return cached.value();
+
+    DBC_MESSAGE* found = nullptr;
     for(int i = 0; i < loadedFiles.count(); i++)
     {
         if (loadedFiles[i].getAssocBus() == -1 || frame.bus == loadedFiles[i].getAssocBus())
         {
-            DBC_MESSAGE* msg = loadedFiles[i].messageHandler->findMsgByID(frame.frameId());
-            if (msg != nullptr) return msg;
+            found = loadedFiles[i].messageHandler->findMsgByID(frame.frameId());
+            if (found != nullptr) break;
         }
     }
-    return nullptr;
+    messageCache.insert(key, found);
+    return found;
 }
 
 DBC_MESSAGE* DBCHandler::findMessage(uint32_t id)
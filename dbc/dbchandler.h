@@ -2,6 +2,9 @@
 #define DBCHANDLER_H
 
 #include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
 #include "dbc_classes.h"
 #include "can_structs.h"
 
@@ -30,9 +33,11 @@ public:
     void removeAllSignals();
     int getCount();
     void sort();
+    quint32 getGeneration();
 
 private:
     QList<DBC_SIGNAL> sigs; //signals is a reserved word or I'd have used that
+    quint32 generation = 0; //bumped whenever signals are added, removed or moved so decode plans know to rebuild
 };
 
 class DBCMessageHandler: public QObject
@@ -56,11 +61,26 @@ public:
     void setFilterLabeling( bool labelFiltering );
     bool filterLabeling();
     void sort();
+    void invalidateDecodePlans();
+    void invalidateIndexes();
+    static int lookupGeneration();
+    static void invalidateLookups();
 
 private:
     QList<DBC_MESSAGE> messages;
     MatchingCriteria_t matchingCriteria;
     bool filterLabelingEnabled;
+
+    //findMsgByID indexes, rebuilt on the next lookup after anything changes
+    QHash<uint32_t, int> exactIndex;     //ID -> first message with exactly that ID
+    QHash<uint32_t, int> j1939Pdu1Index; //ID & 0x3FF0000 -> last message with those bits
+    QHash<uint32_t, int> j1939Pdu2Index; //ID & 0x3FFFF00 -> last message with those bits
+    QHash<uint32_t, int> gmlanIndex;     //ID & 0x3FFE000 -> last message with that arbitration ID
+    bool indexesDirty = true;
+    QMutex indexMutex; //frame sender triggers look messages up from their own thread
+    static QAtomicInt lookupGenerationCounter; //bumped whenever any lookup result might change
+
+    void rebuildIndexes();
 };
 
 //technically there should be a node handler too but I'm sort of treating nodes as second class
@@ -140,6 +160,9 @@ public:
 
 private:
     QList<DBCFile> loadedFiles;
+    QHash<quint64, DBC_MESSAGE*> messageCache; //(bus << 32 | ID) -> resolved message, misses are cached as nullptr
+    int messageCacheGeneration = -1;
+    QMutex messageCacheMutex;
 
     DBCHandler();
     static DBCHandler *instance;
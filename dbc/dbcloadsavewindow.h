@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QTableWidget>
 #include <QComboBox>
+#include "canframestore.h"
 #include "dbchandler.h"
 #include "dbcmaineditor.h"
 
@@ -16,7 +17,7 @@ class DBCLoadSaveWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit DBCLoadSaveWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit DBCLoadSaveWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~DBCLoadSaveWindow();
 
 private slots:
@@ -39,7 +40,7 @@ private:
     Ui::DBCLoadSaveWindow *ui;
     DBCHandler *dbcHandler;
     DBCFile *currentlyEditingFile;
-    const QVector<CANFrame> *referenceFrames;
+    const CANFrameStore *referenceFrames;
     DBCMainEditor *editorWindow;
     bool inhibitCellProcessing;
 
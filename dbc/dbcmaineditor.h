@@ -6,6 +6,7 @@
 #include <QIcon>
 #include <QTreeWidget>
 #include <QRandomGenerator>
+#include "canframestore.h"
 #include "dbchandler.h"
 #include "dbcsignaleditor.h"
 #include "dbcmessageeditor.h"
@@ -30,7 +31,7 @@ class DBCMainEditor : public QDialog
     Q_OBJECT
 
 public:
-    explicit DBCMainEditor(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit DBCMainEditor(const CANFrameStore *frames, QWidget *parent = 0);
     ~DBCMainEditor();
     void setFileIdx(int idx);
 
@@ -62,7 +63,7 @@ private slots:
 private:
     Ui::DBCMainEditor *ui;
     DBCHandler *dbcHandler;
-    const QVector<CANFrame> *referenceFrames;
+    const CANFrameStore *referenceFrames;
     DBCSignalEditor *sigEditor;
     DBCMessageEditor *msgEditor;
     DBCNodeEditor *nodeEditor;
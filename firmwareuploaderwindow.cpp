@@ -11,7 +11,7 @@
 //for firmware updates and wouldn't need this specific code. But, it might be able to be turned into a UDS firmware uploader or downloader.
 //Note that this screen is specifically hidden by default because of it's oddball status. You have to re-enable it in mainwindow.cpp to see it.
 
-FirmwareUploaderWindow::FirmwareUploaderWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+FirmwareUploaderWindow::FirmwareUploaderWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FirmwareUploaderWindow)
 {
@@ -75,6 +75,11 @@ void FirmwareUploaderWindow::updatedFrames(int numFrames)
     }
 }
 
+void FirmwareUploaderWindow::gotTargettedFrames(const QVector<CANFrame> &frames)
+{
+    foreach (const CANFrame &frame, frames) gotTargettedFrame(frame);
+}
+
 void FirmwareUploaderWindow::gotTargettedFrame(CANFrame frame)
 {
     const unsigned char *data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
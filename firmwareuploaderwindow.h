@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QTimer>
 #include "can_structs.h"
+#include "canframestore.h"
 #include "connections/canconmanager.h"
 #include "utility.h"
 
@@ -16,10 +17,11 @@ class FirmwareUploaderWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit FirmwareUploaderWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit FirmwareUploaderWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~FirmwareUploaderWindow();
 
 public slots:
+    void gotTargettedFrames(const QVector<CANFrame> &frames);
     void gotTargettedFrame(CANFrame frame);
 
 private slots:
@@ -43,7 +45,7 @@ private:
     int bus;
     uint32_t token;
     QByteArray firmwareData;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     QTimer *timer;
 };
 
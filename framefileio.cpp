@@ -6,14 +6,27 @@
 #include <QRegularExpression>
 #include <QtEndian>
 #include <QSettings>
+#include <QHash>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include "pcaplite.h"
 
 #include "utility.h"
 #include "blfhandler.h"
+#include "nativebinaryfile.h"
+#include "utils/capturepager.h"
+#include "utils/chunkedtextloader.h"
+#include "utils/filesniff.h"
+#include "utils/frameexporter.h"
+#include "continuouslogwriter.h"
 
-QFile FrameFileIO::continuousFile;
+ContinuousLogWriter *FrameFileIO::continuousWriter = nullptr;
+AutoDetectStats FrameFileIO::autoDetectStats;
 
 struct TeslaAPCANRecord
 {
@@ -32,7 +45,7 @@ FrameFileIO::FrameFileIO()
 {
 }
 
-bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* frameCache)
+bool FrameFileIO::saveFrameFile(QString &fileName, const CANFrameStore* frameCache)
 {
     QString filename;
     QFileDialog dialog(qApp->activeWindow());
@@ -53,6 +66,8 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
     filters.append(QString(tr("Cabana Log (*.csv *.CSV)")));
     filters.append(QString(tr("CANalyzer Ascii Log (*.asc *.ASC)")));
     filters.append(QString(tr("CARBUS Analyzer (*.trc *.TRC)")));
+    filters.append(QString(tr("SavvyCAN Binary Capture (*.scb *.SCB)")));
+    filters.append(QString(tr("Wireshark SocketCAN (*.pcapng *.PCAPNG)")));
 
     dialog.setDirectory(settings.value("FileIO/LoadSaveDirectory", dialog.directory().path()).toString());
     dialog.setFileMode(QFileDialog::AnyFile);
@@ -67,81 +82,94 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
         QProgressDialog progress(qApp->activeWindow());
         progress.setWindowModality(Qt::WindowModal);
         progress.setLabelText("Saving file...");
-        progress.setCancelButton(nullptr);
         progress.setRange(0,0);
         progress.setMinimumDuration(0);
         progress.show();
 
         qApp->processEvents();
 
+        //the savers keep events going for the progress dialog and frames keep arriving in the meantime,
+        //so they work on a copy. It's cheap, the store only shares its vectors until the original changes
+        const CANFrameStore frames(*frameCache);
+
         if (dialog.selectedNameFilter() == filters[0])
         {
             if (!filename.contains('.')) filename += ".csv";
-            result = saveNativeCSVFile(filename, frameCache);
+            result = saveNativeCSVFile(filename, &frames, &progress);
         }
         if (dialog.selectedNameFilter() == filters[1])
         {
             if (!filename.contains('.')) filename += ".txt";
-            result = saveCRTDFile(filename, frameCache);
+            result = saveCRTDFile(filename, &frames, &progress);
         }
         if (dialog.selectedNameFilter() == filters[2])
         {
             if (!filename.contains('.')) filename += ".csv";
-            result = saveGenericCSVFile(filename, frameCache);
+            result = saveGenericCSVFile(filename, &frames, &progress);
         }
         if (dialog.selectedNameFilter() == filters[3])
         {
             if (!filename.contains('.')) filename += ".log";
-            result = saveLogFile(filename, frameCache);
+            result = saveLogFile(filename, &frames, &progress);
         }
         if (dialog.selectedNameFilter() == filters[4])
         {
             if (!filename.contains('.')) filename += ".log";
-            result = saveMicrochipFile(filename, frameCache);
+            result = saveMicrochipFile(filename, &frames, &progress);
         }
 
         if (dialog.selectedNameFilter() == filters[5])
         {
             if (!filename.contains('.')) filename += ".trace";
-            result = saveTraceFile(filename, frameCache);
+            result = saveTraceFile(filename, &frames, &progress);
         }
 
         if (dialog.selectedNameFilter() == filters[6])
         {
             if (!filename.contains('.')) filename += ".csv";
-            result = saveIXXATFile(filename, frameCache);
+            result = saveIXXATFile(filename, &frames, &progress);
         }
 
         if (dialog.selectedNameFilter() == filters[7])
         {
             if (!filename.contains('.')) filename += ".can";
-            result = saveCANDOFile(filename, frameCache);
+            result = saveCANDOFile(filename, &frames, &progress);
         }
 
         if (dialog.selectedNameFilter() == filters[8])
         {
             if (!filename.contains('.')) filename += ".csv";
-            result = saveVehicleSpyFile(filename, frameCache);
+            result = saveVehicleSpyFile(filename, &frames, &progress);
         }
         if (dialog.selectedNameFilter() == filters[9])
         {
             if (!filename.contains('.')) filename += ".log";
-            saveCanDumpFile(filename,frameCache);
+            result = saveCanDumpFile(filename, &frames, &progress);
         }
         if (dialog.selectedNameFilter() == filters[10])
         {
             if (!filename.contains('.')) filename += ".csv";
-            result = saveCabanaFile(filename, frameCache);
+            result = saveCabanaFile(filename, &frames, &progress);
         }
         if (dialog.selectedNameFilter() == filters[11])
         {
             if (!filename.contains('.')) filename += ".asc";
-            result = saveCanalyzerASC(filename, frameCache);
+            result = saveCanalyzerASC(filename, &frames, &progress);
         }
         if (dialog.selectedNameFilter() == filters[12])
         {
             if (!filename.contains('.')) filename += ".trc";
-            result = saveCARBUSAnalzyer(filename, frameCache);
+            result = saveCARBUSAnalzyer(filename, &frames, &progress);
+        }
+        if (dialog.selectedNameFilter() == filters[13])
+        {
+            if (!filename.contains('.')) filename += ".scb";
+            result = saveNativeBinaryFile(filename, &frames, &progress);
+        }
+        if (dialog.selectedNameFilter() == filters[14])
+        {
+            if (!filename.contains('.')) filename += ".pcapng";
+            result = saveWiresharkFile(filename, &frames, &progress);
         }
 
         progress.cancel();
@@ -158,7 +186,7 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
     return false;
 }
 
-bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache)
+bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache, CapturePager **pagedFile)
 {
     QString filename;
     QFileDialog dialog;
@@ -191,7 +219,8 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
     filters.append(QString(tr("CLX000 (*.txt *.TXT)")));
     filters.append(QString(tr("CANServer Binary Log (*.log *.LOG)")));
     filters.append(QString(tr("Wireshark (*.pcap *.PCAP *.pcapng *.PCAPNG)")));
-    filters.append(QString(tr("Wireshark SocketCAN (*.pcap *.PCAP")));
+    filters.append(QString(tr("Wireshark SocketCAN (*.pcap *.PCAP *.pcapng *.PCAPNG)")));
+    filters.append(QString(tr("SavvyCAN Binary Capture (*.scb *.SCB)")));
 
     dialog.setDirectory(settings.value("FileIO/LoadSaveDirectory", dialog.directory().path()).toString());
     dialog.setFileMode(QFileDialog::ExistingFile);
@@ -213,6 +242,23 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
 
         qApp->processEvents();
 
+        //too big to hold in memory, index it and read it as the view scrolls instead. The formats
+        //that can't be paged still load the normal way
+        bool pageable = (selectedNameFilter == filters[0] || selectedNameFilter == filters[1] || selectedNameFilter == filters[9]
+                         || selectedNameFilter == filters[14] || selectedNameFilter == filters[26]);
+        if (pagedFile && pageable && isHugeFile(filename))
+        {
+            *pagedFile = openPagedFile(filename);
+            if (*pagedFile)
+            {
+                progress.cancel();
+                QStringList fileList = filename.split('/');
+                fileName = fileList[fileList.length() - 1];
+                settings.setValue("FileIO/LoadSaveDirectory", dialog.directory().path());
+                return true;
+            }
+        }
+
         if (selectedNameFilter == filters[0]) result = autoDetectLoadFile(filename, frameCache);
         if (selectedNameFilter == filters[1]) result = loadNativeCSVFile(filename, frameCache);
         if (selectedNameFilter == filters[2]) result = loadCRTDFile(filename, frameCache);
@@ -239,6 +285,7 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
         if (selectedNameFilter == filters[23]) result = loadCANServerFile(filename, frameCache);
         if (selectedNameFilter == filters[24]) result = loadWiresharkFile(filename, frameCache);
         if (selectedNameFilter == filters[25]) result = loadWiresharkSocketCANFile(filename, frameCache);
+        if (selectedNameFilter == filters[26]) result = loadNativeBinaryFile(filename, frameCache);
 
 
         progress.cancel();
@@ -265,310 +312,188 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
 }
 
 
-//Try every format by first using the "is" functions which try to detect whether a given file is a good match to that
-//file format or not. Those functions are much less tolerant than the load functions and so should help to discriminate
-//whether a file could be loaded or not by a given loader. The loader return is still used in case the guess was wrong.
-bool FrameFileIO::autoDetectLoadFile(QString filename, QVector<CANFrame>* frames)
+//One entry per format autoDetectLoadFile knows. They're listed in the order the formats used to be
+//tried in one after the other, which now only settles ties between equal probe scores.
+struct AutoDetectFormat
 {
-    qDebug() << "Attempting Canalyzer BLF";
-    if (isCanalyzerBLF(filename))
-    {
-        if (loadCanalyzerBLF(filename, frames))
-        {
-            qDebug() << "Loaded as Canalyzer BLF successfully!";
-            return true;
-        }
-    }
-
-    qDebug() << "Attempting native CSV";
-    if (isNativeCSVFile(filename))
-    {
-        if (loadNativeCSVFile(filename, frames))
-        {
-            qDebug() << "Loaded as native CSV successfully!";
-            return true;
-        }
-    }
-
-    // Attempt to load socket CAN first to avoid generic wireshark logic catching it
-    qDebug() << "Attempting Wireshark Socket CAN Log";
-    if (isWiresharkSocketCANFile(filename))
-    {
-        if (loadWiresharkSocketCANFile(filename, frames))
-        {
-            qDebug() << "Loaded as Wireshark SocketCAN Log successfully!";
-            return true;
-        }
-    }
-
-    // This and the decoder above were both moved above TeslaAPFile as they match based on magic numbers and sometimes these files were falling into the TeslaAP decoder
-    qDebug() << "Attempting Wireshark Log";
-    if (isWiresharkFile(filename))
-    {
-        if (loadWiresharkFile(filename, frames))
-        {
-            qDebug() << "Loaded as Wireshark Log successfully!";
-            return true;
-        }
-    }
-
-    qDebug() << "Attempting Tesla AP Snapshot";
-    if (isTeslaAPFile(filename))
-    {
-        if (loadTeslaAPFile(filename, frames))
-        {
-            qDebug() << "Loaded as Tesla AP Snapshot successfully!";
-            return true;
-        }
-    }
-
-    qDebug() << "Attempting CANServer Binary Log";
-    if (isCANServerFile(filename))
-    {
-        if (loadCANServerFile(filename, frames))
-        {
-            qDebug() << "Loaded as CANServer Binary Log successfully!";
-            return true;
-        }
-    }
-
-    qDebug() << "Attempting canalyzer ASC";
-    if (isCanalyzerASC(filename))
-    {
-        if (loadCanalyzerASC(filename, frames))
-        {
-            qDebug() << "Loaded as Canalyzer ASC successfully!";
-            return true;
-        }
-    }
-
-    qDebug() << "Attempting CRTD";
-    if (isCRTDFile(filename))
-    {
-        if (loadCRTDFile(filename, frames))
-        {
-            qDebug() << "Loaded as CRTD successfully!";
-            return true;
-        }
-    }
-
-
-    qDebug() << "Attempting trace file";
-    if (isTraceFile(filename))
-    {
-        if (loadTraceFile(filename, frames))
-        {
-            qDebug() << "Loaded as trace successfully!";
-            return true;
-        }
-    }
-
-    qDebug() << "Attempting vehicle spy";
-    if (isVehicleSpyFile(filename))
-    {
-        if (loadVehicleSpyFile(filename, frames))
-        {
-            qDebug() << "Loaded as vehicle spy successfully!";
-            return true;
-        }
-    }
-
-    qDebug() << "Attempting candump";
-    if (isCanDumpFile(filename))
-    {
-        if (loadCanDumpFile(filename, frames))
-        {
-            qDebug() << "Loaded as candump successfully!";
-            return true;
-        }
-    }
+    const char *name;
+    int (*probe)(const FileSniff &);
+    bool (*load)(QString, QVector<CANFrame>*);
+    bool (*page)(QString, CapturePager*); //formats that can be shown a page at a time, null for the rest
+};
 
-    qDebug() << "Attempting 'CARBUS Analyzer'";
-    if (isCARBUSAnalyzerFile(filename))
-    {
-        if (loadCARBUSAnalyzerFile(filename, frames))
-        {
-            qDebug() << "Loaded as 'CARBUS Analyzer' successfully!";
-            return true;
-        }
-    }
+struct AutoDetectCandidate
+{
+    int format;
+    int score;
+};
 
-    qDebug() << "Attempting canhacker";
-    if (isCANHackerFile(filename))
-    {
-        if (loadCANHackerFile(filename, frames))
-        {
-            qDebug() << "Loaded as CANHacker successfully!";
-            return true;
-        }
-    }
+static bool pageNativeBinaryFile(QString filename, CapturePager *pager);
+static bool pageNativeCSVFile(QString filename, CapturePager *pager);
+static bool pageCanDumpFile(QString filename, CapturePager *pager);
+static bool pageCanalyzerASC(QString filename, CapturePager *pager);
 
-    qDebug() << "Attempting cabana";
-    if (isCabanaFile(filename))
-    {
-        if (loadCabanaFile(filename, frames))
-        {
-            qDebug() << "Loaded as Cabana successfully!";
-            return true;
-        }
-    }
+static bool loadKvaserHexOrDecimalFile(QString filename, QVector<CANFrame>* frames)
+{
+    int startCount = frames->count();
+    if (FrameFileIO::loadKvaserFile(filename, frames, true)) return true;
+    frames->resize(startCount);
+    return FrameFileIO::loadKvaserFile(filename, frames, false);
+}
 
-    qDebug() << "Attempting canopen";
-    if (isCANOpenFile(filename))
-    {
-        if (loadCANOpenFile(filename, frames))
-        {
-            qDebug() << "Loaded as CANOpen Magic successfully!";
-            return true;
-        }
-    }
+static const AutoDetectFormat autoDetectFormats[] =
+{
+    {"native binary capture", FrameFileIO::probeNativeBinaryFile, FrameFileIO::loadNativeBinaryFile, pageNativeBinaryFile},
+    {"Canalyzer BLF", FrameFileIO::probeCanalyzerBLF, FrameFileIO::loadCanalyzerBLF, nullptr},
+    {"native CSV", FrameFileIO::probeNativeCSVFile, FrameFileIO::loadNativeCSVFile, pageNativeCSVFile},
+    // socket CAN goes before the generic wireshark logic so that doesn't catch it
+    {"Wireshark SocketCAN Log", FrameFileIO::probeWiresharkSocketCANFile, FrameFileIO::loadWiresharkSocketCANFile, nullptr},
+    {"Wireshark Log", FrameFileIO::probeWiresharkFile, FrameFileIO::loadWiresharkFile, nullptr},
+    {"Tesla AP Snapshot", FrameFileIO::probeTeslaAPFile, FrameFileIO::loadTeslaAPFile, nullptr},
+    {"CANServer Binary Log", FrameFileIO::probeCANServerFile, FrameFileIO::loadCANServerFile, nullptr},
+    {"Canalyzer ASC", FrameFileIO::probeCanalyzerASC, FrameFileIO::loadCanalyzerASC, pageCanalyzerASC},
+    {"CRTD", FrameFileIO::probeCRTDFile, FrameFileIO::loadCRTDFile, nullptr},
+    {"trace", FrameFileIO::probeTraceFile, FrameFileIO::loadTraceFile, nullptr},
+    {"vehicle spy", FrameFileIO::probeVehicleSpyFile, FrameFileIO::loadVehicleSpyFile, nullptr},
+    {"candump", FrameFileIO::probeCanDumpFile, FrameFileIO::loadCanDumpFile, pageCanDumpFile},
+    {"'CARBUS Analyzer'", FrameFileIO::probeCARBUSAnalyzerFile, FrameFileIO::loadCARBUSAnalyzerFile, nullptr},
+    {"CANHacker", FrameFileIO::probeCANHackerFile, FrameFileIO::loadCANHackerFile, nullptr},
+    {"Cabana", FrameFileIO::probeCabanaFile, FrameFileIO::loadCabanaFile, nullptr},
+    {"CANOpen Magic", FrameFileIO::probeCANOpenFile, FrameFileIO::loadCANOpenFile, nullptr},
+    {"Busmaster Log", FrameFileIO::probeLogFile, FrameFileIO::loadLogFile, nullptr},
+    {"PCAN", FrameFileIO::probePCANFile, FrameFileIO::loadPCANFile, nullptr},
+    {"IXXAT", FrameFileIO::probeIXXATFile, FrameFileIO::loadIXXATFile, nullptr},
+    {"microchip", FrameFileIO::probeMicrochipFile, FrameFileIO::loadMicrochipFile, nullptr},
+    {"CANDO", FrameFileIO::probeCANDOFile, FrameFileIO::loadCANDOFile, nullptr},
+    {"Kvaser", FrameFileIO::probeKvaserFile, loadKvaserHexOrDecimalFile, nullptr},
+    {"CLX000", FrameFileIO::probeCLX000File, FrameFileIO::loadCLX000File, nullptr},
+    {"lawicel", FrameFileIO::probeLawicelFile, FrameFileIO::loadLawicelFile, nullptr},
+    {"generic CSV", FrameFileIO::probeGenericCSVFile, FrameFileIO::loadGenericCSVFile, nullptr},
+};
 
-    qDebug() << "Attempting busmaster log";
-    if (isLogFile(filename))
-    {
-        if (loadLogFile(filename, frames))
-        {
-            qDebug() << "Loaded as Busmaster Log successfully!";
-            return true;
-        }
-    }
+//every format's probe scores the sniff, all of them at the same time. Best score first
+static QVector<AutoDetectCandidate> rankFormats(const FileSniff &sniff)
+{
+    const int numFormats = static_cast<int>(sizeof(autoDetectFormats) / sizeof(autoDetectFormats[0]));
+    QVector<AutoDetectCandidate> candidates(numFormats);
+    for (int i = 0; i < numFormats; i++) candidates[i].format = i;
+    QtConcurrent::blockingMap(candidates, [&sniff](AutoDetectCandidate &candidate)
+    {
+        candidate.score = autoDetectFormats[candidate.format].probe(sniff);
+    });
+    std::stable_sort(candidates.begin(), candidates.end(), [](const AutoDetectCandidate &a, const AutoDetectCandidate &b)
+    {
+        return a.score > b.score;
+    });
+    return candidates;
+}
 
-    qDebug() << "Attempting pcan";
-    if (isPCANFile(filename))
-    {
-        if (loadPCANFile(filename, frames))
+//The start of the file is read once and every format's probe scores it, all of them at the same
+//time. The probes are much less tolerant than the loaders and so should help to discriminate
+//whether a file could be loaded or not by a given loader. Loaders are then tried from the best
+//score down, the loader return is still used in case the guess was wrong.
+bool FrameFileIO::autoDetectLoadFile(QString filename, QVector<CANFrame>* frames)
+{
+    QElapsedTimer timer;
+    timer.start();
+    autoDetectStats.format.clear();
+    autoDetectStats.score = PROBE_NO_MATCH;
+    autoDetectStats.formatsTried = 0;
+    autoDetectStats.probeMicros = 0;
+    autoDetectStats.loadMicros = 0;
+
+    FileSniff sniff(filename);
+    autoDetectStats.sniffMicros = timer.nsecsElapsed() / 1000;
+
+    QVector<AutoDetectCandidate> candidates;
+    if (sniff.isOpen()) candidates = rankFormats(sniff);
+    else qDebug() << "Could not open" << filename;
+    autoDetectStats.probeMicros = (timer.nsecsElapsed() / 1000) - autoDetectStats.sniffMicros;
+
+    for (int i = 0; i < candidates.count() && candidates.at(i).score > PROBE_NO_MATCH; i++)
+    {
+        const AutoDetectFormat &format = autoDetectFormats[candidates.at(i).format];
+        qDebug() << "Attempting" << format.name << "scored" << candidates.at(i).score;
+        autoDetectStats.formatsTried++;
+        int startCount = frames->count();
+        if (format.load(filename, frames))
         {
-            qDebug() << "Loaded as PCAN successfully!";
+            autoDetectStats.format = format.name;
+            autoDetectStats.score = candidates.at(i).score;
+            autoDetectStats.totalMicros = timer.nsecsElapsed() / 1000;
+            autoDetectStats.loadMicros = autoDetectStats.totalMicros - autoDetectStats.sniffMicros - autoDetectStats.probeMicros;
+            qDebug() << "Loaded as" << format.name << "successfully! Sniff" << autoDetectStats.sniffMicros << "us, probes"
+                     << autoDetectStats.probeMicros << "us, open to frames" << autoDetectStats.totalMicros / 1000 << "ms";
             return true;
         }
+        frames->resize(startCount); //don't leave a failed loader's frames behind for the next one
     }
 
-    qDebug() << "Attempting ixxat";
-    if (isIXXATFile(filename))
-    {
-        if (loadIXXATFile(filename, frames))
-        {
-            qDebug() << "Loaded as IXXAT successfully!";
-            return true;
-        }
-    }
+    autoDetectStats.totalMicros = timer.nsecsElapsed() / 1000;
+    autoDetectStats.loadMicros = autoDetectStats.totalMicros - autoDetectStats.sniffMicros - autoDetectStats.probeMicros;
 
-    qDebug() << "Attempting microchip";
-    if (isMicrochipFile(filename))
-    {
-        if (loadMicrochipFile(filename, frames))
-        {
-            qDebug() << "Loaded as microchip successfully!";
-            return true;
-        }
-    }
+    QMessageBox msgBox;
+    msgBox.setText("Could not autodetect the file type.\rPlease try to manually select the file format.");
+    msgBox.exec();
+    qDebug() << "Nothing worked... sorry...";
+    return false;
+}
 
-    qDebug() << "Attempting CANDo";
-    if (isCANDOFile(filename))
-    {
-        if (loadCANDOFile(filename, frames))
-        {
-            qDebug() << "Loaded as CANDO successfully!";
-            return true;
-        }
-    }
+bool FrameFileIO::isHugeFile(QString filename)
+{
+    QSettings settings;
+    //off unless asked for, a paged file is only shown in the frame list and the other tools don't see it
+    qint64 hugeMB = settings.value("Main/HugeFileMB", 0).toInt();
+    if (hugeMB <= 0) return false;
+    return QFileInfo(filename).size() >= hugeMB * 1048576ll;
+}
 
-    qDebug() << "Attempting kvaser";
-    if (isKvaserFile(filename))
-    {
-        if (loadKvaserFile(filename, frames,true))
-        {
-            qDebug() << "Loaded as Kvaser HEX successfully!";
-            return true;
-        }
-        if (loadKvaserFile(filename, frames,false))
-        {
-            qDebug() << "Loaded as KVaser Decimal successfully!";
-            return true;
-        }
-    }
+//Only the format the probes like best is considered. If it can't be paged the file gets loaded
+//the normal way instead of paging a format that merely didn't object to the file.
+CapturePager *FrameFileIO::openPagedFile(QString filename)
+{
+    FileSniff sniff(filename);
+    if (!sniff.isOpen()) return nullptr;
+    QVector<AutoDetectCandidate> candidates = rankFormats(sniff);
+    if (candidates.isEmpty() || candidates.at(0).score == PROBE_NO_MATCH) return nullptr;
 
-    qDebug() << "Attempting CLX000";
-    if (isCLX000File(filename))
-    {
-        if (loadCLX000File(filename, frames))
-        {
-            qDebug() << "Loaded as CLX000 successfully!";
-            return true;
-        }
-    }
+    const AutoDetectFormat &format = autoDetectFormats[candidates.at(0).format];
+    if (!format.page) return nullptr;
 
-    qDebug() << "Attempting lawicel";
-    if (isLawicelFile(filename))
+    QElapsedTimer timer;
+    timer.start();
+    CapturePager *pager = new CapturePager;
+    if (!format.page(filename, pager))
     {
-        if (loadLawicelFile(filename, frames))
-        {
-            qDebug() << "Loaded as lawicel successfully!";
-            return true;
-        }
+        delete pager;
+        return nullptr;
     }
+    pager->waitForFirstPage();
+    qDebug() << "Paging" << filename << "as" << format.name << "," << pager->frameCount() << "frames ready after" << timer.elapsed() << "ms";
+    return pager;
+}
 
-    qDebug() << "Attempting generic CSV";
-    if (isGenericCSVFile(filename))
+int FrameFileIO::probeVehicleSpyFile(const FileSniff &sniff)
+{
+    bool foundProbableHeader = false;
+    for (int i = 0; i < 10; i++)
     {
-        if (loadGenericCSVFile(filename, frames))
+        QByteArray line = sniff.line(i).simplified().toUpper();
+        if (line.startsWith("LINE") && line.contains("TIME") && line.contains("B1"))
         {
-            qDebug() << "Loaded as generic CSV successfully!";
-            return true;
+            foundProbableHeader = true;
         }
     }
+    if (!foundProbableHeader || sniff.lineCount() <= 10) return PROBE_NO_MATCH;
 
-    QMessageBox msgBox;
-    msgBox.setText("Could not autodetect the file type.\rPlease try to manually select the file format.");
-    msgBox.exec();
-    qDebug() << "Nothing worked... sorry...";
-    return false;
+    QList<QByteArray> tokens = sniff.line(10).simplified().toUpper().split(',');
+    if (tokens.length() > 20 && tokens[9].toInt(nullptr, 16) > 0) return PROBE_HEADER;
+    return PROBE_NO_MATCH;
 }
 
-
 bool FrameFileIO::isVehicleSpyFile(QString filename)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    bool foundProbableHeader = false;
-    bool isMatch = false;
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-    try {
-        for (int i = 0; i < 10; i++)
-        {
-            if (!inFile->atEnd())
-            {
-                line = inFile->readLine().simplified().toUpper();
-                if (line.startsWith("LINE") && line.contains("TIME") && line.contains("B1"))
-                {
-                    foundProbableHeader = true;
-                }
-            }
-        }
-        if (foundProbableHeader)
-        {
-            if (!inFile->atEnd())
-            {
-                line = inFile->readLine().simplified().toUpper();
-                inFile->close();
-                QList<QByteArray> tokens = line.split(',');
-                if (tokens.length() > 20)
-                {
-                    if (tokens[9].toInt(nullptr, 16) > 0) isMatch = true;
-                }
-            }
-        }
-    }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    return isMatch;
+    return probeVehicleSpyFile(FileSniff(filename)) > 0;
 }
 
 
@@ -643,62 +568,48 @@ bool FrameFileIO::loadVehicleSpyFile(QString filename, QVector<CANFrame> *frames
     return !foundErrors;
 }
 
-bool FrameFileIO::saveVehicleSpyFile(QString filename, const QVector<CANFrame> *frames)
+bool FrameFileIO::saveVehicleSpyFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress)
 {
     Q_UNUSED(filename);
     Q_UNUSED(frames);
+    Q_UNUSED(progress);
     return true;
 }
 
-bool FrameFileIO::isCRTDFile(QString filename)
+int FrameFileIO::probeCRTDFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    int lineCounter = 0;
     bool isMatch = false;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-
-    try
+    //line 0 is the header
+    for (int i = 1; i <= 11 && i < sniff.lineCount(); i++)
     {
-        line = inFile->readLine().toUpper(); //read out the header first and discard it.
-
-        while (!inFile->atEnd() && lineCounter < 100) {
-            lineCounter++;
-            line = inFile->readLine().simplified();
-            if (line.length() > 2)
+        QByteArray line = sniff.line(i).simplified();
+        if (line.length() > 2)
+        {
+            QList<QByteArray> tokens = line.split(' ');
+            if (tokens.length() > 2)
             {
-                QList<QByteArray> tokens = line.split(' ');
-                if (tokens.length() > 2)
+                char firstChar = tokens[1].left(1)[0];
+                if (firstChar >= '1' && firstChar <= '9')
                 {
-                    char firstChar = tokens[1].left(1)[0];
-                    if (firstChar >= '1' && firstChar <= '9')
-                    {
-                        tokens[1].remove(0,1); // Remove leading digit (bus number)
-                        firstChar = tokens[1].left(1)[0];
-                    }
-                    if (firstChar == 'R' || firstChar == 'T')
-                    {
-                        if (tokens[1] == "R29" || tokens[1] == "T29") isMatch = true;
-                        if (tokens[1] == "R11" || tokens[1] == "T11") isMatch = true;
-                    }
+                    tokens[1].remove(0,1); // Remove leading digit (bus number)
+                    firstChar = tokens[1].left(1)[0];
+                }
+                if (firstChar == 'R' || firstChar == 'T')
+                {
+                    if (tokens[1] == "R29" || tokens[1] == "T29") isMatch = true;
+                    if (tokens[1] == "R11" || tokens[1] == "T11") isMatch = true;
                 }
-                else isMatch = false;
             }
-            if (lineCounter > 10) break;
+            else isMatch = false;
         }
     }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+    return isMatch ? PROBE_PATTERN : PROBE_NO_MATCH;
+}
+
+bool FrameFileIO::isCRTDFile(QString filename)
+{
+    return probeCRTDFile(FileSniff(filename)) > 0;
 }
 
 //CRTD format from Mark Webb-Johnson / OVMS project
@@ -808,32 +719,16 @@ bool FrameFileIO::loadCRTDFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::isCARBUSAnalyzerFile(QString filename)
+int FrameFileIO::probeCARBUSAnalyzerFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-
-    bool isMatch = false;
-
-    // not Text mode because file contains `\r` new lines
-    if (!inFile->open(QIODevice::ReadOnly))
-    {
-        delete inFile;
-        return false;
-    }
-    try
-    {
-        //read header
-        line = inFile->readLine().toUpper();
-        if (line.startsWith("@ TEXT @")) return true;
-    } catch (...)
-    {
-        isMatch = false;
-    }
+    //the file uses `\r` line breaks so look at the raw bytes
+    if (sniff.start().left(8).toUpper() == "@ TEXT @") return PROBE_HEADER;
+    return PROBE_NO_MATCH;
+}
 
-    inFile->close();
-    delete inFile;
-    return isMatch;
+bool FrameFileIO::isCARBUSAnalyzerFile(QString filename)
+{
+    return probeCARBUSAnalyzerFile(FileSniff(filename)) > 0;
 }
 
 // CARBUS Analayzer trace format https://canhacker.ru/can-trace-format/ :
@@ -920,24 +815,14 @@ bool FrameFileIO::loadCARBUSAnalyzerFile(QString filename, QVector<CANFrame>* fr
     return !foundErrors;
 }
 
-bool FrameFileIO::saveCARBUSAnalzyer(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveCARBUSAnalzyer(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
 {
-    QFile *outFile = new QFile(filename);
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-    QTextStream outTextStream(outFile);
-
-    int lineCounter = 0;
-
-    qint64 minTime = frames->at(0).timeStamp().microSeconds();
+    qint64 minTime = frames->isEmpty() ? 0 : frames->timeStampAt(0);
     qint64 maxTime = minTime;
     for (int c = 0; c < frames->count(); c++)
     {
-        if (frames->at(c).timeStamp().microSeconds() < minTime) minTime = frames->at(c).timeStamp().microSeconds();
-        if (frames->at(c).timeStamp().microSeconds() > maxTime) maxTime = frames->at(c).timeStamp().microSeconds();
+        if (frames->timeStampAt(c) < minTime) minTime = frames->timeStampAt(c);
+        if (frames->timeStampAt(c) > maxTime) maxTime = frames->timeStampAt(c);
     }
     qint64 totalTime = maxTime - minTime;
     // looks like a bug in CARBUS format for 3 version. time is in ms, while packets in us.
@@ -952,118 +837,85 @@ bool FrameFileIO::saveCARBUSAnalzyer(QString filename, const QVector<CANFrame>*
     //
     // "@ TEXT @ 3 @ 64 @ 0 @ 14012 @ 15688 @ 00:00:15.688 @"
     // saving in version format 3 with microseconds in packets time
-    outTextStream << "@ TEXT @ 3 @ 64 @ 0 @ " << frames->count() <<  " @ " << totalTime
-                  <<" @ " << someTime.toString("hh:mm:ss.zzz") <<" @\r";
+    QByteArray header = "@ TEXT @ 3 @ 64 @ 0 @ " + QByteArray::number(frames->count()) + " @ " + QByteArray::number(totalTime)
+                      + " @ " + someTime.toString("hh:mm:ss.zzz").toUtf8() + " @\r";
 
-    const unsigned char *data;
-    for (int c = 0; c < frames->count(); c++)
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, header, [frames](int first, int count, QByteArray &out)
     {
-        lineCounter++;
-        if (lineCounter > 100)
+        ExportLine line;
+        for (int c = first; c < first + count; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-        auto frame = frames->at(c);
-
-        uint64_t timeStamp = frame.timeStamp().microSeconds();
-        QString canId = QString::number(frame.frameId(), 16).toUpper().rightJustified(3, '0').toUtf8();
-        QString canDlc = QString::number(frame.payload().length()).toUtf8();
-
-        QString ascii = "";
-        QString finalCanData;
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
+            uint64_t timeStamp = static_cast<uint64_t>(frame.timeStamp);
+
+            line.clear();
+            line.decUnsigned(timeStamp / 1000000);
+            line.put(',');
+            line.decUnsigned(timeStamp % 1000000);
+            line.put('\t');
+            line.dec(frame.bus); // bus channel
+            line.put("\t0004\t"); // it's CAN frame
+            line.hex(frame.frameId, 3);
+            line.put('\t');
+            line.dec(frame.length);
+            line.put('\t');
+
+            int dataStart = line.length();
+            for (int d = 0; d < frame.length; d++)
+            {
+                line.hexByte(data[d]);
+                line.put(' ');
+            }
+            line.trimRight(dataStart);
+            line.justifyLeft(dataStart, 23);
+            line.put("\t00000000\t");
 
-        data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
-        for (int d = 0; d < frame.payload().length(); d++)
-        {
-            auto octet = data[d];
-            finalCanData.append(QString::number(octet, 16).toUpper().rightJustified(2, '0').toUtf8());
-            finalCanData.append(" ");
-
-            QString strCode = QString::number(octet, 16);
-            bool conv;
-            uint symbolCode = strCode.toInt(&conv, 16);
-
-            if ((symbolCode >= 32 && symbolCode < 126)) {
-                QChar localQChar = QChar(symbolCode);
-                if (localQChar.toLatin1() != 0) {
-                   ascii += QString::fromLocal8Bit(QByteArray::fromHex(strCode.toLatin1()));
-              }
-            } else {
-                ascii += " ";
+            int asciiStart = line.length();
+            for (int d = 0; d < frame.length; d++)
+            {
+                line.put((data[d] >= 32 && data[d] < 126) ? static_cast<char>(data[d]) : ' ');
             }
+            line.justifyLeft(asciiStart, 8);
+            line.put("\t\r");
+            line.appendTo(out);
         }
-        finalCanData = finalCanData.trimmed().leftJustified(23, ' ');
-        ascii = ascii.leftJustified(8, ' ');
-        auto seconds = QString::number(timeStamp / 1000000);
-        auto uSeconds = QString::number(timeStamp % 1000000);
-        QString localArg = "";
-        localArg.append(seconds).append(",").append(uSeconds).append("\t")
-                .append(QString::number(frame.bus)).append("\t") // bus channel
-                .append("0004").append("\t") // it's CAN frame
-                .append(canId).append("\t")
-                .append(canDlc).append("\t")
-                .append(finalCanData).append("\t")
-                .append("00000000").append("\t")
-                .append(ascii).append("\t")
-                .append("\r");
-
-        qDebug() << localArg;
-        outTextStream << localArg;
-    }
-
-    outFile->close();
-    delete outFile;
-
-    return true;
+    });
 }
 
-bool FrameFileIO::isCANHackerFile(QString filename)
+int FrameFileIO::probeCANHackerFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    int lineCounter = 0;
     bool isMatch = false;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-    try
-    {
-        line = inFile->readLine().toUpper(); //read out the header first and discard it.
-        if (line.contains("CANHACKER")) return true;
+    if (sniff.line(0).toUpper().contains("CANHACKER")) return PROBE_HEADER;
 
-        while (!inFile->atEnd()) {
-            lineCounter++;
-            line = inFile->readLine().simplified();
-            if (line.length() > 2)
+    for (int i = 1; i <= 11 && i < sniff.lineCount(); i++)
+    {
+        QByteArray line = sniff.line(i).simplified();
+        if (line.length() > 2)
+        {
+            QList<QByteArray> tokens = line.split(' ');
+            if (tokens.length() > 3)
             {
-                QList<QByteArray> tokens = line.split(' ');
-                if (tokens.length() > 3)
+                if (tokens[1].toInt(nullptr, 16) > 0)
                 {
-                    if (tokens[1].toInt(nullptr, 16) > 0)
+                    int len = tokens[2].toInt();
+                    if (len > -1 && len < 9)
                     {
-                        int len = tokens[2].toInt();
-                        if (len > -1 && len < 9)
-                        {
-                            isMatch = true;
-                        }
+                        isMatch = true;
                     }
                 }
-                else isMatch = false;
             }
-            if (lineCounter > 10) break;
+            else isMatch = false;
         }
     }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+    return isMatch ? PROBE_PATTERN : PROBE_NO_MATCH;
+}
+
+bool FrameFileIO::isCANHackerFile(QString filename)
+{
+    return probeCANHackerFile(FileSniff(filename)) > 0;
 }
 
 // CANHacker trace format
@@ -1150,58 +1002,37 @@ bool FrameFileIO::loadCANHackerFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::isCANOpenFile(QString filename)
+int FrameFileIO::probeCANOpenFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    int lineCounter = 0;
     bool isMatch = false;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
+    if (!sniff.line(0).toUpper().contains("CANOPEN MAGIC")) return PROBE_NO_MATCH;
 
-    try
+    //four more header lines, then look at up to ten frames
+    for (int i = 5; i < 15 && i < sniff.lineCount(); i++)
     {
-        line = inFile->readLine().toUpper();
-        if (!line.contains("CANOPEN MAGIC")) return false;
-        line = inFile->readLine();
-        line = inFile->readLine();
-        line = inFile->readLine();
-        line = inFile->readLine();
-
-        while (!inFile->atEnd()) {
-            lineCounter++;
-            if (lineCounter > 10)
-            {
-                break;
-            }
-
-            line = inFile->readLine().replace('\"', ' ').simplified();
-            if (line.length() > 2)
+        QByteArray line = sniff.line(i);
+        line = line.replace('\"', ' ').simplified();
+        if (line.length() > 2)
+        {
+            QList<QByteArray> tokens = line.split(',');
+            if (tokens.length() > 11)
             {
-                QList<QByteArray> tokens = line.split(',');
-                if (tokens.length() > 11)
+                if (Utility::ParseStringToNum(tokens[5].simplified()) > 0)
                 {
-                    if (Utility::ParseStringToNum(tokens[5].simplified()) > 0)
-                    {
-                        QList<QByteArray> dataTok = tokens[11].simplified().split(' ');
-                        if ( dataTok.length() > -1 && dataTok.length() < 9) isMatch = true;
-                    }
+                    QList<QByteArray> dataTok = tokens[11].simplified().split(' ');
+                    if ( dataTok.length() > -1 && dataTok.length() < 9) isMatch = true;
                 }
-                else isMatch = false;
             }
+            else isMatch = false;
         }
     }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+    return isMatch ? PROBE_HEADER : PROBE_NO_MATCH;
+}
+
+bool FrameFileIO::isCANOpenFile(QString filename)
+{
+    return probeCANOpenFile(FileSniff(filename)) > 0;
 }
 
 //"Message Number","Time (ms)","Time","Excel Time","Count","ID","Flags","Message Type","Node","Details","Process Data","Data (Hex)","Data (Text)","Data (Decimal)","Length","Raw Message"
@@ -1268,102 +1099,60 @@ bool FrameFileIO::loadCANOpenFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::saveCRTDFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveCRTDFile(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
 {
-    QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-
     //write in float format with 6 digits after the decimal point
-    outFile->write(QString::number(frames->at(0).timeStamp().microSeconds() / 1000000.0, 'f', 6).toUtf8() + tr(" CXX GVRET-PC Reverse Engineering Tool Output V").toUtf8() + QString::number(VERSION).toUtf8());
-    outFile->write("\n");
+    qint64 startTime = frames->isEmpty() ? 0 : frames->timeStampAt(0);
+    QByteArray header = QString::number(startTime / 1000000.0, 'f', 6).toUtf8() + tr(" CXX GVRET-PC Reverse Engineering Tool Output V").toUtf8()
+                      + QString::number(VERSION).toUtf8() + "\n";
 
-    for (int c = 0; c < frames->count(); c++)
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, header, [frames](int first, int count, QByteArray &out)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        outFile->write(QString::number(frame->timeStamp().microSeconds() / 1000000.0, 'f', 6).toUtf8());
-        outFile->putChar(' ');
-
-        outFile->write(QString::number(frame->bus + 1).toUtf8());
-        if (frame->isReceived) outFile->putChar('R');
-        else outFile->putChar('T');
-
-        if (frame->hasExtendedFrameFormat())
+        ExportLine line;
+        for (int c = first; c < first + count; c++)
         {
-            outFile->write("29 ");
-        }
-        else outFile->write("11 ");
-        outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        outFile->putChar(' ');
-
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
+
+            line.clear();
+            line.seconds(frame.timeStamp, 6);
+            line.put(' ');
+            line.dec(frame.bus + 1);
+            line.put(frame.received ? 'R' : 'T');
+            line.put(frame.extended ? "29 " : "11 ");
+            line.hex(frame.frameId, 8);
+            line.put(' ');
+
+            for (int temp = 0; temp < frame.length; temp++)
+            {
+                line.hexByte(data[temp]);
+                line.put(' ');
+            }
+            line.put('\n');
+            line.appendTo(out);
         }
-
-        outFile->write("\n");
-    }
-    outFile->close();
-    delete outFile;
-
-    return true;
+    });
 }
 
 
-bool FrameFileIO::isPCANFile(QString filename)
+int FrameFileIO::probePCANFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    int lineCounter = 0;
     bool hasFileVer = false;
     bool isMatch = false;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    for (int i = 0; i < 25 && i < sniff.lineCount(); i++)
     {
-        delete inFile;
-        return false;
+        const QByteArray &line = sniff.line(i);
+        if (line.startsWith(";$FILEVERSION=")) hasFileVer = true;
+        if (line.toUpper().contains("PCAN") && hasFileVer) isMatch = true;
     }
+    return isMatch ? PROBE_HEADER : PROBE_NO_MATCH;
+}
 
-    try
-    {
-        while (!inFile->atEnd()) {
-            lineCounter++;
-            if (lineCounter > 25)
-            {
-                break;
-            }
-            line = inFile->readLine();
-            if (line.startsWith(";$FILEVERSION=")) hasFileVer = true;
-            if (line.toUpper().contains("PCAN") && hasFileVer) isMatch = true;
-        }
-    }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+bool FrameFileIO::isPCANFile(QString filename)
+{
+    return probePCANFile(FileSniff(filename)) > 0;
 }
 
 /*Fixed length lines
@@ -1638,37 +1427,16 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
 }
 
 //supporting two styles now and they have very different line layouts. Just checking for the header for now. That should still match only ASC files.
-bool FrameFileIO::isCanalyzerASC(QString filename)
+int FrameFileIO::probeCanalyzerASC(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    bool isMatch = true;
+    if (!sniff.line(0).startsWith("date")) return PROBE_NO_MATCH;
+    if (sniff.lineCount() > 1 && !sniff.line(1).startsWith("base")) return PROBE_NO_MATCH;
+    return PROBE_HEADER;
+}
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-    try
-    {
-        if (!inFile->atEnd())
-        {
-            line = inFile->readLine();
-            if (!line.startsWith("date")) isMatch = false;
-        }
-        if (!inFile->atEnd() && isMatch)
-        {
-            line = inFile->readLine();
-            if (!line.startsWith("base")) isMatch = false;
-        }
-    }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+bool FrameFileIO::isCanalyzerASC(QString filename)
+{
+    return probeCanalyzerASC(FileSniff(filename)) > 0;
 }
 
 //There tends to be four lines of header first. The last of which starts with // so first burn off lines
@@ -1691,214 +1459,146 @@ bool FrameFileIO::isCanalyzerASC(QString filename)
 //Time Type Bus Dir ID ?          ?         (length)    (Real Length) (bytes) (many values of unknown type)           (Ver 17.3)
 //0    1    2   3   4  5          6         7           8             9       10
 //This seems like a rather eclectic mix. It's almost arbitrary!
-bool FrameFileIO::loadCanalyzerASC(QString filename, QVector<CANFrame>* frames)
+static void parseCanalyzerASCLine(const char *begin, const char *end, ChunkedTextLoader::Chunk &chunk)
 {
-    QFile *inFile = new QFile(filename);
-    CANFrame thisFrame;
-    QByteArray line;
-    int lineCounter = 0;
-    bool foundErrors = false;
-    bool inHeader = true;
-    int verMajor;
-    int verMinor;
-    int verRevision;
+    if ((end - begin) <= 1 || ((end - begin) >= 2 && begin[0] == '/' && begin[1] == '/')) return;
 
+    TextTokens tokens;
+    tokens.splitWhitespace(begin, end);
+
+    if (tokens[0].contains("Begin")) return; //probably begin triggerblock but we're ignoring that.
+
+    //try to do some investigating to see if this line is a CAN frame or not. The file format has many other potential line types it seems...
+    if (tokens.count() <= 5) return;
+    TextToken dir = {tokens[3].begin, tokens[3].begin + qMin(tokens[3].length(), 2)};
+    bool isRx = dir.containsNoCase("RX");
+    if (!isRx && !dir.containsNoCase("TX")) return;
+
+    CANFrame thisFrame;
+    thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, tokens[0].toMicroseconds()));
+    thisFrame.isReceived = isRx;
     thisFrame.setFrameType(QCanBusFrame::DataFrame);
-    QList<QByteArray> tokens;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    //the CANFD style lines have a type column in front of the bus so everything else moves over one
+    bool fdStyle = tokens[1].contains("CAN");
+    const TextToken &idTok = fdStyle ? tokens[4] : tokens[2];
+    if (idTok.endsWith('x'))
     {
-        delete inFile;
-        return false;
+        thisFrame.setFrameId(static_cast<uint32_t>(TextToken{idTok.begin, idTok.end - 1}.toHex()));
+        thisFrame.setExtendedFrameFormat(true);
+    }
+    else
+    {
+        thisFrame.setFrameId(static_cast<uint32_t>(idTok.toHex()));
+        thisFrame.setExtendedFrameFormat(thisFrame.frameId() > 0x7FF);  //some .asc files have extended IDs without 'x'
     }
 
-    while (!inFile->atEnd()) {
-        lineCounter++;
-        if (lineCounter > 100)
+    int payloadLen;
+    int dataStart;
+    if (fdStyle) //the different format I haven't seen a whole lot of, seems to support CANFD in this format
+    {
+        payloadLen = static_cast<int>(tokens[8].toDecimal());
+        thisFrame.bus = static_cast<int>(tokens[2].toDecimal());
+        //version 9 puts a signal name in column 5, the data moves over one when it's there
+        dataStart = (tokens[5].at(0) >= '0' && tokens[5].at(0) <= '9') ? 9 : 10;
+        if (payloadLen > 64)
         {
-            qApp->processEvents();
-            lineCounter = 0;
+            qDebug() << "Payload length too long. Original line: " << QByteArray(begin, static_cast<int>(end - begin));
+            chunk.aborted = true;
+            return;
         }
-        line = inFile->readLine();
-        if (inHeader)
+    }
+    else
+    {
+        payloadLen = static_cast<int>(tokens[5].toDecimal());
+        thisFrame.bus = static_cast<int>(tokens[1].toDecimal());
+        if (tokens[4].equals("r")) thisFrame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        dataStart = 6;
+        if (payloadLen > 8)
         {
-            if (line.startsWith("//"))
-            {
-                line = line.right(line.length() - 11);
-                QList<QByteArray> versionTokens = line.split('.');
-                if (versionTokens.length() > 2)
-                {
-                    verMajor = versionTokens[0].toInt();
-                    verMinor = versionTokens[1].toInt();
-                    verRevision = versionTokens[2].toInt();
-                    qDebug() << "Major: " << verMajor << " Minor:" << verMinor << " Rev:" << verRevision;
-                }
-            }
-            if (line.startsWith("//") ||  lineCounter > 4)
-            {
-                inHeader = false;
-                continue;
-            }
+            qDebug() << "Payload length too long. Original line: " << QByteArray(begin, static_cast<int>(end - begin));
+            chunk.aborted = true;
+            return;
         }
-        if (inHeader) continue;
-        if (line.length() > 2 && !line.startsWith("//"))
-        {            
-            tokens = line.simplified().split(' ');
-
-            if (tokens[0].contains("Begin")) continue; //probably begin triggerblock but we're ignoring that.
-
-            //try to do some investigating to see if this line is a CAN frame or not. The file format has many other potential line types it seems...
-            if (tokens.length() > 5)
-            {
-                if (tokens[3].toUpper().startsWith("RX") || tokens[3].toUpper().startsWith("TX"))
-                {
-                    thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, static_cast<uint64_t>(tokens[0].toDouble() * 1000000.0)));
-                    if (tokens[1].contains("CAN")) //the different format I haven't seen a whole lot of, seems to support CANFD in this format
-                    {
-                        if (tokens[4].endsWith('x'))
-                        {
-                            QByteArray copied_id = tokens[4];
-                            copied_id.chop(1);
-                            thisFrame.setFrameId(copied_id.toUInt(nullptr, 16));
-                            thisFrame.setExtendedFrameFormat(true);
-                        }
-                        else
-                        {
-                            thisFrame.setFrameId(tokens[4].toUInt(nullptr, 16));
-                            thisFrame.setExtendedFrameFormat(thisFrame.frameId() > 0x7FF);  //some .asc files have extended IDs without 'x'
-                        }
-
-                        int payloadLen = tokens[8].toInt();
-                        qDebug() << "PayloadLen: " << payloadLen << " Tokens: " << tokens;
-                        QByteArray bytes(payloadLen, 0);
-                        if (payloadLen > 64)
-                        {
-                            qDebug() << "Payload length too long. Original line: " << line;
-                            return false;
-                        }
-                        if (payloadLen < 0)
-                        {
-                            qDebug() << "Payload length negative! Original line: " << line;
-                            return false;
-                        }
-                        thisFrame.isReceived = tokens[3].toUpper().contains("RX");
-                        thisFrame.bus = tokens[2].toInt();
-
-                        if (tokens[5].at(0) >= '0' && tokens[5].at(0) <= '9')
-                        {
-                            for (int d = 9; d < (9 + payloadLen); d++)
-                            {
-                                if (tokens.count() > d)
-                                {
-                                    bytes[d - 9] = static_cast<char>(tokens[d].toInt(nullptr, 16));
-                                }
-                                else //expected byte wasn't there to read. Set it zero and set error flag
-                                {
-                                    bytes[d - 9] = 0;
-                                    foundErrors = true;
-                                    qDebug() << "D:" << d << " Count:" << tokens.count();
-                                    qDebug() << "Expected byte missing! Original line: " << line;
-                                }
-                            }
-                            thisFrame.setPayload(bytes);
-                        }
-                        else
-                        {
-                            for (int d = 10; d < (10 + payloadLen); d++)
-                            {
-                                if (tokens.count() > d)
-                                {
-                                    bytes[d - 10] = static_cast<char>(tokens[d].toInt(nullptr, 16));
-                                }
-                                else //expected byte wasn't there to read. Set it zero and set error flag
-                                {
-                                    bytes[d - 10] = 0;
-                                    foundErrors = true;
-                                    qDebug() << "D:" << d << " Count:" << tokens.count();
-                                    qDebug() << "Expected byte missing! Original line: " << line;
-                                }
-                            }
-                            thisFrame.setPayload(bytes);
-                        }
-                    }
-                    else
-                    {
-                        int payloadLen = tokens[5].toInt();
-                        thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, static_cast<uint64_t>(tokens[0].toDouble() * 1000000.0)));
-                        if (tokens[2].endsWith('x'))
-                        {
-                            QByteArray copied_id = tokens[2];
-                            copied_id.chop(1);
-                            thisFrame.setFrameId(copied_id.toUInt(nullptr, 16));
-                            thisFrame.setExtendedFrameFormat(true);
-                        }
-                        else
-                        {
-                            thisFrame.setFrameId(tokens[2].toUInt(nullptr, 16));
-                            thisFrame.setExtendedFrameFormat(thisFrame.frameId() > 0x7FF);  //some .asc files have extended IDs without 'x'
-                        }
-                        QByteArray bytes(payloadLen, 0);
+    }
+    if (payloadLen < 0)
+    {
+        qDebug() << "Payload length negative! Original line: " << QByteArray(begin, static_cast<int>(end - begin));
+        chunk.aborted = true;
+        return;
+    }
 
-                        if (payloadLen > 8)
-                        {
-                            qDebug() << "Payload length too long. Original line: " << line;
-                            return false;
-                        }
-                        if (payloadLen < 0)
-                        {
-                            qDebug() << "Payload length negative! Original line: " << line;
-                            return false;
-                        }
-                        thisFrame.isReceived = tokens[3].toUpper().contains("RX");
-                        thisFrame.bus = tokens[1].toInt();
-                        if (tokens[4] == "r") thisFrame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-                        for (int d = 6; d < (6 + payloadLen); d++)
-                        {
-                            if (tokens.count() > d)
-                            {
-                                bytes[d - 6] = static_cast<char>(tokens[d].toInt(nullptr, 16));
-                            }
-                            else //expected byte wasn't there to read. Set it zero and set error flag
-                            {
-                                bytes[d - 6] = 0;
-                                foundErrors = true;
-                                qDebug() << "D:" << d << " Count:" << tokens.count();
-                                qDebug() << "Expected byte missing! Original line: " << line;
-                            }
-                        }
-                        thisFrame.setPayload(bytes);
-                    }
-                    frames->append(thisFrame);
-                }
-            }
+    QByteArray bytes(payloadLen, 0);
+    for (int d = dataStart; d < (dataStart + payloadLen); d++)
+    {
+        if (tokens.count() > d)
+        {
+            bytes[d - dataStart] = static_cast<char>(tokens[d].toHex());
+        }
+        else //expected byte wasn't there to read. Leave it zero and set error flag
+        {
+            chunk.foundErrors = true;
+            qDebug() << "D:" << d << " Count:" << tokens.count();
+            qDebug() << "Expected byte missing! Original line: " << QByteArray(begin, static_cast<int>(end - begin));
         }
-        //else foundErrors = true;
     }
-    inFile->close();
-    delete inFile;
-    return !foundErrors;
+    thisFrame.setPayload(bytes);
+    chunk.frames.append(thisFrame);
 }
 
-bool FrameFileIO::saveCanalyzerASC(QString filename, const QVector<CANFrame>* frames)
+//The header ends with a line starting with // that also holds the version. Failing that the
+//first five lines are taken as header.
+static void readCanalyzerASCHeader(const ChunkedTextLoader &loader, qint64 &pos)
 {
-    QFile *outFile = new QFile(filename);
+    const char *lineBegin;
+    const char *lineEnd;
     int lineCounter = 0;
-    int64_t offsetTime = frames->at(0).timeStamp().microSeconds();
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
 
-    for (int c = 0; c < frames->count(); c++)
+    while (loader.readLine(pos, lineBegin, lineEnd))
     {
-        if (frames->at(c).timeStamp().microSeconds() < offsetTime) offsetTime = frames->at(c).timeStamp().microSeconds();
+        lineCounter++;
+        QByteArray line(lineBegin, static_cast<int>(lineEnd - lineBegin));
+        if (line.startsWith("//"))
+        {
+            QList<QByteArray> versionTokens = line.mid(11).split('.');
+            if (versionTokens.length() > 2)
+            {
+                qDebug() << "Major: " << versionTokens[0].toInt() << " Minor:" << versionTokens[1].toInt() << " Rev:" << versionTokens[2].toInt();
+            }
+            break;
+        }
+        if (lineCounter > 4) break;
     }
+}
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
+bool FrameFileIO::loadCanalyzerASC(QString filename, QVector<CANFrame>* frames)
+{
+    ChunkedTextLoader loader;
+    qint64 pos = 0;
+
+    if (!loader.open(filename)) return false;
+    readCanalyzerASCHeader(loader, pos);
+
+    loader.parse(pos, parseCanalyzerASCLine);
+    return loader.collect(frames);
+}
+
+static bool pageCanalyzerASC(QString filename, CapturePager *pager)
+{
+    if (!pager->openText(filename)) return false;
+    qint64 pos = 0;
+    readCanalyzerASCHeader(pager->textFile(), pos);
+    pager->startIndexing(pos, parseCanalyzerASCLine);
+    return true;
+}
+
+bool FrameFileIO::saveCanalyzerASC(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
+{
+    int64_t offsetTime = frames->isEmpty() ? 0 : frames->timeStampAt(0);
+    for (int c = 0; c < frames->count(); c++)
+    {
+        if (frames->timeStampAt(c) < offsetTime) offsetTime = frames->timeStampAt(c);
+    }
 
     QDateTime now;
     now = QDateTime::currentDateTime();
@@ -1906,94 +1606,79 @@ bool FrameFileIO::saveCanalyzerASC(QString filename, const QVector<CANFrame>* fr
     {
         now.setMSecsSinceEpoch(offsetTime / 1000); //offsetTime was in microseconds
     }
-    outFile->write("date " + now.toString("ddd MMM dd h:mm:ss.zzz a yyyy").toUtf8());
+    QByteArray header = "date " + now.toString("ddd MMM dd h:mm:ss.zzz a yyyy").toUtf8();
+    header += "\nbase hex  timestamps absolute\n";
+    header += "no internal event logging\n";
+    header += "// version 11.0.0\n";
 
-    outFile->write("\nbase hex  timestamps absolute\n");
-    outFile->write("no internal event logging\n");
-    outFile->write("// version 11.0.0\n");
-
-    for (int c = 0; c < frames->count(); c++)
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, header, [frames, offsetTime](int first, int count, QByteArray &out)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        uint64_t timeStamp = (frame->timeStamp().microSeconds() - offsetTime) / 1000000ull;
-        int tsLen = QString::number(timeStamp).length();
-        int precision = 6;
-        //vector seems to keep 10 bytes at the start of the line for the timestamp. It should never exceed this
-        //and there should never be a precision over 6 digits after the decimal
-        if (tsLen > 3) precision = 9 - tsLen;
-        outFile->write(QString::number((frame->timeStamp().microSeconds() - offsetTime) / 1000000.0, 'f', precision).rightJustified(10, ' ').toUtf8());
-        outFile->putChar(' ');
-        outFile->write(QString::number(frame->bus + 1).toUtf8());
-        outFile->write("  ");
-        if (frames->at(c).hasExtendedFrameFormat())
-        {
-            outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-            outFile->write("x");
-        }
-        else
+        ExportLine line;
+        for (int c = first; c < first + count; c++)
         {
-            outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(3, '0').toUtf8());
-            outFile->write("      ");
-        }
-        outFile->write("   ");
-
-        if (frames->at(c).isReceived) outFile->write("Rx ");
-        else outFile->write("Tx ");
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
+            int64_t relative = frame.timeStamp - offsetTime;
+
+            //vector seems to keep 10 bytes at the start of the line for the timestamp. It should never exceed this
+            //and there should never be a precision over 6 digits after the decimal
+            int tsLen = 1;
+            for (uint64_t secs = static_cast<uint64_t>(relative) / 1000000ull; secs >= 10; secs /= 10) tsLen++;
+            int precision = 6;
+            if (tsLen > 3) precision = 9 - tsLen;
+
+            line.clear();
+            line.seconds(relative, precision, 10);
+            line.put(' ');
+            line.dec(frame.bus + 1);
+            line.put("  ");
+            if (frame.extended)
+            {
+                line.hex(frame.frameId, 8);
+                line.put('x');
+            }
+            else
+            {
+                line.hex(frame.frameId, 3);
+                line.put("      ");
+            }
+            line.put("   ");
 
-        if (frames->at(c).frameType() == QCanBusFrame::RemoteRequestFrame) outFile->write("r ");
-        else outFile->write("d ");
+            line.put(frame.received ? "Rx " : "Tx ");
+            line.put((frame.frameType == QCanBusFrame::RemoteRequestFrame) ? "r " : "d ");
 
-        outFile->write(QString::number(dataLen).toUtf8());
-        outFile->write("  ");
+            line.dec(frame.length);
+            line.put("  ");
 
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->write("  ");
+            for (int temp = 0; temp < frame.length; temp++)
+            {
+                line.hexByte(data[temp]);
+                line.put("  ");
+            }
+            line.put('\n');
+            line.appendTo(out);
         }
-
-        outFile->write("\n");
-    }
-    outFile->close();
-    delete outFile;
-
-    return true;
+    });
 }
 
-bool FrameFileIO::isCanalyzerBLF(QString filename)
+int FrameFileIO::probeCanalyzerBLF(const FileSniff &sniff)
 {
-    BLF_FILE_HEADER header;
-
-    QFile *inFile = new QFile(filename);
-    bool isMatch = false;
+    if (sniff.start().length() < static_cast<int>(sizeof(BLF_FILE_HEADER))) return PROBE_NO_MATCH;
 
-    if (!inFile->open(QIODevice::ReadOnly))
-    {
-        delete inFile;
-        return false;
-    }
-    inFile->read(reinterpret_cast<char *>(&header), sizeof(header));
+    BLF_FILE_HEADER header;
+    memcpy(&header, sniff.start().constData(), sizeof(header));
     if (qFromLittleEndian(header.sig) == 0x47474F4C)
     {
         qDebug() << "Proper BLF file header token";
-        isMatch = true;
+        return PROBE_SIGNATURE;
     }
-    else isMatch = false;
-
-    inFile->close();
-    delete inFile;
+    return PROBE_NO_MATCH;
+}
 
-    return isMatch;
+bool FrameFileIO::isCanalyzerBLF(QString filename)
+{
+    return probeCanalyzerBLF(FileSniff(filename)) > 0;
 }
 
 //this one is pretty complicated and handled by it's own class
@@ -2003,220 +1688,214 @@ bool FrameFileIO::loadCanalyzerBLF(QString filename, QVector<CANFrame> *frames)
     return blf.loadBLF(filename, frames);
 }
 
-bool FrameFileIO::isNativeCSVFile(QString filename)
+int FrameFileIO::probeNativeBinaryFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    int fileVersion = 1;
-    bool isMatch = true;
+    return NativeBinaryFile::isNativeBinary(sniff.start(), sniff.end(), sniff.fileSize()) ? PROBE_SIGNATURE : PROBE_NO_MATCH;
+}
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-    try
-    {
-        line = inFile->readLine().toUpper(); //read out the header first and discard it.
-        if (line.length() < 23) isMatch = false;
-        else if (line.at(23) == 'D') fileVersion = 2; //Dir is found starting at position 23 if this is a V2 file
+bool FrameFileIO::isNativeBinaryFile(QString filename)
+{
+    return probeNativeBinaryFile(FileSniff(filename)) > 0;
+}
 
-        if (!line.contains("TIME STAMP")) isMatch = false;
-        if (!line.contains("EXTENDED")) isMatch = false;
-        if (!line.contains("D1")) isMatch = false;
+bool FrameFileIO::loadNativeBinaryFile(QString filename, QVector<CANFrame> *frames)
+{
+    NativeBinaryFile binFile;
+    if (!binFile.open(filename)) return false;
+    return binFile.loadAll(frames);
+}
 
-        if (!inFile->atEnd()) {
-            line = inFile->readLine().simplified();
-            if (line.length() > 2)
-            {
-                QList<QByteArray> tokens = line.split(',');
-                if (tokens.length() >= 5)
-                {
-                    if (fileVersion == 1)
-                    {
-                        if (tokens[4].toUInt() > 8) isMatch = false;
-                    }
-                    else if (fileVersion == 2)
-                    {
-                        if ( tokens[5].toUInt() > 8) isMatch = false;
-                    }
-                }
-                else isMatch = false;
-            }
-        }
-    }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    delete inFile;
+static bool pageNativeBinaryFile(QString filename, CapturePager *pager)
+{
+    return pager->openNativeBinary(filename);
+}
 
-    return isMatch;
+bool FrameFileIO::saveNativeBinaryFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress)
+{
+    return NativeBinaryFile::save(filename, frames, progress);
 }
 
-//The "native" file format for this program
-//Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8
-//39747828,000005EB,false,Rx,0,8,E8,45,85,4B,4A,28,36,69,
-bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
+int FrameFileIO::probeNativeCSVFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    CANFrame thisFrame;
-    QByteArray line;
     int fileVersion = 1;
-    uint64_t timeStamp = Utility::GetTimeMS();
-    int lineCounter = 0;
-    bool foundErrors = false;
-    thisFrame.setFrameType(QCanBusFrame::DataFrame);
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
 
-    line = inFile->readLine().toUpper(); //read out the header first and discard it.
+    QByteArray line = sniff.line(0).toUpper(); //the header
+    if (line.length() < 24) return PROBE_NO_MATCH;
     if (line.at(23) == 'D') fileVersion = 2; //Dir is found starting at position 23 if this is a V2 file
 
-    while (!inFile->atEnd()) {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+    if (!line.contains("TIME STAMP")) return PROBE_NO_MATCH;
+    if (!line.contains("EXTENDED")) return PROBE_NO_MATCH;
+    if (!line.contains("D1")) return PROBE_NO_MATCH;
 
-        line = inFile->readLine().simplified();
+    if (sniff.lineCount() > 1)
+    {
+        line = sniff.line(1).simplified();
         if (line.length() > 2)
         {
             QList<QByteArray> tokens = line.split(',');
-            if (tokens.length() >= 5)
-            {
-                if (tokens[0].length() > 3)
-                {
-                    quint64 tstamp = tokens[0].toULongLong();
-                    if (tstamp == 0) tstamp = (quint64)(tokens[0].toLongLong());
-                    thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, tstamp));
-                }
-                else
-                {
-                    timeStamp += 5;
-                    thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, timeStamp));
-                }
-
-                thisFrame.setFrameId(tokens[1].toUInt(nullptr, 16));
-                if (tokens[2].toUpper().contains("TRUE")) thisFrame.setExtendedFrameFormat(true);
-                    else thisFrame.setExtendedFrameFormat(false);
-
-                //fix for faulty files that fail to set the extended flag when they should
-                if (thisFrame.frameId() > 0x7FF) thisFrame.setExtendedFrameFormat(true);
-
-                thisFrame.setFrameType(QCanBusFrame::DataFrame);
-
-                if (fileVersion == 1)
-                {
-                    thisFrame.isReceived = true;
-                    thisFrame.bus = tokens[3].toInt();
-                    int lng = tokens[4].toInt();
-                    if (lng > 8) lng = 8;
-                    if (lng < 0) lng = 0;
-                    if (lng + 5 > tokens.length()) lng = tokens.length() - 5;
-                    QByteArray bytes(lng, 0);
-                    for (int c = 0; c < lng; c++) bytes[c] = 0;
-                    for (int d = 0; d < lng; d++)
-                        bytes[d] = static_cast<char>(tokens[5 + d].toInt(nullptr, 16));
-                    thisFrame.setPayload(bytes);
-                }
-                else if (fileVersion == 2)
-                {
-                    if (tokens[3].at(0) == 'R') thisFrame.isReceived = true;
-                    else thisFrame.isReceived = false;
-                    thisFrame.bus = tokens[4].toInt();                    
-                    int lng = tokens[5].toInt();
-                    if (lng > 8) lng = 8;
-                    if (lng < 0) lng = 0;
-                    if (lng + 6 > tokens.length()) lng = tokens.length() - 6;
-                    QByteArray bytes(lng, 0);
-                    for (int c = 0; c < lng; c++) bytes[c] = 0;
-                    for (int d = 0; d < lng; d++)
-                        bytes[d] = static_cast<char>(tokens[6 + d].toInt(nullptr, 16));
-                    thisFrame.setPayload(bytes);
-                }
-
-                frames->append(thisFrame);
-            }
-            else foundErrors = true;
+            if (tokens.length() < 4 + fileVersion) return PROBE_NO_MATCH;
+            if (tokens[3 + fileVersion].toUInt() > 64) return PROBE_NO_MATCH;
         }
     }
-    inFile->close();
-    delete inFile;
-    return !foundErrors;
+    return PROBE_HEADER;
 }
 
-bool FrameFileIO::saveNativeCSVFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::isNativeCSVFile(QString filename)
 {
-    QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
+    return probeNativeCSVFile(FileSniff(filename)) > 0;
+}
 
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
+//The "native" file format for this program
+//Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8
+//39747828,000005EB,false,Rx,0,8,E8,45,85,4B,4A,28,36,69,
+static void parseNativeCSVLine(const char *begin, const char *end, ChunkedTextLoader::Chunk &chunk, int fileVersion)
+{
+    TextTokens tokens;
+    tokens.split(begin, end, ',');
+    if (tokens.count() == 0 || (tokens[tokens.count() - 1].end - tokens[0].begin) <= 2) return;
+    if (tokens.count() < 5)
+    {
+        chunk.foundErrors = true;
+        return;
+    }
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
+    CANFrame thisFrame;
+    if (tokens[0].length() > 3)
     {
-        delete outFile;
-        return false;
+        thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, tokens[0].toDecimal()));
     }
+    else chunk.untimedFrames.append(chunk.frames.count());
 
-    outFile->write("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8");
-    outFile->write("\n");
+    thisFrame.setFrameId(static_cast<uint32_t>(tokens[1].toHex()));
+    thisFrame.setExtendedFrameFormat(tokens[2].containsNoCase("TRUE"));
 
-    for (int c = 0; c < frames->count(); c++)
+    //fix for faulty files that fail to set the extended flag when they should
+    if (thisFrame.frameId() > 0x7FF) thisFrame.setExtendedFrameFormat(true);
+
+    thisFrame.setFrameType(QCanBusFrame::DataFrame);
+
+    int dataStart;
+    if (fileVersion == 1)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+        thisFrame.isReceived = true;
+        thisFrame.bus = static_cast<int>(tokens[3].toDecimal());
+        dataStart = 5;
+    }
+    else
+    {
+        thisFrame.isReceived = (tokens[3].at(0) == 'R');
+        thisFrame.bus = static_cast<int>(tokens[4].toDecimal());
+        dataStart = 6;
+    }
+    //CAN-FD frames carry their extra bytes in columns past D8
+    int lng = static_cast<int>(tokens[dataStart - 1].toDecimal());
+    if (lng > 64) lng = 64;
+    if (lng < 0) lng = 0;
+    if (lng + dataStart > tokens.count()) lng = qMax(tokens.count() - dataStart, 0);
+    QByteArray bytes(lng, 0);
+    for (int d = 0; d < lng; d++) bytes[d] = static_cast<char>(tokens[dataStart + d].toHex());
+    if (lng > 8) thisFrame.setFlexibleDataRateFormat(true);
+    thisFrame.setPayload(bytes);
+
+    chunk.frames.append(thisFrame);
+}
+
+//The "native" file format for this program
+//Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8
+//39747828,000005EB,false,Rx,0,8,E8,45,85,4B,4A,28,36,69,
+//reads out the header and returns the file version
+static int readNativeCSVHeader(const ChunkedTextLoader &loader, qint64 &pos)
+{
+    int fileVersion = 1;
+    const char *lineBegin;
+    const char *lineEnd;
+    if (loader.readLine(pos, lineBegin, lineEnd))
+    {
+        if ((lineEnd - lineBegin) > 23 && (lineBegin[23] == 'D' || lineBegin[23] == 'd')) fileVersion = 2; //Dir is found starting at position 23 if this is a V2 file
+    }
+    return fileVersion;
+}
 
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
+bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
+{
+    ChunkedTextLoader loader;
+    qint64 pos = 0;
 
-        outFile->write(QString::number(frame->timeStamp().microSeconds()).toUtf8());
-        outFile->putChar(44);
+    if (!loader.open(filename)) return false;
+    int fileVersion = readNativeCSVHeader(loader, pos);
 
-        outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        outFile->putChar(44);
+    loader.parse(pos, [fileVersion](const char *begin, const char *end, ChunkedTextLoader::Chunk &chunk)
+    {
+        parseNativeCSVLine(begin, end, chunk, fileVersion);
+    });
 
-        if (frame->hasExtendedFrameFormat()) outFile->write("true,");
-        else outFile->write("false,");
+    QVector<int> untimedFrames;
+    bool ok = loader.collect(frames, &untimedFrames);
 
-        if (frame->isReceived) outFile->write("Rx,");
-        else outFile->write("Tx,");
+    //lines with no usable time stamp get made up ones 5ms apart
+    uint64_t timeStamp = Utility::GetTimeMS();
+    for (int i = 0; i < untimedFrames.count(); i++)
+    {
+        timeStamp += 5;
+        (*frames)[untimedFrames.at(i)].setTimeStamp(QCanBusFrame::TimeStamp(0, static_cast<qint64>(timeStamp)));
+    }
+    return ok;
+}
 
-        outFile->write(QString::number(frame->bus).toUtf8());
-        outFile->putChar(44);
+//frames without a time stamp stay at 0 when paged, there's no file order to make times up from
+static bool pageNativeCSVFile(QString filename, CapturePager *pager)
+{
+    if (!pager->openText(filename)) return false;
+    qint64 pos = 0;
+    int fileVersion = readNativeCSVHeader(pager->textFile(), pos);
+    pager->startIndexing(pos, [fileVersion](const char *begin, const char *end, ChunkedTextLoader::Chunk &chunk)
+    {
+        parseNativeCSVLine(begin, end, chunk, fileVersion);
+    });
+    return true;
+}
 
-        outFile->write(QString::number(dataLen).toUtf8());
-        outFile->putChar(44);
+const char FrameFileIO::nativeCSVHeader[] = "Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n";
 
-        for (int temp = 0; temp < 8; temp++)
+void FrameFileIO::formatNativeCSV(const CANFrameStore *frames, int first, int count, QByteArray &out)
+{
+    ExportLine line;
+    for (int c = first; c < first + count; c++)
+    {
+        const PackedCANFrame &frame = frames->recordAt(c);
+        const uint8_t *data = frames->payloadAt(c);
+
+        line.clear();
+        line.dec(frame.timeStamp);
+        line.put(',');
+        line.hex(frame.frameId, 8);
+        line.put(',');
+        line.put(frame.extended ? "true," : "false,");
+        line.put(frame.received ? "Rx," : "Tx,");
+        line.dec(frame.bus);
+        line.put(',');
+        line.dec(frame.length);
+        line.put(',');
+
+        //always at least D1-D8, CAN-FD frames keep going past that so nothing gets cut off
+        for (int temp = 0; temp < qMax(static_cast<int>(frame.length), 8); temp++)
         {
-            if (temp < dataLen)
-                outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            else
-                outFile->write("00");
-            outFile->putChar(44);
+            if (temp < frame.length) line.hexByte(data[temp]);
+            else line.put("00");
+            line.put(',');
         }
-
-        outFile->write("\n");
-
+        line.put('\n');
+        line.appendTo(out);
     }
-    outFile->close();
-    delete outFile;
-    return true;
+}
+
+bool FrameFileIO::saveNativeCSVFile(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
+{
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, nativeCSVHeader, [frames](int first, int count, QByteArray &out)
+    {
+        formatNativeCSV(frames, first, count, out);
+    });
 }
 
 bool FrameFileIO::openContinuousNative()
@@ -2227,6 +1906,7 @@ bool FrameFileIO::openContinuousNative()
 
     QStringList filters;
     filters.append(QString(tr("GVRET Logs (*.csv *.CSV)")));
+    filters.append(QString(tr("GVRET Logs, gzip compressed (*.csv.gz)")));
 
     dialog.setDirectory(settings.value("FileIO/LoadSaveDirectory", dialog.directory().path()).toString());
     dialog.setFileMode(QFileDialog::AnyFile);
@@ -2237,14 +1917,24 @@ bool FrameFileIO::openContinuousNative()
     if (dialog.exec() == QDialog::Accepted)
     {
         filename = dialog.selectedFiles()[0];
-        continuousFile.setFileName(filename);
+        bool gzip = (dialog.selectedNameFilter() == filters[1]) || filename.endsWith(".gz", Qt::CaseInsensitive);
+        if (gzip && !filename.endsWith(".gz", Qt::CaseInsensitive))
+        {
+            if (!filename.endsWith(".csv", Qt::CaseInsensitive)) filename += ".csv";
+            filename += ".gz";
+        }
+
+        closeContinuousNative();
+        qint64 rotateBytes = settings.value("Main/ContinuousLogRotateMB", 0).toLongLong() * 1048576;
+        int rotateSeconds = settings.value("Main/ContinuousLogRotateMinutes", 0).toInt() * 60;
 
-        if (!continuousFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        continuousWriter = new ContinuousLogWriter();
+        if (!continuousWriter->start(filename, gzip, rotateBytes, rotateSeconds))
         {
+            delete continuousWriter;
+            continuousWriter = nullptr;
             return false;
         }
-        continuousFile.write("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8");
-        continuousFile.write("\n");
         settings.setValue("FileIO/LoadSaveDirectory", dialog.directory().path());
         return true;
     }
@@ -2253,118 +1943,47 @@ bool FrameFileIO::openContinuousNative()
 
 bool FrameFileIO::closeContinuousNative()
 {
-    if (continuousFile.isOpen())
+    if (continuousWriter)
     {
-        continuousFile.close();
+        continuousWriter->stop();
+        delete continuousWriter;
+        continuousWriter = nullptr;
         return true;
     }
     return false;
 }
 
-bool FrameFileIO::writeContinuousNative(const QVector<CANFrame>* frames, int beginningFrame)
+bool FrameFileIO::writeContinuousNative(const QVector<CANFrame> &frames)
 {
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
-    if (!continuousFile.isOpen()) return false;
-    qDebug() << "Bgn: " << beginningFrame << "  Count: " << frames->count();
-    for (int c = beginningFrame; c < frames->count(); c++)
-    {
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        continuousFile.write(QString::number(frame->timeStamp().microSeconds()).toUtf8());
-        continuousFile.putChar(44);
-
-        continuousFile.write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        continuousFile.putChar(44);
-
-        if (frame->hasExtendedFrameFormat()) continuousFile.write("true,");
-        else continuousFile.write("false,");
-
-        if (frame->isReceived) continuousFile.write("Rx,");
-        else continuousFile.write("Tx,");
-
-        continuousFile.write(QString::number(frame->bus).toUtf8());
-        continuousFile.putChar(44);
-
-        continuousFile.write(QString::number(dataLen).toUtf8());
-        continuousFile.putChar(44);
-
-        for (int temp = 0; temp < 8; temp++)
-        {
-            if (temp < dataLen)
-                continuousFile.write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            else
-                continuousFile.write("00");
-            continuousFile.putChar(44);
-        }
-
-        continuousFile.write("\n");
-    }
+    if (!continuousWriter) return false;
+    continuousWriter->queueFrames(frames);
     return true;
 }
 
-bool FrameFileIO::flushContinuousNative()
+int FrameFileIO::probeGenericCSVFile(const FileSniff &sniff)
 {
-    if (continuousFile.isOpen())
+    //line 0 is the header
+    if (sniff.lineCount() > 1)
     {
-        return continuousFile.flush();
-    }
-    return false;
-}
+        const QByteArray &line = sniff.line(1);
+        if (line.length() <= 2) return PROBE_NO_MATCH;
 
+        QList<QByteArray> tokens = line.split(',');
 
-bool FrameFileIO::isGenericCSVFile(QString filename)
-{
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    bool isMatch = true;
+        int ID = tokens[0].toInt(nullptr, 16);
+        if (ID < 1 || ID > 0x1FFFFFFF) return PROBE_NO_MATCH;
+        if (tokens.count() < 2) return PROBE_NO_MATCH;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
+        QList<QByteArray> dataTok = tokens[1].split(' ');
+        int len = dataTok.length();
+        if (len > 8 || len < 2) return PROBE_NO_MATCH;
     }
-    try
-    {
-        line = inFile->readLine(); //read out the header first and discard it.
-
-        if (!inFile->atEnd()) {
-            line = inFile->readLine();
-            if (line.length() > 2)
-            {
-                QList<QByteArray> tokens = line.split(',');
-
-                int ID = tokens[0].toInt(nullptr, 16);
-                if (ID < 1 || ID > 0x1FFFFFFF) isMatch = false;
-
-                if (tokens.count() < 2)
-                {
-                    isMatch = false;
-                }
+    return PROBE_WEAK;
+}
 
-                if (isMatch)
-                {
-                    QList<QByteArray> dataTok = tokens[1].split(' ');
-                    int len = dataTok.length();
-                    if (len > 8) isMatch = false;
-                    if (len < 2) isMatch = false;
-                }
-            }
-            else isMatch = false;
-        }
-    }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+bool FrameFileIO::isGenericCSVFile(QString filename)
+{
+    return probeGenericCSVFile(FileSniff(filename)) > 0;
 }
 
 bool FrameFileIO::loadGenericCSVFile(QString filename, QVector<CANFrame>* frames)
@@ -2424,104 +2043,62 @@ bool FrameFileIO::loadGenericCSVFile(QString filename, QVector<CANFrame>* frames
 }
 
 //4f5,ff 34 23 45 24 e4
-bool FrameFileIO::saveGenericCSVFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveGenericCSVFile(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
 {
-    QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, "ID,Data Bytes\n", [frames](int first, int count, QByteArray &out)
     {
-        delete outFile;
-        return false;
-    }
-
-    outFile->write("ID,Data Bytes");
-    outFile->write("\n");
+        ExportLine line;
+        for (int c = first; c < first + count; c++)
+        {
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
 
-    for (int c = 0; c < frames->count(); c++)
-    {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        outFile->putChar(44);
-
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            line.clear();
+            line.hex(frame.frameId, 8);
+            line.put(',');
+            for (int temp = 0; temp < frame.length; temp++)
+            {
+                line.hexByte(data[temp]);
+                line.put(' ');
+            }
+            line.put('\n');
+            line.appendTo(out);
         }
-
-        outFile->write("\n");
-
-    }
-    outFile->close();
-    delete outFile;
-    return true;
+    });
 }
 
-bool FrameFileIO::isLogFile(QString filename)
+int FrameFileIO::probeLogFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    bool isMatch = true;
+    if (!sniff.line(0).toUpper().contains("BUSMASTER")) return PROBE_NO_MATCH;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
+    //skip the *** header block and the line after it
+    int idx = 0;
+    while (idx + 1 < sniff.lineCount() && sniff.line(idx).startsWith("***")) idx++;
+    idx++;
+    if (idx >= sniff.lineCount()) return PROBE_HEADER;
 
-    try
+    QByteArray line = sniff.line(idx).toUpper();
+    if (line.length() > 1)
     {
-        line = inFile->readLine().toUpper();
-        if (!line.contains("BUSMASTER")) isMatch = false;
+        QList<QByteArray> tokens = line.split(' ');
+        if (tokens.length() < 6) return PROBE_NO_MATCH;
 
-        while (!inFile->atEnd() && line.startsWith("***")) {
-            line = inFile->readLine().toUpper();
-        }
+        QList<QByteArray> timeToks = tokens[0].split(':');
+        if (timeToks.count() != 4) return PROBE_NO_MATCH;
 
-        if (!inFile->atEnd())
-        {
-            line = inFile->readLine().toUpper();
-            if (line.length() > 1)
-            {
-                QList<QByteArray> tokens = line.split(' ');
-                if (tokens.length() >= 6)
-                {
-                    QList<QByteArray> timeToks = tokens[0].split(':');
-                    if (timeToks.count() != 4) isMatch = false;
-
-                    int ID = tokens[3].right(tokens[3].length() - 2).toInt(nullptr, 16);
-                    if (ID < 1 || ID > 0x1FFFFFFF) isMatch = false;
-                    if (tokens[4] != "S" && tokens[4] != "X" && tokens[4] != "SR" && tokens[4] != "XR") isMatch = false;
-                    int len = tokens[5].toInt();
-                    if (len > 8) isMatch = false;
-                }
-                else isMatch = false;
-            }
-        }
-    }
-    catch (...)
-    {
-        isMatch = false;
+        int ID = tokens[3].right(tokens[3].length() - 2).toInt(nullptr, 16);
+        if (ID < 1 || ID > 0x1FFFFFFF) return PROBE_NO_MATCH;
+        if (tokens[4] != "S" && tokens[4] != "X" && tokens[4] != "SR" && tokens[4] != "XR") return PROBE_NO_MATCH;
+        int len = tokens[5].toInt();
+        if (len > 8) return PROBE_NO_MATCH;
     }
+    return PROBE_HEADER;
+}
 
-    inFile->close();
-    delete inFile;
-    return isMatch;
+bool FrameFileIO::isLogFile(QString filename)
+{
+    return probeLogFile(FileSniff(filename)) > 0;
 }
 
 //busmaster log file
@@ -2628,120 +2205,86 @@ bool FrameFileIO::loadLogFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::saveLogFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveLogFile(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
 {
-    QFile *outFile = new QFile(filename);
-    QDateTime timestamp, tempStamp;
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
+    QDateTime timestamp;
 
     //timestamp = QDateTime::currentDateTime();
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-
-    outFile->write("***BUSMASTER Ver 3.2.0***\n");
-    outFile->write("***PROTOCOL CAN***\n");
-    outFile->write("***NOTE: PLEASE DO NOT EDIT THIS DOCUMENT***\n");
-    outFile->write("***[START LOGGING SESSION]***\n");
-    outFile->write("***START DATE AND TIME ");
-    outFile->write(timestamp.toString("d:M:yyyy h:m:s:z").toUtf8());
-    outFile->write("***\n");
-    outFile->write("***HEX***\n");
-    outFile->write("***SYSTEM MODE***\n");
-    outFile->write("***START CHANNEL BAUD RATE***\n");
-    outFile->write("***CHANNEL 1 - Kvaser - Kvaser Leaf Light HS #0 (Channel 0), Serial Number- 0, Firmware- 0x00000037 0x00020000 - 500000 bps***\n");
-    outFile->write("***END CHANNEL BAUD RATE***\n");
-    outFile->write("***START DATABASE FILES***\n");
-    outFile->write("***END OF DATABASE FILES***\n");
-    outFile->write("***<Time><Tx/Rx><Channel><CAN ID><Type><DLC><DataBytes>***\n");
-
-    for (int c = 0; c < frames->count(); c++)
-    {
-        lineCounter++;
-        if (lineCounter > 100)
+    QByteArray header;
+    header += "***BUSMASTER Ver 3.2.0***\n";
+    header += "***PROTOCOL CAN***\n";
+    header += "***NOTE: PLEASE DO NOT EDIT THIS DOCUMENT***\n";
+    header += "***[START LOGGING SESSION]***\n";
+    header += "***START DATE AND TIME ";
+    header += timestamp.toString("d:M:yyyy h:m:s:z").toUtf8();
+    header += "***\n";
+    header += "***HEX***\n";
+    header += "***SYSTEM MODE***\n";
+    header += "***START CHANNEL BAUD RATE***\n";
+    header += "***CHANNEL 1 - Kvaser - Kvaser Leaf Light HS #0 (Channel 0), Serial Number- 0, Firmware- 0x00000037 0x00020000 - 500000 bps***\n";
+    header += "***END CHANNEL BAUD RATE***\n";
+    header += "***START DATABASE FILES***\n";
+    header += "***END OF DATABASE FILES***\n";
+    header += "***<Time><Tx/Rx><Channel><CAN ID><Type><DLC><DataBytes>***\n";
+
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, header, [frames](int first, int count, QByteArray &out)
+    {
+        ExportLine line;
+        LocalClock clock;
+        for (int c = first; c < first + count; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        tempStamp = QDateTime::fromMSecsSinceEpoch(frame->timeStamp().microSeconds() / 1000);
-        outFile->write(tempStamp.toString("hh:mm:ss:zzz").toUtf8());
-        if (frame->isReceived) outFile->write(" Rx ");
-        else outFile->write(" Tx ");
-        // busmaster channel start at 1
-        outFile->write(QString::number(frame->bus + 1).toUtf8() + " ");
-        outFile->write("0x");
-        if (frame->hasExtendedFrameFormat() && frame->frameId() > 0x7FF) {
-            outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8());
-        } else {
-            outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(3, '0').toUtf8());
-        }
-        if (frame->hasExtendedFrameFormat()) outFile->write(" x");
-            else outFile->write(" s");
-        if (frame->frameType() == QCanBusFrame::RemoteRequestFrame) outFile->write("r ");
-            else outFile->write(" ");
-        outFile->write(QString::number(dataLen).toUtf8() + " ");
-
-        if (frame->frameType() != QCanBusFrame::RemoteRequestFrame) {
-            for (int temp = 0; temp < dataLen; temp++)
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
+            bool isRemote = (frame.frameType == QCanBusFrame::RemoteRequestFrame);
+
+            //hh:mm:ss:zzz local time
+            int ms = clock.msOfDay(frame.timeStamp / 1000);
+            line.clear();
+            line.dec(ms / 3600000, 2, '0');
+            line.put(':');
+            line.dec((ms / 60000) % 60, 2, '0');
+            line.put(':');
+            line.dec((ms / 1000) % 60, 2, '0');
+            line.put(':');
+            line.dec(ms % 1000, 3, '0');
+            line.put(frame.received ? " Rx " : " Tx ");
+            // busmaster channel start at 1
+            line.dec(frame.bus + 1);
+            line.put(" 0x");
+            if (frame.extended && frame.frameId > 0x7FF) line.hex(frame.frameId, 8);
+            else line.hex(frame.frameId, 3);
+            line.put(frame.extended ? " x" : " s");
+            line.put(isRemote ? "r " : " ");
+            line.dec(frame.length);
+            line.put(' ');
+
+            if (!isRemote)
             {
-                outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-                outFile->putChar(' ');
+                for (int temp = 0; temp < frame.length; temp++)
+                {
+                    line.hexByte(data[temp]);
+                    line.put(' ');
+                }
             }
+            line.put('\n');
+            line.appendTo(out);
         }
+    });
+}
 
-        outFile->write("\n");
-
-    }
-    outFile->close();
-    delete outFile;
-    return true;
+int FrameFileIO::probeIXXATFile(const FileSniff &sniff)
+{
+    if (!sniff.line(0).toUpper().contains("IXXAT")) return PROBE_NO_MATCH;
+    if (sniff.lineCount() < 7) return PROBE_NO_MATCH;
+    if (!sniff.line(6).toUpper().contains("FORMAT")) return PROBE_NO_MATCH;
+    return PROBE_HEADER;
 }
 
 bool FrameFileIO::isIXXATFile(QString filename)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    bool isMatch = true;
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-
-    try
-    {
-        line = inFile->readLine().toUpper();
-        if (!line.contains("IXXAT")) isMatch = false;
-
-        for (int i = 0; i < 6; i++)
-        {
-            if (!inFile->atEnd()) line = inFile->readLine().toUpper();
-            else isMatch = false;
-        }
-
-        if (!line.contains("FORMAT")) isMatch = false;
-    }
-    catch (...)
-    {
-        isMatch = false;
-    }
-
-    inFile->close();
-    delete inFile;
-    return isMatch;
+    return probeIXXATFile(FileSniff(filename)) > 0;
 }
 
 //"00:01:03.03","223","Std","","00 00 00 00 49 00 00 01 "
@@ -2825,114 +2368,82 @@ bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::saveIXXATFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveIXXATFile(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
 {
-    QFile *outFile = new QFile(filename);
-    QDateTime timestamp, tempStamp;
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
-    timestamp = QDateTime::currentDateTime();
-
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-
-    outFile->write("ASCII Trace IXXAT SavvyCAN V" + QString::number(VERSION).toUtf8() + "\n");
-    outFile->write("Date: " + timestamp.toString("d:M:yyyy").toUtf8() + "\n");
-    outFile->write("Start time: " + timestamp.toString("h:m:s").toUtf8() + "\n");
-    timestamp = timestamp.addMSecs((frames->last().timeStamp().microSeconds() - frames->first().timeStamp().microSeconds()) / 1000);
-    outFile->write("Stop time: " + timestamp.toString("h:m:s").toUtf8() + "\n");
-    outFile->write("Overruns: 0\n");
-    outFile->write("Baudrate: 500 kbit/s\n"); //could be a lie... this code has no way to know the baud rate (at the moment)
-    outFile->write("\"Time\",\"Identifier (hex)\",\"Format\",\"Flags\",\"Data (hex)\"\n");
-
-    for (int c = 0; c < frames->count(); c++)
-    {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        tempStamp = QDateTime::fromMSecsSinceEpoch(frame->timeStamp().microSeconds() / 1000);
-        outFile->write("\"" + tempStamp.toString("h:m:s.").toUtf8() + tempStamp.toString("z").rightJustified(3, '0').toUtf8() + "\"");
-
-        outFile->write(",\"" + QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8() + "\"");
-        if (frame->hasExtendedFrameFormat()) outFile->write(",\"Ext\"");
-            else outFile->write(",\"Std\"");
-        outFile->write(",\"\",\"");
-
-        for (int temp = 0; temp < dataLen; temp++)
+    QDateTime timestamp = QDateTime::currentDateTime();
+
+    QByteArray header;
+    header += "ASCII Trace IXXAT SavvyCAN V" + QString::number(VERSION).toUtf8() + "\n";
+    header += "Date: " + timestamp.toString("d:M:yyyy").toUtf8() + "\n";
+    header += "Start time: " + timestamp.toString("h:m:s").toUtf8() + "\n";
+    if (!frames->isEmpty()) timestamp = timestamp.addMSecs((frames->timeStampAt(frames->count() - 1) - frames->timeStampAt(0)) / 1000);
+    header += "Stop time: " + timestamp.toString("h:m:s").toUtf8() + "\n";
+    header += "Overruns: 0\n";
+    header += "Baudrate: 500 kbit/s\n"; //could be a lie... this code has no way to know the baud rate (at the moment)
+    header += "\"Time\",\"Identifier (hex)\",\"Format\",\"Flags\",\"Data (hex)\"\n";
+
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, header, [frames](int first, int count, QByteArray &out)
+    {
+        ExportLine line;
+        LocalClock clock;
+        for (int c = first; c < first + count; c++)
         {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
+
+            //"h:m:s.zzz" local time, only the milliseconds are padded
+            int ms = clock.msOfDay(frame.timeStamp / 1000);
+            line.clear();
+            line.put('"');
+            line.dec(ms / 3600000);
+            line.put(':');
+            line.dec((ms / 60000) % 60);
+            line.put(':');
+            line.dec((ms / 1000) % 60);
+            line.put('.');
+            line.dec(ms % 1000, 3, '0');
+            line.put("\",\"");
+            line.hex(frame.frameId, 8);
+            line.put('"');
+            line.put(frame.extended ? ",\"Ext\"" : ",\"Std\"");
+            line.put(",\"\",\"");
+
+            for (int temp = 0; temp < frame.length; temp++)
+            {
+                line.hexByte(data[temp]);
+                line.put(' ');
+            }
+            line.put("\"\n");
+            line.appendTo(out);
         }
-
-        outFile->write("\"\n");
-
-    }
-    outFile->close();
-    delete outFile;
-    return true;
+    });
 }
 
-bool FrameFileIO::isCANDOFile(QString filename)
+int FrameFileIO::probeCANDOFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    int lineCounter = 0;
-    QByteArray data;
-    bool isMatch = true;
-
-    if (!inFile->open(QIODevice::ReadOnly))
-    {
-        delete inFile;
-        return false;
-    }
-
     //this file format is in static 12 byte blocks.
     //Bytes 0 - 1 are a time stamp
     //Bytes 2 - 3 are the data length (top 4 bits) then ID (bottom 11 bits)
     //Bytes 4 - 11 are the data bytes (padded with FF for bytes not used)
-    try
-    {
-        while (!inFile->atEnd() && lineCounter < 200)
-        {
-            lineCounter++;
-
-            data = inFile->read(12);
+    const uchar *data = reinterpret_cast<const uchar *>(sniff.start().constData());
+    int blocks = qMin(sniff.start().length() / 12, 200);
+    if (blocks == 0) return PROBE_NO_MATCH;
 
-            int ID = ((data[3] & 0x0F) * 256 + data[2]);
-            int len = data[3] >> 4;
-
-            if (len <= 8 && ID <= 0x7FF)
-            {
-                if (len < 8)
-                {
-                    if (data[4 + len] != static_cast<char>(0xFF)) isMatch = false;
-                }
-            }
-            else isMatch = false;
-        }
-    }
-    catch (...)
+    for (int b = 0; b < blocks; b++, data += 12)
     {
-        isMatch = false;
+        int ID = ((data[3] & 0x0F) * 256 + data[2]);
+        int len = data[3] >> 4;
+
+        if (len > 8 || ID > 0x7FF) return PROBE_NO_MATCH;
+        if (len < 8 && data[4 + len] != 0xFF) return PROBE_NO_MATCH;
     }
+    return PROBE_WEAK;
+}
 
-    inFile->close();
-    delete inFile;
-    return isMatch;
+bool FrameFileIO::isCANDOFile(QString filename)
+{
+    return probeCANDOFile(FileSniff(filename)) > 0;
 }
 
 bool FrameFileIO::loadCANDOFile(QString filename, QVector<CANFrame>* frames)
@@ -3001,120 +2512,80 @@ bool FrameFileIO::loadCANDOFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::saveCANDOFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveCANDOFile(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
 {
-    QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
-    QByteArray data;
-    CANFrame thisFrame;
-    int id;
-    qint64 ms;
-
-    const unsigned char *inData;
-    int inDataLen;
-    const CANFrame *frame;
-
-    if (!outFile->open(QIODevice::WriteOnly))
+    //The initial frame in official files sets the global time but I don't care so it is set all zeros here.
+    QByteArray header;
+    if (!frames->isEmpty())
     {
-        delete outFile;
-        return false;
+        qint64 ms = (frames->timeStampAt(0) / 1000);
+        header.resize(12);
+        header[0] = static_cast<char>((((ms / 1000) % 60) << 2) + ((ms % 1000) >> 8));
+        header[1] = static_cast<char>(ms & 0xFF);
+        header[2] = static_cast<char>(0xFF);
+        header[3] = static_cast<char>(0xFF);
+        for (int l = 0; l < 8; l++) header[4 + l] = 0;
     }
 
-    data.reserve(13);
-
-    //The initial frame in official files sets the global time but I don't care so it is set all zeros here.
-    thisFrame = frames->at(0);
-    ms = (thisFrame.timeStamp().microSeconds() / 1000);
-    data[0] = (((ms / 1000) % 60) << 2) + ((ms % 1000) >> 8);
-    data[1] = (char)(ms & 0xFF);
-    data[2] = (char)0xFF;
-    data[3] = (char)0xFF;
-    for (int l = 0; l < 8; l++) data[4 + l] = 0;
-    outFile->write(data);
-
-    for (int c = 0; c < frames->count(); c++)
+    FrameExporter exporter(frames, progress);
+    exporter.setOpenMode(QIODevice::WriteOnly);
+    return exporter.run(filename, header, [frames](int first, int count, QByteArray &out)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        inData = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        inDataLen = frame->payload().count();
-
-        for (int j = 0; j < 8; j++) data[4 + j] = (char)0xFF;
-
-        if (!frame->hasExtendedFrameFormat())
+        char data[12];
+        for (int c = first; c < first + count; c++)
         {
-            ms = (frame->timeStamp().microSeconds() / 1000);
-            id = frame->frameId() & 0x7FF;
-            data[0] = (((ms / 1000) % 60) << 2) + ((ms % 1000) >> 8);
-            data[1] = (char)(ms & 0xFF);
-            data[2] = (char)(id & 0xFF);
-            data[3] = (char)((id >> 8) + (inDataLen << 4));
-            for (int d = 0; d < inDataLen; d++) data[4 + d] = (char)inData[d];
-            outFile->write(data);
-        }
-    }
-    outFile->close();
-    delete outFile;
-    return true;
+            const PackedCANFrame &frame = frames->recordAt(c);
+            if (frame.extended) continue; //the format only has room for 11 bit IDs
+
+            //records are 8 data bytes long, a CAN-FD payload gets cut down to that
+            int dataLen = qMin(static_cast<int>(frame.length), 8);
+            qint64 ms = (frame.timeStamp / 1000);
+            int id = frame.frameId & 0x7FF;
+            data[0] = static_cast<char>((((ms / 1000) % 60) << 2) + ((ms % 1000) >> 8));
+            data[1] = static_cast<char>(ms & 0xFF);
+            data[2] = static_cast<char>(id & 0xFF);
+            data[3] = static_cast<char>((id >> 8) + (frame.length << 4));
+            memset(data + 4, 0xFF, 8);
+            memcpy(data + 4, frames->payloadAt(c), static_cast<size_t>(dataLen));
+            out.append(data, 12);
+        }
+    });
 }
 
-bool FrameFileIO::isMicrochipFile(QString filename)
+int FrameFileIO::probeMicrochipFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
     bool inComment = false;
-    int lineCounter = 0;
-    bool isMatch = true;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    for (int i = 0; i < 100 && i < sniff.lineCount(); i++)
     {
-        delete inFile;
-        return false;
-    }
-    try
-    {
-        while (!inFile->atEnd() && lineCounter < 100) {
-            lineCounter++;
-
-            line = inFile->readLine();
-            if (line.length() > 2)
+        const QByteArray &line = sniff.line(i);
+        if (line.length() > 2)
+        {
+            if (line.startsWith("//"))
             {
-                if (line.startsWith("//"))
-                {
-                    inComment = !inComment;
-                }
-                else
+                inComment = !inComment;
+            }
+            else
+            {
+                if (!inComment)
                 {
-                    if (!inComment)
-                    {
-                        QList<QByteArray> tokens = line.split(';');
-                        if (tokens.length() >= 4)
-                        {
-                            int ID = Utility::ParseStringToNum(tokens[2]);
-                            if (ID < 1 || ID > 0x1FFFFFFF) isMatch = false;
-                            int len = tokens[3].toInt();
-                            if ( len > 8 || len < 0 ) isMatch = false;
-                            if ( (len + 4)  < tokens.length() ) isMatch = false;
-                        }
-                        else isMatch = false;
-                    }
+                    QList<QByteArray> tokens = line.split(';');
+                    if (tokens.length() < 4) return PROBE_NO_MATCH;
+                    int ID = Utility::ParseStringToNum(tokens[2]);
+                    if (ID < 1 || ID > 0x1FFFFFFF) return PROBE_NO_MATCH;
+                    int len = tokens[3].toInt();
+                    if ( len > 8 || len < 0 ) return PROBE_NO_MATCH;
+                    if ( (len + 4)  < tokens.length() ) return PROBE_NO_MATCH;
                 }
             }
         }
     }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+    return PROBE_PATTERN;
+}
+
+bool FrameFileIO::isMicrochipFile(QString filename)
+{
+    return probeMicrochipFile(FileSniff(filename)) > 0;
 }
 
 //log file from microchip tool
@@ -3205,521 +2676,123 @@ tokens:
 3 = data length
 4-x = data bytes in hex with 0x prefix
 */
-bool FrameFileIO::saveMicrochipFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveMicrochipFile(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
 {
-    QFile *outFile = new QFile(filename);
-    QDateTime timestamp, tempStamp;
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
-    timestamp = QDateTime::currentDateTime();
-
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-
-    outFile->write("//---------------------------------\n");
-    outFile->write("Microchip Technology Inc.\n");
-    outFile->write("CAN BUS Analyzer\n");
-    outFile->write("SavvyCAN Exporter\n");
-    outFile->write("Logging Started: ");
-    outFile->write(timestamp.toString("d/M/yyyy h:m:s").toUtf8());
-    outFile->write("\n");
-    outFile->write("//---------------------------------\n");
-
-    for (int c = 0; c < frames->count(); c++)
-    {
-        lineCounter++;
-        if (lineCounter > 100)
+    QDateTime timestamp = QDateTime::currentDateTime();
+
+    QByteArray header;
+    header += "//---------------------------------\n";
+    header += "Microchip Technology Inc.\n";
+    header += "CAN BUS Analyzer\n";
+    header += "SavvyCAN Exporter\n";
+    header += "Logging Started: ";
+    header += timestamp.toString("d/M/yyyy h:m:s").toUtf8();
+    header += "\n";
+    header += "//---------------------------------\n";
+
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, header, [frames](int first, int count, QByteArray &out)
+    {
+        ExportLine line;
+        for (int c = first; c < first + count; c++)
         {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        outFile->write(QString::number((frame->timeStamp().microSeconds() / 1000)).toUtf8());
-        if (frame->isReceived) outFile->write(";RX;");
-        else outFile->write(";TX;");
-        outFile->write("0x" + QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8() + ";");
-        outFile->write(QString::number(dataLen).toUtf8() + ";");
-
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write("0x" + QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(';');
-        }
-
-        outFile->write("\n");
-
-    }
-    outFile->close();
-    delete outFile;
-    return true;
-}
-
-bool FrameFileIO::isTraceFile(QString filename)
-{
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    int lineCounter = 0;
-    bool isMatch = true;
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-
-    try
-    {
-        while (!inFile->atEnd() && lineCounter < 100) {
-            lineCounter++;
-
-            line = inFile->readLine();
-            line = line.trimmed();
-            if (line.length() > 2)
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
+
+            line.clear();
+            line.dec(frame.timeStamp / 1000);
+            line.put(frame.received ? ";RX;0x" : ";TX;0x");
+            line.hex(frame.frameId, 8);
+            line.put(';');
+            line.dec(frame.length);
+            line.put(';');
+
+            for (int temp = 0; temp < frame.length; temp++)
             {
-                if (line.startsWith(";"))
-                {
-                    // a comment. Ignore it.
-                }
-                else
-                {
-                    QList<QByteArray> tokens = line.split('\t');
-                    if (tokens.length() > 3)
-                    {
-                        QList<QByteArray> timestampToks = tokens[1].split(':');
-                        if (timestampToks.count() != 4) isMatch = false;
-
-                        long ID = tokens[2].toLong(nullptr, 16);
-                        if (ID < 1 || ID > 0x1FFFFFFF) isMatch = false;
-                        int len = tokens[3].toInt();
-                        if (len > 8 || len < 0) isMatch = false;
-                        QList<QByteArray> dataToks = tokens[4].split(' ');
-                        if (len > dataToks.length()) isMatch = false;
-                    }
-                    else isMatch = false;
-                }
+                line.put("0x");
+                line.hexByte(data[temp]);
+                line.put(';');
             }
+            line.put('\n');
+            line.appendTo(out);
         }
-    }
-    catch (...)
-    {
-        isMatch = false;
-    }
-
-    inFile->close();
-    delete inFile;
-    return isMatch;
+    });
 }
 
-/*
-;  CAN Logger trace file
-;  Device Serial Number :
-;  Start Time : Tue, Nov 17, 2015 :: 11:19:59
-;
-;  Column description :
-;  ~~~~~~~~~~~~~~~~~~~~~
-;
-;   + Message Number
-;   |
-;   |     	     + Time Stamp (ms)
-;   |     	     |
-;   |     	     |      	    + Message ID (hex)
-;   |     	     |      	    |
-;   |     	     |      	    |   	+ Data Length Code
-;   |     	     |      	    |   	|
-;   |     	     |      	    |   	|	 + Data Bytes (hex)
-;   |     	     |      	    |   	|	 |
-;---+-----	-----+------	----+---	+	-+ -- -- -- -- -- -- --
-         0	00:00:00:0008	00000268	8	55 00 84 03 A8 0D 38 00
-         1	00:00:00:0021	0000000E	8	1F D3 3F FF 08 FF E0 CB
-
-It appears that all lines that start in a semicolon are comments
-The rest of the lines need the whitespace stripped from beginning and end
-and then it appears to be tab delimited. The first field is a sequence number
-and irrelevant. The second field is a funky timestamp, then message id, etc as
-shown in the file comments. The bytes seem to be space delimited and in hex
-*/
-
-bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame>* frames)
+int FrameFileIO::probeTraceFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    CANFrame thisFrame;
-    QByteArray line;
-    long long timeStamp = 0;
-    int lineCounter = 0;
-    bool foundErrors = false;
-    thisFrame.setFrameType(QCanBusFrame::DataFrame);
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    for (int i = 0; i < 100 && i < sniff.lineCount(); i++)
     {
-        delete inFile;
-        return false;
-    }
-
-    while (!inFile->atEnd()) {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        line = inFile->readLine();
-        line = line.trimmed();
+        QByteArray line = sniff.line(i).trimmed();
         if (line.length() > 2)
         {
             if (line.startsWith(";"))
             {
                 // a comment. Ignore it.
             }
-            else
-            {
-                QList<QByteArray> tokens = line.split('\t');
-                if (tokens.length() > 3)
-                {
-                    QList<QByteArray> timestampToks = tokens[1].split(':');
-
-                    timeStamp = timestampToks[0].toInt() * 1000000l * 60 * 60;
-                    timeStamp += timestampToks[1].toInt() * 1000000l * 60;
-                    timeStamp += timestampToks[2].toInt() * 1000000l;
-                    timeStamp += timestampToks[3].toInt() * 100;
-
-                    thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, static_cast<uint32_t>(timeStamp)));
-
-                    thisFrame.setFrameId(static_cast<uint32_t>(tokens[2].toLong(nullptr, 16)));
-                    if (thisFrame.frameId() <= 0x7FF) thisFrame.setExtendedFrameFormat(false);
-                        else thisFrame.setExtendedFrameFormat(true);
-                    thisFrame.bus = 0;
-                    thisFrame.setFrameType(QCanBusFrame::DataFrame);
-                    int numBytes = tokens[3].toInt();
-                    if (numBytes > 8) numBytes = 8;
-                    QByteArray bytes(numBytes, 0);
-                    QList<QByteArray> dataToks = tokens[4].split(' ');
-                    //if (numBytes > dataToks.length()) thisFrame.payload().resize(dataToks.length());
-                    for (int d = 0; d < numBytes; d++) bytes[d] = static_cast<char>(dataToks[d].toInt(nullptr, 16));
-                    thisFrame.setPayload(bytes);
-                    frames->append(thisFrame);
-                }
-                else foundErrors = true;
-            }
-        }
-    }
-    inFile->close();
-    delete inFile;
-    return !foundErrors;
-}
-
-bool FrameFileIO::saveTraceFile(QString filename, const QVector<CANFrame> * frames)
-{
-    QFile *outFile = new QFile(filename);
-    QDateTime timestamp;
-    int lineCounter = 0;
-    int64_t tempTime;
-    int tempTimePiece;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
-    timestamp = QDateTime::currentDateTime();
-
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-
-    outFile->write(";  SavvyCAN CAN Logger trace file\n");
-    outFile->write(";  Device Serial Number : 0000 \n");
-    outFile->write(";  Start Time : ");
-    outFile->write(timestamp.toString("ddd, MMM dd, yyyy :: h:m:s\n").toUtf8());
-    outFile->write(";\n");
-    outFile->write(";  Column description :\n");
-    outFile->write(";  ~~~~~~~~~~~~~~~~~~~~~\n");
-    outFile->write(";\n");
-    outFile->write(";   + Message Number\n");
-    outFile->write(";   |\n");
-    outFile->write(";   |     	     + Time Stamp (ms)\n");
-    outFile->write(";   |     	     |\n");
-    outFile->write(";   |     	     |      	    + Message ID (hex)\n");
-    outFile->write(";   |     	     |      	    |\n");
-    outFile->write(";   |     	     |      	    |   	+ Data Length Code\n");
-    outFile->write(";   |     	     |      	    |   	|\n");
-    outFile->write(";   |     	     |      	    |   	|	 + Data Bytes (hex)\n");
-    outFile->write(";   |     	     |      	    |   	|	 |\n");
-    outFile->write(";---+-----	-----+------	----+---	+	-+ -- -- -- -- -- -- --\n");
-
-
-    for (int c = 0; c < frames->count(); c++)
-    {
-        lineCounter++;
-        if ((lineCounter % 100) == 0)
-        {
-            qApp->processEvents();
-            //lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-         //1F D3 3F FF 08 FF E0 CB
-        outFile->write(QString::number(lineCounter).rightJustified(10, ' ').toUtf8());
-        outFile->write("\t");
-
-        tempTime = frame->timeStamp().microSeconds();
-        tempTimePiece = static_cast<int>(tempTime / 1000000l / 60 / 60);
-        tempTime -= tempTimePiece * 1000000l * 60 * 60;
-        outFile->write(QString::number(tempTimePiece).rightJustified(2, '0').toUtf8());
-        outFile->write(":");
-
-        tempTimePiece = static_cast<int>(tempTime / 1000000l / 60);
-        tempTime -= tempTimePiece * 1000000l * 60;
-        outFile->write(QString::number(tempTimePiece).rightJustified(2, '0').toUtf8());
-        outFile->write(":");
-
-        tempTimePiece = static_cast<int>(tempTime / 1000000l);
-        tempTime -= tempTimePiece * 1000000l;
-        outFile->write(QString::number(tempTimePiece).rightJustified(2, '0').toUtf8());
-        outFile->write(":");
-
-        tempTimePiece = static_cast<int>(tempTime / 100);
-        outFile->write(QString::number(tempTimePiece).rightJustified(4, '0').toUtf8());
-        outFile->write("\t");
-
-        outFile->write(QString::number(frame->frameId(), 16).toUpper().rightJustified(8, '0').toUtf8() + "\t");
-
-        outFile->write(QString::number(dataLen).toUtf8() + "\t");
-
-        for (int temp = 0; temp < dataLen; temp++)
-        {
-            outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
-        }
-
-        outFile->write("\n");
-
-    }
-    outFile->close();
-    delete outFile;
-    return true;
-}
-
-bool FrameFileIO::saveCanDumpFile(QString filename, const QVector<CANFrame> * frames)
-{
-    QFile *outFile = new QFile(filename);
-    QDateTime timestamp;
-    int lineCounter = 0;
-    double tempTime;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
-    timestamp = QDateTime::currentDateTime();
-
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-
-    for (int c = 0; c < frames->count(); c++)
-    {
-        lineCounter++;
-        if ((lineCounter % 100) == 0)
-        {
-            qApp->processEvents();
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        outFile->write("(");
-
-        tempTime = frame->timeStamp().microSeconds() / 1000000.0;
-        outFile->write(QString::number(tempTime,'f', 6).rightJustified(17, '0').toUtf8());
-        outFile->write(") vcan0 ");
-
-        if (frame->hasExtendedFrameFormat()) {
-            outFile->write(QString::number(frame->frameId(), 16).rightJustified(8,'0').toUpper().toUtf8());
-        } else {
-            outFile->write(QString::number(frame->frameId(), 16).rightJustified(3,'0').toUpper().toUtf8());
-        }
-
-        outFile->write("#");
-
-        if (frame->frameType() == QCanBusFrame::RemoteRequestFrame) {
-            outFile->write("R");
-            outFile->write(QString::number(dataLen).toUtf8());
-        } else {
-            for (int temp = 0; temp < dataLen; temp++)
-            {
-                outFile->write(QString::number(data[temp], 16).rightJustified(2,'0').toUpper().toUtf8());
-            }
-        }
-
-        outFile->write("\n");
-
-    }
-    outFile->close();
-    delete outFile;
-    return true;
-}
-
-bool FrameFileIO::isCanDumpFile(QString filename)
-{
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    QList<QByteArray> tokens;
-    QRegularExpression timeExp(QRegularExpression::anchoredPattern("^\\((\\S+)\\)$")); //anchored pattern causes exact match
-    QRegularExpression IdValExp(QRegularExpression::anchoredPattern("^(\\S+)#(\\S+)$"));
-    QRegularExpression valExp("(\\S{2})");
-    int lineCounter = 0;
-    int pos = 0;
-    bool isMatch = true;
-    bool ret;
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-
-    try
-    {
-        while (!inFile->atEnd() && lineCounter < 100) {
-            lineCounter++;
-
-            line = inFile->readLine().toUpper();
-            if (line.length() > 1)
-            {
-                /* tokenize */
-                tokens.clear();
-                tokens = line.simplified().split(' ');
-                if(tokens.count() < 3) isMatch = false;
-
-                /* timestamp */                
-                QRegularExpressionMatch timeExpMatched = timeExp.match(tokens[0]);
-                if(!timeExpMatched.hasMatch()) {
-                    isMatch = false;
-                }
-
-                /*uint64_t timestamp = (uint64_t)*/(timeExpMatched.captured(1).toDouble(&ret) /** (double)1000000.0*/);
-                if(!ret) isMatch = false;
-
-                if (line.contains('[')) //the expanded format
-                {
-                    //(1551774790.942758) can1 7A8 [8] F4 DC D1 83 0E 02 00 00
-                    //     0               1     2   3  4 5  6  7  8  9  10 11
-                    if (tokens.count() < 4)
-                    {
-                        isMatch = false;
-                        continue;
-                    }
-                    int ID = tokens[2].toULong(nullptr, 16);
-                    if (ID > 0x1FFFFFFF || ID == 0) isMatch = false;
-                    if (tokens[3].size() < 2) {
-                        isMatch = false;
-                        continue;
-                    }
-                    int len = tokens[3].at(1) - '0';
-                    if (len < 0 || len > 8) isMatch = false;
-                }
-                else  //the more concise format
-                {
-                    /* ID & value */
-                    //qDebug() << tokens[2];
-                    if (tokens.count() < 3)
-                    {
-                        isMatch = false;
-                        continue;
-                    }
-
-
-                    QRegularExpressionMatch IdValExpMatched = IdValExp.match(tokens[2]);
-                    if(!IdValExpMatched.hasMatch())
-                    {
-                        isMatch = false;
-                        continue;
-                    }
-
-                    /* ID */
-                    /*int ID = */IdValExpMatched.captured(1).toInt(&ret, 16);
-
-                    QString val= IdValExpMatched.captured(2);
-
-                    pos = 0;
-                    int len = 0;
-                    if (val.startsWith("R") && val.at(1).isDigit()) {
-                        len = val.at(1).toLatin1() - '0';
-                        if (len < 0 || len > 8)
-                        {
-                            isMatch = false;
-                            continue;
-                        }
-                    } else {
-                        /* val byte per byte */
-                        int lng = 0;
-                        QRegularExpressionMatch valExpMatch;
-                        QRegularExpressionMatchIterator i = valExp.globalMatch(val);
-                        while (i.hasNext()) {
-                            valExpMatch = i.next();
-                            lng++;
-                            if (lng > 8)
-                            {
-                                isMatch = false;
-                                break;
-                            }
-                            /*int data = */valExpMatch.captured(1).toInt(&ret, 16);
-                            if(!ret)
-                            {
-                                isMatch = false;
-                                break;
-                            }
+            else
+            {
+                QList<QByteArray> tokens = line.split('\t');
+                if (tokens.length() <= 3) return PROBE_NO_MATCH;
 
-                        }
-                    }
-                }
+                QList<QByteArray> timestampToks = tokens[1].split(':');
+                if (timestampToks.count() != 4) return PROBE_NO_MATCH;
+
+                long ID = tokens[2].toLong(nullptr, 16);
+                if (ID < 1 || ID > 0x1FFFFFFF) return PROBE_NO_MATCH;
+                int len = tokens[3].toInt();
+                if (len > 8 || len < 0) return PROBE_NO_MATCH;
+                QList<QByteArray> dataToks = tokens.value(4).split(' ');
+                if (len > dataToks.length()) return PROBE_NO_MATCH;
             }
         }
     }
-    catch (...)
-    {
-        isMatch = false;
-    }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+    return PROBE_PATTERN;
+}
+
+bool FrameFileIO::isTraceFile(QString filename)
+{
+    return probeTraceFile(FileSniff(filename)) > 0;
 }
 
 /*
-   (0.003800) vcan0 164#0000c01aa8000013
-                       or
-   (1551774790.942758) can1 7A8 [8] F4 DC D1 83 0E 02 00 00
+;  CAN Logger trace file
+;  Device Serial Number :
+;  Start Time : Tue, Nov 17, 2015 :: 11:19:59
+;
+;  Column description :
+;  ~~~~~~~~~~~~~~~~~~~~~
+;
+;   + Message Number
+;   |
+;   |     	     + Time Stamp (ms)
+;   |     	     |
+;   |     	     |      	    + Message ID (hex)
+;   |     	     |      	    |
+;   |     	     |      	    |   	+ Data Length Code
+;   |     	     |      	    |   	|
+;   |     	     |      	    |   	|	 + Data Bytes (hex)
+;   |     	     |      	    |   	|	 |
+;---+-----	-----+------	----+---	+	-+ -- -- -- -- -- -- --
+         0	00:00:00:0008	00000268	8	55 00 84 03 A8 0D 38 00
+         1	00:00:00:0021	0000000E	8	1F D3 3F FF 08 FF E0 CB
+
+It appears that all lines that start in a semicolon are comments
+The rest of the lines need the whitespace stripped from beginning and end
+and then it appears to be tab delimited. The first field is a sequence number
+and irrelevant. The second field is a funky timestamp, then message id, etc as
+shown in the file comments. The bytes seem to be space delimited and in hex
 */
-bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame>* frames)
+
+bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame>* frames)
 {
     QFile *inFile = new QFile(filename);
     CANFrame thisFrame;
     QByteArray line;
-    QList<QByteArray> tokens;
-    QRegularExpression timeExp(QRegularExpression::anchoredPattern("^\\((\\S+)\\)$")); //anchored pattern causes exact match
-    QRegularExpression IdValExp(QRegularExpression::anchoredPattern("^(\\S+)#(\\S+)$"));
-    QRegularExpression valExp("(\\S{2})");
+    long long timeStamp = 0;
     int lineCounter = 0;
-    bool ret;
+    bool foundErrors = false;
+    thisFrame.setFrameType(QCanBusFrame::DataFrame);
 
     if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
     {
@@ -3735,152 +2808,367 @@ bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame>* frames)
             lineCounter = 0;
         }
 
-        line = inFile->readLine().toUpper();
-        if (line.length() > 1)
+        line = inFile->readLine();
+        line = line.trimmed();
+        if (line.length() > 2)
         {
-            /* tokenize */
-            tokens.clear();
-            tokens = line.simplified().split(' ');
-            if(tokens.count()<3) continue;
-
-            /* timestamp */
-            QRegularExpressionMatch timeExpMatched = timeExp.match(tokens[0]);
-            if(!timeExpMatched.hasMatch()) continue;
-            
-            //Sort out the bus
-            std::string busString = tokens[1].toStdString();
-            const char* busStringPtr = busString.c_str();
-            
-            int busNum = 0;
-            
-            //Search for where we have a bus number (skipping the can or vcan text)
-            for (unsigned int i = 0; i < busString.length(); i++)
-            {
-                if (busStringPtr[i] >= '0' && busStringPtr[i] <= '9')
-                {
-                    //Found where the number starts
-                    busNum = atoi(busStringPtr + i);
-                    break;
-                }
-            }
-            
-            thisFrame.bus = busNum;
-            
-            thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, (uint64_t)(timeExpMatched.captured(1).toDouble(&ret) * (double)1000000.0)));
-            if(!ret) continue;
-
-            if (line.contains('[')) //the expanded format (second one from the above list)
+            if (line.startsWith(";"))
             {
-                //(1551774790.942758) can1 7A8 [8] F4 DC D1 83 0E 02 00 00
-                //(1551774790.942758) can1 7A8 [08] F4 DC D1 83 0E 02 00 00
-                //     0               1     2   3  4 5  6  7  8  9  10 11
-                thisFrame.setFrameId(tokens[2].toLong(nullptr, 16));
-                if (thisFrame.frameId() > 0x7FF) thisFrame.setExtendedFrameFormat(true);
-                else thisFrame.setExtendedFrameFormat(false);
-                thisFrame.setFrameType(QCanBusFrame::DataFrame);
-                int numBytes;
-		if (tokens[3].at(2) == ']')
-		    numBytes = tokens[3].at(1) - '0';
-		else
-		    numBytes = (tokens[3].at(1) - '0')*10 + (tokens[3].at(2) - '0');
-                QByteArray bytes(numBytes, 0);
-                for (int c = 0; c < numBytes; c++)
-                {
-                    if ((4 + c) < tokens.size()) bytes[c] = static_cast<char>(tokens[4 + c].toInt(nullptr, 16));
-                }
-                thisFrame.setPayload(bytes);
+                // a comment. Ignore it.
             }
-            else  //the more concise format (first one from list above)
+            else
             {
-                /* ID & value */
-                //qDebug() << tokens[2];
-                QRegularExpressionMatch IdValExpMatched = IdValExp.match(tokens[2]);
-                if(!IdValExpMatched.hasMatch())
+                QList<QByteArray> tokens = line.split('\t');
+                if (tokens.length() > 3)
                 {
-                    qDebug() << "ID regex didn't match!";
-                    continue;
-                }
+                    QList<QByteArray> timestampToks = tokens[1].split(':');
 
-                /* ID */
-                thisFrame.setFrameId(static_cast<uint32_t>(IdValExpMatched.captured(1).toInt(&ret, 16)));
-                if (IdValExpMatched.captured(1).length() > 3)
-                {
-                    thisFrame.setExtendedFrameFormat(true);
-                }
-                else
-                {
-                    thisFrame.setExtendedFrameFormat(false);
-                }
+                    timeStamp = timestampToks[0].toInt() * 1000000l * 60 * 60;
+                    timeStamp += timestampToks[1].toInt() * 1000000l * 60;
+                    timeStamp += timestampToks[2].toInt() * 1000000l;
+                    timeStamp += timestampToks[3].toInt() * 100;
 
-                QString val = IdValExpMatched.captured(2);
+                    thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, static_cast<uint32_t>(timeStamp)));
 
-                QByteArray bytes;
-                if (val.startsWith("R") && val.at(1).isDigit()) {
-                    thisFrame.payload().resize( val.at(1).toLatin1() - '0' );
-                    thisFrame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-                } else {
+                    thisFrame.setFrameId(static_cast<uint32_t>(tokens[2].toLong(nullptr, 16)));
+                    if (thisFrame.frameId() <= 0x7FF) thisFrame.setExtendedFrameFormat(false);
+                        else thisFrame.setExtendedFrameFormat(true);
+                    thisFrame.bus = 0;
                     thisFrame.setFrameType(QCanBusFrame::DataFrame);
-                    /* val byte per byte */
-                    QRegularExpressionMatch valExpMatch;
-                    QRegularExpressionMatchIterator i = valExp.globalMatch(val);
-                    while (i.hasNext())
-                    {
-                        valExpMatch = i.next();
-                        bytes.append((char)valExpMatch.captured(1).toInt(&ret, 16));
-                        if(!ret) continue;
-                    }
+                    int numBytes = tokens[3].toInt();
+                    if (numBytes > 8) numBytes = 8;
+                    QByteArray bytes(numBytes, 0);
+                    QList<QByteArray> dataToks = tokens[4].split(' ');
+                    //if (numBytes > dataToks.length()) thisFrame.payload().resize(dataToks.length());
+                    for (int d = 0; d < numBytes; d++) bytes[d] = static_cast<char>(dataToks[d].toInt(nullptr, 16));
+                    thisFrame.setPayload(bytes);
+                    frames->append(thisFrame);
                 }
-                thisFrame.setPayload(bytes);
+                else foundErrors = true;
             }
-
-            /*NB: should we make sure len <= 8? */
-            thisFrame.isReceived = true;
-       }
-       frames->append(thisFrame);
+        }
     }
     inFile->close();
     delete inFile;
-    return true;
+    return !foundErrors;
 }
 
-bool FrameFileIO::isLawicelFile(QString filename)
+bool FrameFileIO::saveTraceFile(QString filename, const CANFrameStore * frames, QProgressDialog *progress)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    int lineCounter = 0;
-    bool isMatch = false;
+    QDateTime timestamp = QDateTime::currentDateTime();
+
+    QByteArray header;
+    header += ";  SavvyCAN CAN Logger trace file\n";
+    header += ";  Device Serial Number : 0000 \n";
+    header += ";  Start Time : ";
+    header += timestamp.toString("ddd, MMM dd, yyyy :: h:m:s\n").toUtf8();
+    header += ";\n";
+    header += ";  Column description :\n";
+    header += ";  ~~~~~~~~~~~~~~~~~~~~~\n";
+    header += ";\n";
+    header += ";   + Message Number\n";
+    header += ";   |\n";
+    header += ";   |     \t     + Time Stamp (ms)\n";
+    header += ";   |     \t     |\n";
+    header += ";   |     \t     |      \t    + Message ID (hex)\n";
+    header += ";   |     \t     |      \t    |\n";
+    header += ";   |     \t     |      \t    |   \t+ Data Length Code\n";
+    header += ";   |     \t     |      \t    |   \t|\n";
+    header += ";   |     \t     |      \t    |   \t|\t + Data Bytes (hex)\n";
+    header += ";   |     \t     |      \t    |   \t|\t |\n";
+    header += ";---+-----\t-----+------\t----+---\t+\t-+ -- -- -- -- -- -- --\n";
+
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, header, [frames](int first, int count, QByteArray &out)
+    {
+        ExportLine line;
+        for (int c = first; c < first + count; c++)
+        {
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
+
+            //1F D3 3F FF 08 FF E0 CB
+            line.clear();
+            line.dec(c + 1, 10);
+            line.put('\t');
+
+            int64_t tempTime = frame.timeStamp;
+            int64_t tempTimePiece = tempTime / 1000000ll / 60 / 60;
+            tempTime -= tempTimePiece * 1000000ll * 60 * 60;
+            line.dec(tempTimePiece, 2, '0');
+            line.put(':');
+
+            tempTimePiece = tempTime / 1000000ll / 60;
+            tempTime -= tempTimePiece * 1000000ll * 60;
+            line.dec(tempTimePiece, 2, '0');
+            line.put(':');
+
+            tempTimePiece = tempTime / 1000000ll;
+            tempTime -= tempTimePiece * 1000000ll;
+            line.dec(tempTimePiece, 2, '0');
+            line.put(':');
+
+            line.dec(tempTime / 100, 4, '0');
+            line.put('\t');
+
+            line.hex(frame.frameId, 8);
+            line.put('\t');
+            line.dec(frame.length);
+            line.put('\t');
+
+            for (int temp = 0; temp < frame.length; temp++)
+            {
+                line.hexByte(data[temp]);
+                line.put(' ');
+            }
+            line.put('\n');
+            line.appendTo(out);
+        }
+    });
+}
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+bool FrameFileIO::saveCanDumpFile(QString filename, const CANFrameStore * frames, QProgressDialog *progress)
+{
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, QByteArray(), [frames](int first, int count, QByteArray &out)
     {
-        delete inFile;
-        return false;
-    }
+        ExportLine line;
+        for (int c = first; c < first + count; c++)
+        {
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
 
-    try
-    {
-        while (!inFile->atEnd() && lineCounter < 100) {
-            lineCounter++;
+            line.clear();
+            line.put('(');
+            line.seconds(frame.timeStamp, 6, 17, '0');
+            line.put(") vcan0 ");
+            line.hex(frame.frameId, frame.extended ? 8 : 3);
+            line.put('#');
 
-            line = inFile->readLine().toUpper();
-            if (line.length() > 4 && !line.startsWith("S"))
+            if (frame.frameType == QCanBusFrame::RemoteRequestFrame)
             {
-                int ID = line.mid(0, 3).toInt(nullptr, 16);
-                if (ID > 0 && ID < 0x800)
-                {
-                    line.remove(0, 3);
-                    int len = line.length() / 2;
-                    if (len > -1 && len < 9) isMatch = true;
+                line.put('R');
+                line.dec(frame.length);
+            }
+            else
+            {
+                for (int temp = 0; temp < frame.length; temp++) line.hexByte(data[temp]);
+            }
+            line.put('\n');
+            line.appendTo(out);
+        }
+    });
+}
+
+int FrameFileIO::probeCanDumpFile(const FileSniff &sniff)
+{
+    //compiled once, matching with a const QRegularExpression is safe from any thread
+    static const QRegularExpression timeExp(QRegularExpression::anchoredPattern("^\\((\\S+)\\)$")); //anchored pattern causes exact match
+    static const QRegularExpression IdValExp(QRegularExpression::anchoredPattern("^([^#\\s]+)#(\\S+)$"));
+    static const QRegularExpression valExp("(\\S{2})");
+    bool ret;
+
+    for (int i = 0; i < 100 && i < sniff.lineCount(); i++)
+    {
+        QByteArray line = sniff.line(i).toUpper();
+        if (line.length() <= 1) continue;
+
+        /* tokenize */
+        QList<QByteArray> tokens = line.simplified().split(' ');
+        if (tokens.count() < 3) return PROBE_NO_MATCH;
+
+        /* timestamp */
+        QRegularExpressionMatch timeExpMatched = timeExp.match(tokens[0]);
+        if (!timeExpMatched.hasMatch()) return PROBE_NO_MATCH;
+        timeExpMatched.captured(1).toDouble(&ret);
+        if (!ret) return PROBE_NO_MATCH;
+
+        if (line.contains('[')) //the expanded format
+        {
+            //(1551774790.942758) can1 7A8 [8] F4 DC D1 83 0E 02 00 00
+            //     0               1     2   3  4 5  6  7  8  9  10 11
+            //(1551774790.942758) can1 7A8 [08] F4 DC D1 83 0E 02 00 00
+            if (tokens.count() < 4) return PROBE_NO_MATCH;
+            int ID = tokens[2].toULong(nullptr, 16);
+            if (ID > 0x1FFFFFFF || ID == 0) return PROBE_NO_MATCH;
+            const QByteArray &lenTok = tokens[3];
+            if (lenTok.size() < 3 || lenTok.size() > 4 || !lenTok.startsWith('[') || !lenTok.endsWith(']')) return PROBE_NO_MATCH;
+            int len = lenTok.mid(1, lenTok.size() - 2).toInt(&ret); //one or two digits, FD frames go up to 64
+            if (!ret || len < 0 || len > 64) return PROBE_NO_MATCH;
+        }
+        else  //the more concise format
+        {
+            /* ID & value */
+            QRegularExpressionMatch IdValExpMatched = IdValExp.match(tokens[2]);
+            if (!IdValExpMatched.hasMatch()) return PROBE_NO_MATCH;
+
+            QString val = IdValExpMatched.captured(2);
+            int maxLen = 8;
+            //ID##<flags><data> is a CAN-FD frame, skip the flags digit and allow up to 64 bytes
+            if (val.startsWith("#")) {
+                val.mid(1, 1).toInt(&ret, 16);
+                if (!ret) return PROBE_NO_MATCH;
+                val = val.mid(2);
+                maxLen = 64;
+            }
+            if (val.startsWith("R") && val.length() > 1 && val.at(1).isDigit()) {
+                int len = val.at(1).toLatin1() - '0';
+                if (len < 0 || len > 8) return PROBE_NO_MATCH;
+            } else {
+                /* val byte per byte */
+                int lng = 0;
+                QRegularExpressionMatchIterator it = valExp.globalMatch(val);
+                while (it.hasNext()) {
+                    QRegularExpressionMatch valExpMatch = it.next();
+                    lng++;
+                    if (lng > maxLen) return PROBE_NO_MATCH;
+                    valExpMatch.captured(1).toInt(&ret, 16);
+                    if (!ret) return PROBE_NO_MATCH;
                 }
             }
         }
     }
-    catch (...)
+    return PROBE_PATTERN;
+}
+
+bool FrameFileIO::isCanDumpFile(QString filename)
+{
+    return probeCanDumpFile(FileSniff(filename)) > 0;
+}
+
+static void parseCanDumpLine(const char *begin, const char *end, ChunkedTextLoader::Chunk &chunk)
+{
+    TextTokens tokens;
+    tokens.splitWhitespace(begin, end);
+    if (tokens.count() < 3) return;
+
+    /* timestamp */
+    const TextToken &timeTok = tokens[0];
+    if (timeTok.length() < 3 || timeTok.at(0) != '(' || !timeTok.endsWith(')')) return;
+    bool ret;
+    TextToken timeVal = {timeTok.begin + 1, timeTok.end - 1};
+    int64_t micros = timeVal.toMicroseconds(&ret);
+    if (!ret) return;
+
+    CANFrame thisFrame;
+    thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, micros));
+
+    //Sort out the bus. Search for where we have a bus number (skipping the can or vcan text)
+    int busNum = 0;
+    const TextToken &busTok = tokens[1];
+    for (const char *p = busTok.begin; p < busTok.end; p++)
     {
-        isMatch = false;
+        if (*p >= '0' && *p <= '9')
+        {
+            TextToken digits = {p, p};
+            while (digits.end < busTok.end && *digits.end >= '0' && *digits.end <= '9') digits.end++;
+            busNum = static_cast<int>(digits.toDecimal());
+            break;
+        }
     }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+    thisFrame.bus = busNum;
+
+    if (memchr(begin, '[', static_cast<size_t>(end - begin))) //the expanded format (second one from the above list)
+    {
+        //(1551774790.942758) can1 7A8 [8] F4 DC D1 83 0E 02 00 00
+        //(1551774790.942758) can1 7A8 [08] F4 DC D1 83 0E 02 00 00
+        //     0               1     2   3  4 5  6  7  8  9  10 11
+        thisFrame.setFrameId(static_cast<uint32_t>(tokens[2].toHex()));
+        thisFrame.setExtendedFrameFormat(thisFrame.frameId() > 0x7FF);
+        thisFrame.setFrameType(QCanBusFrame::DataFrame);
+        const TextToken &lenTok = tokens[3];
+        int numBytes;
+        if (lenTok.at(2) == ']') numBytes = lenTok.at(1) - '0';
+        else numBytes = ((lenTok.at(1) - '0') * 10) + (lenTok.at(2) - '0');
+        if (numBytes < 0 || numBytes > 64) return;
+        QByteArray bytes(numBytes, 0);
+        for (int c = 0; c < numBytes; c++) bytes[c] = static_cast<char>(tokens[4 + c].toHex());
+        thisFrame.setPayload(bytes);
+    }
+    else  //the more concise format (first one from list above)
+    {
+        /* ID & value */
+        const TextToken &idVal = tokens[2];
+        const char *hash = static_cast<const char *>(memchr(idVal.begin, '#', static_cast<size_t>(idVal.length())));
+        if (!hash || hash == idVal.begin) return;
+        TextToken idTok = {idVal.begin, hash};
+        TextToken val = {hash + 1, idVal.end};
+
+        /* ID */
+        thisFrame.setFrameId(static_cast<uint32_t>(idTok.toHex()));
+        thisFrame.setExtendedFrameFormat(idTok.length() > 3);
+
+        //ID##<flags><data> is how candump writes CAN-FD frames, the single hex digit carries BRS and ESI
+        if (val.at(0) == '#')
+        {
+            TextToken flagTok = {qMin(val.begin + 1, val.end), qMin(val.begin + 2, val.end)};
+            int flags = static_cast<int>(flagTok.toHex());
+            thisFrame.setFlexibleDataRateFormat(true);
+            thisFrame.setBitrateSwitch(flags & 1);
+            thisFrame.setErrorStateIndicator(flags & 2);
+            val.begin = qMin(val.begin + 2, val.end);
+        }
+
+        QByteArray bytes;
+        if ((val.at(0) == 'R' || val.at(0) == 'r') && val.at(1) >= '0' && val.at(1) <= '9')
+        {
+            thisFrame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        }
+        else
+        {
+            thisFrame.setFrameType(QCanBusFrame::DataFrame);
+            /* val byte per byte */
+            for (const char *p = val.begin; p + 1 < val.end; p += 2) bytes.append(static_cast<char>(TextToken{p, p + 2}.toHex()));
+        }
+        thisFrame.setPayload(bytes);
+    }
+
+    thisFrame.isReceived = true;
+    chunk.frames.append(thisFrame);
+}
+
+/*
+   (0.003800) vcan0 164#0000c01aa8000013
+                       or
+   (1551774790.942758) can1 7A8 [8] F4 DC D1 83 0E 02 00 00
+*/
+bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame>* frames)
+{
+    ChunkedTextLoader loader;
+    if (!loader.open(filename)) return false;
+    loader.parse(0, parseCanDumpLine);
+    loader.collect(frames);
+    return true;
+}
+
+static bool pageCanDumpFile(QString filename, CapturePager *pager)
+{
+    if (!pager->openText(filename)) return false;
+    pager->startIndexing(0, parseCanDumpLine);
+    return true;
+}
+
+int FrameFileIO::probeLawicelFile(const FileSniff &sniff)
+{
+    for (int i = 0; i < 100 && i < sniff.lineCount(); i++)
+    {
+        QByteArray line = sniff.line(i).toUpper();
+        if (line.length() > 4 && !line.startsWith("S"))
+        {
+            int ID = line.mid(0, 3).toInt(nullptr, 16);
+            if (ID > 0 && ID < 0x800)
+            {
+                int len = (line.length() - 3) / 2;
+                if (len > -1 && len < 9) return PROBE_WEAK;
+            }
+        }
+    }
+    return PROBE_NO_MATCH;
+}
+
+bool FrameFileIO::isLawicelFile(QString filename)
+{
+    return probeLawicelFile(FileSniff(filename)) > 0;
 }
 
 /*Example line:
@@ -3935,48 +3223,30 @@ bool FrameFileIO::loadLawicelFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::isKvaserFile(QString filename)
+int FrameFileIO::probeKvaserFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    int lineCounter = 0;
-    bool isMatch = true;
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-    try
-    {
-        line = inFile->readLine().simplified().toUpper();
-        if (!line.contains("CHN")) isMatch = false;
-        if (!line.contains("FLG")) isMatch = false;
-        if (!line.contains("D0")) isMatch = false;
-
-        if (inFile->atEnd()) isMatch = false;
+    QByteArray line = sniff.line(0).simplified().toUpper();
+    if (!line.contains("CHN")) return PROBE_NO_MATCH;
+    if (!line.contains("FLG")) return PROBE_NO_MATCH;
+    if (!line.contains("D0")) return PROBE_NO_MATCH;
 
-        while (!inFile->atEnd() && lineCounter < 10) {
-            lineCounter++;
+    if (sniff.lineCount() < 2) return PROBE_NO_MATCH;
 
-            line = inFile->readLine().toUpper();
-
-            if (line.length() > 70) {
-                //Chn Identifier Flg   DLC  D0...1...2...3...4...5...6..D7       Time     Dir
-                // 0    000000AD         8  FF  FF  00  00  00  00  00  00     154.266550 R
-                int len = line.mid(21, 3).simplified().toInt();
-                if (len > 8 || len < 0) isMatch = false;
-            }
-            else isMatch = false;
-        }
-    }
-    catch (...)
+    for (int i = 1; i <= 10 && i < sniff.lineCount(); i++)
     {
-        isMatch = false;
+        line = sniff.line(i).toUpper();
+        //Chn Identifier Flg   DLC  D0...1...2...3...4...5...6..D7       Time     Dir
+        // 0    000000AD         8  FF  FF  00  00  00  00  00  00     154.266550 R
+        if (line.length() <= 70) return PROBE_NO_MATCH;
+        int len = line.mid(21, 3).simplified().toInt();
+        if (len > 8 || len < 0) return PROBE_NO_MATCH;
     }
-    inFile->close();
-    delete inFile;
-    return isMatch;
+    return PROBE_HEADER;
+}
+
+bool FrameFileIO::isKvaserFile(QString filename)
+{
+    return probeKvaserFile(FileSniff(filename)) > 0;
 }
 
 //Chn Identifier Flg   DLC  D0...1...2...3...4...5...6..D7       Time     Dir
@@ -4041,48 +3311,29 @@ bool FrameFileIO::loadKvaserFile(QString filename, QVector<CANFrame> *frames, bo
     return !foundErrors;
 }
 
-bool FrameFileIO::isCabanaFile(QString filename)
+int FrameFileIO::probeCabanaFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray line;
-    int lineCounter = 0;
-    bool isMatch = true;
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-    try
-    {
-        line = inFile->readLine().toUpper(); //read out the header first and discard it.
-        if (!line.contains("TIME")) isMatch = false;
-        if (!line.contains("ADDR")) isMatch = false;
+    QByteArray line = sniff.line(0).toUpper(); //the header
+    if (!line.contains("TIME")) return PROBE_NO_MATCH;
+    if (!line.contains("ADDR")) return PROBE_NO_MATCH;
 
-        while (!inFile->atEnd() || lineCounter < 100) {
-            lineCounter++;
-
-            line = inFile->readLine().simplified();
-            if (line.length() > 2)
-            {
-                QList<QByteArray> tokens = line.split(',');
-                if (tokens.length() >= 3 && tokens.length() < 5)
-                {
-                    int ID = tokens[1].toInt();
-                    if (ID < 1 || ID > 0x1FFFFFFF) isMatch = false;
-                }
-                else isMatch = false;
-            }
-        }
-    }
-    catch (...)
+    for (int i = 1; i <= 100 && i < sniff.lineCount(); i++)
     {
-        isMatch = false;
+        line = sniff.line(i).simplified();
+        if (line.length() > 2)
+        {
+            QList<QByteArray> tokens = line.split(',');
+            if (tokens.length() < 3 || tokens.length() >= 5) return PROBE_NO_MATCH;
+            int ID = tokens[1].toInt();
+            if (ID < 1 || ID > 0x1FFFFFFF) return PROBE_NO_MATCH;
+        }
     }
+    return PROBE_HEADER;
+}
 
-    inFile->close();
-    delete inFile;
-    return isMatch;
+bool FrameFileIO::isCabanaFile(QString filename)
+{
+    return probeCabanaFile(FileSniff(filename)) > 0;
 }
 
 //Cabana uses a CSV file with four columns
@@ -4193,91 +3444,57 @@ bool FrameFileIO::loadCabanaFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::saveCabanaFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveCabanaFile(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
 {
-    QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
-
-    const unsigned char *data;
-    int dataLen;
-    const CANFrame *frame;
-
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-    
-    outFile->write("time,addr,bus,data");
-    outFile->write("\n");
-
-    for (int c = 0; c < frames->count(); c++)
+    FrameExporter exporter(frames, progress);
+    return exporter.run(filename, "time,addr,bus,data\n", [frames](int first, int count, QByteArray &out)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        frame = &frames->at(c);
-        data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        dataLen = frame->payload().count();
-
-        double tempTimeStamp = frame->timeStamp().microSeconds();
-        tempTimeStamp /= 1000000;
-
-        outFile->write(QString::number(tempTimeStamp, 'f').toUtf8());
-        outFile->write(".0");
-        outFile->putChar(44);
-
-        outFile->write(QString::number(frame->frameId(), 10).toUpper().toUtf8());
-        outFile->putChar(44);
-
-        outFile->write(QString::number(frame->bus).toUtf8());
-        outFile->putChar(44);
-
-        for (int temp = 0; temp < 8; temp++)
+        ExportLine line;
+        for (int c = first; c < first + count; c++)
         {
-            if (temp < dataLen)
-                outFile->write(QString::number(data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            else
-                outFile->write("00");
+            const PackedCANFrame &frame = frames->recordAt(c);
+            const uint8_t *data = frames->payloadAt(c);
+
+            line.clear();
+            line.seconds(frame.timeStamp, 6);
+            line.put(".0,");
+            line.decUnsigned(frame.frameId);
+            line.put(',');
+            line.dec(frame.bus);
+            line.put(',');
+
+            for (int temp = 0; temp < 8; temp++)
+            {
+                if (temp < frame.length) line.hexByte(data[temp]);
+                else line.put("00");
+            }
+            line.put('\n');
+            line.appendTo(out);
         }
-
-        outFile->write("\n");
-
-    }
-    outFile->close();
-    delete outFile;
-    return true;
+    });
 }
 
-bool FrameFileIO::isTeslaAPFile(QString filename)
+int FrameFileIO::probeTeslaAPFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    CANFrame thisFrame;
-    QByteArray data;
-    bool isValidFile = true;
-    TeslaAPCANRecord record;
-
-    if (!inFile->open(QIODevice::ReadOnly))
-    {
-        delete inFile;
-        return false;
-    }
+    //nothing identifies these files, all there is to go on is whether every record looks sane
+    int numRecords = sniff.start().length() / static_cast<int>(sizeof(TeslaAPCANRecord));
+    if (numRecords == 0) return PROBE_NO_MATCH;
 
-    while (!inFile->atEnd())
+    const char *data = sniff.start().constData();
+    for (int i = 0; i < numRecords; i++)
     {
-        inFile->read((char *)&record, sizeof(TeslaAPCANRecord));
-        if (record.id > 0x7FF) isValidFile = false;
-        if ((record.ctr >> 4) > 8) isValidFile = false;
-        if ((record.ctr & 0xF) > 6) isValidFile = false;
+        TeslaAPCANRecord record;
+        memcpy(&record, data + (i * sizeof(TeslaAPCANRecord)), sizeof(TeslaAPCANRecord));
+        if (record.id > 0x7FF) return PROBE_NO_MATCH;
+        if ((record.ctr >> 4) > 8) return PROBE_NO_MATCH;
+        if ((record.ctr & 0xF) > 6) return PROBE_NO_MATCH;
     }
+    return PROBE_WEAK;
+}
 
-    inFile->close();
-    delete inFile;
-    return isValidFile;
+bool FrameFileIO::isTeslaAPFile(QString filename)
+{
+    return probeTeslaAPFile(FileSniff(filename)) > 0;
 }
 
 bool FrameFileIO::loadTeslaAPFile(QString filename, QVector<CANFrame>* frames)
@@ -4334,117 +3551,55 @@ bool FrameFileIO::loadTeslaAPFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::isCLX000File(QString filename) {
-    std::unique_ptr<QFile> inFile = std::unique_ptr<QFile>(new QFile(filename));
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        qDebug() << "Could not open the file!";
-        return false;
-    }
-
-    QTextStream fileStream(inFile.get());
-    //bool foundErrors = false;
+int FrameFileIO::probeCLX000File(const FileSniff &sniff)
+{
+    static const QString validSeparators(" -~");
+    static const QRegularExpression valueSeparatorRegEx("# Value separator: \"(?<valueSeparator>[" + validSeparators + "])\"");
+    static const QRegularExpression timeFormatRegEx("# Time format: (?<timeFormat>\\d)");
+    static const QRegularExpression timeSeparatorRegEx("# Time separator: \"(?<timeSeparator>[" + validSeparators + "]?)\"");
+    static const QRegularExpression timeSeparatorMsRegEx("# Time separator ms: \"(?<timeSeparatorMs>[" + validSeparators + "]?)\"");
+    static const QRegularExpression dateSeparatorRegEx("# Date separator: \"(?<dateSeparator>[" + validSeparators + "]?)\"");
+    static const QRegularExpression timeDateSeparatorRegEx("# Time and date separator: \"(?<timeDateSeparator>[" + validSeparators + "]?)\"");
 
     // Contains 16 lines of header prior to (potential) data.
-    QString headerLine;
-    headerLine = fileStream.readLine();
-    if(!headerLine.startsWith("# Logger type: ")) {
-        qDebug() << "Not the correct first header line:" << headerLine;
-        return false;
-    }
-
-    // Skip to next usable field.
-    fileStream.readLine();
-    fileStream.readLine();
-    fileStream.readLine();
-    fileStream.readLine();
-    fileStream.readLine();
+    if (!sniff.line(0).startsWith("# Logger type: ")) return PROBE_NO_MATCH;
 
-    // Extract base time.
-    headerLine = fileStream.readLine();
-    if(!headerLine.startsWith("# Time: ")) {
+    // Extract base time, the lines before it aren't needed.
+    QString headerLine = sniff.text(6);
+    if (!headerLine.startsWith("# Time: ")) {
         qDebug() << "Not the correct start time:" << headerLine;
-        return false;
+        return PROBE_NO_MATCH;
     }
     headerLine = headerLine.right(15);
 
     QDateTime startDate = QDateTime::fromString(headerLine, "yyyyMMddThhmmss");
-    if(!startDate.isValid()) {
+    if (!startDate.isValid()) {
         qDebug() << "Could not parse " << headerLine << "using \"yyyyMMddThhmmss\" as format string";
-        return false;
+        return PROBE_NO_MATCH;
     }
 
-    QString const validSeparators(" -~");
-
     // Decode separators and format for later decoding.
-    headerLine = fileStream.readLine();
-    QString const valueSeparatorPattern = "# Value separator: \"(?<valueSeparator>[" + validSeparators + "])\"";
-    QRegularExpression valueSeparatorRegEx(valueSeparatorPattern);
+    headerLine = sniff.text(7);
     auto matchValueSeparator = valueSeparatorRegEx.match(headerLine);
-    if(!matchValueSeparator.hasMatch()) {
-        qDebug() << "Could not decode value separator" << headerLine << "using pattern" << valueSeparatorPattern;
-        return false;
+    if (!matchValueSeparator.hasMatch()) {
+        qDebug() << "Could not decode value separator" << headerLine << "using pattern" << valueSeparatorRegEx.pattern();
+        return PROBE_NO_MATCH;
     }
     QChar valueSeparator = matchValueSeparator.captured("valueSeparator").front();
 
-    headerLine = fileStream.readLine();
-    QString const timeFormatPattern = "# Time format: (?<timeFormat>\\d)";
-    QRegularExpression timeFormatRegEx(timeFormatPattern);
-    auto matchTimeFormat = timeFormatRegEx.match(headerLine);
-    if(!matchTimeFormat.hasMatch()) {
-        qDebug() << "Could not decode time format" << headerLine << "using pattern" << timeFormatPattern;
-        return false;
-    }
-    //auto timeFormat = matchTimeFormat.captured("timeFormat").front().digitValue();
-
-    headerLine = fileStream.readLine();
-    QString const timeSeparatorPattern = "# Time separator: \"(?<timeSeparator>[" + validSeparators + "]?)\"";
-    QRegularExpression timeSeparatorRegEx(timeSeparatorPattern);
-    auto matchTimeSeparator = timeSeparatorRegEx.match(headerLine);
-    if( !matchTimeSeparator.hasMatch()) {
-        qDebug() << "Could not decode time format" << headerLine << "using pattern" << timeSeparatorPattern;
-        return false;
-    }
-    //QChar timeSeparator = matchTimeSeparator.captured("timeSeparator").front();
-
-    headerLine = fileStream.readLine();
-    QString const timeSeparatorMsPattern = "# Time separator ms: \"(?<timeSeparatorMs>[" + validSeparators + "]?)\"";
-    QRegularExpression timeSeparatorMsRegEx(timeSeparatorMsPattern);
-    auto matchTimeSeparatorMs = timeSeparatorMsRegEx.match(headerLine);
-    if( !matchTimeSeparatorMs.hasMatch()) {
-        qDebug() << "Could not decode time format ms" << headerLine << "using pattern" << timeSeparatorMsPattern;
-        return false;
-    }
-    //QChar timeSeparatorMs = matchTimeSeparatorMs.captured("timeSeparatorMs").front();
-
-    headerLine = fileStream.readLine();
-    QString const dateSeparatorPattern = "# Date separator: \"(?<dateSeparator>[" + validSeparators + "]?)\"";
-    QRegularExpression dateSeparatorRegEx(dateSeparatorPattern);
-    auto matchDateSeparator = dateSeparatorRegEx.match(headerLine);
-    if( !matchDateSeparator.hasMatch()) {
-        qDebug() << "Could not decode time format ms" << headerLine << "using pattern" << dateSeparatorPattern;
-        return false;
-    }
-    //QChar dateSeparator = matchDateSeparator.captured("dateSeparator").front();
-
-    headerLine = fileStream.readLine();
-    QString const timeDateSeparatorPattern = "# Time and date separator: \"(?<timeDateSeparator>[" + validSeparators + "]?)\"";
-    QRegularExpression timeDateSeparatorRegEx(timeDateSeparatorPattern);
-    auto matchTimeDateSeparator = timeDateSeparatorRegEx.match(headerLine);
-    if( !matchTimeDateSeparator.hasMatch()) {
-        qDebug() << "Could not decode time format ms" << headerLine << "using pattern" << timeDateSeparatorPattern;
-        return false;
+    const QRegularExpression *const formatLines[] = {&timeFormatRegEx, &timeSeparatorRegEx, &timeSeparatorMsRegEx,
+                                                     &dateSeparatorRegEx, &timeDateSeparatorRegEx};
+    for (int i = 0; i < 5; i++)
+    {
+        headerLine = sniff.text(8 + i);
+        if (!formatLines[i]->match(headerLine).hasMatch()) {
+            qDebug() << "Could not decode time format" << headerLine << "using pattern" << formatLines[i]->pattern();
+            return PROBE_NO_MATCH;
+        }
     }
-    //QChar timeDateSeparator = matchTimeDateSeparator.captured("timeDateSeparator").front();
-
-    // Skip remaining header lines.
-    fileStream.readLine();
-    fileStream.readLine();
-    fileStream.readLine();
 
-    // Decode which fields are present.
-    headerLine = fileStream.readLine();
+    // Skip remaining header lines then decode which fields are present.
+    headerLine = sniff.text(16);
     auto const presentFields = headerLine.split(valueSeparator);
     QStringList const validStrings = {"Timestamp", "Type", "ID", "Length", "Data"};
 
@@ -4453,10 +3608,15 @@ bool FrameFileIO::isCLX000File(QString filename) {
         presentFields.cend(),
         [&validStrings](QString const& entry){return validStrings.contains(entry);})
         ) {
-        return false;
+        return PROBE_NO_MATCH;
     }
 
-    return true;
+    return PROBE_HEADER;
+}
+
+bool FrameFileIO::isCLX000File(QString filename)
+{
+    return probeCLX000File(FileSniff(filename)) > 0;
 }
 
 bool FrameFileIO::loadCLX000File(QString filename, QVector<CANFrame>* frames) {
@@ -4780,42 +3940,17 @@ bool FrameFileIO::loadCLX000File(QString filename, QVector<CANFrame>* frames) {
     return !foundErrors;
 }
 
-bool FrameFileIO::isCANServerFile(QString filename)
+int FrameFileIO::probeCANServerFile(const FileSniff &sniff)
 {
-    QFile *inFile = new QFile(filename);
-    QByteArray headerData;
-    bool isMatch = false;
-
-    if (!inFile->open(QIODevice::ReadOnly))
-    {
-        delete inFile;
-        return false;
-    }
-    try
-    {
-        //Read the first 20 bytes from the file to check for the matching signature
-        headerData = inFile->read(22);
-
-        //qDebug() << "header.length: " << headerData.length();
-
-        if (headerData.length() == 22)
-        {
-            //qDebug() << "header: " << headerData;
-            //We have enough bytes to make up our header.  Lets check if it matches
-            if (headerData == "CANSERVER_v2_CANSERVER" || headerData == "CANSERVER_v3_CANSERVER")
-            {
-                isMatch = true;
-            }
-        }
-    }
-    catch (...)
-    {
-        isMatch = false;
-    }
+    //the first 22 bytes of the file are the signature
+    QByteArray headerData = sniff.start().left(22);
+    if (headerData == "CANSERVER_v2_CANSERVER" || headerData == "CANSERVER_v3_CANSERVER") return PROBE_SIGNATURE;
+    return PROBE_NO_MATCH;
+}
 
-    inFile->close();
-    delete inFile;
-    return isMatch;
+bool FrameFileIO::isCANServerFile(QString filename)
+{
+    return probeCANServerFile(FileSniff(filename)) > 0;
 }
 
 bool FrameFileIO::loadCANServerFile(QString filename, QVector<CANFrame>* frames)
@@ -5014,182 +4149,197 @@ bool FrameFileIO::loadCANServerFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::loadWiresharkFile(QString filename, QVector<CANFrame>* frames)
+//walking the blocks is cheap, building the frames is not. Packets are collected first and turned
+//into frames on all cores. Time stamps come out relative to the first packet
+template<typename PacketDecoder>
+static void decodePcapPackets(const QVector<pcap_packet> &packets, QVector<CANFrame> *frames, PacketDecoder decode)
 {
-    pcap_t *pcap_data_file;
-    CANFrame thisFrame;
-    long long startTimestamp = 0;
-    long long timeStamp;
-    int lineCounter = 0;
-    bool foundErrors = false;
-    pcap_pkthdr    packetHeader;
-	const char     *packetData = NULL;
-	char errbuf[PCAP_ERRBUF_SIZE];
-
-    thisFrame.setFrameType(QCanBusFrame::DataFrame);
-    
-    QByteArray ba = filename.toLocal8Bit();
+    if (packets.isEmpty()) return;
+    const int chunkSize = 16384;
+    long long startTimestamp = packets.first().timestamp;
+    int first = frames->count();
+    frames->resize(first + packets.count());
+    CANFrame *out = frames->data() + first;
+
+    QVector<int> chunks;
+    for (int i = 0; i < packets.count(); i += chunkSize) chunks.append(i);
+    QtConcurrent::blockingMap(chunks, [&packets, out, startTimestamp, chunkSize, decode](int begin)
+    {
+        int end = qMin(begin + chunkSize, packets.count());
+        for (int i = begin; i < end; i++) decode(packets.at(i), startTimestamp, out[i]);
+    });
+}
 
-    pcap_data_file = pcap_open_offline(ba.data(), errbuf, PCAP_LINKTYPE_ANY);
-	if (!pcap_data_file) {
-		return false;
-	}
+//SocketCAN frame behind a 16 byte Linux cooked capture header, can_id in host (little endian) order
+static void decodeCookedCANPacket(const pcap_packet &packet, long long startTimestamp, CANFrame &frame)
+{
+    const unsigned char *data = packet.data;
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, (packet.timestamp - startTimestamp) / 1000));
+    frame.isReceived = true; // TODO: check if tx detection is possible
+    frame.setFrameType(QCanBusFrame::DataFrame);
+    if (0x80 & data[19]) {
+        frame.setExtendedFrameFormat(true);
+        frame.setFrameId((0x3f & data[19]) << 24 | data[18] << 16 | data[17] << 8 | data[16]);
+    } else {
+        frame.setExtendedFrameFormat(false);
+        frame.setFrameId(data[17] << 8 | data[16]);
+    }
+    frame.bus = packet.interface_id;
+    int numBytes = qMin(qMin(static_cast<int>(data[20]), 8), static_cast<int>(packet.caplen) - 24);
+    frame.setPayload(QByteArray(reinterpret_cast<const char *>(data + 24), qMax(numBytes, 0)));
+}
 
-    packetData = (const char*)pcap_next(pcap_data_file, &packetHeader);
+#define SOCKETCAN_FD_BRS 0x01
+#define SOCKETCAN_FD_ESI 0x02
+#define SOCKETCAN_FD_FDF 0x04
+#define SOCKETCAN_MTU    16
+#define SOCKETCAN_FD_MTU 72
 
-    while (packetData) {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-        
-        timeStamp = packetHeader.ts.tv_sec * 1000000 + packetHeader.ts.tv_usec;
-        if (0 == startTimestamp) 
-        {
-            startTimestamp = timeStamp;
-        }
+//link type 227: can_id in network byte order, length, FD flags, two reserved bytes, then the data
+static void decodeSocketCANPacket(const pcap_packet &packet, long long startTimestamp, CANFrame &frame)
+{
+    const unsigned char *data = packet.data;
+    frame.bus = packet.interface_id;
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, (packet.timestamp - startTimestamp) / 1000));
+
+    // ID and extended frame format
+    const quint32 can_id = qFromBigEndian<quint32>(data);
+    if (can_id & 0x80000000) {
+        frame.setExtendedFrameFormat(true);
+        frame.setFrameId(0x1fffffff & can_id);
+    } else {
+        frame.setExtendedFrameFormat(false);
+        frame.setFrameId(0x7ff & can_id);
+    }
+
+    // Frame type
+    if (can_id & 0x20000000U) {
+        frame.setFrameType(QCanBusFrame::ErrorFrame);
+    } else if (can_id & 0x40000000U) {
+        frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+    } else {
+        frame.setFrameType(QCanBusFrame::DataFrame);
+    }
+
+    // Direction - This isn't actually officially supported, but CAN Bus Debugger device logs set this byte to 1 to indicate a TX frame and 0 for RX
+    frame.isReceived = (data[6] != 1);
+
+    // CAN-FD is flagged in the header by newer captures, older ones only tell by the packet size
+    quint8 fdFlags = data[5];
+    bool fd = (fdFlags & SOCKETCAN_FD_FDF) || packet.caplen == SOCKETCAN_FD_MTU;
+    frame.setFlexibleDataRateFormat(fd);
+    frame.setBitrateSwitch(fd && (fdFlags & SOCKETCAN_FD_BRS));
+    frame.setErrorStateIndicator(fd && (fdFlags & SOCKETCAN_FD_ESI));
+
+    // Data
+    int numBytes = qMin(static_cast<int>(data[4]), fd ? 64 : 8);
+    numBytes = qMax(qMin(numBytes, static_cast<int>(packet.caplen) - 8), 0);
+    frame.setPayload(QByteArray(reinterpret_cast<const char *>(data + 8), numBytes));
+}
 
-        timeStamp -= startTimestamp;
+bool FrameFileIO::loadWiresharkFile(QString filename, QVector<CANFrame>* frames)
+{
+    PcapReader reader;
+    if (!reader.open(filename)) return false;
 
-        thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, timeStamp));
-        thisFrame.isReceived = true; // TODO: check if tx detection is possible
-            
-        thisFrame.setFrameType(QCanBusFrame::DataFrame);
-        if ((0x80 & *(packetData+19)))  {
-            thisFrame.setExtendedFrameFormat(true);
-            thisFrame.setFrameId((0x3f & *(packetData+19))<<24 | (0xff & *(packetData+18)) << 16 | (0xff & *(packetData+17)) << 8 | (0xff & *(packetData+16)));
-        } else {
-            thisFrame.setExtendedFrameFormat(false);
-            thisFrame.setFrameId((0xff & *(packetData+17)) << 8 | (0xff & *(packetData+16)));
-        }
-        thisFrame.bus = 0;
-        int numBytes = *(packetData+20);
-        QByteArray bytes(numBytes, 0);
-        if (thisFrame.payload().length() > 8) thisFrame.payload().resize(8);
-        for (int d = 0; d < numBytes; d++) 
-        { 
-            bytes[d] = *(packetData + 24 + d);
+    QVector<pcap_packet> packets;
+    pcap_packet packet;
+    bool foundErrors = false;
+    while (reader.next(packet))
+    {
+        if (packet.caplen < 24)
+        {
+            foundErrors = true;
+            continue;
         }
-        thisFrame.setPayload(bytes);
-        frames->append(thisFrame);
-
-        packetData = (const char*)pcap_next(pcap_data_file, &packetHeader);
+        packets.append(packet);
     }
-
-    pcap_close(pcap_data_file);
-	pcap_data_file = NULL;
-    
+    decodePcapPackets(packets, frames, decodeCookedCANPacket);
     return !foundErrors;
 }
 
-bool FrameFileIO::isWiresharkFile(QString filename)
+int FrameFileIO::probeWiresharkFile(const FileSniff &sniff)
 {
-    pcap_t *pcap_data_file;
-    char errbuf[PCAP_ERRBUF_SIZE];
-    QByteArray ba = filename.toLocal8Bit();
-
-    pcap_data_file = pcap_open_offline(ba.data(), errbuf, PCAP_LINKTYPE_ANY);
-	if (!pcap_data_file) {
-		return false;
-	}
-
-    pcap_close(pcap_data_file);
-	pcap_data_file = NULL;
+    PcapReader reader;
+    return reader.open(sniff.start()) ? PROBE_SIGNATURE : PROBE_NO_MATCH;
+}
 
-    return true;
+bool FrameFileIO::isWiresharkFile(QString filename)
+{
+    return probeWiresharkFile(FileSniff(filename)) > 0;
 }
 
 bool FrameFileIO::loadWiresharkSocketCANFile(QString filename, QVector<CANFrame>* frames)
 {
-    pcap_t *pcap_data_file;
-    CANFrame thisFrame;
-    long long startTimestamp = 0;
-    long long timeStamp;
-    int lineCounter = 0;
-    bool foundErrors = false;
-    pcap_pkthdr packetHeader;
-    const char *packetData = NULL;
-    char errbuf[PCAP_ERRBUF_SIZE];
-
-    QByteArray ba = filename.toLocal8Bit();
-
-    pcap_data_file = pcap_open_offline(ba.data(), errbuf, PCAP_LINKTYPE_SOCKETCAN);
-    if (!pcap_data_file) {
-        return false;
-    }
-
-    packetData = (const char*)pcap_next(pcap_data_file, &packetHeader);
-    while (packetData) {
-        lineCounter++;
-        if (lineCounter > 100) {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-        thisFrame.bus = 0;
-
-        // Timestamp
-        timeStamp = packetHeader.ts.tv_sec * 1000000 + packetHeader.ts.tv_usec;
-        if (0 == startTimestamp) {
-            startTimestamp = timeStamp;
-        }
-        timeStamp -= startTimestamp;
-        thisFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, timeStamp));
-
-        // ID and extended frame format
-        const quint32 can_id = qFromBigEndian<quint32>(packetData);
-        if (can_id & 0x80000000) {
-            thisFrame.setExtendedFrameFormat(true);
-                thisFrame.setFrameId(0x1fffffff & can_id);
-        } else {
-            thisFrame.setExtendedFrameFormat(false);
-            thisFrame.setFrameId(0x7ff & can_id);
-        }
-
-        // Frame type
-        if (can_id & 0x20000000U) {
-            thisFrame.setFrameType(QCanBusFrame::ErrorFrame);
-        } else if (can_id & 0x40000000U) {
-            thisFrame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-        } else {
-            thisFrame.setFrameType(QCanBusFrame::DataFrame);
-        }
+    PcapReader reader;
+    if (!reader.open(filename) || reader.linkType() != PCAP_LINKTYPE_SOCKETCAN) return false;
 
-        // Direction - This isn't actually officially supported, but CAN Bus Debugger device logs set this byte to 1 to indicate a TX frame and 0 for RX
-        quint8 direction = (quint8) *(packetData + 6);
-        thisFrame.isReceived = (direction != 1);
-
-        // Data
-        quint8 numBytes = (quint8) *(packetData + 4);
-        if (numBytes > 8) {
-            numBytes = 8;
-        }
-        QByteArray bytes(numBytes, 0);
-        for (int d = 0; d < numBytes; d++) {
-            bytes[d] = *(packetData + 8 + d);
+    //every interface in the file becomes a bus. Interfaces that aren't SocketCAN are skipped
+    QVector<pcap_packet> packets;
+    pcap_packet packet;
+    bool foundErrors = false;
+    while (reader.next(packet))
+    {
+        if (packet.link_type != PCAP_LINKTYPE_SOCKETCAN) continue;
+        if (packet.caplen < 8)
+        {
+            foundErrors = true;
+            continue;
         }
-        thisFrame.setPayload(bytes);
-        frames->append(thisFrame);
-
-        packetData = (const char*) pcap_next(pcap_data_file, &packetHeader);
+        packets.append(packet);
     }
-    pcap_close(pcap_data_file);
-    pcap_data_file = NULL;
+    decodePcapPackets(packets, frames, decodeSocketCANPacket);
     return !foundErrors;
 }
 
+int FrameFileIO::probeWiresharkSocketCANFile(const FileSniff &sniff)
+{
+    PcapReader reader;
+    return (reader.open(sniff.start()) && reader.linkType() == PCAP_LINKTYPE_SOCKETCAN) ? PROBE_SIGNATURE : PROBE_NO_MATCH;
+}
+
 bool FrameFileIO::isWiresharkSocketCANFile(QString filename)
 {
-    pcap_t *pcap_data_file;
-    char errbuf[PCAP_ERRBUF_SIZE];
-    QByteArray ba = filename.toLocal8Bit();
+    return probeWiresharkSocketCANFile(FileSniff(filename)) > 0;
+}
 
-    pcap_data_file = pcap_open_offline(ba.data(), errbuf, PCAP_LINKTYPE_SOCKETCAN);
-    if (!pcap_data_file) {
-        return false;
-    }
-    pcap_close(pcap_data_file);
-    pcap_data_file = NULL;
-    return true;
+//pcapng with one SocketCAN interface per bus, readable by Wireshark and by the loader above
+bool FrameFileIO::saveWiresharkFile(QString filename, const CANFrameStore* frames, QProgressDialog *progress)
+{
+    //the loader takes the interface number as the bus so there is an interface for every bus number up
+    //to the highest one used, whether or not a bus has frames. Writing them all up front puts the
+    //interface blocks in the header and leaves nothing for the packet batches to share
+    QByteArray header;
+    PcapNgWriter::appendSectionHeader(header);
+    int maxBus = 0;
+    for (int i = 0; i < frames->count(); i++) maxBus = qMax(maxBus, frames->busAt(i));
+    for (int bus = 0; bus <= maxBus; bus++)
+        PcapNgWriter::appendInterfaceBlock(header, PCAP_LINKTYPE_SOCKETCAN, QString("can%1").arg(bus), SOCKETCAN_FD_MTU);
+
+    FrameExporter exporter(frames, progress);
+    exporter.setOpenMode(QIODevice::WriteOnly);
+    return exporter.run(filename, header, [frames](int first, int count, QByteArray &out)
+    {
+        unsigned char packet[SOCKETCAN_FD_MTU];
+        for (int i = first; i < first + count; i++)
+        {
+            const PackedCANFrame &rec = frames->recordAt(i);
+            int len = rec.length;
+            bool fd = rec.fd || len > 8;
+            int packetLen = fd ? SOCKETCAN_FD_MTU : SOCKETCAN_MTU;
+            memset(packet, 0, static_cast<size_t>(packetLen));
+
+            quint32 canId = rec.frameId;
+            if (rec.extended) canId |= 0x80000000U;
+            if (rec.frameType == QCanBusFrame::RemoteRequestFrame) canId |= 0x40000000U;
+            if (rec.frameType == QCanBusFrame::ErrorFrame) canId |= 0x20000000U;
+            qToBigEndian(canId, packet);
+            packet[4] = static_cast<unsigned char>(len);
+            if (fd) packet[5] = SOCKETCAN_FD_FDF | (rec.brs ? SOCKETCAN_FD_BRS : 0) | (rec.esi ? SOCKETCAN_FD_ESI : 0);
+            packet[6] = rec.received ? 0 : 1; //the direction byte the loader understands
+            memcpy(packet + 8, frames->payloadAt(i), static_cast<size_t>(len));
+
+            PcapNgWriter::appendPacketBlock(out, rec.bus, rec.timeStamp, packet, static_cast<unsigned int>(packetLen));
+        }
+    });
 }
@@ -13,24 +13,58 @@
 #include <QStringList>
 #include <QFileDialog>
 #include "can_structs.h"
+#include "canframestore.h"
 #include "utility.h"
 
+class CapturePager;
+class ContinuousLogWriter;
+class FileSniff;
+class QProgressDialog;
+
+//what the last autoDetectLoadFile found and how long each step took
+struct AutoDetectStats
+{
+    QString format;   //empty if nothing could load the file
+    int score;
+    int formatsTried; //loaders run, including ones that failed
+    qint64 sniffMicros;
+    qint64 probeMicros;
+    qint64 loadMicros;
+    qint64 totalMicros; //from opening the file to having the frames
+};
+
 class FrameFileIO: public QObject
 {
     Q_OBJECT
 
 public:
+    //how sure a probe is about a file. The loader of the best scoring format gets the first try,
+    //ties are broken by the order autoDetectLoadFile lists the formats in
+    enum ProbeScore
+    {
+        PROBE_NO_MATCH = 0,
+        PROBE_WEAK = 10,      //nothing in the file identifies the format, it just doesn't contradict it
+        PROBE_PATTERN = 40,   //the lines look like the format
+        PROBE_HEADER = 70,    //a header specific to the format
+        PROBE_SIGNATURE = 100 //a magic number
+    };
+
     FrameFileIO();
 
     //these present a GUI to the user and allow them to pick the file to load/save
     //The QString returns the filename that was selected and so is really a sort of return value
     //The QVector is used as either the target for loading or the source for saving.
     //These routines call the below loading/saving functions so no need to use them directly if you don't want.
-    static bool loadFrameFile(QString &, QVector<CANFrame>*);
-    static bool saveFrameFile(QString &, const QVector<CANFrame>*);
+    //With pagedFile given, a file bigger than the Main/HugeFileMB setting (0, the default, is never) in a
+    //format that can be paged comes back as a CapturePager instead of being loaded. The caller owns it
+    static bool loadFrameFile(QString &, QVector<CANFrame>*, CapturePager **pagedFile = nullptr);
+    static bool saveFrameFile(QString &, const CANFrameStore*);
 
     //These do the actual loading and saving and can be used directly if you'd prefer
     static bool autoDetectLoadFile(QString, QVector<CANFrame>*);
+    static const AutoDetectStats &lastAutoDetect() { return autoDetectStats; }
+    static bool isHugeFile(QString filename);
+    static CapturePager *openPagedFile(QString filename); //null if the file's format can't be paged
     static bool loadCRTDFile(QString, QVector<CANFrame>*);
     static bool loadNativeCSVFile(QString, QVector<CANFrame>*);
     static bool loadGenericCSVFile(QString, QVector<CANFrame>*);
@@ -55,6 +89,7 @@ public:
     static bool loadCANServerFile(QString filename, QVector<CANFrame>* frames);
     static bool loadWiresharkFile(QString filename, QVector<CANFrame>* frames);
     static bool loadWiresharkSocketCANFile(QString filename, QVector<CANFrame>* frames);
+    static bool loadNativeBinaryFile(QString filename, QVector<CANFrame>* frames);
 
     //functions that pre-scan a file to try to figure out if they could read it. Used to automatically determine
     //file type and load it.
@@ -82,28 +117,67 @@ public:
     static bool isCANServerFile(QString filename);
     static bool isWiresharkFile(QString filename);
     static bool isWiresharkSocketCANFile(QString filename);
+    static bool isNativeBinaryFile(QString filename);
+
+    //The checks behind the is functions. Each one scores how well the start of a file fits its
+    //format, PROBE_NO_MATCH if it doesn't at all. They only look at the FileSniff they're given so
+    //autoDetectLoadFile reads the file once and runs them all at the same time.
+    static int probeCRTDFile(const FileSniff &);
+    static int probeNativeCSVFile(const FileSniff &);
+    static int probeGenericCSVFile(const FileSniff &);
+    static int probeLogFile(const FileSniff &);
+    static int probeMicrochipFile(const FileSniff &);
+    static int probeTraceFile(const FileSniff &);
+    static int probeIXXATFile(const FileSniff &);
+    static int probeCANDOFile(const FileSniff &);
+    static int probeVehicleSpyFile(const FileSniff &);
+    static int probeCanDumpFile(const FileSniff &);
+    static int probeLawicelFile(const FileSniff &);
+    static int probePCANFile(const FileSniff &);
+    static int probeKvaserFile(const FileSniff &);
+    static int probeCanalyzerASC(const FileSniff &);
+    static int probeCanalyzerBLF(const FileSniff &);
+    static int probeCARBUSAnalyzerFile(const FileSniff &);
+    static int probeCANHackerFile(const FileSniff &);
+    static int probeCabanaFile(const FileSniff &);
+    static int probeCANOpenFile(const FileSniff &);
+    static int probeTeslaAPFile(const FileSniff &);
+    static int probeCLX000File(const FileSniff &);
+    static int probeCANServerFile(const FileSniff &);
+    static int probeWiresharkFile(const FileSniff &);
+    static int probeWiresharkSocketCANFile(const FileSniff &);
+    static int probeNativeBinaryFile(const FileSniff &);
+
+    //the savers format through FrameExporter. Given a progress dialog they keep it up to date and
+    //stop, removing the partial file, if it gets canceled
+    static bool saveCRTDFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveNativeCSVFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveGenericCSVFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveLogFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveMicrochipFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveTraceFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveIXXATFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveCANDOFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveVehicleSpyFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveCanDumpFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveCabanaFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveCanalyzerASC(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveCARBUSAnalzyer(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveNativeBinaryFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool saveWiresharkFile(QString filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
 
-    static bool saveCRTDFile(QString, const QVector<CANFrame>*);
-    static bool saveNativeCSVFile(QString, const QVector<CANFrame>*);
-    static bool saveGenericCSVFile(QString, const QVector<CANFrame>*);
-    static bool saveLogFile(QString, const QVector<CANFrame>*);
-    static bool saveMicrochipFile(QString, const QVector<CANFrame>*);
-    static bool saveTraceFile(QString, const QVector<CANFrame>*);
-    static bool saveIXXATFile(QString, const QVector<CANFrame>*);
-    static bool saveCANDOFile(QString, const QVector<CANFrame>*);
-    static bool saveVehicleSpyFile(QString, const QVector<CANFrame>*);
-    static bool saveCanDumpFile(QString filename, const QVector<CANFrame> * frames);
-    static bool saveCabanaFile(QString filename, const QVector<CANFrame>* frames);
-    static bool saveCanalyzerASC(QString filename, const QVector<CANFrame>* frames);
-    static bool saveCARBUSAnalzyer(QString filename, const QVector<CANFrame>* frames);
+    //the GVRET native CSV encoding on its own, for writers that produce the frames a block at a time
+    static const char nativeCSVHeader[];
+    static void formatNativeCSV(const CANFrameStore *frames, int first, int count, QByteArray &out);
 
     static bool openContinuousNative();
     static bool closeContinuousNative();
-    static bool writeContinuousNative(const QVector<CANFrame>*, int);
-    static bool flushContinuousNative();
+    static bool writeContinuousNative(const QVector<CANFrame> &frames); //only queues, the writer thread does the rest
+    static const ContinuousLogWriter *continuousLog() { return continuousWriter; } //null while not logging
 
 private:
-    static QFile continuousFile;
+    static ContinuousLogWriter *continuousWriter;
+    static AutoDetectStats autoDetectStats;
 };
 
 #endif // FRAMEFILEIO_H
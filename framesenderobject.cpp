@@ -1,7 +1,7 @@
 #include "framesenderobject.h"
 #include "mainwindow.h"
 
-FrameSenderObject::FrameSenderObject(const QVector<CANFrame> *frames)
+FrameSenderObject::FrameSenderObject(const CANFrameStore *frames)
 {
     mThread_p = new QThread();
 
@@ -219,19 +219,17 @@ void FrameSenderObject::timerTriggered()
 
 void FrameSenderObject::buildFrameCache()
 {
-    CANFrame thisFrame;
-    frameCache.clear();
+    //find the newest frame for each ID first so only those get unpacked
+    QHash<int, int> lastIndex;
     for (int i = 0; i < modelFrames->count(); i++)
     {
-        thisFrame = modelFrames->at(i);
-        if (!frameCache.contains(thisFrame.frameId()))
-        {
-            frameCache.insert(thisFrame.frameId(), thisFrame);
-        }
-        else
-        {
-            frameCache[thisFrame.frameId()] = thisFrame;
-        }
+        lastIndex[static_cast<int>(modelFrames->frameIdAt(i))] = i;
+    }
+
+    frameCache.clear();
+    for (QHash<int, int>::const_iterator it = lastIndex.constBegin(); it != lastIndex.constEnd(); ++it)
+    {
+        frameCache.insert(it.key(), modelFrames->at(it.value()));
     }
 }
 
@@ -16,7 +16,7 @@
  * Also, rows default to enabled which is odd because the button state does not reflect that.
 */
 
-FrameSenderWindow::FrameSenderWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+FrameSenderWindow::FrameSenderWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FrameSenderWindow)
 {
@@ -138,19 +138,17 @@ void FrameSenderWindow::createBlankRow()
 
 void FrameSenderWindow::buildFrameCache()
 {
-    CANFrame thisFrame;
-    frameCache.clear();
+    //find the newest frame for each ID first so only those get unpacked
+    QHash<int, int> lastIndex;
     for (int i = 0; i < modelFrames->count(); i++)
     {
-        thisFrame = modelFrames->at(i);
-        if (!frameCache.contains(thisFrame.frameId()))
-        {
-            frameCache.insert(thisFrame.frameId(), thisFrame);
-        }
-        else
-        {
-            frameCache[thisFrame.frameId()] = thisFrame;
-        }
+        lastIndex[static_cast<int>(modelFrames->frameIdAt(i))] = i;
+    }
+
+    frameCache.clear();
+    for (QHash<int, int>::const_iterator it = lastIndex.constBegin(); it != lastIndex.constEnd(); ++it)
+    {
+        frameCache.insert(it.key(), modelFrames->at(it.value()));
     }
 }
 
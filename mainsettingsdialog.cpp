@@ -1,12 +1,14 @@
 #include "mainsettingsdialog.h"
 #include "ui_mainsettingsdialog.h"
 #include "helpwindow.h"
+#include "mainwindow.h"
 #include <qevent.h>
 #include <QDebug>
 #include <QDir>
 #include <QRegExp>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QMessageBox>
 #include "simplecrypt.h"
 
 //using this simple encryption library to obfuscate stored password a bit. It's not super secure but better than
@@ -142,7 +144,7 @@ MainSettingsDialog::MainSettingsDialog(QWidget *parent) :
             ui->comboLanguage->setCurrentIndex(idx);
     }
 
-    int maxFramesDefault;
+    confirmingCaptureLimits = false;
     if (QSysInfo::WordSize > 32)
     {
         qDebug() << "64 bit OS detected. Requesting a large preallocation";
@@ -155,6 +157,11 @@ MainSettingsDialog::MainSettingsDialog(QWidget *parent) :
     }
 
     ui->spinMaximumFrames->setValue(settings.value("Main/MaximumFrames", maxFramesDefault).toInt());
+    ui->cbRingBufferCapture->setChecked(settings.value("Main/RingBufferCapture", false).toBool());
+    ui->spinCaptureMemoryMB->setValue(settings.value("Main/CaptureMemoryMB", 0).toInt());
+    ui->spinLogRotateMB->setValue(settings.value("Main/ContinuousLogRotateMB", 0).toInt());
+    ui->spinLogRotateMinutes->setValue(settings.value("Main/ContinuousLogRotateMinutes", 0).toInt());
+    ui->spinHugeFileMB->setValue(settings.value("Main/HugeFileMB", 0).toInt());
     ui->spinBytesPerLine->setValue(settings.value("Main/BytesPerLine", 8).toInt());
 
     //just for simplicity they all call the same function and that function updates all settings at once
@@ -186,7 +193,13 @@ MainSettingsDialog::MainSettingsDialog(QWidget *parent) :
     connect(ui->cbHexGraphFlow, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
     connect(ui->cbHexGraphInfo, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
     connect(ui->cbIgnoreDBCColors, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
-    connect(ui->spinMaximumFrames, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
+    //the capture limits apply to the running capture, so only once an edit is done and not on every keystroke
+    connect(ui->spinMaximumFrames, SIGNAL(editingFinished()), this, SLOT(updateCaptureLimits()));
+    connect(ui->cbRingBufferCapture, SIGNAL(toggled(bool)), this, SLOT(updateCaptureLimits()));
+    connect(ui->spinCaptureMemoryMB, SIGNAL(editingFinished()), this, SLOT(updateCaptureLimits()));
+    connect(ui->spinLogRotateMB, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
+    connect(ui->spinLogRotateMinutes, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
+    connect(ui->spinHugeFileMB, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
     connect(ui->cbFontFixedWidth, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
     connect(ui->spinBytesPerLine, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
 
@@ -202,6 +215,7 @@ void MainSettingsDialog::closeEvent(QCloseEvent *event)
 {
     Q_UNUSED(event);
     removeEventFilter(this);
+    updateCaptureLimits();
     updateSettings();
 }
 
@@ -257,7 +271,9 @@ void MainSettingsDialog::updateSettings()
     settings.setValue("Remote/Pass", encPass);
     settings.setValue("Main/FilterLabeling", ui->cbFilterLabeling->isChecked());
     settings.setValue("Main/IgnoreDBCColors", ui->cbIgnoreDBCColors->isChecked());
-    settings.setValue("Main/MaximumFrames", ui->spinMaximumFrames->value());
+    settings.setValue("Main/ContinuousLogRotateMB", ui->spinLogRotateMB->value());
+    settings.setValue("Main/ContinuousLogRotateMinutes", ui->spinLogRotateMinutes->value());
+    settings.setValue("Main/HugeFileMB", ui->spinHugeFileMB->value());
     settings.setValue("Main/BytesPerLine", ui->spinBytesPerLine->value());
     settings.setValue("Main/FontFixedWidth", ui->cbFontFixedWidth->isChecked());
     settings.setValue("Main/ColorsByCanId", ui->cbColorsByCanId->isChecked());
@@ -265,3 +281,45 @@ void MainSettingsDialog::updateSettings()
     settings.sync();
     emit updatedSettings();
 }
+
+/*
+ * Saving the capture limits puts them into effect on the running capture straight away, so they
+ * get saved on their own. If that would throw away frames already captured, ask first and put the
+ * old values back if the answer is no.
+ */
+void MainSettingsDialog::updateCaptureLimits()
+{
+    if (confirmingCaptureLimits) return;
+    QSettings settings;
+    int maxFrames = ui->spinMaximumFrames->value();
+    int memoryMB = ui->spinCaptureMemoryMB->value();
+    bool ringBuffer = ui->cbRingBufferCapture->isChecked();
+    int oldMaxFrames = settings.value("Main/MaximumFrames", maxFramesDefault).toInt();
+    int oldMemoryMB = settings.value("Main/CaptureMemoryMB", 0).toInt();
+    bool oldRingBuffer = settings.value("Main/RingBufferCapture", false).toBool();
+    if (maxFrames == oldMaxFrames && memoryMB == oldMemoryMB && ringBuffer == oldRingBuffer) return;
+
+    if (MainWindow::getReference()->getCANFrameModel()->captureLimitsDropFrames(maxFrames, memoryMB))
+    {
+        QMessageBox::StandardButton confirmDialog;
+        confirmingCaptureLimits = true;
+        confirmDialog = QMessageBox::question(this, tr("Really?"), tr("The capture already holds more than these limits allow.\n"
+                                              "The oldest frames will be thrown away. Apply them anyway?"),
+                                              QMessageBox::Yes|QMessageBox::No);
+        confirmingCaptureLimits = false;
+        if (confirmDialog != QMessageBox::Yes)
+        {
+            //spins first, putting the checkbox back calls in here again and has to find nothing changed
+            ui->spinMaximumFrames->setValue(oldMaxFrames);
+            ui->spinCaptureMemoryMB->setValue(oldMemoryMB);
+            ui->cbRingBufferCapture->setChecked(oldRingBuffer);
+            return;
+        }
+    }
+
+    settings.setValue("Main/MaximumFrames", maxFrames);
+    settings.setValue("Main/RingBufferCapture", ringBuffer);
+    settings.setValue("Main/CaptureMemoryMB", memoryMB);
+    settings.sync();
+    emit updatedSettings();
+}
@@ -21,9 +21,12 @@ signals:
 
 public slots:
     void updateSettings();
+    void updateCaptureLimits();
 
 private:
     Ui::MainSettingsDialog *ui;
+    int maxFramesDefault;
+    bool confirmingCaptureLimits; //a question box is up, taking focus off a spin box finishes its edit a second time
 
     void populateLanguageCombo();
     void closeEvent(QCloseEvent *event);
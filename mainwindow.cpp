@@ -3,11 +3,17 @@
 #include "can_structs.h"
 #include <QDateTime>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QtSerialPort/QSerialPortInfo>
 #include "connections/canconmanager.h"
 #include "connections/connectionwindow.h"
 #include "helpwindow.h"
 #include "utility.h"
+#include "utils/capturepager.h"
+#include "utils/capturemerger.h"
+#include "mergefilesdialog.h"
+#include "signalexportdialog.h"
+#include "continuouslogwriter.h"
 #include "filterutility.h"
 
 #include <QClipboard>
@@ -103,11 +109,12 @@ MainWindow::MainWindow(QWidget *parent) :
     rxFrames = 0;
     framesPerSec = 0;
     continuousLogging = false;
-    continuousLogFlushCounter = 0;
+    continuousLogBlinkCounter = 0;
 
     //handlers for all menu entries
     connect(ui->actionSetup, SIGNAL(triggered(bool)), SLOT(showConnectionSettingsWindow()));
     connect(ui->actionOpen_Log_File, &QAction::triggered, this, &MainWindow::handleLoadFile);
+    connect(ui->actionMerge_Log_Files, &QAction::triggered, this, &MainWindow::handleMergeFiles);
     connect(ui->actionGraph_Dta, &QAction::triggered, this, &MainWindow::showGraphingWindow);
     connect(ui->actionFrame_Data_Analysis, &QAction::triggered, this, &MainWindow::showFrameDataAnalysis);
     connect(ui->actionSave_Log_File, &QAction::triggered, this, &MainWindow::handleSaveFile);
@@ -122,6 +129,7 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->actionRange_State_2, &QAction::triggered, this, &MainWindow::showRangeWindow);
     connect(ui->actionSave_Decoded_Frames, &QAction::triggered, this, &MainWindow::handleSaveDecoded);
     connect(ui->actionSave_Decoded_Frames_CSV, &QAction::triggered, this, &MainWindow::handleSaveDecodedCsv);
+    connect(ui->actionExport_Decoded_Signals, &QAction::triggered, this, &MainWindow::handleExportSignals);
     connect(ui->actionSingle_Multi_State_2, &QAction::triggered, this, &MainWindow::showSingleMultiWindow);
     connect(ui->actionFile_Comparison, &QAction::triggered, this, &MainWindow::showComparisonWindow);
     connect(ui->actionDBC_Comparison, &QAction::triggered, this, &MainWindow::showDBCComparisonWindow);
@@ -263,6 +271,7 @@ MainWindow::~MainWindow()
 {
     updateTimer.stop();
     frameSender->stopSending();
+    FrameFileIO::closeContinuousNative(); //get whatever is still queued onto disk
     killEmAll(); //Ride the lightning
     delete ui;
     delete model;
@@ -440,6 +449,7 @@ void MainWindow::readUpdateableSettings()
     model->setIgnoreDBCColors(ignoreDBCColors);
     int bpl = settings.value("Main/BytesPerLine", 8).toInt();
     model->setBytesPerLine(bpl);
+    model->readCaptureSettings();
 
     CSVAbsTime = settings.value("Main/CSVAbsTime", false).toBool();
 
@@ -1022,10 +1032,7 @@ void MainWindow::filterClearAll()
 void MainWindow::logReceivedFrame(CANConnection* conn, QVector<CANFrame> frames)
 {
     Q_UNUSED(conn);
-    if (continuousLogging)
-    {
-        FrameFileIO::writeContinuousNative(&frames, 0);
-    }
+    if (continuousLogging) FrameFileIO::writeContinuousNative(frames);
 }
 
 void MainWindow::tickGUIUpdate()
@@ -1042,6 +1049,11 @@ void MainWindow::tickGUIUpdate()
             framesPerSec = 0;
 
         ui->lbNumFrames->setText(QString::number(model->rowCount()));
+        CapturePager *pager = model->getPagedSource();
+        if (pager && !pager->isIndexed())
+        {
+            ui->lbNumFrames->setText(QString::number(model->rowCount()) + tr(" (indexing %1%)").arg(pager->indexProgress() / 10));
+        }
         if (rxFrames > 0 && /*allowCapture && */ ui->cbAutoScroll->isChecked())
                 ui->canFramesView->scrollToBottom();
         ui->lbFPS->setText(QString::number(framesPerSec));
@@ -1056,26 +1068,24 @@ void MainWindow::tickGUIUpdate()
 
         if (continuousLogging)
         {
-//            const QVector<CANFrame> *modelFrames = model->getListReference();
-//            FrameFileIO::writeContinuousNative(modelFrames, modelFrames->count() - rxFrames);
-
-            continuousLogFlushCounter++;
-            if ((continuousLogFlushCounter % 3) == 0)
+            continuousLogBlinkCounter++;
+            if ((continuousLogBlinkCounter % 3) == 0)
             {
-                if (ui->lblContMsg->text().length() > 2)
+                const ContinuousLogWriter *logWriter = FrameFileIO::continuousLog();
+                if (ui->lblContMsg->text().length() > 2 || !logWriter)
                 {
                     ui->lblContMsg->setText("");
                 }
                 else
                 {
-                    ui->lblContMsg->setText("LOGGING");
+                    ui->lblContMsg->setText(tr("LOGGING %1 KB/s").arg(logWriter->bytesPerSecond() / 1024.0, 0, 'f', 1));
+                    ui->lblContMsg->setToolTip(tr("%1\nQueue depth: %2 frames\nWritten: %3 frames\nDropped: %4 frames")
+                                               .arg(logWriter->currentFileName())
+                                               .arg(logWriter->queueDepth())
+                                               .arg(logWriter->writtenCount())
+                                               .arg(logWriter->droppedCount()));
                 }
             }
-            if (continuousLogFlushCounter > 8)
-            {
-                continuousLogFlushCounter = 0;
-                FrameFileIO::flushContinuousNative();
-            }
         }
 
         //refresh the count for all the frame senders
@@ -1146,7 +1156,14 @@ void MainWindow::handleLoadFile()
 
     QMessageBox::StandardButton confirmDialog;
 
-    bool loadResult = FrameFileIO::loadFrameFile(filename, &tempFrames);
+    CapturePager *pagedFile = nullptr;
+    bool loadResult = FrameFileIO::loadFrameFile(filename, &tempFrames, &pagedFile);
+
+    if (pagedFile)
+    {
+        showPagedFile(pagedFile, filename);
+        return;
+    }
 
     if (!loadResult)
     {
@@ -1178,6 +1195,16 @@ void MainWindow::handleLoadFile()
 
 void MainWindow::handleDroppedFile(const QString &filename)
 {
+    if (FrameFileIO::isHugeFile(filename))
+    {
+        CapturePager *pager = FrameFileIO::openPagedFile(filename);
+        if (pager)
+        {
+            showPagedFile(pager, filename);
+            return;
+        }
+    }
+
     QProgressDialog progress(qApp->activeWindow());
     progress.setWindowModality(Qt::WindowModal);
     progress.setLabelText("Loading file...");
@@ -1220,11 +1247,85 @@ void MainWindow::handleDroppedFile(const QString &filename)
     }
 }
 
+//Several captures, usually one per bus, lined up by time stamp. The merge streams the files so they
+//are never all in memory at once before being shown or written out
+void MainWindow::handleMergeFiles()
+{
+    MergeFilesDialog dialog(this);
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    CaptureMerger merger;
+    QVector<MergeInput> inputs = dialog.getInputs();
+    for (int i = 0; i < inputs.count(); i++) merger.addInput(inputs[i]);
+
+    QString outFile;
+    if (dialog.mergeIntoFile())
+    {
+        QSettings settings;
+        outFile = QFileDialog::getSaveFileName(this, tr("Save merged log"), settings.value("FileIO/LoadSaveDirectory").toString(),
+                                               tr("GVRET Logs (*.csv *.CSV)"));
+        if (outFile.isEmpty()) return;
+        if (!outFile.contains('.')) outFile += ".csv";
+    }
+
+    QProgressDialog progress(this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setLabelText("Merging files...");
+    progress.setMinimumDuration(0);
+    progress.show();
+    qApp->processEvents();
+
+    bool result;
+    if (!outFile.isEmpty()) result = merger.runToFile(outFile, &progress);
+    else
+    {
+        disableAutoRowExpansion();
+        ui->canFramesView->scrollToTop();
+        model->clearFrames();
+        result = merger.run([this](const QVector<CANFrame> &block)
+        {
+            model->insertFrames(block);
+            return true;
+        }, &progress);
+
+        //whatever made it in before a failure or cancel stays, like salvaging a bad load
+        loadedFileName = "";
+        model->recalcOverwrite();
+        ui->lbNumFrames->setText(QString::number(model->rowCount()));
+        if (ui->cbAutoScroll->isChecked()) ui->canFramesView->scrollToBottom();
+        updateFileStatus();
+        emit framesUpdated(-1);
+    }
+    progress.cancel();
+
+    if (!result && !merger.wasCanceled())
+    {
+        QMessageBox::warning(this, "Merge Log Files", "The merge failed: " + merger.errorString());
+    }
+}
+
+//Huge files are shown straight from disk. The rest of the file gets indexed in the background and
+//its rows are added by tickGUIUpdate as they become available.
+void MainWindow::showPagedFile(CapturePager *pager, const QString &filename)
+{
+    disableAutoRowExpansion();
+    ui->canFramesView->scrollToTop();
+    model->clearFrames();
+    model->setPagedSource(pager);
+    loadedFileName = filename;
+    bDirty = false;
+    ui->lbNumFrames->setText(QString::number(model->rowCount()));
+
+    updateFileStatus();
+    emit framesUpdated(-1);
+}
 
 void MainWindow::handleSaveFile()
 {
     QString filename;
 
+    if (model->getPagedSource()) return; //nothing is loaded, the frames are still on disk. See updateFileStatus
+
     if (FrameFileIO::saveFrameFile(filename, model->getListReference()))
     {
         loadedFileName = filename;
@@ -1238,13 +1339,18 @@ void MainWindow::handleContinousLogging()
 
     if (continuousLogging)
     {
+        if (!FrameFileIO::openContinuousNative())
+        {
+            continuousLogging = false;
+            return;
+        }
         ui->actionSave_Continuous_Logfile->setText(tr("Cease Continuous Logging"));
-        FrameFileIO::openContinuousNative();
     }
     else
     {
         ui->actionSave_Continuous_Logfile->setText(tr("Start Continuous Logging"));
         ui->lblContMsg->setText("");
+        ui->lblContMsg->setToolTip("");
         FrameFileIO::closeContinuousNative();
     }
 }
@@ -1253,6 +1359,8 @@ void MainWindow::handleSaveFilteredFile()
 {
     QString filename;
 
+    if (model->getPagedSource()) return;
+
     if (FrameFileIO::saveFrameFile(filename, model->getFilteredListReference()))
     {
         loadedFileName = filename;
@@ -1317,6 +1425,56 @@ void MainWindow::handleSaveDecodedCsv()
     handleSaveDecodedMethod(true);
 }
 
+//Decoded signals resampled into one table for pandas and the like. Paged captures are read straight
+//from disk so the whole file never has to be in memory
+void MainWindow::handleExportSignals()
+{
+    DBCHandler *dbcHandler = DBCHandler::getReference();
+    if (dbcHandler->getFileCount() == 0)
+    {
+        QMessageBox::warning(this, "Export Decoded Signals", "Load a DBC file first, signals can't be decoded without one.");
+        return;
+    }
+
+    SignalExportDialog dialog(dbcHandler, this);
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    QSettings settings;
+    QString csvFilter = tr("CSV File (*.csv *.CSV)");
+    QString parquetFilter = tr("Parquet File (*.parquet)");
+    QString selectedFilter;
+    QString filename = QFileDialog::getSaveFileName(this, tr("Export decoded signals"), settings.value("FileIO/LoadSaveDirectory").toString(),
+                                                    csvFilter + ";;" + parquetFilter, &selectedFilter);
+    if (filename.isEmpty()) return;
+    bool parquet = selectedFilter == parquetFilter || filename.endsWith(".parquet", Qt::CaseInsensitive);
+    if (!filename.contains('.')) filename += parquet ? ".parquet" : ".csv";
+    settings.setValue("FileIO/LoadSaveDirectory", QFileInfo(filename).absolutePath());
+
+    SignalExporter exporter(dbcHandler);
+    QVector<QPair<DBC_MESSAGE *, DBC_SIGNAL *>> sigs = dialog.getSignals();
+    for (int i = 0; i < sigs.count(); i++) exporter.addSignal(sigs.at(i).first, sigs.at(i).second);
+    exporter.setPeriod(dialog.getPeriod());
+    exporter.setJoinMode(dialog.getJoinMode());
+
+    QProgressDialog progress(this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setLabelText("Exporting signals...");
+    progress.setMinimumDuration(0);
+    progress.show();
+    qApp->processEvents();
+
+    SignalExporter::FrameSource source;
+    if (model->getPagedSource()) source = SignalExporter::pagerSource(model->getPagedSource());
+    else source = SignalExporter::storeSource(model->getListReference());
+    bool result = exporter.run(source, filename, parquet ? SignalExporter::OUTPUT_PARQUET : SignalExporter::OUTPUT_CSV, &progress);
+    progress.cancel();
+
+    if (!result && !exporter.wasCanceled())
+    {
+        QMessageBox::warning(this, "Export Decoded Signals", "The export failed: " + exporter.errorString());
+    }
+}
+
 void MainWindow::handleSaveDecodedMethod(bool csv)
 {
     QString filename;
@@ -1354,11 +1512,12 @@ void MainWindow::handleSaveDecodedMethod(bool csv)
 void MainWindow::saveDecodedTextFileAsColumns(QString filename)
 {
     QFile *outFile = new QFile(filename);
-    const QVector<CANFrame> *frames = model->getFilteredListReference();
+    const CANFrameStore *frames = model->getFilteredListReference();
 
     //const unsigned char *data;
     int dataLen;
     const CANFrame *frame;
+    CANFrame frameCopy;
 
     if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
         return;
@@ -1400,7 +1559,8 @@ Data Bytes: 88 10 00 13 BB 00 06 00
     //loop through all the frames and the message data therein
     for (int c = 0; c < frames->count(); c++)
     {
-        frame = &frames->at(c);
+        frameCopy = frames->at(c);
+        frame = &frameCopy;
         //data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
         dataLen = frame->payload().count();
 
@@ -1457,7 +1617,8 @@ Data Bytes: 88 10 00 13 BB 00 06 00
     for (int c = 0; c < frames->count(); c++)
     {
         dataColumnsAdded = 0;
-        frame = &frames->at(c);
+        frameCopy = frames->at(c);
+        frame = &frameCopy;
         //data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
         dataLen = frame->payload().count();
 
@@ -1529,11 +1690,12 @@ Data Bytes: 88 10 00 13 BB 00 06 00
 void MainWindow::saveDecodedTextFile(QString filename)
 {
     QFile *outFile = new QFile(filename);
-    const QVector<CANFrame> *frames = model->getFilteredListReference();
+    const CANFrameStore *frames = model->getFilteredListReference();
 
     const unsigned char *data;
     int dataLen;
     const CANFrame *frame;
+    CANFrame frameCopy;
 
     if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
         return;
@@ -1544,7 +1706,8 @@ Data Bytes: 88 10 00 13 BB 00 06 00
 */
     for (int c = 0; c < frames->count(); c++)
     {
-        frame = &frames->at(c);
+        frameCopy = frames->at(c);
+        frame = &frameCopy;
         data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
         dataLen = frame->payload().count();
 
@@ -1628,6 +1791,12 @@ void MainWindow::updateFileStatus()
             output += " (X)";
         }
     }
+
+    //a paged file is only in the frame list, make it plain that nothing else has it
+    bool paged = model->getPagedSource() != nullptr;
+    if (paged) output = tr("%1 paged from disk, only the frame list shows it").arg(loadedFileName);
+    ui->actionSave_Log_File->setEnabled(!paged);
+    ui->actionSave_Filtered_Log_File->setEnabled(!paged);
     lbStatusFilename.setText(output);
 }
 
@@ -1687,7 +1856,7 @@ void MainWindow::showTemporalGraphWindow()
     //only create an instance of the object if we dont have one. Otherwise just display the existing one.
     if (!temporalGraphWindow)
     {
-        const QVector<CANFrame> *frames;
+        const CANFrameStore *frames;
         if (!useFiltered)
             frames = model->getListReference();
         else
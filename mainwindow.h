@@ -71,6 +71,7 @@ public:
 
 private slots:
     void handleLoadFile();
+    void handleMergeFiles();
     void handleSaveFile();
     void handleSaveFilteredFile();
     void handleSaveFilters();
@@ -106,6 +107,7 @@ private slots:
     void exitApp();
     void handleSaveDecoded();
     void handleSaveDecodedCsv();
+    void handleExportSignals();
     void connectionStatusUpdated(int conns);
     void gridClicked(QModelIndex);
     void gridDoubleClicked(QModelIndex);
@@ -171,7 +173,7 @@ private:
     bool inhibitSenderChanged;
 
     bool continuousLogging;
-    int continuousLogFlushCounter;
+    int continuousLogBlinkCounter;
 
     //References to other windows we can display
 
@@ -230,6 +232,7 @@ private:
     bool eventFilter(QObject *obj, QEvent *event);
     void manageRowExpansion();
     void disableAutoRowExpansion();
+    void showPagedFile(CapturePager *pager, const QString &filename);
     void createSenderRow();
     void processSenderCellChange(int line, int col);
 };
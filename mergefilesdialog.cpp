@@ -0,0 +1,132 @@
+#include "mergefilesdialog.h"
+#include "ui_mergefilesdialog.h"
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QSettings>
+#include <cmath>
+
+MergeFilesDialog::MergeFilesDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::MergeFilesDialog)
+{
+    ui->setupUi(this);
+
+    ui->tableFiles->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    ui->tableFiles->verticalHeader()->setVisible(false);
+
+    connect(ui->btnAdd, &QPushButton::clicked, this, &MergeFilesDialog::addFiles);
+    connect(ui->btnRemove, &QPushButton::clicked, this, &MergeFilesDialog::removeSelected);
+    connect(ui->btnMerge, &QPushButton::clicked, this, &MergeFilesDialog::handleMerge);
+    connect(ui->btnCancel, &QPushButton::clicked, this, &QDialog::reject);
+}
+
+MergeFilesDialog::~MergeFilesDialog()
+{
+    delete ui;
+}
+
+bool MergeFilesDialog::mergeIntoFile() const
+{
+    return ui->rbIntoFile->isChecked();
+}
+
+void MergeFilesDialog::addFiles()
+{
+    QSettings settings;
+    QStringList files = QFileDialog::getOpenFileNames(this, tr("Files to merge"),
+                                                      settings.value("FileIO/LoadSaveDirectory").toString());
+    if (files.isEmpty()) return;
+    settings.setValue("FileIO/LoadSaveDirectory", QFileInfo(files.first()).absolutePath());
+
+    for (const QString &file : files)
+    {
+        int row = ui->tableFiles->rowCount();
+        ui->tableFiles->insertRow(row);
+        QTableWidgetItem *item = new QTableWidgetItem(file);
+        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+        ui->tableFiles->setItem(row, 0, item);
+        ui->tableFiles->setItem(row, 1, new QTableWidgetItem(""));
+        ui->tableFiles->setItem(row, 2, new QTableWidgetItem(""));
+        ui->tableFiles->setItem(row, 3, new QTableWidgetItem("0"));
+    }
+}
+
+void MergeFilesDialog::removeSelected()
+{
+    QList<QTableWidgetSelectionRange> ranges = ui->tableFiles->selectedRanges();
+    //bottom up so the rows still to go keep their numbers
+    for (int r = ranges.count() - 1; r >= 0; r--)
+    {
+        for (int row = ranges[r].bottomRow(); row >= ranges[r].topRow(); row--) ui->tableFiles->removeRow(row);
+    }
+}
+
+bool MergeFilesDialog::parseRow(int row, MergeInput &input, QString &problem) const
+{
+    QString bus = ui->tableFiles->item(row, 1) ? ui->tableFiles->item(row, 1)->text().trimmed() : QString();
+    QString remap = ui->tableFiles->item(row, 2) ? ui->tableFiles->item(row, 2)->text().trimmed() : QString();
+    QString offset = ui->tableFiles->item(row, 3) ? ui->tableFiles->item(row, 3)->text().trimmed() : QString();
+    bool ok;
+
+    input.filename = ui->tableFiles->item(row, 0)->text();
+    input.bus = -1;
+    if (!bus.isEmpty())
+    {
+        input.bus = bus.toInt(&ok);
+        if (!ok || input.bus < 0)
+        {
+            problem = "Bus \"" + bus + "\" is not a bus number";
+            return false;
+        }
+    }
+
+    input.busMap.clear();
+    const QStringList entries = remap.split(',', Qt::SkipEmptyParts);
+    for (const QString &entry : entries)
+    {
+        QStringList buses = entry.split('=');
+        bool fromOk = false, toOk = false;
+        int from = (buses.count() == 2) ? buses[0].trimmed().toInt(&fromOk) : -1;
+        int to = (buses.count() == 2) ? buses[1].trimmed().toInt(&toOk) : -1;
+        if (!fromOk || !toOk || from < 0 || to < 0)
+        {
+            problem = "Bus remap \"" + entry.trimmed() + "\" should look like 0=2";
+            return false;
+        }
+        input.busMap.insert(from, to);
+    }
+
+    double ms = offset.isEmpty() ? 0.0 : offset.toDouble(&ok);
+    if (!offset.isEmpty() && !ok)
+    {
+        problem = "Time offset \"" + offset + "\" is not a number";
+        return false;
+    }
+    input.timeOffset = static_cast<int64_t>(std::llround(ms * 1000.0));
+    return true;
+}
+
+void MergeFilesDialog::handleMerge()
+{
+    inputs.clear();
+    if (ui->tableFiles->rowCount() == 0)
+    {
+        QMessageBox::warning(this, "Merge Log Files", "Add the files to merge first");
+        return;
+    }
+
+    for (int row = 0; row < ui->tableFiles->rowCount(); row++)
+    {
+        MergeInput input;
+        QString problem;
+        if (!parseRow(row, input, problem))
+        {
+            QMessageBox::warning(this, "Merge Log Files", QFileInfo(ui->tableFiles->item(row, 0)->text()).fileName() + ": " + problem);
+            return;
+        }
+        inputs.append(input);
+    }
+    accept();
+}
@@ -0,0 +1,34 @@
+#ifndef MERGEFILESDIALOG_H
+#define MERGEFILESDIALOG_H
+
+#include <QDialog>
+#include <QVector>
+#include "utils/capturemerger.h"
+
+namespace Ui {
+class MergeFilesDialog;
+}
+
+//picks the files for a merge and the bus and time changes for each of them
+class MergeFilesDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit MergeFilesDialog(QWidget *parent = nullptr);
+    ~MergeFilesDialog();
+
+    QVector<MergeInput> getInputs() const { return inputs; }
+    bool mergeIntoFile() const;
+
+private:
+    Ui::MergeFilesDialog *ui;
+    QVector<MergeInput> inputs;
+
+    void addFiles();
+    void removeSelected();
+    void handleMerge();
+    bool parseRow(int row, MergeInput &input, QString &problem) const;
+};
+
+#endif // MERGEFILESDIALOG_H
@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QTimer>
 #include "can_structs.h"
+#include "canframestore.h"
 
 namespace Ui {
 class MotorControllerConfigWindow;
@@ -41,7 +42,7 @@ class MotorControllerConfigWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit MotorControllerConfigWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit MotorControllerConfigWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~MotorControllerConfigWindow();
 
 signals:
@@ -57,7 +58,7 @@ private slots:
 
 private:
     Ui::MotorControllerConfigWindow *ui;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     QTimer timer;
     CANFrame outFrame;
     bool doingRequest;
@@ -0,0 +1,434 @@
+#include "nativebinaryfile.h"
+#include "utils/frameexporter.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QHash>
+#include <QtEndian>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+static_assert(sizeof(NB_FILE_HEADER) == 32, "NB_FILE_HEADER is part of the file format");
+static_assert(sizeof(NB_FRAME_RECORD) == 24, "NB_FRAME_RECORD is part of the file format");
+static_assert(sizeof(NB_BLOCK_ENTRY) == 40, "NB_BLOCK_ENTRY is part of the file format");
+static_assert(sizeof(NB_ID_ENTRY) == 40, "NB_ID_ENTRY is part of the file format");
+static_assert(sizeof(NB_FILE_TRAILER) == 32, "NB_FILE_TRAILER is part of the file format");
+
+static const char headerMagic[8] = {'S', 'V', 'C', 'A', 'N', 'C', 'A', 'P'};
+static const char trailerMagic[8] = {'S', 'V', 'C', 'A', 'N', 'I', 'D', 'X'};
+static const int fdPayloadSize = 64;
+
+NativeBinaryFile::NativeBinaryFile()
+{
+    base = nullptr;
+    fileSize = 0;
+    numFrames = 0;
+    footerOffset = 0;
+    blockFrames = framesPerBlock;
+    idCount = 0;
+}
+
+NativeBinaryFile::~NativeBinaryFile()
+{
+    close();
+}
+
+struct NBIDAccumulator
+{
+    NBIDAccumulator() : count(0), firstFrame(0), lastFrame(0) {}
+    uint32_t count;
+    quint64 firstFrame;
+    quint64 lastFrame;
+    QVector<uint32_t> blocks;
+};
+
+//one ID's frames within a single block, merged in block order into an NBIDAccumulator at the end
+struct NBBlockIDs
+{
+    NBBlockIDs() : count(0), firstFrame(0), lastFrame(0) {}
+    uint32_t count;
+    quint64 firstFrame;
+    quint64 lastFrame;
+};
+
+bool NativeBinaryFile::save(const QString &filename, const CANFrameStore *frames, QProgressDialog *progress)
+{
+    NB_FILE_HEADER header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, headerMagic, 8);
+    header.version = qToLittleEndian<uint16_t>(1);
+    header.headerSize = qToLittleEndian<uint16_t>(sizeof(NB_FILE_HEADER));
+    header.recordSize = qToLittleEndian<uint16_t>(sizeof(NB_FRAME_RECORD));
+    header.framesPerBlock = qToLittleEndian<uint32_t>(framesPerBlock);
+    header.created = qToLittleEndian<int64_t>(QDateTime::currentMSecsSinceEpoch());
+
+    //Where a block lands in the file only depends on how many CAN-FD payloads the blocks before it
+    //carry. Working that out first leaves every block free to be built on its own thread
+    int count = frames->count();
+    int numBlocks = (count + framesPerBlock - 1) / framesPerBlock;
+    QVector<NB_BLOCK_ENTRY> blockIndex(numBlocks);
+    QVector<QHash<quint64, NBBlockIDs>> blockIds(numBlocks); //key is extended << 40 | bus << 32 | id
+    quint64 offset = sizeof(NB_FILE_HEADER);
+    for (int b = 0; b < numBlocks; b++)
+    {
+        int first = b * framesPerBlock;
+        int num = std::min(static_cast<int>(framesPerBlock), count - first);
+        int numFD = 0;
+        for (int i = first; i < first + num; i++)
+        {
+            if (frames->payloadLengthAt(i) > 8) numFD++;
+        }
+        NB_BLOCK_ENTRY &entry = blockIndex[b];
+        memset(&entry, 0, sizeof(entry));
+        entry.offset = offset;
+        entry.firstFrame = static_cast<uint64_t>(first);
+        entry.frameCount = static_cast<uint32_t>(num);
+        offset += (num * sizeof(NB_FRAME_RECORD)) + (numFD * fdPayloadSize);
+    }
+    quint64 footerOffset = offset;
+
+    //each block only ever touches its own entries so the formatters can share these
+    NB_BLOCK_ENTRY *entries = blockIndex.data();
+    QHash<quint64, NBBlockIDs> *idLists = blockIds.data();
+
+    auto formatBlock = [frames, entries, idLists, numBlocks, footerOffset](int first, int num, QByteArray &blockBuf)
+    {
+        int blockNum = first / framesPerBlock;
+        NB_BLOCK_ENTRY &entry = entries[blockNum];
+        QHash<quint64, NBBlockIDs> &ids = idLists[blockNum];
+        quint64 blockEnd = (blockNum + 1 < numBlocks) ? entries[blockNum + 1].offset : footerOffset;
+
+        blockBuf.resize(static_cast<int>(blockEnd - entry.offset));
+        uchar *recPtr = reinterpret_cast<uchar *>(blockBuf.data());
+        uchar *fdPtr = recPtr + (num * sizeof(NB_FRAME_RECORD));
+        quint64 fdOffset = entry.offset + (num * sizeof(NB_FRAME_RECORD));
+
+        entry.minTimeStamp = frames->timeStampAt(first);
+        entry.maxTimeStamp = entry.minTimeStamp;
+
+        for (int i = first; i < first + num; i++, recPtr += sizeof(NB_FRAME_RECORD))
+        {
+            const PackedCANFrame &packed = frames->recordAt(i);
+            NB_FRAME_RECORD rec;
+            rec.timeStamp = qToLittleEndian<int64_t>(packed.timeStamp);
+            rec.frameId = qToLittleEndian<uint32_t>(packed.frameId);
+            rec.bus = static_cast<uint8_t>(packed.bus);
+            rec.length = static_cast<uint8_t>(packed.length);
+            rec.flags = static_cast<uint8_t>((packed.extended ? NB_FLAG_EXTENDED : 0) | (packed.received ? NB_FLAG_RECEIVED : 0)
+                                             | (packed.fd ? NB_FLAG_FD : 0) | (packed.brs ? NB_FLAG_BRS : 0)
+                                             | (packed.esi ? NB_FLAG_ESI : 0) | (packed.localEcho ? NB_FLAG_LOCAL_ECHO : 0));
+            rec.frameType = static_cast<uint8_t>(packed.frameType);
+            memset(rec.data, 0, 8);
+            if (packed.length <= 8) memcpy(rec.data, frames->payloadAt(i), packed.length);
+            else
+            {
+                memset(fdPtr, 0, fdPayloadSize);
+                memcpy(fdPtr, frames->payloadAt(i), packed.length);
+                qToLittleEndian<quint64>(fdOffset, rec.data);
+                fdPtr += fdPayloadSize;
+                fdOffset += fdPayloadSize;
+            }
+            memcpy(recPtr, &rec, sizeof(rec));
+
+            if (packed.timeStamp < entry.minTimeStamp) entry.minTimeStamp = packed.timeStamp;
+            if (packed.timeStamp > entry.maxTimeStamp) entry.maxTimeStamp = packed.timeStamp;
+
+            quint64 key = (static_cast<quint64>(packed.extended) << 40) | (static_cast<quint64>(packed.bus) << 32) | packed.frameId;
+            NBBlockIDs &blockId = ids[key];
+            if (blockId.count == 0) blockId.firstFrame = static_cast<quint64>(i);
+            blockId.count++;
+            blockId.lastFrame = static_cast<quint64>(i);
+        }
+    };
+
+    //footer. ID entries are sorted by bus then ID so the file comes out the same every time
+    auto buildFooter = [&blockIndex, &blockIds, footerOffset, count]()
+    {
+        QByteArray footer;
+        QHash<quint64, NBIDAccumulator> ids;
+        for (int b = 0; b < blockIndex.count(); b++)
+        {
+            const QHash<quint64, NBBlockIDs> &blockId = blockIds.at(b);
+            for (QHash<quint64, NBBlockIDs>::const_iterator it = blockId.constBegin(); it != blockId.constEnd(); ++it)
+            {
+                NBIDAccumulator &acc = ids[it.key()];
+                if (acc.count == 0) acc.firstFrame = it.value().firstFrame;
+                acc.count += it.value().count;
+                acc.lastFrame = it.value().lastFrame;
+                acc.blocks.append(static_cast<uint32_t>(b));
+            }
+
+            NB_BLOCK_ENTRY entry = blockIndex.at(b);
+            entry.offset = qToLittleEndian<uint64_t>(entry.offset);
+            entry.firstFrame = qToLittleEndian<uint64_t>(entry.firstFrame);
+            entry.minTimeStamp = qToLittleEndian<int64_t>(entry.minTimeStamp);
+            entry.maxTimeStamp = qToLittleEndian<int64_t>(entry.maxTimeStamp);
+            entry.frameCount = qToLittleEndian<uint32_t>(entry.frameCount);
+            footer.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        }
+
+        QList<quint64> keys = ids.keys();
+        std::sort(keys.begin(), keys.end(), [](quint64 a, quint64 b)
+        {
+            quint64 busA = (a >> 32) & 0xFF;
+            quint64 busB = (b >> 32) & 0xFF;
+            if (busA != busB) return busA < busB;
+            return a < b;
+        });
+        uint32_t blockListStart = 0;
+        for (int k = 0; k < keys.count(); k++)
+        {
+            const NBIDAccumulator &acc = ids[keys.at(k)];
+            NB_ID_ENTRY entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.frameId = qToLittleEndian<uint32_t>(static_cast<uint32_t>(keys.at(k) & 0xFFFFFFFF));
+            entry.bus = static_cast<uint8_t>((keys.at(k) >> 32) & 0xFF);
+            entry.extended = static_cast<uint8_t>((keys.at(k) >> 40) & 1);
+            entry.count = qToLittleEndian<uint32_t>(acc.count);
+            entry.blockListStart = qToLittleEndian<uint32_t>(blockListStart);
+            entry.blockListCount = qToLittleEndian<uint32_t>(static_cast<uint32_t>(acc.blocks.count()));
+            entry.firstFrame = qToLittleEndian<uint64_t>(acc.firstFrame);
+            entry.lastFrame = qToLittleEndian<uint64_t>(acc.lastFrame);
+            footer.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+            blockListStart += static_cast<uint32_t>(acc.blocks.count());
+        }
+        for (int k = 0; k < keys.count(); k++)
+        {
+            const QVector<uint32_t> &list = ids[keys.at(k)].blocks;
+            QByteArray listBuf(list.count() * 4, 0);
+            for (int i = 0; i < list.count(); i++) qToLittleEndian<uint32_t>(list.at(i), reinterpret_cast<uchar *>(listBuf.data()) + (i * 4));
+            footer.append(listBuf);
+        }
+
+        NB_FILE_TRAILER trailer;
+        memset(&trailer, 0, sizeof(trailer));
+        trailer.footerOffset = qToLittleEndian<uint64_t>(footerOffset);
+        trailer.frameCount = qToLittleEndian<uint64_t>(static_cast<uint64_t>(count));
+        trailer.blockCount = qToLittleEndian<uint32_t>(static_cast<uint32_t>(blockIndex.count()));
+        trailer.idCount = qToLittleEndian<uint32_t>(static_cast<uint32_t>(keys.count()));
+        memcpy(trailer.magic, trailerMagic, 8);
+        footer.append(reinterpret_cast<const char *>(&trailer), sizeof(trailer));
+        return footer;
+    };
+
+    FrameExporter exporter(frames, progress);
+    exporter.setOpenMode(QIODevice::WriteOnly);
+    exporter.setBatchSize(framesPerBlock); //one batch per block
+    return exporter.run(filename, QByteArray(reinterpret_cast<const char *>(&header), sizeof(header)), formatBlock, buildFooter);
+}
+
+bool NativeBinaryFile::isNativeBinary(const QString &filename)
+{
+    QFile inFile(filename);
+    if (!inFile.open(QIODevice::ReadOnly)) return false;
+    if (inFile.size() < static_cast<qint64>(sizeof(NB_FILE_HEADER) + sizeof(NB_FILE_TRAILER))) return false;
+
+    QByteArray start = inFile.read(sizeof(NB_FILE_HEADER));
+    inFile.seek(inFile.size() - static_cast<qint64>(sizeof(NB_FILE_TRAILER)));
+    QByteArray end = inFile.read(sizeof(NB_FILE_TRAILER));
+    return isNativeBinary(start, end, inFile.size());
+}
+
+bool NativeBinaryFile::isNativeBinary(const QByteArray &start, const QByteArray &end, qint64 fileSize)
+{
+    if (fileSize < static_cast<qint64>(sizeof(NB_FILE_HEADER) + sizeof(NB_FILE_TRAILER))) return false;
+    if (start.length() < static_cast<int>(sizeof(NB_FILE_HEADER)) || end.length() < static_cast<int>(sizeof(NB_FILE_TRAILER))) return false;
+    const char *trailer = end.constData() + end.length() - sizeof(NB_FILE_TRAILER);
+    return memcmp(start.constData() + offsetof(NB_FILE_HEADER, magic), headerMagic, 8) == 0 &&
+           memcmp(trailer + offsetof(NB_FILE_TRAILER, magic), trailerMagic, 8) == 0;
+}
+
+bool NativeBinaryFile::open(const QString &filename)
+{
+    close();
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    fileSize = file.size();
+    if (fileSize < static_cast<qint64>(sizeof(NB_FILE_HEADER) + sizeof(NB_FILE_TRAILER)))
+    {
+        close();
+        return false;
+    }
+    base = file.map(0, fileSize);
+    if (!base)
+    {
+        qDebug() << "Could not map" << filename;
+        close();
+        return false;
+    }
+
+    NB_FILE_HEADER header;
+    NB_FILE_TRAILER trailer;
+    memcpy(&header, base, sizeof(header));
+    memcpy(&trailer, base + fileSize - sizeof(trailer), sizeof(trailer));
+    if (memcmp(header.magic, headerMagic, 8) != 0 || memcmp(trailer.magic, trailerMagic, 8) != 0
+        || qFromLittleEndian(header.version) != 1 || qFromLittleEndian(header.recordSize) != sizeof(NB_FRAME_RECORD))
+    {
+        qDebug() << "Not a native binary capture or an unsupported version";
+        close();
+        return false;
+    }
+
+    blockFrames = static_cast<int>(qFromLittleEndian(header.framesPerBlock));
+    numFrames = qFromLittleEndian(trailer.frameCount);
+    footerOffset = qFromLittleEndian(trailer.footerOffset);
+    quint64 blockCount = qFromLittleEndian(trailer.blockCount);
+    idCount = static_cast<int>(qFromLittleEndian(trailer.idCount));
+    quint64 footerEnd = footerOffset + (blockCount * sizeof(NB_BLOCK_ENTRY)) + (static_cast<quint64>(idCount) * sizeof(NB_ID_ENTRY));
+    if (blockFrames <= 0 || footerOffset < sizeof(NB_FILE_HEADER) || footerEnd > static_cast<quint64>(fileSize) - sizeof(NB_FILE_TRAILER))
+    {
+        qDebug() << "Native binary capture footer is damaged";
+        close();
+        return false;
+    }
+
+    //the frame to block mapping relies on every block but the last being full, check that holds
+    blocks.resize(static_cast<int>(blockCount));
+    quint64 expectFirst = 0;
+    for (int b = 0; b < blocks.count(); b++)
+    {
+        NB_BLOCK_ENTRY entry;
+        memcpy(&entry, base + footerOffset + (b * sizeof(NB_BLOCK_ENTRY)), sizeof(entry));
+        entry.offset = qFromLittleEndian(entry.offset);
+        entry.firstFrame = qFromLittleEndian(entry.firstFrame);
+        entry.minTimeStamp = qFromLittleEndian(entry.minTimeStamp);
+        entry.maxTimeStamp = qFromLittleEndian(entry.maxTimeStamp);
+        entry.frameCount = qFromLittleEndian(entry.frameCount);
+        bool lastBlock = (b == blocks.count() - 1);
+        if (entry.firstFrame != expectFirst || (!lastBlock && entry.frameCount != static_cast<uint32_t>(blockFrames))
+            || entry.frameCount > static_cast<uint32_t>(blockFrames)
+            || entry.offset + (entry.frameCount * sizeof(NB_FRAME_RECORD)) > footerOffset)
+        {
+            qDebug() << "Native binary capture block index is damaged at block" << b;
+            close();
+            return false;
+        }
+        expectFirst += entry.frameCount;
+        blocks[b] = entry;
+    }
+    if (expectFirst != numFrames)
+    {
+        qDebug() << "Native binary capture frame count doesn't match its blocks";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void NativeBinaryFile::close()
+{
+    if (base) file.unmap(const_cast<uchar *>(base));
+    base = nullptr;
+    file.close();
+    blocks.clear();
+    numFrames = 0;
+    idCount = 0;
+}
+
+int NativeBinaryFile::findBlock(int64_t timeStamp) const
+{
+    for (int b = 0; b < blocks.count(); b++)
+    {
+        if (blocks.at(b).maxTimeStamp >= timeStamp) return b;
+    }
+    return -1;
+}
+
+const uchar *NativeBinaryFile::recordPtr(quint64 idx) const
+{
+    int block = static_cast<int>(idx / static_cast<quint64>(blockFrames));
+    int inBlock = static_cast<int>(idx % static_cast<quint64>(blockFrames));
+    return base + blocks.at(block).offset + (static_cast<quint64>(inBlock) * sizeof(NB_FRAME_RECORD));
+}
+
+void NativeBinaryFile::decodeRecord(const uchar *rec, CANFrame &frame) const
+{
+    NB_FRAME_RECORD r;
+    memcpy(&r, rec, sizeof(r));
+    int len = std::min<int>(r.length, fdPayloadSize);
+
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, qFromLittleEndian(r.timeStamp)));
+    frame.setFrameId(qFromLittleEndian(r.frameId));
+    frame.setFrameType(static_cast<QCanBusFrame::FrameType>(r.frameType));
+    frame.setExtendedFrameFormat(r.flags & NB_FLAG_EXTENDED);
+    frame.setFlexibleDataRateFormat(r.flags & NB_FLAG_FD);
+    frame.setBitrateSwitch(r.flags & NB_FLAG_BRS);
+    frame.setErrorStateIndicator(r.flags & NB_FLAG_ESI);
+    frame.setLocalEcho(r.flags & NB_FLAG_LOCAL_ECHO);
+    frame.isReceived = (r.flags & NB_FLAG_RECEIVED);
+    frame.bus = r.bus;
+
+    if (len <= 8) frame.setPayload(QByteArray(reinterpret_cast<const char *>(r.data), len));
+    else
+    {
+        quint64 payloadOffset = qFromLittleEndian<quint64>(r.data);
+        if (payloadOffset + fdPayloadSize <= footerOffset) frame.setPayload(QByteArray(reinterpret_cast<const char *>(base + payloadOffset), len));
+        else frame.setPayload(QByteArray(len, 0)); //points outside the frame data, the file is damaged
+    }
+}
+
+CANFrame NativeBinaryFile::frameAt(quint64 idx) const
+{
+    CANFrame frame;
+    if (idx < numFrames) decodeRecord(recordPtr(idx), frame);
+    return frame;
+}
+
+int64_t NativeBinaryFile::timeStampAt(quint64 idx) const
+{
+    if (idx >= numFrames) return 0;
+    return qFromLittleEndian<int64_t>(recordPtr(idx));
+}
+
+QVector<NativeBinaryIDInfo> NativeBinaryFile::idIndex() const
+{
+    QVector<NativeBinaryIDInfo> out;
+    if (!base) return out;
+    const uchar *entries = base + footerOffset + (blocks.count() * sizeof(NB_BLOCK_ENTRY));
+    const uchar *lists = entries + (idCount * sizeof(NB_ID_ENTRY));
+    quint64 listLimit = (static_cast<quint64>(fileSize) - sizeof(NB_FILE_TRAILER) - static_cast<quint64>(lists - base)) / 4;
+    out.reserve(idCount);
+    for (int i = 0; i < idCount; i++)
+    {
+        NB_ID_ENTRY entry;
+        memcpy(&entry, entries + (i * sizeof(NB_ID_ENTRY)), sizeof(entry));
+        NativeBinaryIDInfo info;
+        info.frameId = qFromLittleEndian(entry.frameId);
+        info.bus = entry.bus;
+        info.extended = entry.extended;
+        info.count = qFromLittleEndian(entry.count);
+        info.firstFrame = qFromLittleEndian(entry.firstFrame);
+        info.lastFrame = qFromLittleEndian(entry.lastFrame);
+        quint64 start = qFromLittleEndian(entry.blockListStart);
+        quint64 num = qFromLittleEndian(entry.blockListCount);
+        if (start + num <= listLimit)
+        {
+            for (quint64 b = start; b < start + num; b++) info.blocks.append(static_cast<int>(qFromLittleEndian<uint32_t>(lists + (b * 4))));
+        }
+        out.append(info);
+    }
+    return out;
+}
+
+bool NativeBinaryFile::loadAll(QVector<CANFrame> *frames) const
+{
+    if (!base) return false;
+    int start = frames->count();
+    frames->resize(start + static_cast<int>(numFrames));
+    CANFrame *out = frames->data() + start;
+
+    QVector<int> work;
+    for (int b = 0; b < blocks.count(); b++) work.append(b);
+    QtConcurrent::blockingMap(work, [this, out](int b)
+    {
+        const NB_BLOCK_ENTRY &entry = blocks.at(b);
+        const uchar *rec = base + entry.offset;
+        for (uint32_t i = 0; i < entry.frameCount; i++, rec += sizeof(NB_FRAME_RECORD))
+        {
+            decodeRecord(rec, out[entry.firstFrame + i]);
+        }
+    });
+    return true;
+}
@@ -0,0 +1,151 @@
+#ifndef NATIVEBINARYFILE_H
+#define NATIVEBINARYFILE_H
+
+#include <Qt>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include "can_structs.h"
+#include "canframestore.h"
+
+class QProgressDialog;
+
+/*
+ * SavvyCAN's own binary capture format (.scb). Unlike the GVRET CSV it needs no parsing: every
+ * frame is a fixed size record so a file can be memory mapped and any frame read straight out of
+ * it, and a footer indexes the capture by time and by bus/ID.
+ *
+ * Layout, everything little endian:
+ *   header    NB_FILE_HEADER, 32 bytes
+ *   blocks    framesPerBlock records of 24 bytes each (the last block may be short), followed by
+ *             the 64 byte payloads of any CAN-FD frames in the block too long to store inline
+ *   footer    one NB_BLOCK_ENTRY per block, one NB_ID_ENTRY per bus/ID pair, then the block lists
+ *             the ID entries point into (uint32 block numbers)
+ *   trailer   NB_FILE_TRAILER, always the last 32 bytes of the file
+ *
+ * Since every block but the last is full, frame n lives in block n / framesPerBlock.
+ */
+
+enum
+{
+    NB_FLAG_EXTENDED    = 0x01,
+    NB_FLAG_RECEIVED    = 0x02,
+    NB_FLAG_FD          = 0x04,
+    NB_FLAG_BRS         = 0x08,
+    NB_FLAG_ESI         = 0x10,
+    NB_FLAG_LOCAL_ECHO  = 0x20
+};
+
+struct NB_FILE_HEADER
+{
+    char magic[8]; //SVCANCAP
+    uint16_t version;
+    uint16_t headerSize;
+    uint16_t recordSize;
+    uint16_t flags;
+    uint32_t framesPerBlock;
+    uint32_t reserved;
+    int64_t created; //ms since the epoch
+}; //32 bytes
+
+struct NB_FRAME_RECORD
+{
+    int64_t timeStamp; //microseconds
+    uint32_t frameId;
+    uint8_t bus;
+    uint8_t length;
+    uint8_t flags;
+    uint8_t frameType; //QCanBusFrame::FrameType
+    uint8_t data[8];   //payload if length <= 8, otherwise the uint64 file offset of a 64 byte payload
+}; //24 bytes
+
+struct NB_BLOCK_ENTRY
+{
+    uint64_t offset;
+    uint64_t firstFrame;
+    int64_t minTimeStamp;
+    int64_t maxTimeStamp;
+    uint32_t frameCount;
+    uint32_t reserved;
+}; //40 bytes
+
+struct NB_ID_ENTRY
+{
+    uint32_t frameId;
+    uint8_t bus;
+    uint8_t extended;
+    uint16_t reserved;
+    uint32_t count;
+    uint32_t blockListStart; //index into the block lists following the ID entries
+    uint32_t blockListCount;
+    uint32_t reserved2;
+    uint64_t firstFrame;
+    uint64_t lastFrame;
+}; //40 bytes
+
+struct NB_FILE_TRAILER
+{
+    uint64_t footerOffset;
+    uint64_t frameCount;
+    uint32_t blockCount;
+    uint32_t idCount;
+    char magic[8]; //SVCANIDX
+}; //32 bytes
+
+//everything the footer knows about one bus/ID pair
+struct NativeBinaryIDInfo
+{
+    uint32_t frameId;
+    int bus;
+    bool extended;
+    uint32_t count;
+    quint64 firstFrame;
+    quint64 lastFrame;
+    QVector<int> blocks; //blocks that hold at least one of these frames, in file order
+};
+
+class NativeBinaryFile
+{
+public:
+    static const int framesPerBlock = 4096;
+
+    NativeBinaryFile();
+    ~NativeBinaryFile();
+
+    static bool save(const QString &filename, const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+    static bool isNativeBinary(const QString &filename);
+    static bool isNativeBinary(const QByteArray &start, const QByteArray &end, qint64 fileSize); //first and last bytes of a file
+
+    bool open(const QString &filename); //maps the file and checks the footer, no frames are read
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    quint64 frameCount() const { return numFrames; }
+    int blockCount() const { return blocks.count(); }
+    quint64 blockFirstFrame(int block) const { return blocks.at(block).firstFrame; }
+    int blockFrameCount(int block) const { return static_cast<int>(blocks.at(block).frameCount); }
+    int64_t blockMinTimeStamp(int block) const { return blocks.at(block).minTimeStamp; }
+    int64_t blockMaxTimeStamp(int block) const { return blocks.at(block).maxTimeStamp; }
+    int findBlock(int64_t timeStamp) const; //first block holding frames at or after timeStamp, -1 if none
+
+    CANFrame frameAt(quint64 idx) const;
+    int64_t timeStampAt(quint64 idx) const;
+    QVector<NativeBinaryIDInfo> idIndex() const;
+
+    bool loadAll(QVector<CANFrame> *frames) const; //decodes blocks in parallel
+
+private:
+    const uchar *recordPtr(quint64 idx) const;
+    void decodeRecord(const uchar *rec, CANFrame &frame) const;
+
+    QFile file;
+    const uchar *base;
+    qint64 fileSize;
+    quint64 numFrames;
+    quint64 footerOffset;
+    int blockFrames; //framesPerBlock the file was written with
+    QVector<NB_BLOCK_ENTRY> blocks;
+    int idCount;
+};
+
+#endif // NATIVEBINARYFILE_H
@@ -1,4 +1,5 @@
 #include <math.h>
+#include <string.h>
 #include "pcaplite.h"
 
 #define MAGIC_NG 0x0A0D0D0A
@@ -227,3 +228,443 @@ const unsigned char *pcap_next(pcap_t *p, struct pcap_pkthdr *h)
 void pcap_close(pcap_t *p) {
     fclose(p->file);
 }
+
+#define MAGIC_NSEC 0xA1B23C4D
+#define BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define OBSOLETE_PACKET_BLOCK 0x02
+#define SIMPLE_PACKET_BLOCK 0x03
+#define OPTION_END 0
+#define OPTION_IF_NAME 2
+#define OPTION_IF_TSRESOL 9
+#define OPTION_IF_TSOFFSET 14
+#define WRITE_BUFFER_SIZE (1024 * 1024)
+
+static inline unsigned int swap32(unsigned int v)
+{
+    return ((v & 0xFF) << 24) | ((v & 0xFF00) << 8) | ((v >> 8) & 0xFF00) | (v >> 24);
+}
+
+PcapReader::PcapReader()
+{
+    base = nullptr;
+    length = 0;
+    pos = 0;
+    ng = false;
+    swapped = false;
+    nanoseconds = false;
+    firstLinkType = -1;
+    sectionBase = 0;
+}
+
+PcapReader::~PcapReader()
+{
+    close();
+}
+
+void PcapReader::close()
+{
+    file.close(); //also drops the mapping
+    fallback.clear();
+    base = nullptr;
+    length = 0;
+    interfaces.clear();
+    firstLinkType = -1;
+}
+
+unsigned int PcapReader::rd16(const unsigned char *p) const
+{
+    unsigned short v;
+    memcpy(&v, p, sizeof(v));
+    return swapped ? static_cast<unsigned short>((v >> 8) | (v << 8)) : v;
+}
+
+unsigned int PcapReader::rd32(const unsigned char *p) const
+{
+    unsigned int v;
+    memcpy(&v, p, sizeof(v));
+    return swapped ? swap32(v) : v;
+}
+
+bool PcapReader::open(const QString &filename)
+{
+    close();
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    length = file.size();
+    if (length < PCAP_FILE_HEADER_LENGTH)
+    {
+        close();
+        return false;
+    }
+    base = file.map(0, length);
+    if (!base)
+    {
+        fallback = file.readAll();
+        base = reinterpret_cast<const unsigned char *>(fallback.constData());
+        length = fallback.length();
+    }
+    return readFileHeader();
+}
+
+bool PcapReader::open(const QByteArray &contents)
+{
+    close();
+    fallback = contents;
+    base = reinterpret_cast<const unsigned char *>(fallback.constData());
+    length = fallback.length();
+    if (length < PCAP_FILE_HEADER_LENGTH)
+    {
+        close();
+        return false;
+    }
+    return readFileHeader();
+}
+
+bool PcapReader::readFileHeader()
+{
+    unsigned int magic;
+    memcpy(&magic, base, sizeof(magic));
+    if (magic == MAGIC_NG)
+    {
+        ng = true;
+        pos = 0;
+        if (!readSectionHeader(base))
+        {
+            close();
+            return false;
+        }
+        firstLinkType = findFirstLinkType();
+        rewind();
+        return true;
+    }
+
+    ng = false;
+    swapped = (swap32(magic) == MACIG || swap32(magic) == MAGIC_NSEC);
+    if (swapped) magic = swap32(magic);
+    if (magic != MACIG && magic != MAGIC_NSEC)
+    {
+        close();
+        return false;
+    }
+    nanoseconds = (magic == MAGIC_NSEC);
+    rewind();
+    firstLinkType = interfaces.at(0).linkType;
+    return true;
+}
+
+void PcapReader::rewind()
+{
+    interfaces.clear();
+    sectionBase = 0;
+    if (ng)
+    {
+        pos = 0; //the section header is read again on the way through
+        return;
+    }
+    //classic pcap has exactly one interface, described by the file header. The upper bits of the
+    //link type field carry FCS information
+    Interface iface;
+    iface.linkType = static_cast<int>(rd32(base + PCAP_FILE_HEADER_LENGTH - 4) & 0xFFFF);
+    iface.resolution = nanoseconds ? 9 : 6;
+    iface.offset = 0;
+    interfaces.append(iface);
+    pos = PCAP_FILE_HEADER_LENGTH;
+}
+
+bool PcapReader::readSectionHeader(const unsigned char *block)
+{
+    if ((block - base) + 28 > length) return false;
+    unsigned int byteOrder;
+    memcpy(&byteOrder, block + 8, sizeof(byteOrder));
+    if (byteOrder == BYTE_ORDER_MAGIC) swapped = false;
+    else if (swap32(byteOrder) == BYTE_ORDER_MAGIC) swapped = true;
+    else return false;
+    sectionBase = interfaces.count(); //interface ids start over in every section
+    return true;
+}
+
+void PcapReader::readInterface(const unsigned char *block, unsigned int blockLen)
+{
+    Interface iface;
+    iface.linkType = (blockLen >= 20) ? static_cast<int>(rd16(block + 8)) : -1;
+    iface.resolution = 6;
+    iface.offset = 0;
+
+    unsigned int opt = 16;
+    while (opt + 4 <= blockLen - 4)
+    {
+        unsigned int code = rd16(block + opt);
+        unsigned int optLen = rd16(block + opt + 2);
+        if (code == OPTION_END || opt + 4 + optLen > blockLen - 4) break;
+        if (code == OPTION_IF_TSRESOL && optLen >= 1) iface.resolution = block[opt + 4];
+        if (code == OPTION_IF_TSOFFSET && optLen >= 8)
+        {
+            unsigned long long lo = rd32(block + opt + 4);
+            unsigned long long hi = rd32(block + opt + 8);
+            iface.offset = static_cast<long long>(swapped ? ((lo << 32) | hi) : ((hi << 32) | lo));
+        }
+        opt += 4 + ((optLen + 3) & ~3u);
+    }
+    interfaces.append(iface);
+}
+
+int PcapReader::findFirstLinkType()
+{
+    while (pos + 12 <= length)
+    {
+        const unsigned char *block = base + pos;
+        unsigned int type = rd32(block);
+        unsigned int blockLen = rd32(block + 4);
+        if (blockLen < 12 || (blockLen & 3) || pos + blockLen > length) break;
+        if (type == INTERFACE_DESCRITION_BLOCK)
+        {
+            readInterface(block, blockLen);
+            return interfaces.last().linkType;
+        }
+        pos += blockLen;
+    }
+    return -1;
+}
+
+long long PcapReader::toNanoseconds(const Interface &iface, unsigned long long ticks) const
+{
+    long long ns;
+    if (iface.resolution & 0x80)
+    {
+        unsigned int shift = iface.resolution & 0x7F;
+        if (shift == 0) ns = static_cast<long long>(ticks * 1000000000ull);
+        else if (shift >= 64) ns = 0;
+        else
+        {
+            unsigned long long frac = ticks & ((1ull << shift) - 1);
+            ns = static_cast<long long>((ticks >> shift) * 1000000000ull) + static_cast<long long>(ldexp(static_cast<double>(frac), -static_cast<int>(shift)) * 1e9);
+        }
+    }
+    else
+    {
+        unsigned long long scale = 1;
+        if (iface.resolution <= 9)
+        {
+            for (unsigned int i = iface.resolution; i < 9; i++) scale *= 10;
+            ns = static_cast<long long>(ticks * scale);
+        }
+        else
+        {
+            for (unsigned int i = 9; i < iface.resolution && i < 28; i++) scale *= 10;
+            ns = static_cast<long long>(ticks / scale);
+        }
+    }
+    return ns + (iface.offset * 1000000000ll);
+}
+
+bool PcapReader::next(pcap_packet &packet)
+{
+    if (!base) return false;
+    return ng ? nextNG(packet) : nextClassic(packet);
+}
+
+bool PcapReader::nextClassic(pcap_packet &packet)
+{
+    if (pos + PCAP_FRAME_HEADER_LENGTH > length) return false;
+    const unsigned char *rec = base + pos;
+    unsigned int caplen = rd32(rec + PCAP_CAP_FRAME_LENGTH_OFFSET);
+    if (pos + PCAP_FRAME_HEADER_LENGTH + caplen > length) return false; //cut off mid packet
+
+    unsigned long long seconds = rd32(rec);
+    unsigned long long fraction = rd32(rec + 4);
+    packet.data = rec + PCAP_FRAME_HEADER_LENGTH;
+    packet.caplen = caplen;
+    packet.len = rd32(rec + PCAP_FRAME_LENGTH_OFFSET);
+    packet.timestamp = static_cast<long long>((seconds * 1000000000ull) + (nanoseconds ? fraction : fraction * 1000));
+    packet.interface_id = 0;
+    packet.link_type = interfaces.at(0).linkType;
+    pos += PCAP_FRAME_HEADER_LENGTH + caplen;
+    return true;
+}
+
+bool PcapReader::nextNG(pcap_packet &packet)
+{
+    while (pos + 12 <= length)
+    {
+        const unsigned char *block = base + pos;
+        unsigned int rawType;
+        memcpy(&rawType, block, sizeof(rawType));
+        if (rawType == MAGIC_NG && !readSectionHeader(block)) return false;
+
+        unsigned int type = rd32(block);
+        unsigned int blockLen = rd32(block + 4);
+        if (blockLen < 12 || (blockLen & 3) || pos + blockLen > length) return false;
+        pos += blockLen;
+
+        unsigned int localId;
+        unsigned int dataOffset;
+        switch (type)
+        {
+        case INTERFACE_DESCRITION_BLOCK:
+            readInterface(block, blockLen);
+            continue;
+        case ENCHANCED_PACKET_BLOCK:
+            if (blockLen < 32) continue;
+            localId = rd32(block + 8);
+            dataOffset = 28;
+            break;
+        case OBSOLETE_PACKET_BLOCK:
+            if (blockLen < 32) continue;
+            localId = rd16(block + 8);
+            dataOffset = 28;
+            break;
+        case SIMPLE_PACKET_BLOCK:
+        {
+            //no interface id and no time stamp, always the first interface of the section
+            if (blockLen < 16 || sectionBase >= interfaces.count()) continue;
+            unsigned int len = rd32(block + 8);
+            packet.data = block + 12;
+            packet.len = len;
+            packet.caplen = (len < blockLen - 16) ? len : blockLen - 16;
+            packet.timestamp = 0;
+            packet.interface_id = sectionBase;
+            packet.link_type = interfaces.at(sectionBase).linkType;
+            return true;
+        }
+        default:
+            continue;
+        }
+
+        int id = sectionBase + static_cast<int>(localId);
+        unsigned int caplen = rd32(block + 20);
+        if (id >= interfaces.count() || dataOffset + caplen > blockLen - 4) continue;
+        unsigned long long ticks = (static_cast<unsigned long long>(rd32(block + 12)) << 32) | rd32(block + 16);
+        packet.data = block + dataOffset;
+        packet.caplen = caplen;
+        packet.len = rd32(block + 24);
+        packet.timestamp = toNanoseconds(interfaces.at(id), ticks);
+        packet.interface_id = id;
+        packet.link_type = interfaces.at(id).linkType;
+        return true;
+    }
+    return false;
+}
+
+static void appendLE32(QByteArray &out, unsigned int v)
+{
+    char bytes[4] = {static_cast<char>(v), static_cast<char>(v >> 8), static_cast<char>(v >> 16), static_cast<char>(v >> 24)};
+    out.append(bytes, 4);
+}
+
+static void appendLE16(QByteArray &out, unsigned int v)
+{
+    char bytes[2] = {static_cast<char>(v), static_cast<char>(v >> 8)};
+    out.append(bytes, 2);
+}
+
+PcapNgWriter::PcapNgWriter()
+{
+    numInterfaces = 0;
+    ok = false;
+}
+
+PcapNgWriter::~PcapNgWriter()
+{
+    close();
+}
+
+bool PcapNgWriter::open(const QString &filename)
+{
+    file.setFileName(filename);
+    ok = file.open(QIODevice::WriteOnly);
+    if (!ok) return false;
+    numInterfaces = 0;
+    buffer.reserve(WRITE_BUFFER_SIZE + 4096);
+    appendSectionHeader(buffer);
+    return true;
+}
+
+int PcapNgWriter::addInterface(int linkType, const QString &name, unsigned int snapLen)
+{
+    appendInterfaceBlock(buffer, linkType, name, snapLen);
+    return numInterfaces++;
+}
+
+void PcapNgWriter::writePacket(int interfaceId, long long timestamp, const unsigned char *data, unsigned int len)
+{
+    if (!ok) return;
+    appendPacketBlock(buffer, interfaceId, timestamp, data, len);
+    if (buffer.length() >= WRITE_BUFFER_SIZE) flush();
+}
+
+void PcapNgWriter::appendSectionHeader(QByteArray &out)
+{
+    QByteArray body;
+    appendLE32(body, BYTE_ORDER_MAGIC);
+    appendLE16(body, 1); //version 1.0
+    appendLE16(body, 0);
+    appendLE32(body, 0xFFFFFFFF); //section length not given
+    appendLE32(body, 0xFFFFFFFF);
+    appendBlock(out, MAGIC_NG, body);
+}
+
+void PcapNgWriter::appendInterfaceBlock(QByteArray &out, int linkType, const QString &name, unsigned int snapLen)
+{
+    QByteArray body;
+    appendLE16(body, static_cast<unsigned int>(linkType));
+    appendLE16(body, 0);
+    appendLE32(body, snapLen);
+    if (!name.isEmpty())
+    {
+        QByteArray utf = name.toUtf8();
+        appendLE16(body, OPTION_IF_NAME);
+        appendLE16(body, static_cast<unsigned int>(utf.length()));
+        body.append(utf);
+        while (body.length() & 3) body.append('\0');
+    }
+    appendLE16(body, OPTION_IF_TSRESOL);
+    appendLE16(body, 1);
+    body.append(static_cast<char>(6)); //microseconds, spelled out for readers that don't assume it
+    body.append(QByteArray(3, '\0'));
+    appendLE16(body, OPTION_END);
+    appendLE16(body, 0);
+    appendBlock(out, INTERFACE_DESCRITION_BLOCK, body);
+}
+
+void PcapNgWriter::appendPacketBlock(QByteArray &out, int interfaceId, long long timestamp, const unsigned char *data, unsigned int len)
+{
+    unsigned int padded = (len + 3) & ~3u;
+    unsigned int blockLen = 32 + padded;
+    unsigned long long ts = static_cast<unsigned long long>(timestamp);
+
+    appendLE32(out, ENCHANCED_PACKET_BLOCK);
+    appendLE32(out, blockLen);
+    appendLE32(out, static_cast<unsigned int>(interfaceId));
+    appendLE32(out, static_cast<unsigned int>(ts >> 32));
+    appendLE32(out, static_cast<unsigned int>(ts));
+    appendLE32(out, len);
+    appendLE32(out, len);
+    out.append(reinterpret_cast<const char *>(data), static_cast<int>(len));
+    for (unsigned int i = len; i < padded; i++) out.append('\0');
+    appendLE32(out, blockLen);
+}
+
+void PcapNgWriter::appendBlock(QByteArray &out, unsigned int type, const QByteArray &body)
+{
+    unsigned int blockLen = 12 + static_cast<unsigned int>(body.length());
+    appendLE32(out, type);
+    appendLE32(out, blockLen);
+    out.append(body);
+    appendLE32(out, blockLen);
+}
+
+void PcapNgWriter::flush()
+{
+    if (buffer.isEmpty() || !ok) return;
+    if (file.write(buffer) != buffer.length()) ok = false;
+    buffer.resize(0);
+}
+
+bool PcapNgWriter::close()
+{
+    if (!file.isOpen()) return ok;
+    flush();
+    file.close();
+    return ok;
+}
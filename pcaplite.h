@@ -2,6 +2,10 @@
 #define PCAPLITE_H
 
 #include <stdio.h>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
 #if defined(unix) || defined __APPLE__
 #include <sys/time.h>
 #else
@@ -31,4 +35,103 @@ const unsigned char *pcap_next(pcap_t *, struct pcap_pkthdr *);
 
 void pcap_close(pcap_t *);
 
+/*
+ * Memory mapped reader for both pcap and pcapng. Blocks are walked right where they sit in the
+ * file, nothing is copied and next() hands back a pointer into the mapping, so reading a capture
+ * costs little more than paging it in.
+ *
+ * Handles either byte order, microsecond and nanosecond classic pcap, multiple pcapng sections
+ * and interfaces (each with its own link type, if_tsresol and if_tsoffset) and the enhanced,
+ * simple and obsolete packet blocks. Interfaces are numbered across the whole file in the order
+ * they are described, which is what callers use as the bus number.
+ */
+struct pcap_packet
+{
+    const unsigned char *data; //into the mapped file, good until the reader is closed
+    unsigned int caplen;
+    unsigned int len;
+    long long timestamp; //nanoseconds since the epoch
+    int interface_id;
+    int link_type;
+};
+
+class PcapReader
+{
+public:
+    PcapReader();
+    ~PcapReader();
+
+    bool open(const QString &filename);
+    bool open(const QByteArray &contents); //reads from memory, e.g. just the start of a file to check what it is
+    void close();
+    bool isNG() const { return ng; }
+    int linkType() const { return firstLinkType; } //of the first interface, -1 if the file describes none
+    int interfaceCount() const { return interfaces.count(); }
+    int interfaceLinkType(int id) const { return interfaces.at(id).linkType; }
+
+    bool next(pcap_packet &packet); //false at the end of the file or at the first damaged block
+    void rewind();
+
+private:
+    struct Interface
+    {
+        int linkType;
+        unsigned int resolution; //if_tsresol as written in the file
+        long long offset;        //if_tsoffset in seconds
+    };
+
+    unsigned int rd16(const unsigned char *p) const;
+    unsigned int rd32(const unsigned char *p) const;
+    long long toNanoseconds(const Interface &iface, unsigned long long ticks) const;
+    bool nextClassic(pcap_packet &packet);
+    bool nextNG(pcap_packet &packet);
+    bool readSectionHeader(const unsigned char *block);
+    void readInterface(const unsigned char *block, unsigned int blockLen);
+    bool readFileHeader();
+    int findFirstLinkType();
+
+    QFile file;
+    QByteArray fallback; //file contents if it can't be mapped
+    const unsigned char *base;
+    long long length;
+    long long pos;
+    bool ng;
+    bool swapped;
+    bool nanoseconds; //classic pcap only
+    int firstLinkType;
+    int sectionBase; //interface number the current pcapng section starts at
+    QVector<Interface> interfaces;
+};
+
+/*
+ * pcapng writer. Blocks are assembled in memory and go to disk in large writes. Interfaces can
+ * be added at any point, a packet may use any interface added before it.
+ */
+class PcapNgWriter
+{
+public:
+    PcapNgWriter();
+    ~PcapNgWriter();
+
+    bool open(const QString &filename); //writes the section header
+    int addInterface(int linkType, const QString &name, unsigned int snapLen = 0); //returns the interface id
+    //timestamp in microseconds, the pcapng default resolution
+    void writePacket(int interfaceId, long long timestamp, const unsigned char *data, unsigned int len);
+    bool close(); //false if anything failed to write
+
+    //the blocks the writer is made of, for callers that put the file together themselves
+    static void appendSectionHeader(QByteArray &out);
+    static void appendInterfaceBlock(QByteArray &out, int linkType, const QString &name, unsigned int snapLen = 0);
+    static void appendPacketBlock(QByteArray &out, int interfaceId, long long timestamp, const unsigned char *data, unsigned int len);
+
+private:
+    static void appendBlock(QByteArray &out, unsigned int type, const QByteArray &body);
+    void flush();
+
+    QFile file;
+    QByteArray buffer;
+    int numInterfaces;
+    bool ok;
+};
+
 #endif// PCAPLITE_H
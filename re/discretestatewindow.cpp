@@ -3,7 +3,7 @@
 #include "mainwindow.h"
 #include "helpwindow.h"
 
-DiscreteStateWindow::DiscreteStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+DiscreteStateWindow::DiscreteStateWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::DiscreteStateWindow)
 {
@@ -123,7 +123,6 @@ void DiscreteStateWindow::typeChanged()
 
 void DiscreteStateWindow::updatedFrames(int numFrames)
 {
-    CANFrame thisFrame;
     if (numFrames == -1) //all frames deleted. Kill the display
     {
         ui->listID->clear();
@@ -138,12 +137,12 @@ void DiscreteStateWindow::updatedFrames(int numFrames)
         if (numFrames > modelFrames->count()) return;
         for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
         {
-            thisFrame = modelFrames->at(i);
+            int id = modelFrames->frameIdAt(i);
 
-            if (!idFilters.contains(thisFrame.frameId()))
+            if (!idFilters.contains(id))
             {
-                idFilters.insert(thisFrame.frameId(), true);
-                QListWidgetItem* listItem = new QListWidgetItem(Utility::formatCANID(thisFrame.frameId(), thisFrame.hasExtendedFrameFormat()), ui->listID);
+                idFilters.insert(id, true);
+                QListWidgetItem* listItem = new QListWidgetItem(Utility::formatCANID(id, modelFrames->recordAt(i).extended), ui->listID);
                 listItem->setFlags(listItem->flags() | Qt::ItemIsUserCheckable); // set checkable flag
                 listItem->setCheckState(Qt::Checked); //default all filters to be set active
             }
@@ -163,12 +162,11 @@ void DiscreteStateWindow::refreshFilterList()
 
     for (int i = 0; i < modelFrames->length(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = thisFrame.frameId();
+        id = modelFrames->frameIdAt(i);
         if (!idFilters.contains(id))
         {
             idFilters.insert(id, true);
-            QListWidgetItem* listItem = new QListWidgetItem(Utility::formatCANID(id, thisFrame.hasExtendedFrameFormat()), ui->listID);
+            QListWidgetItem* listItem = new QListWidgetItem(Utility::formatCANID(id, modelFrames->recordAt(i).extended), ui->listID);
             listItem->setFlags(listItem->flags() | Qt::ItemIsUserCheckable); // set checkable flag
             listItem->setCheckState(Qt::Checked); //default all filters to be set active
         }
@@ -359,7 +357,7 @@ void DiscreteStateWindow::calculateResults()
                 frameCache.clear();
                 for (int i = 0; i < modelFrames->count(); i++)
                 {
-                    if (modelFrames->at(i).frameId() == (unsigned int)it.key()) frameCache.append(modelFrames->at(i));
+                    if (modelFrames->frameIdAt(i) == (unsigned int)it.key()) frameCache.append(modelFrames->at(i));
                 }
                 for (int bits = maxBits; bits >= minBits; bits--)
                 {
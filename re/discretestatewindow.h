@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QTimer>
 #include "can_structs.h"
+#include "canframestore.h"
 
 namespace Ui {
 class DiscreteStateWindow;
@@ -26,7 +27,7 @@ class DiscreteStateWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit DiscreteStateWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit DiscreteStateWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~DiscreteStateWindow();
     void showEvent(QShowEvent*);
 
@@ -38,7 +39,7 @@ private slots:
 
 private:
     Ui::DiscreteStateWindow *ui;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     QList< QVector<CANFrame> *> stateFrames;
     QTimer *timer;
     DiscreteWindowState operatingState;
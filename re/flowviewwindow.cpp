@@ -9,7 +9,7 @@ const QColor FlowViewWindow::graphColors[8] = {Qt::blue, Qt::green, Qt::black, Q
                                                Qt::gray, Qt::darkYellow, Qt::cyan, Qt::darkMagenta}; //4 5 6 7
 
 
-FlowViewWindow::FlowViewWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+FlowViewWindow::FlowViewWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FlowViewWindow)
 {
@@ -483,7 +483,8 @@ void FlowViewWindow::updatedFrames(int numFrames)
         bool needRefresh = false;
         for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
         {
-            thisFrame = &modelFrames->at(i);
+            CANFrame frameCopy = modelFrames->at(i);
+            thisFrame = &frameCopy;
             data = reinterpret_cast<const unsigned char *>(thisFrame->payload().constData());
             dataLen = thisFrame->payload().length();
 
@@ -610,8 +611,7 @@ void FlowViewWindow::refreshIDList()
     int id;
     for (int i = 0; i < modelFrames->count(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = thisFrame.frameId();
+        id = modelFrames->frameIdAt(i);
         if (!foundID.contains(id))
         {
             foundID.append(id);
@@ -641,9 +641,9 @@ void FlowViewWindow::changeID(QString newID)
     int maxBytes = 0;
     for (int x = 0; x < modelFrames->count(); x++)
     {
-        CANFrame thisFrame = modelFrames->at(x);
-        if (thisFrame.frameId() == id)
+        if (modelFrames->frameIdAt(x) == id)
         {
+            CANFrame thisFrame = modelFrames->at(x);
             thisFrame.payload().clear();
             frameCache.append(thisFrame);
             if (thisFrame.payload().length() > maxBytes) maxBytes = thisFrame.payload().length();
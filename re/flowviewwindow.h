@@ -6,6 +6,7 @@
 #include <QSlider>
 #include "qcustomplot.h"
 #include "can_structs.h"
+#include "canframestore.h"
 
 namespace Ui {
 class FlowViewWindow;
@@ -16,7 +17,7 @@ class FlowViewWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit FlowViewWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit FlowViewWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~FlowViewWindow();
     void showEvent(QShowEvent*);
 
@@ -50,7 +51,7 @@ private:
     Ui::FlowViewWindow *ui;
     QList<quint32> foundID;
     QList<CANFrame> frameCache;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     unsigned char refBytes[64];
     unsigned char currBytes[64];
     int triggerValues[8];
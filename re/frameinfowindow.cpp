@@ -13,7 +13,7 @@ QPen FrameInfoWindow::bytePens[8];
 
 const int numIntervalHistBars = 20;
 
-FrameInfoWindow::FrameInfoWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+FrameInfoWindow::FrameInfoWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FrameInfoWindow)
 {
@@ -338,15 +338,14 @@ void FrameInfoWindow::updatedFrames(int numFrames)
         bool thisID = false;
         for (int x = modelFrames->count() - numFrames; x < modelFrames->count(); x++)
         {
-            CANFrame thisFrame = modelFrames->at(x);
-            int32_t id = static_cast<int32_t>(thisFrame.frameId());
+            int32_t id = static_cast<int32_t>(modelFrames->frameIdAt(x));
             if (!foundID.contains(id))
             {
                 foundID.append(id);
                 FilterUtility::createFilterItem(id, ui->listFrameID);
             }
 
-            if (currID == modelFrames->at(x).frameId())
+            if (currID == modelFrames->frameIdAt(x))
             {
                 thisID = true;
                 break;
@@ -409,8 +408,7 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         frameCache.clear();
         for (int i = 0; i < modelFrames->count(); i++)
         {
-            CANFrame thisFrame = modelFrames->at(i);
-            if (thisFrame.frameId() == static_cast<uint32_t>(targettedID)) frameCache.append(thisFrame);
+            if (modelFrames->frameIdAt(i) == static_cast<uint32_t>(targettedID)) frameCache.append(modelFrames->at(i));
         }
 
         if (frameCache.count() == 0) return; //nothing to do if there are no frames!
@@ -844,8 +842,7 @@ void FrameInfoWindow::refreshIDList()
     int id;
     for (int i = 0; i < modelFrames->count(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = (int)thisFrame.frameId();
+        id = (int)modelFrames->frameIdAt(i);
         if (!foundID.contains(id))
         {
             foundID.append(id);
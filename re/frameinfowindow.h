@@ -7,6 +7,7 @@
 #include <QTreeWidget>
 #include <candatagrid.h>
 #include "can_structs.h"
+#include "canframestore.h"
 #include "bus_protocols/j1939_handler.h"
 #include "dbc/dbchandler.h"
 
@@ -21,7 +22,7 @@ class FrameInfoWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit FrameInfoWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit FrameInfoWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~FrameInfoWindow();
     void showEvent(QShowEvent*);
 
@@ -41,7 +42,7 @@ private:
 
     QList<int> foundID;
     QList<CANFrame> frameCache;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     bool useOpenGL;
     bool useHexTicker;
     static const QColor byteGraphColors[8];
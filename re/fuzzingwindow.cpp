@@ -8,7 +8,7 @@
 #include "connections/canconmanager.h"
 #include "filterutility.h"
 
-FuzzingWindow::FuzzingWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+FuzzingWindow::FuzzingWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FuzzingWindow)
 {
@@ -107,7 +107,7 @@ void FuzzingWindow::updatedFrames(int numFrames)
         if (numFrames > modelFrames->count()) return;
         for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
         {
-            id = modelFrames->at(i).frameId();
+            id = modelFrames->frameIdAt(i);
             if (!foundIDs.contains(id))
             {
                 foundIDs.append(id);
@@ -421,8 +421,7 @@ void FuzzingWindow::refreshIDList()
     int id;
     for (int i = 0; i < modelFrames->count(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = thisFrame.frameId();
+        id = modelFrames->frameIdAt(i);
         if (!foundIDs.contains(id))
         {
             foundIDs.append(id);
@@ -9,7 +9,7 @@
 #include <algorithm>
 #include <limits>
 
-GraphingWindow::GraphingWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+GraphingWindow::GraphingWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::GraphingWindow)
 {
@@ -220,9 +220,9 @@ void GraphingWindow::updatedFrames(int numFrames)
             y.clear();
             for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
             {
-                thisFrame = modelFrames->at(i);
-                if ( graphParams[j].ID == thisFrame.frameId() && ( (graphParams[j].bus == -1) || (graphParams[j].bus == thisFrame.bus) ) )
+                if ( graphParams[j].ID == modelFrames->frameIdAt(i) && ( (graphParams[j].bus == -1) || (graphParams[j].bus == modelFrames->busAt(i)) ) )
                 {
+                    thisFrame = modelFrames->at(i);
                     appendToGraph(graphParams[j], thisFrame, x, y);
                     appendedToGraph = true;
                 }
@@ -1341,9 +1341,10 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     frameCache.clear();
     for (int i = 0; i < modelFrames->count(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        if ( (thisFrame.frameId() == params.ID) && (thisFrame.frameType() == QCanBusFrame::DataFrame)
-       &&  ( ( params.bus == -1) ||  (params.bus == thisFrame.bus) ) ) frameCache.append(thisFrame);
+        //filter on the packed record and only unpack the frames that are actually graphed
+        const PackedCANFrame &rec = modelFrames->recordAt(i);
+        if ( (rec.frameId == params.ID) && (rec.frameType == QCanBusFrame::DataFrame)
+       &&  ( ( params.bus == -1) ||  (params.bus == static_cast<int>(rec.bus)) ) ) frameCache.append(modelFrames->at(i));
     }
 
     //to fix weirdness where a graph that has no data won't be able to be edited, selected, or deleted properly
@@ -1380,7 +1381,8 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
         if (params.associatedSignal)
         {
             //skip all the rest of the stuff in this loop and don't add this to the graph if this signal isn't in this frame
-            if (!params.associatedSignal->isSignalInMessage(frameCache[k]))
+            DBC_SIGNAL_VALUE sigVal;
+            if (!params.associatedSignal->parentMessage->decodeSignal(frameCache[k], params.associatedSignal, sigVal))
             {
                 qDebug() << "Signal was not in this frame";
                 continue;
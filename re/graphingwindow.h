@@ -3,6 +3,7 @@
 
 #include "qcustomplot.h"
 #include "can_structs.h"
+#include "canframestore.h"
 #include "dbc/dbchandler.h"
 
 #include <QDialog>
@@ -51,7 +52,7 @@ class GraphingWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit GraphingWindow(const QVector<CANFrame> *, QWidget *parent = 0);
+    explicit GraphingWindow(const CANFrameStore *, QWidget *parent = 0);
     ~GraphingWindow();
     void showEvent(QShowEvent*);
 
@@ -95,7 +96,7 @@ private:
     Ui::GraphingWindow *ui;
     DBCHandler *dbcHandler;
     QList<CANFrame> frameCache;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     QList<GraphParams> graphParams;
     QPen selectedPen;
     QCPSelectionDecorator *selDecorator;
@@ -2,6 +2,7 @@
 #define ISOTP_INTERPRETERWINDOW_H
 
 #include <QDialog>
+#include "canframestore.h"
 #include "bus_protocols/isotp_handler.h"
 
 class ISOTP_MESSAGE;
@@ -16,7 +17,7 @@ class ISOTP_InterpreterWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit ISOTP_InterpreterWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit ISOTP_InterpreterWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~ISOTP_InterpreterWindow();
     void showEvent(QShowEvent*);
 
@@ -39,7 +40,7 @@ private:
     ISOTP_HANDLER *decoder;
     UDS_HANDLER *udsDecoder;
 
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     QVector<ISOTP_MESSAGE> messages;
     QHash<int, bool> idFilters;
 
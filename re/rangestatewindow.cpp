@@ -5,7 +5,7 @@
 #include "helpwindow.h"
 #include "filterutility.h"
 
-RangeStateWindow::RangeStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+RangeStateWindow::RangeStateWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::RangeStateWindow)
 {
@@ -143,7 +143,6 @@ void RangeStateWindow::writeSettings()
 
 void RangeStateWindow::updatedFrames(int numFrames)
 {
-    CANFrame thisFrame;
     if (numFrames == -1) //all frames deleted. We don't need to do a thing on this window but erase everything in the filters section
     {
         ui->listFilter->clear();
@@ -158,11 +157,11 @@ void RangeStateWindow::updatedFrames(int numFrames)
         if (numFrames > modelFrames->count()) return;
         for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
         {
-            thisFrame = modelFrames->at(i);
-            if (!idFilters.contains(thisFrame.frameId()))
+            int id = modelFrames->frameIdAt(i);
+            if (!idFilters.contains(id))
             {
-                idFilters.insert(thisFrame.frameId(), true);
-                FilterUtility::createCheckableFilterItem(thisFrame.frameId(), true, ui->listFilter);
+                idFilters.insert(id, true);
+                FilterUtility::createCheckableFilterItem(id, true, ui->listFilter);
             }
         }
     }
@@ -177,7 +176,7 @@ void RangeStateWindow::refreshFilterList()
 
     for (int i = 0; i < modelFrames->length(); i++)
     {
-        id = modelFrames->at(i).frameId();
+        id = modelFrames->frameIdAt(i);
         if (!idFilters.contains(id))
         {
             idFilters.insert(id, true);
@@ -218,7 +217,7 @@ void RangeStateWindow::recalcButton()
             id = iter.key();
             for (int j = 0; j < modelFrames->count(); j++)
             {
-                if (modelFrames->at(j).frameId() == id) frameCache.append(modelFrames->at(j));
+                if (modelFrames->frameIdAt(j) == id) frameCache.append(modelFrames->at(j));
             }
             //now we've got a list with all the same ID. Time to send it off for processing
             signalsFactory();
@@ -469,7 +468,7 @@ void RangeStateWindow::clickedSignalList(int idx)
 
     for (int j = 0; j < modelFrames->count(); j++)
     {
-        if (modelFrames->at(j).frameId() == id) frameCache.append(modelFrames->at(j));
+        if (modelFrames->frameIdAt(j) == id) frameCache.append(modelFrames->at(j));
     }
 
     int numFrames = frameCache.count();
@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QMap>
 #include "can_structs.h"
+#include "canframestore.h"
 
 namespace Ui {
 class RangeStateWindow;
@@ -14,7 +15,7 @@ class RangeStateWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit RangeStateWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit RangeStateWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~RangeStateWindow();
     void showEvent(QShowEvent*);
 
@@ -25,7 +26,7 @@ private slots:
 
 private:
     Ui::RangeStateWindow *ui;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     QVector<CANFrame> frameCache;
     QList<int64_t> foundSignals;
     QMap<int, bool> idFilters;
@@ -13,7 +13,7 @@ QString HexTicker::getTickLabel (double tick, const QLocale& locale, QChar forma
     return "0x" + QString::number(valu, 16).toUpper().rightJustified(3,'0');
 }
 
-TemporalGraphWindow::TemporalGraphWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+TemporalGraphWindow::TemporalGraphWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::TemporalGraphWindow)
 {
@@ -142,8 +142,8 @@ void TemporalGraphWindow::updatedFrames(int numFrames)
             y.clear();
             for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
             {
-                thisFrame = modelFrames->at(i);
                 /*
+                thisFrame = modelFrames->at(i);
                 if (graphParams[j].ID == thisFrame.ID)
                 {
                     appendToGraph(graphParams[j], thisFrame, x, y);
@@ -196,13 +196,13 @@ void TemporalGraphWindow::generateGraph()
     x.reserve(frameCount);
     y.reserve(frameCount);
 
-    xminval = xmaxval = modelFrames->at(0).timeStamp().microSeconds() / 1000000.0;
-    yminval = ymaxval = modelFrames->at(0).frameId();
+    xminval = xmaxval = modelFrames->timeStampAt(0) / 1000000.0;
+    yminval = ymaxval = modelFrames->frameIdAt(0);
 
     for (int i = 0; i < frameCount; i++)
     {
-        x.append(modelFrames->at(i).timeStamp().microSeconds() / 1000000.0);
-        y.append(modelFrames->at(i).frameId());
+        x.append(modelFrames->timeStampAt(i) / 1000000.0);
+        y.append(modelFrames->frameIdAt(i));
         if (x[i] > xmaxval) xmaxval = x[i];
         if (x[i] < xminval) xminval = x[i];
         if (y[i] > ymaxval) ymaxval = y[i];
@@ -246,8 +246,8 @@ void TemporalGraphWindow::generateGraph()
 
     for (int i = 0; i < frameCount; i++)
     {
-        int x = static_cast<int>(((modelFrames->at(i).timeStamp().microSeconds() / 1000000.0) - xminval) * 4.0);
-        int y = static_cast<int>(modelFrames->at(i).frameId() - yminval) / 30;
+        int x = static_cast<int>(((modelFrames->timeStampAt(i) / 1000000.0) - xminval) * 4.0);
+        int y = static_cast<int>(modelFrames->frameIdAt(i) - yminval) / 30;
         double val = colorMap->data()->cell(x, y);
         double inc;
         inc = 1 / (val + 1); //logarithmic decay
@@ -23,7 +23,7 @@ static QVector<QString> SCANTYPE_NAMES = {
     QString("Custom UDS"),
 };
 
-UDSScanWindow::UDSScanWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+UDSScanWindow::UDSScanWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::UDSScanWindow)
 {
@@ -250,6 +250,11 @@ void CANScriptHelper::sendFrame(QJSValue bus, QJSValue id, QJSValue length, QJSV
     CANConManager::getInstance()->sendFrame(frame);
 }
 
+void CANScriptHelper::gotTargettedFrames(const QVector<CANFrame> &frames)
+{
+    foreach (const CANFrame &frame, frames) gotTargettedFrame(frame);
+}
+
 void CANScriptHelper::gotTargettedFrame(const CANFrame &frame)
 {
     if (!gotFrameFunction.isCallable()) return; //nothing to do if we can't even call the function
@@ -27,6 +27,7 @@ public slots:
     void setRxCallback(QJSValue cb);
 
 private slots:
+    void gotTargettedFrames(const QVector<CANFrame> &frames);
     void gotTargettedFrame(const CANFrame &frame);
 
 private:
@@ -11,7 +11,7 @@
 #include "connections/canconmanager.h"
 #include "helpwindow.h"
 
-ScriptingWindow::ScriptingWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+ScriptingWindow::ScriptingWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::ScriptingWindow)
 {
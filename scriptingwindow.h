@@ -3,6 +3,7 @@
 
 #include "scriptcontainer.h"
 #include "can_structs.h"
+#include "canframestore.h"
 #include "connections/canconnection.h"
 #include "jsedit.h"
 
@@ -20,7 +21,7 @@ class ScriptingWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit ScriptingWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit ScriptingWindow(const CANFrameStore *frames, QWidget *parent = 0);
     void showEvent(QShowEvent*);
     ~ScriptingWindow();
 
@@ -58,7 +59,7 @@ private:
     JSEdit *editor;
     QList<ScriptContainer *> scripts;
     ScriptContainer *currentScript;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
     QElapsedTimer elapsedTime;
     QTimer valuesTimer;
 };
@@ -0,0 +1,107 @@
+#include "signalexportdialog.h"
+#include "ui_signalexportdialog.h"
+#include <QMessageBox>
+#include <QSettings>
+#include "dbc/dbchandler.h"
+#include "utility.h"
+
+SignalExportDialog::SignalExportDialog(DBCHandler *handler, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::SignalExportDialog)
+{
+    ui->setupUi(this);
+
+    QSettings settings;
+    ui->spinPeriod->setValue(settings.value("SignalExport/PeriodMS", 10.0).toDouble());
+    ui->cbJoinMode->addItem(tr("Last value (sample and hold)"));
+    ui->cbJoinMode->addItem(tr("Nearest value within half a period"));
+    ui->cbJoinMode->setCurrentIndex(settings.value("SignalExport/JoinMode", 0).toInt() == 1 ? 1 : 0);
+
+    fillTree(handler);
+
+    connect(ui->btnAll, &QPushButton::clicked, this, [this]() { setAllChecked(true); });
+    connect(ui->btnNone, &QPushButton::clicked, this, [this]() { setAllChecked(false); });
+    connect(ui->btnExport, &QPushButton::clicked, this, &SignalExportDialog::handleExport);
+    connect(ui->btnCancel, &QPushButton::clicked, this, &QDialog::reject);
+}
+
+SignalExportDialog::~SignalExportDialog()
+{
+    delete ui;
+}
+
+int64_t SignalExportDialog::getPeriod() const
+{
+    return qMax(static_cast<int64_t>(ui->spinPeriod->value() * 1000.0), static_cast<int64_t>(1));
+}
+
+SignalExporter::JoinMode SignalExportDialog::getJoinMode() const
+{
+    return ui->cbJoinMode->currentIndex() == 1 ? SignalExporter::JOIN_NEAREST : SignalExporter::JOIN_HOLD;
+}
+
+//one branch per message, string signals are left out since they have no number to put in a column
+void SignalExportDialog::fillTree(DBCHandler *handler)
+{
+    ui->treeSignals->clear();
+    candidates.clear();
+    for (int f = 0; f < handler->getFileCount(); f++)
+    {
+        DBCFile *file = handler->getFileByIdx(f);
+        for (int m = 0; m < file->messageHandler->getCount(); m++)
+        {
+            DBC_MESSAGE *msg = file->messageHandler->findMsgByIdx(m);
+            QTreeWidgetItem *msgItem = new QTreeWidgetItem(ui->treeSignals);
+            msgItem->setText(0, msg->name + " (" + Utility::formatCANID(msg->ID) + ")");
+            msgItem->setFlags(msgItem->flags() | Qt::ItemIsUserCheckable | Qt::ItemIsAutoTristate);
+            msgItem->setCheckState(0, Qt::Unchecked);
+
+            for (int s = 0; s < msg->sigHandler->getCount(); s++)
+            {
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+                if (sig->valType == STRING) continue;
+                QTreeWidgetItem *sigItem = new QTreeWidgetItem(msgItem);
+                sigItem->setText(0, sig->name);
+                sigItem->setText(1, sig->unitName);
+                sigItem->setFlags(sigItem->flags() | Qt::ItemIsUserCheckable);
+                sigItem->setCheckState(0, Qt::Unchecked);
+                sigItem->setData(0, Qt::UserRole, candidates.count());
+                candidates.append(qMakePair(msg, sig));
+            }
+            if (msgItem->childCount() == 0) delete msgItem;
+        }
+    }
+}
+
+void SignalExportDialog::setAllChecked(bool checked)
+{
+    for (int i = 0; i < ui->treeSignals->topLevelItemCount(); i++)
+    {
+        ui->treeSignals->topLevelItem(i)->setCheckState(0, checked ? Qt::Checked : Qt::Unchecked);
+    }
+}
+
+void SignalExportDialog::handleExport()
+{
+    chosen.clear();
+    for (int i = 0; i < ui->treeSignals->topLevelItemCount(); i++)
+    {
+        QTreeWidgetItem *msgItem = ui->treeSignals->topLevelItem(i);
+        for (int c = 0; c < msgItem->childCount(); c++)
+        {
+            QTreeWidgetItem *sigItem = msgItem->child(c);
+            if (sigItem->checkState(0) == Qt::Checked) chosen.append(candidates.at(sigItem->data(0, Qt::UserRole).toInt()));
+        }
+    }
+
+    if (chosen.isEmpty())
+    {
+        QMessageBox::warning(this, windowTitle(), tr("Pick at least one signal to export."));
+        return;
+    }
+
+    QSettings settings;
+    settings.setValue("SignalExport/PeriodMS", ui->spinPeriod->value());
+    settings.setValue("SignalExport/JoinMode", ui->cbJoinMode->currentIndex());
+    accept();
+}
@@ -0,0 +1,38 @@
+#ifndef SIGNALEXPORTDIALOG_H
+#define SIGNALEXPORTDIALOG_H
+
+#include <QDialog>
+#include <QPair>
+#include <QVector>
+#include "utils/signalexporter.h"
+
+namespace Ui {
+class SignalExportDialog;
+}
+
+class DBCHandler;
+
+//picks the signals, the row period and how samples land on rows for a SignalExporter
+class SignalExportDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SignalExportDialog(DBCHandler *handler, QWidget *parent = nullptr);
+    ~SignalExportDialog();
+
+    QVector<QPair<DBC_MESSAGE *, DBC_SIGNAL *>> getSignals() const { return chosen; }
+    int64_t getPeriod() const; //microseconds
+    SignalExporter::JoinMode getJoinMode() const;
+
+private:
+    Ui::SignalExportDialog *ui;
+    QVector<QPair<DBC_MESSAGE *, DBC_SIGNAL *>> candidates; //every signal in the tree, the items hold their index
+    QVector<QPair<DBC_MESSAGE *, DBC_SIGNAL *>> chosen;
+
+    void fillTree(DBCHandler *handler);
+    void setAllChecked(bool checked);
+    void handleExport();
+};
+
+#endif // SIGNALEXPORTDIALOG_H
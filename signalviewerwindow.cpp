@@ -8,7 +8,7 @@
 #define MSG_COL     1
 #define VALUE_COL   2
 
-SignalViewerWindow::SignalViewerWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+SignalViewerWindow::SignalViewerWindow(const CANFrameStore *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::SignalViewerWindow)
 {
@@ -98,18 +98,18 @@ void SignalViewerWindow::processFrame(CANFrame &frame)
         if (!sig) return;
         if (sig->parentMessage->ID == frame.frameId())
         {
-            if (sig->isSignalInMessage(frame)) //filter out multiplexed signals that aren't in this message.
+            //false for multiplexed signals that aren't in this message or signals that can't be interpreted
+            DBC_SIGNAL_VALUE val;
+            if (sig->parentMessage->decodeSignal(frame, sig, val))
             {
-                if (sig->processAsText(frame, sigString, false)) //if true we could interpret the signal so update it in the list
+                sigString = val.text(false);
+                QTableWidgetItem *item = ui->tableViewer->item(i, VALUE_COL);
+                if (!item)
                 {
-                    QTableWidgetItem *item = ui->tableViewer->item(i, VALUE_COL);
-                    if (!item)
-                    {
-                        item = new QTableWidgetItem(sigString);
-                        ui->tableViewer->setItem(i, VALUE_COL, item);
-                    }
-                    else item->setText(sigString);
+                    item = new QTableWidgetItem(sigString);
+                    ui->tableViewer->setItem(i, VALUE_COL, item);
                 }
+                else item->setText(sigString);
             }
         }
     }
@@ -2,6 +2,7 @@
 #define SIGNALVIEWERWINDOW_H
 
 #include <QDialog>
+#include "canframestore.h"
 #include "dbc/dbchandler.h"
 
 namespace Ui {
@@ -13,7 +14,7 @@ class SignalViewerWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit SignalViewerWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit SignalViewerWindow(const CANFrameStore *frames, QWidget *parent = 0);
     ~SignalViewerWindow();
 
 private slots:
@@ -39,7 +40,7 @@ private:
     DBC_MESSAGE *currentlySelectedMsg;
 
     QList<DBC_SIGNAL *> signalList;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameStore *modelFrames;
 
     void processFrame(CANFrame &frame);
 };
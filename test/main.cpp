@@ -2,6 +2,19 @@
 
 #include "tst_lfqueue.h"
 #include "tst_cancon.h"
+#include "tst_signalextract.h"
+#include "tst_textloader.h"
+#include "tst_nativebinary.h"
+#include "tst_blf.h"
+#include "tst_pcap.h"
+#include "tst_export.h"
+#include "tst_capturepager.h"
+#include "tst_merge.h"
+#include "tst_signalexport.h"
+#include "tst_parallelsort.h"
+#include "tst_canframestore.h"
+#include "tst_gvret.h"
+#include "tst_conmanager.h"
 
 
 int main(int argc, char** argv)
@@ -15,7 +28,20 @@ int main(int argc, char** argv)
    };
 
    ASSERT_TEST(new TestLFQueue());
-   ASSERT_TEST(new TestCanCon(CANCon::SOCKETCAN, "vcan0", 1));
+   ASSERT_TEST(new TestSignalExtract());
+   ASSERT_TEST(new TestTextLoader());
+   ASSERT_TEST(new TestNativeBinary());
+   ASSERT_TEST(new TestBLF());
+   ASSERT_TEST(new TestPcap());
+   ASSERT_TEST(new TestExport());
+   ASSERT_TEST(new TestCapturePager());
+   ASSERT_TEST(new TestMerge());
+   ASSERT_TEST(new TestSignalExport());
+   ASSERT_TEST(new TestParallelSort());
+   ASSERT_TEST(new TestCANFrameStore());
+   ASSERT_TEST(new TestGVRET());
+   ASSERT_TEST(new TestConManager());
+   ASSERT_TEST(new TestCanCon(CANCon::SERIALBUS, "vcan0", "socketcan", 1));
 
    return status;
 }
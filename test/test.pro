@@ -1,4 +1,4 @@
-QT += core gui serialbus widgets testlib serialbus
+QT += core gui serialbus serialport network widgets testlib concurrent
 
 
 CONFIG += c++11
@@ -9,11 +9,61 @@ SOURCES += \
     tst_lfqueue.cpp \
     main.cpp \
     tst_cancon.cpp \
+    tst_signalextract.cpp \
+    tst_textloader.cpp \
+    tst_nativebinary.cpp \
+    tst_blf.cpp \
+    tst_pcap.cpp \
+    tst_export.cpp \
+    tst_capturepager.cpp \
+    tst_merge.cpp \
+    tst_signalexport.cpp \
+    tst_parallelsort.cpp \
+    tst_canframestore.cpp \
+    tst_gvret.cpp \
+    tst_conmanager.cpp \
     ../connections/canconfactory.cpp \
     ../connections/canconnection.cpp \
+    ../connections/canconmanager.cpp \
     ../connections/gvretserial.cpp \
-    ../connections/socketcan.cpp \
-    ../canbus.cpp
+    ../connections/canbus.cpp \
+    ../connections/canlogserver.cpp \
+    ../connections/canserver.cpp \
+    ../connections/lawicel_serial.cpp \
+    ../connections/mqtt_bus.cpp \
+    ../connections/serialbusconnection.cpp \
+    ../connections/socketcand.cpp \
+    ../mqtt/qmqtt_client.cpp \
+    ../mqtt/qmqtt_client_p.cpp \
+    ../mqtt/qmqtt_frame.cpp \
+    ../mqtt/qmqtt_message.cpp \
+    ../mqtt/qmqtt_network.cpp \
+    ../mqtt/qmqtt_router.cpp \
+    ../mqtt/qmqtt_routesubscription.cpp \
+    ../mqtt/qmqtt_socket.cpp \
+    ../mqtt/qmqtt_ssl_socket.cpp \
+    ../mqtt/qmqtt_timer.cpp \
+    ../mqtt/qmqtt_websocket.cpp \
+    ../mqtt/qmqtt_websocketiodevice.cpp \
+    ../simplecrypt.cpp \
+    ../framefileio.cpp \
+    ../canframestore.cpp \
+    ../canframemodel.cpp \
+    ../can_structs.cpp \
+    ../utility.cpp \
+    ../pcaplite.cpp \
+    ../blfhandler.cpp \
+    ../nativebinaryfile.cpp \
+    ../utils/chunkedtextloader.cpp \
+    ../utils/filesniff.cpp \
+    ../utils/frameexporter.cpp \
+    ../utils/capturepager.cpp \
+    ../utils/capturemerger.cpp \
+    ../utils/parquetwriter.cpp \
+    ../utils/signalexporter.cpp \
+    ../dbc/dbchandler.cpp \
+    ../dbc/dbc_classes.cpp \
+    ../continuouslogwriter.cpp
 
 
 #HEADERS += \
@@ -25,9 +75,52 @@ INSTALLS += target
 HEADERS += \
     tst_lfqueue.h \
     tst_cancon.h \
+    tst_signalextract.h \
+    tst_textloader.h \
+    tst_nativebinary.h \
+    tst_blf.h \
+    tst_pcap.h \
+    tst_export.h \
+    tst_capturepager.h \
+    tst_merge.h \
+    tst_signalexport.h \
+    tst_parallelsort.h \
+    tst_canframestore.h \
+    tst_gvret.h \
+    tst_conmanager.h \
     ../connections/canconconst.h \
     ../connections/canconfactory.h \
     ../connections/canconnection.h \
+    ../connections/canconmanager.h \
     ../connections/gvretserial.h \
-    ../connections/socketcan.h \
-    ../canbus.h
+    ../connections/canbus.h \
+    ../connections/canlogserver.h \
+    ../connections/canserver.h \
+    ../connections/lawicel_serial.h \
+    ../connections/mqtt_bus.h \
+    ../connections/serialbusconnection.h \
+    ../connections/socketcand.h \
+    ../mqtt/qmqtt.h \
+    ../mqtt/qmqtt_client.h \
+    ../mqtt/qmqtt_client_p.h \
+    ../mqtt/qmqtt_frame.h \
+    ../mqtt/qmqtt_global.h \
+    ../mqtt/qmqtt_message.h \
+    ../mqtt/qmqtt_message_p.h \
+    ../mqtt/qmqtt_network_p.h \
+    ../mqtt/qmqtt_networkinterface.h \
+    ../mqtt/qmqtt_routedmessage.h \
+    ../mqtt/qmqtt_router.h \
+    ../mqtt/qmqtt_routesubscription.h \
+    ../mqtt/qmqtt_socket_p.h \
+    ../mqtt/qmqtt_socketinterface.h \
+    ../mqtt/qmqtt_ssl_socket_p.h \
+    ../mqtt/qmqtt_timer_p.h \
+    ../mqtt/qmqtt_timerinterface.h \
+    ../mqtt/qmqtt_websocket_p.h \
+    ../mqtt/qmqtt_websocketiodevice_p.h \
+    ../simplecrypt.h \
+    ../framefileio.h \
+    ../canframemodel.h \
+    ../dbc/dbchandler.h \
+    ../continuouslogwriter.h
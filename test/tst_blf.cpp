@@ -0,0 +1,200 @@
+#include <QtTest>
+#include <QtEndian>
+
+#include "blfhandler.h"
+#include "framefileio.h"
+#include "tst_blf.h"
+
+
+static void appendLE(QByteArray &out, quint64 val, int bytes)
+{
+    for (int i = 0; i < bytes; i++) out.append(static_cast<char>((val >> (i * 8)) & 0xFF));
+}
+
+static void appendObjectHeader(QByteArray &out, quint32 objSize, quint32 objType)
+{
+    appendLE(out, 0x4A424F4C, 4); //LOBJ
+    appendLE(out, 32, 2);
+    appendLE(out, 1, 2);
+    appendLE(out, objSize, 4);
+    appendLE(out, objType, 4);
+}
+
+//classic, CAN_MSG2 and CAN-FD objects with the odd comment mixed in, stamped in nanoseconds
+void TestBLF::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+    savedWindow = BLFHandler::containersPerWindow;
+
+    quint32 seed = 0xB1F0u;
+    for (int i = 0; i < 20000; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        bool extended = (seed >> 16) & 1;
+        quint32 id = extended ? ((seed >> 3) & 0x1FFFFFFF) : ((seed >> 5) & 0x7FF);
+        int type = (i % 7 == 0) ? BLF_CAN_FD_MSG : ((i & 1) ? BLF_CAN_MSG2 : BLF_CAN_MSG);
+        int len = (type == BLF_CAN_FD_MSG) ? 12 + (i % 53) : static_cast<int>((seed >> 8) % 9);
+        bool remote = (type != BLF_CAN_FD_MSG) && (i % 101 == 0);
+        QByteArray data(len, 0);
+        for (int d = 0; d < len && !remote; d++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            data[d] = static_cast<char>(seed >> 16);
+        }
+        quint64 stampNs = 5000000000ull + (i * 123456ull);
+
+        CANFrame frame;
+        frame.setFrameId(id);
+        frame.setExtendedFrameFormat(extended);
+        frame.bus = i % 3;
+        frame.isReceived = true;
+        frame.setFrameType(remote ? QCanBusFrame::RemoteRequestFrame : QCanBusFrame::DataFrame);
+        frame.setPayload(data);
+        if (type == BLF_CAN_FD_MSG)
+        {
+            frame.setFlexibleDataRateFormat(true);
+            frame.setBitrateSwitch(i & 2);
+        }
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, static_cast<qint64>(stampNs / 1000)));
+        expected.append(frame);
+
+        QByteArray body;
+        appendLE(body, static_cast<quint64>(frame.bus), 2);
+        body.append(static_cast<char>(remote ? 0x80 : 0));
+        if (type == BLF_CAN_FD_MSG)
+        {
+            body.append(static_cast<char>(0)); //dlc code, unused by the loader
+            appendLE(body, id | (extended ? 0x80000000u : 0), 4);
+            appendLE(body, 0, 4);
+            body.append(static_cast<char>(0));
+            body.append(static_cast<char>(1 | ((i & 2) ? 2 : 0)));
+            body.append(static_cast<char>(len));
+            body.append(QByteArray(5, 0));
+            body.append(data);
+            body.append(QByteArray(64 - len, 0));
+        }
+        else
+        {
+            body.append(static_cast<char>(len));
+            appendLE(body, id | (extended ? 0x80000000u : 0), 4);
+            body.append(data);
+            body.append(QByteArray(8 - len, 0));
+            if (type == BLF_CAN_MSG2) body.append(QByteArray(8, 0));
+        }
+
+        appendObjectHeader(objects, static_cast<quint32>(32 + body.count()), static_cast<quint32>(type));
+        appendLE(objects, 2, 4); //flags, nanosecond stamps
+        appendLE(objects, 0, 4);
+        appendLE(objects, stampNs, 8);
+        objects.append(body);
+        while (objects.count() % 4) objects.append('\0');
+
+        if (i % 500 == 250)
+        {
+            QByteArray text("marker");
+            appendObjectHeader(objects, static_cast<quint32>(32 + text.count()), BLF_EVENT_COMMENT);
+            appendLE(objects, 2, 4);
+            appendLE(objects, 0, 4);
+            appendLE(objects, stampNs, 8);
+            objects.append(text);
+            while (objects.count() % 4) objects.append('\0');
+        }
+    }
+}
+
+void TestBLF::cleanupTestCase()
+{
+    BLFHandler::containersPerWindow = savedWindow;
+}
+
+//cut the object stream into containers of containerBytes, so objects land across container boundaries
+QString TestBLF::writeFile(const QString &name, int containerBytes, bool compress)
+{
+    QByteArray file;
+    appendLE(file, 0x47474F4C, 4); //LOGG
+    appendLE(file, sizeof(BLF_FILE_HEADER), 4);
+    file.append(QByteArray(sizeof(BLF_FILE_HEADER) - 8, 0));
+
+    for (int pos = 0, n = 0; pos < objects.count(); pos += containerBytes, n++)
+    {
+        QByteArray plain = objects.mid(pos, containerBytes);
+        bool zlib = compress && (n % 5 != 4); //the odd stored container too
+        QByteArray payload = zlib ? qCompress(plain).mid(4) : plain;
+        quint32 objSize = static_cast<quint32>(32 + payload.count());
+        appendObjectHeader(file, objSize, BLF_CONTAINER);
+        appendLE(file, zlib ? BLF_CONT_ZLIB_COMPRESSION : BLF_CONT_NO_COMPRESSION, 2);
+        file.append(QByteArray(6, 0));
+        appendLE(file, static_cast<quint64>(plain.count()), 4);
+        file.append(QByteArray(4, 0));
+        file.append(payload);
+        file.append(QByteArray(static_cast<int>(objSize % 4), 0));
+    }
+
+    QString filename = tempDir.filePath(name);
+    QFile out(filename);
+    if (!out.open(QIODevice::WriteOnly)) return QString();
+    out.write(file);
+    return filename;
+}
+
+void TestBLF::loadsAllFrames_data()
+{
+    QTest::addColumn<int>("containerBytes");
+    QTest::addColumn<bool>("compress");
+    QTest::addColumn<int>("window");
+
+    QTest::newRow("zlib, small window") << 1000 << true << 2;
+    QTest::newRow("zlib, default window") << 131072 << true << 0;
+    QTest::newRow("stored, odd size") << 4099 << false << 3;
+    QTest::newRow("one container") << 1 << true << 0; //replaced by the whole stream below
+}
+
+void TestBLF::loadsAllFrames()
+{
+    QFETCH(int, containerBytes);
+    QFETCH(bool, compress);
+    QFETCH(int, window);
+    if (containerBytes == 1) containerBytes = objects.count();
+
+    QString filename = writeFile(QString("frames_%1.blf").arg(containerBytes), containerBytes, compress);
+    QVERIFY(!filename.isEmpty());
+    QVERIFY(FrameFileIO::isCanalyzerBLF(filename));
+
+    BLFHandler::containersPerWindow = window;
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::loadCanalyzerBLF(filename, &loaded));
+    QCOMPARE(loaded.count(), expected.count());
+    for (int i = 0; i < loaded.count(); i++)
+    {
+        const CANFrame &got = loaded.at(i);
+        const CANFrame &want = expected.at(i);
+        QCOMPARE(got.frameId(), want.frameId());
+        QCOMPARE(got.hasExtendedFrameFormat(), want.hasExtendedFrameFormat());
+        QCOMPARE(got.frameType(), want.frameType());
+        QCOMPARE(got.hasFlexibleDataRateFormat(), want.hasFlexibleDataRateFormat());
+        QCOMPARE(got.hasBitrateSwitch(), want.hasBitrateSwitch());
+        QCOMPARE(got.bus, want.bus);
+        QCOMPARE(got.payload(), want.payload());
+        QCOMPARE(got.timeStamp().microSeconds(), want.timeStamp().microSeconds());
+    }
+}
+
+//a trace cut off mid write still gives back everything in the complete containers
+void TestBLF::truncatedFile()
+{
+    QString filename = writeFile("truncated.blf", 2048, true);
+    QVERIFY(!filename.isEmpty());
+    QFile file(filename);
+    QVERIFY(file.resize(file.size() - 700));
+
+    BLFHandler::containersPerWindow = 0;
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::loadCanalyzerBLF(filename, &loaded));
+    QVERIFY(loaded.count() > 0);
+    QVERIFY(loaded.count() < expected.count());
+    for (int i = 0; i < loaded.count(); i += 17)
+    {
+        QCOMPARE(loaded.at(i).frameId(), expected.at(i).frameId());
+        QCOMPARE(loaded.at(i).payload(), expected.at(i).payload());
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef TST_BLF_H
+#define TST_BLF_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include "can_structs.h"
+
+class TestBLF: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir tempDir;
+    QVector<CANFrame> expected;
+    QByteArray objects; //every frame as BLF objects back to back, before it's cut into containers
+    int savedWindow;
+
+    QString writeFile(const QString &name, int containerBytes, bool compress);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void loadsAllFrames_data();
+    void loadsAllFrames();
+    void truncatedFile();
+};
+
+#endif // TST_BLF_H
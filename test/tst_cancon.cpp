@@ -18,15 +18,17 @@ do {\
         return false;\
 } while (0)
 
-Q_DECLARE_METATYPE(QVector<CANFlt>);
-
-
-
-TestCanCon::TestCanCon(CANCon::type pType, QString pPortName, int pNbBus):
+TestCanCon::TestCanCon(CANCon::type pType, QString pPortName, QString pDriverName, int pNbBus):
     mType(pType),
     mPortName(pPortName),
+    mDriverName(pDriverName),
     mNbBus(pNbBus){}
 
+void TestCanCon::gotTargettedFrames(const QVector<CANFrame> &frames)
+{
+    mTargetted += frames;
+}
+
 void TestCanCon::create()
 {
     CANConnection* conn_p;
@@ -43,7 +45,7 @@ void TestCanCon::connectToDevice()
     CANConnection* conn_p;
     QVERIFY(pCreate(conn_p));
 
-    QSignalSpy spy(conn_p, SIGNAL(status(CANCon::status)));
+    QSignalSpy spy(conn_p, SIGNAL(status(CANConStatus)));
 
     /* start connection */
     conn_p->start();
@@ -54,9 +56,7 @@ void TestCanCon::connectToDevice()
 
 
     QCOMPARE(spy.count(), 1); // make sure the signal was emitted exactly one time
-    QList<QVariant> arguments = spy.takeFirst(); // take the first signal
-
-    QVERIFY(arguments.at(0).toInt() == CANCon::CONNECTED); // verify the first argument
+    QCOMPARE(conn_p->getStatus(), CANCon::CONNECTED);
 
     /* stop connection */
     conn_p->stop();
@@ -161,8 +161,8 @@ void TestCanCon::filter_data()
         CANFrame* canf_p = queue.peek();
         QVERIFY(pValidateFrame(conn_p, canf_p));
 
-        if(!ids.contains(canf_p->ID))
-            ids.append(canf_p->ID);
+        if(!ids.contains(canf_p->frameId()))
+            ids.append(canf_p->frameId());
 
         queue.dequeue();
     }
@@ -175,44 +175,25 @@ void TestCanCon::filter_data()
 
     /* prepare test vector */
 
-    QTest::addColumn<QVector<CANFlt>>("filters");
-    QTest::addColumn<bool>("filterOut");
-    QTest::addColumn<bool>("signalReceived");
     QTest::addColumn<QVector<quint32>>("filtered");
 
-    QVector<CANFlt> filters;
     QVector<quint32> filteredIds;
 
-    /* one filter no signal*/
-    filters.clear();
+    /* one filter */
     filteredIds.clear();
-    filters.append({ids[0], 0xFFFF, false});
     filteredIds.append(ids[0]);
-    QTest::newRow("1filternosignal")        << filters << false << false << filteredIds;
-
-    /* one filter & signal*/
-    filters.clear();
-    filteredIds.clear();
-    filters.append({ids[0], 0xFFFF, true});
-    filteredIds.append(ids[0]);
-    QTest::newRow("1filtersignal")          << filters << false << true << filteredIds;
+    QTest::newRow("1filter")                << filteredIds;
 
     /* 3 filters */
-    filters.clear();
     filteredIds.clear();
-    foreach(quint32 id, ids) {
-        filters.append({id, 0xFFFF, false});
+    foreach(quint32 id, ids)
         filteredIds.append(id);
-    }
-    QTest::newRow("3filters")               << filters << false << false << filteredIds;
+    QTest::newRow("3filters")               << filteredIds;
 }
 
 
 void TestCanCon::filter()
 {
-    QFETCH(QVector<CANFlt>, filters);
-    QFETCH(bool, filterOut);
-    QFETCH(bool, signalReceived);
     QFETCH(QVector<quint32>, filtered);
 
     CANConnection* conn_p;
@@ -221,37 +202,22 @@ void TestCanCon::filter()
     /* start connection */
     conn_p->start();
 
-    /* set filters */
-    for(int i=0 ; i<conn_p->getNumBuses() ; i++)
-        QVERIFY(conn_p->setFilters(i, filters, filterOut));
-
-    /* spy signal */
-    QSignalSpy spy(conn_p, SIGNAL(notify()));
+    /* target the ids on every bus, matches come back through gotTargettedFrames */
+    mTargetted.clear();
+    foreach(quint32 id, filtered)
+        QVERIFY(conn_p->addTargettedFrame(-1, id, 0x7FF, this));
 
     /* configure */
     QVERIFY(pConfig(conn_p));
 
-    LFQueue<CANFrame>& queue = conn_p->getQueue();
-
     /* wait for frames to arrive */
     QTest::qWait(1000);
 
-    if(signalReceived)
-        QVERIFY(spy.count()>0);
-
-    int i;
-    for(i=0 ; queue.peek() && i<1000 ; i++)
-    {
-        CANFrame* canf_p = queue.peek();
-        QVERIFY(pValidateFrame(conn_p, canf_p));
-
-        if(filterOut)
-            QVERIFY(filtered.contains(canf_p->ID));
-
-        queue.dequeue();
-    }
+    QVERIFY(mTargetted.count() > 0);
+    foreach(const CANFrame &frame, mTargetted)
+        QVERIFY(filtered.contains(frame.frameId()));
 
-    QVERIFY(i>0);
+    QVERIFY(conn_p->removeAllTargettedFrames(this));
 
     conn_p->stop();
     delete conn_p;
@@ -273,34 +239,28 @@ void TestCanCon::write()
     /* build frames */
     CANFrame frame;
     frame.bus       = 0;
-    frame.ID        = 0x1DE;
-    frame.data[0]   = 0xDE;
-    frame.data[1]   = 0xAD;
-    frame.data[2]   = 0xC0;
-    frame.data[3]   = 0xDE;
-    frame.len       = 4;
+    frame.setFrameId(0x1DE);
+    frame.setPayload(QByteArray::fromHex("DEADC0DE"));
 
     frames.append(frame);
 
-    frame.data[2]   = 0xBE;
-    frame.data[3]   = 0xEF;
+    frame.setPayload(QByteArray::fromHex("DEADBEEF"));
     frames.append(frame);
 
-    frame.data[2]   = 0xDE;
-    frame.data[3]   = 0xAD;
+    frame.setPayload(QByteArray::fromHex("DEADDEAD"));
 
 
-    /* bad frame length */
-    unsigned int oldVal = frame.len;
-    frame.len = 9;
+    /* bad frame length, longer than even an FD frame can carry */
+    QByteArray oldPayload = frame.payload();
+    frame.setPayload(QByteArray(65, 0));
     QCOMPARE(conn_p->sendFrame(frame), false);
-    frame.len       = oldVal;
+    frame.setPayload(oldPayload);
 
     /* bad bus id */
-    oldVal = frame.bus;
+    int oldBus = frame.bus;
     frame.bus = 48;
     QCOMPARE(conn_p->sendFrame(frame), false);
-    frame.bus       = oldVal;
+    frame.bus       = oldBus;
 
     qDebug() << "Sending DE AD DE AD";
     /* send */
@@ -326,7 +286,7 @@ void TestCanCon::write()
 
 bool TestCanCon::pCreate(CANConnection*& pConn_p)
 {
-    pConn_p = CanConFactory::create(mType, mPortName);
+    pConn_p = CanConFactory::create(mType, mPortName, mDriverName, 0, 0, false, 0);
     QVERIFYB(pConn_p);
 
     QCOMPAREB(pConn_p->getPort(),     mPortName);
@@ -345,7 +305,7 @@ bool TestCanCon::pConfig(CANConnection* pConn_p)
     for(int i=0 ; i<pConn_p->getNumBuses() ; i++)
     {
         /* TODO: fix configuration */
-        bus.active = true;
+        bus.setActive(true);
         pConn_p->setBusSettings(i, bus);
         QVERIFYB(pConn_p->getBusSettings(i, retBus));
         QCOMPAREB(bus, retBus);
@@ -359,8 +319,8 @@ bool TestCanCon::pValidateFrame(CANConnection* pConn_p, CANFrame* pCan_p)
     QVERIFYB( pCan_p );
     QVERIFYB( (0<=pCan_p->bus) && (pCan_p->bus <= pConn_p->getNumBuses()) );
     QVERIFYB( pCan_p->isReceived);
-    QVERIFYB( pCan_p->len<=8 );
-    QVERIFYB( (0<=pCan_p->ID) && (pCan_p->ID<2048) );
+    QVERIFYB( pCan_p->payload().length()<=8 );
+    QVERIFYB( pCan_p->frameId()<2048 );
 
     return true;
 }
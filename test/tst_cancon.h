@@ -9,11 +9,17 @@ class TestCanCon: public QObject
 {
     Q_OBJECT
 public:
-    TestCanCon(CANCon::type, QString pPortName, int pNbBus);
+    TestCanCon(CANCon::type, QString pPortName, QString pDriverName, int pNbBus);
+
+public slots:
+    void gotTargettedFrames(const QVector<CANFrame> &frames);
+
 private:
     CANCon::type mType;
     QString      mPortName;
+    QString      mDriverName;
     int          mNbBus;
+    QVector<CANFrame> mTargetted;
 
 private slots:
     void create();
@@ -0,0 +1,581 @@
+#include <QtTest>
+
+#include "canframestore.h"
+#include "canframemodel.h"
+#include "tst_canframestore.h"
+
+
+static CANFrame makeFrame(uint32_t id, int bus, int64_t stamp, int len)
+{
+    CANFrame frame;
+    frame.setFrameId(id);
+    frame.bus = bus;
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, stamp));
+    QByteArray payload(len, 0);
+    for (int i = 0; i < len; i++) payload[i] = static_cast<char>(id + static_cast<uint32_t>(i));
+    frame.setPayload(payload);
+    return frame;
+}
+
+//every field a CANFrame carries that the store is meant to keep
+static void compareFrames(const CANFrame &actual, const CANFrame &expected)
+{
+    QCOMPARE(actual.frameId(), expected.frameId());
+    QCOMPARE(actual.bus, expected.bus);
+    QCOMPARE(actual.timeStamp().microSeconds(), expected.timeStamp().microSeconds());
+    QCOMPARE(actual.payload(), expected.payload());
+    QCOMPARE(actual.frameType(), expected.frameType());
+    QCOMPARE(actual.hasExtendedFrameFormat(), expected.hasExtendedFrameFormat());
+    QCOMPARE(actual.hasFlexibleDataRateFormat(), expected.hasFlexibleDataRateFormat());
+    QCOMPARE(actual.hasBitrateSwitch(), expected.hasBitrateSwitch());
+    QCOMPARE(actual.hasErrorStateIndicator(), expected.hasErrorStateIndicator());
+    QCOMPARE(actual.hasLocalEcho(), expected.hasLocalEcho());
+    QCOMPARE(actual.isReceived, expected.isReceived);
+    QCOMPARE(actual.timedelta, expected.timedelta);
+    QCOMPARE(actual.frameCount, expected.frameCount);
+}
+
+void TestCANFrameStore::roundTrip()
+{
+    QVector<CANFrame> frames;
+
+    frames.append(makeFrame(0x123, 0, 1000, 8));
+
+    CANFrame ext = makeFrame(0x1ABCDEF0, 3, 5000000123ll, 3);
+    ext.setExtendedFrameFormat(true);
+    ext.isReceived = false;
+    ext.setLocalEcho(true);
+    frames.append(ext);
+
+    CANFrame rtr = makeFrame(0x7FF, 255, 2, 0);
+    rtr.setFrameType(QCanBusFrame::RemoteRequestFrame);
+    frames.append(rtr);
+
+    CANFrame err = makeFrame(0x4, 1, 3, 0);
+    err.setFrameType(QCanBusFrame::ErrorFrame);
+    frames.append(err);
+
+    CANFrame fd = makeFrame(0x55, 2, 4, 12);
+    fd.setFlexibleDataRateFormat(true);
+    fd.setBitrateSwitch(true);
+    fd.setErrorStateIndicator(true);
+    frames.append(fd);
+
+    frames.append(makeFrame(0x66, 2, 5, 64));
+
+    CANFrameStore store(frames);
+    QCOMPARE(store.count(), frames.count());
+    for (int i = 0; i < frames.count(); i++)
+    {
+        compareFrames(store.at(i), frames.at(i));
+        compareFrames(store[i], frames.at(i));
+        QCOMPARE(store.frameIdAt(i), frames.at(i).frameId());
+        QCOMPARE(store.busAt(i), frames.at(i).bus);
+        QCOMPARE(store.timeStampAt(i), static_cast<int64_t>(frames.at(i).timeStamp().microSeconds()));
+        QCOMPARE(store.payloadLengthAt(i), frames.at(i).payload().length());
+        QCOMPARE(QByteArray(reinterpret_cast<const char *>(store.payloadAt(i)), store.payloadLengthAt(i)), frames.at(i).payload());
+    }
+
+    int idx = 0;
+    for (const CANFrame &frame : store) compareFrames(frame, frames.at(idx++));
+    QCOMPARE(idx, frames.count());
+}
+
+void TestCANFrameStore::fdSlab()
+{
+    CANFrameStore store;
+    store.append(makeFrame(1, 0, 1, 8));
+    store.append(makeFrame(2, 0, 2, 64));
+    store.append(makeFrame(3, 0, 3, 9));
+    store.append(makeFrame(4, 0, 4, 0));
+
+    //classic frames keep the payload inline, FD frames point into the slab
+    QVERIFY(store.payloadAt(0) == store.recordAt(0).payload.data);
+    QVERIFY(store.payloadAt(1) != store.recordAt(1).payload.data);
+    QVERIFY(store.payloadAt(2) != store.recordAt(2).payload.data);
+    QVERIFY(store.recordAt(1).payload.slab != store.recordAt(2).payload.slab);
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(4 * sizeof(PackedCANFrame) + 2 * sizeof(CANFDPayloadSlab)));
+
+    //replacing an FD frame with a classic one hands its slab back
+    store.replace(1, makeFrame(5, 0, 5, 2));
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(4 * sizeof(PackedCANFrame) + sizeof(CANFDPayloadSlab)));
+    compareFrames(store.at(1), makeFrame(5, 0, 5, 2));
+    compareFrames(store.at(2), makeFrame(3, 0, 3, 9));
+
+    //and the next FD payload reuses it rather than growing the slab
+    store.replace(3, makeFrame(6, 0, 6, 48));
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(4 * sizeof(PackedCANFrame) + 2 * sizeof(CANFDPayloadSlab)));
+    compareFrames(store.at(2), makeFrame(3, 0, 3, 9));
+    compareFrames(store.at(3), makeFrame(6, 0, 6, 48));
+}
+
+void TestCANFrameStore::overwriteStats()
+{
+    CANFrameStore store;
+    store.append(makeFrame(1, 0, 1, 1));
+    store.append(makeFrame(2, 0, 2, 1));
+    //no frame has used the stats yet so the side array does not exist
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(2 * sizeof(PackedCANFrame)));
+    QCOMPARE(store.frameCountAt(0), 1u);
+
+    CANFrame counted = makeFrame(2, 0, 3, 1);
+    counted.timedelta = 1234;
+    counted.frameCount = 7;
+    store.replace(1, counted);
+    store.append(makeFrame(3, 0, 4, 1));
+
+    QVERIFY(store.bytesUsed() > static_cast<quint64>(3 * sizeof(PackedCANFrame)));
+    QCOMPARE(store.timeDeltaAt(0), static_cast<uint64_t>(0));
+    QCOMPARE(store.frameCountAt(0), 1u);
+    QCOMPARE(store.timeDeltaAt(1), static_cast<uint64_t>(1234));
+    QCOMPARE(store.frameCountAt(1), 7u);
+    QCOMPARE(store.frameCountAt(2), 1u);
+    compareFrames(store.at(1), counted);
+}
+
+void TestCANFrameStore::removeMiddle()
+{
+    CANFrameStore store;
+    QVector<CANFrame> expected;
+    for (int i = 0; i < 20; i++)
+    {
+        CANFrame frame = makeFrame(static_cast<uint32_t>(i), i % 3, i, (i % 4 == 0) ? 20 : 8);
+        store.append(frame);
+        expected.append(frame);
+    }
+
+    store.remove(5, 6);
+    expected.remove(5, 6);
+    store.remove(0, 1);
+    expected.remove(0, 1);
+    store.remove(10, 100); //past the end only removes what is there
+    expected.remove(10, expected.count() - 10);
+
+    QCOMPARE(store.count(), expected.count());
+    for (int i = 0; i < expected.count(); i++) compareFrames(store.at(i), expected.at(i));
+
+    //slabs of removed FD frames are dropped rather than left behind
+    int fdFrames = 0;
+    for (int i = 0; i < expected.count(); i++) if (expected.at(i).payload().length() > 8) fdFrames++;
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(expected.count() * sizeof(PackedCANFrame) + fdFrames * sizeof(CANFDPayloadSlab)));
+
+    store.clear();
+    QVERIFY(store.isEmpty());
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(0));
+}
+
+void TestCANFrameStore::appendFromStore()
+{
+    CANFrameStore source;
+    for (int i = 0; i < 10; i++)
+    {
+        CANFrame frame = makeFrame(static_cast<uint32_t>(i), 1, i * 10, (i & 1) ? 16 : 4);
+        if (i == 4)
+        {
+            frame.timedelta = 99;
+            frame.frameCount = 3;
+        }
+        source.append(frame);
+    }
+
+    CANFrameStore dest;
+    for (int i = 0; i < 10; i += 2) dest.append(source, i);
+    dest.append(source, 3);
+
+    QCOMPARE(dest.count(), 6);
+    for (int i = 0; i < 5; i++) compareFrames(dest.at(i), source.at(i * 2));
+    compareFrames(dest.at(5), source.at(3));
+
+    //the copy owns its own slab
+    source.clear();
+    compareFrames(dest.at(5), makeFrame(3, 1, 30, 16));
+}
+
+void TestCANFrameStore::toVector()
+{
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 100; i++) frames.append(makeFrame(static_cast<uint32_t>(i * 7), i % 4, i * 100, i % 65));
+
+    CANFrameStore store(frames);
+    QVector<CANFrame> out = store.toVector();
+    QCOMPARE(out.count(), frames.count());
+    for (int i = 0; i < frames.count(); i++) compareFrames(out.at(i), frames.at(i));
+
+    QVERIFY(CANFrameStore().toVector().isEmpty());
+}
+
+//measure what a capture actually costs per frame against the QVector<CANFrame> it replaced
+void TestCANFrameStore::bytesPerFrame()
+{
+    const int count = 100000;
+    CANFrameStore store;
+    for (int i = 0; i < count; i++) store.append(makeFrame(static_cast<uint32_t>(i & 0x7FF), 0, i, 8));
+
+    double perFrame = static_cast<double>(store.bytesUsed()) / count;
+    //a CANFrame also owns a heap allocated QByteArray for the payload, which is not counted here
+    double vectorPerFrame = sizeof(CANFrame) + 8;
+    qDebug() << "Classic frames:" << perFrame << "bytes per frame packed," << vectorPerFrame << "or more as CANFrame";
+    QCOMPARE(perFrame, 24.0);
+    QVERIFY(perFrame < vectorPerFrame);
+
+    store.clear();
+    for (int i = 0; i < count; i++) store.append(makeFrame(static_cast<uint32_t>(i & 0x7FF), 0, i, 64));
+    perFrame = static_cast<double>(store.bytesUsed()) / count;
+    qDebug() << "FD frames:" << perFrame << "bytes per frame packed";
+    QCOMPARE(perFrame, 24.0 + 64.0);
+}
+
+//every third frame is FD so the ring also has to juggle slabs
+static CANFrame ringFrame(int n)
+{
+    return makeFrame(static_cast<uint32_t>(n), n % 2, n, (n % 3 == 0) ? 64 : 8);
+}
+
+//the store should hold exactly these frames, oldest first
+static void compareRing(const CANFrameStore &store, const QVector<int> &expected)
+{
+    QCOMPARE(store.count(), expected.count());
+    for (int i = 0; i < expected.count(); i++) compareFrames(store.at(i), ringFrame(expected.at(i)));
+}
+
+void TestCANFrameStore::ringWrap()
+{
+    CANFrameStore store;
+    store.setRingCapacity(5);
+    QCOMPARE(store.ringCapacity(), 5);
+    for (int n = 0; n < 12; n++) store.append(ringFrame(n));
+
+    QCOMPARE(store.capacity(), 5);
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(7));
+    compareRing(store, QVector<int>() << 7 << 8 << 9 << 10 << 11);
+    //evictedCount turns a logical index into the absolute frame number
+    for (int i = 0; i < store.count(); i++) QCOMPARE(store.evictedCount() + i, static_cast<quint64>(store.frameIdAt(i)));
+
+    //replacing a frame in a wrapped ring goes to the right slot
+    store.replace(3, ringFrame(100));
+    compareRing(store, QVector<int>() << 7 << 8 << 9 << 100 << 11);
+}
+
+void TestCANFrameStore::ringRemoveFront()
+{
+    CANFrameStore store;
+    store.setRingCapacity(6);
+    for (int n = 0; n < 9; n++) store.append(ringFrame(n));
+    compareRing(store, QVector<int>() << 3 << 4 << 5 << 6 << 7 << 8);
+
+    //dropping the oldest frames just moves the head and counts them as gone
+    store.remove(0, 2);
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(5));
+    compareRing(store, QVector<int>() << 5 << 6 << 7 << 8);
+
+    //the freed slots get filled before anything else is evicted
+    store.append(ringFrame(9));
+    store.append(ringFrame(10));
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(5));
+    compareRing(store, QVector<int>() << 5 << 6 << 7 << 8 << 9 << 10);
+    store.append(ringFrame(11));
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(6));
+    compareRing(store, QVector<int>() << 6 << 7 << 8 << 9 << 10 << 11);
+
+    store.remove(0, store.count());
+    QVERIFY(store.isEmpty());
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(12));
+    store.append(ringFrame(12));
+    compareRing(store, QVector<int>() << 12);
+
+    //a plain list counts front removals the same way
+    CANFrameStore plain;
+    for (int n = 0; n < 10; n++) plain.append(ringFrame(n));
+    plain.remove(0, 4);
+    plain.remove(2, 1);
+    QCOMPARE(plain.evictedCount(), static_cast<quint64>(4));
+    compareRing(plain, QVector<int>() << 4 << 5 << 7 << 8 << 9);
+    plain.clear();
+    QCOMPARE(plain.evictedCount(), static_cast<quint64>(0));
+}
+
+void TestCANFrameStore::ringLinearize()
+{
+    CANFrameStore store;
+    store.setRingCapacity(5);
+    for (int n = 0; n < 8; n++) store.append(ringFrame(n));
+
+    //removing from the middle of a wrapped ring straightens it out first
+    store.remove(1, 2);
+    compareRing(store, QVector<int>() << 3 << 6 << 7);
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(3));
+
+    //then it grows back up to the capacity before evicting again
+    store.append(ringFrame(8));
+    store.append(ringFrame(9));
+    compareRing(store, QVector<int>() << 3 << 6 << 7 << 8 << 9);
+    store.append(ringFrame(10));
+    compareRing(store, QVector<int>() << 6 << 7 << 8 << 9 << 10);
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(4));
+
+    //a ring that wrapped before it was full has to straighten out before it can grow
+    CANFrameStore partial;
+    partial.setRingCapacity(5);
+    for (int n = 0; n < 3; n++) partial.append(ringFrame(n));
+    partial.remove(0, 1);
+    partial.append(ringFrame(3));
+    partial.append(ringFrame(4));
+    partial.append(ringFrame(5));
+    compareRing(partial, QVector<int>() << 1 << 2 << 3 << 4 << 5);
+
+    //growing a wrapped ring keeps the order, shrinking drops the oldest
+    store.setRingCapacity(8);
+    for (int n = 11; n < 14; n++) store.append(ringFrame(n));
+    compareRing(store, QVector<int>() << 6 << 7 << 8 << 9 << 10 << 11 << 12 << 13);
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(4));
+    store.append(ringFrame(14));
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(5));
+    store.setRingCapacity(3);
+    compareRing(store, QVector<int>() << 12 << 13 << 14);
+    QCOMPARE(store.evictedCount(), static_cast<quint64>(10));
+
+    //and turning the ring off leaves a plain list that grows again
+    store.setRingCapacity(0);
+    store.append(ringFrame(15));
+    store.append(ringFrame(16));
+    compareRing(store, QVector<int>() << 12 << 13 << 14 << 15 << 16);
+}
+
+void TestCANFrameStore::ringSlabReuse()
+{
+    CANFrameStore store;
+    store.setRingCapacity(4);
+    for (int n = 0; n < 4; n++) store.append(makeFrame(static_cast<uint32_t>(n), 0, n, 64));
+    const quint64 full = 4 * sizeof(PackedCANFrame) + 4 * sizeof(CANFDPayloadSlab);
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(full));
+
+    //evicted FD frames hand their slab straight to the frame that replaces them
+    for (int n = 4; n < 40; n++) store.append(makeFrame(static_cast<uint32_t>(n), 0, n, 64));
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(full));
+    for (int i = 0; i < 4; i++) compareFrames(store.at(i), makeFrame(static_cast<uint32_t>(36 + i), 0, 36 + i, 64));
+
+    //classic frames taking over leave the slabs on the free list
+    store.append(makeFrame(40, 0, 40, 8));
+    store.append(makeFrame(41, 0, 41, 8));
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(4 * sizeof(PackedCANFrame) + 2 * sizeof(CANFDPayloadSlab)));
+    store.remove(0, 1);
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(4 * sizeof(PackedCANFrame) + sizeof(CANFDPayloadSlab)));
+
+    //a removal from the middle compacts what is left down to the FD frames still held
+    store.append(makeFrame(42, 0, 42, 20));
+    store.remove(1, 1);
+    compareFrames(store.at(0), makeFrame(39, 0, 39, 64));
+    compareFrames(store.at(1), makeFrame(41, 0, 41, 8));
+    compareFrames(store.at(2), makeFrame(42, 0, 42, 20));
+    QCOMPARE(store.bytesUsed(), static_cast<quint64>(3 * sizeof(PackedCANFrame) + 2 * sizeof(CANFDPayloadSlab)));
+}
+
+//a full ring only makes room for the frames that actually become rows
+void TestCANFrameStore::modelRingKeepsShownRows()
+{
+    CANFrameModel model;
+    model.setCaptureLimits(10, true);
+
+    QVector<CANFrame> batch;
+    for (int n = 0; n < 8; n++) batch.append(makeFrame(1 + (n & 1), 0, n, 8));
+    model.addFrames(nullptr, batch);
+    QCOMPARE(model.sendBulkRefresh(), 8);
+    QCOMPARE(model.rowCount(), 8);
+
+    model.setFilterState(2, false);
+    QCOMPARE(model.rowCount(), 4);
+
+    //ten hidden frames and two shown ones. Only the two shown ones need room
+    batch.clear();
+    for (int n = 8; n < 18; n++) batch.append(makeFrame(2, 0, n, 8));
+    batch.append(makeFrame(1, 0, 18, 8));
+    batch.append(makeFrame(1, 0, 19, 8));
+    model.addFrames(nullptr, batch);
+    //the full list wrapped so only the frames still held are reported as new
+    QCOMPARE(model.sendBulkRefresh(), 10);
+    QCOMPARE(model.rowCount(), 6);
+    const CANFrameStore *filtered = model.getFilteredListReference();
+    QCOMPARE(filtered->timeStampAt(0), static_cast<int64_t>(0));
+    QCOMPARE(filtered->timeStampAt(5), static_cast<int64_t>(19));
+    QCOMPARE(model.getListReference()->count(), 10);
+    QCOMPARE(model.getTrimmedFrames(), static_cast<quint64>(10));
+
+    //once rows do go, the survivors keep their row numbers
+    QCOMPARE(model.headerData(5, Qt::Vertical, Qt::DisplayRole).toString(), QString("6"));
+    batch.clear();
+    for (int n = 20; n < 26; n++) batch.append(makeFrame(1, 0, n, 8));
+    model.addFrames(nullptr, batch);
+    model.sendBulkRefresh();
+    QCOMPARE(model.rowCount(), 10);
+    QCOMPARE(filtered->timeStampAt(0), static_cast<int64_t>(4));
+    QCOMPARE(model.headerData(0, Qt::Vertical, Qt::DisplayRole).toString(), QString("3"));
+    QCOMPARE(model.headerData(3, Qt::Vertical, Qt::DisplayRole).toString(), QString("6"));
+}
+
+//merging files goes through insertFrames a block at a time, a full ring still announces what it drops
+void TestCANFrameStore::modelRingInsertFrames()
+{
+    CANFrameModel model;
+    model.setCaptureLimits(10, true);
+
+    QVector<CANFrame> batch;
+    for (int n = 0; n < 8; n++) batch.append(makeFrame(1, 0, n, 8));
+    model.insertFrames(batch);
+    model.sendBulkRefresh();
+    QCOMPARE(model.rowCount(), 8);
+
+    QSignalSpy removed(&model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)));
+    batch.clear();
+    for (int n = 8; n < 14; n++) batch.append(makeFrame(1, 0, n, 8));
+    model.insertFrames(batch);
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(1).toInt(), 0);
+    QCOMPARE(removed.at(0).at(2).toInt(), 3);
+    QCOMPARE(model.rowCount(), 4);
+
+    model.sendBulkRefresh();
+    QCOMPARE(model.rowCount(), 10);
+    QCOMPARE(model.getFilteredListReference()->timeStampAt(0), static_cast<int64_t>(4));
+    QCOMPARE(model.headerData(0, Qt::Vertical, Qt::DisplayRole).toString(), QString("5"));
+}
+
+//a sorted ring still drops the oldest frames, not whatever sorted to the top, and keeps its numbering
+void TestCANFrameStore::modelRingSortEvictsOldest()
+{
+    CANFrameModel model;
+    model.setCaptureLimits(10, true);
+
+    //IDs count down as the time stamps count up so sorting by ID reverses the rows
+    QVector<CANFrame> batch;
+    for (int n = 0; n < 12; n++) batch.append(makeFrame(static_cast<uint32_t>(100 - n), 0, n, 8));
+    model.addFrames(nullptr, batch);
+    model.sendBulkRefresh();
+    QCOMPARE(model.rowCount(), 10);
+    QCOMPARE(model.headerData(0, Qt::Vertical, Qt::DisplayRole).toString(), QString("3"));
+
+    model.sortByColumn(static_cast<int>(Column::FrameId));
+    const CANFrameStore *filtered = model.getFilteredListReference();
+    QCOMPARE(filtered->timeStampAt(0), static_cast<int64_t>(11));
+    QCOMPARE(filtered->timeStampAt(9), static_cast<int64_t>(2));
+    QCOMPARE(model.headerData(0, Qt::Vertical, Qt::DisplayRole).toString(), QString("3"));
+
+    batch.clear();
+    batch.append(makeFrame(200, 0, 12, 8));
+    model.addFrames(nullptr, batch);
+    model.sendBulkRefresh();
+    QCOMPARE(model.rowCount(), 10);
+    QCOMPARE(filtered->timeStampAt(0), static_cast<int64_t>(11));
+    QCOMPARE(filtered->timeStampAt(8), static_cast<int64_t>(3));
+    QCOMPARE(filtered->timeStampAt(9), static_cast<int64_t>(12));
+    QCOMPARE(filtered->evictedCount(), static_cast<quint64>(3));
+}
+
+//limits apply to a capture that is already running
+void TestCANFrameStore::modelCaptureLimits()
+{
+    CANFrameModel model;
+    model.setCaptureLimits(100, false);
+
+    QVector<CANFrame> batch;
+    for (int n = 0; n < 50; n++) batch.append(makeFrame(static_cast<uint32_t>(n % 5), 0, n, 8));
+    model.addFrames(nullptr, batch);
+    model.sendBulkRefresh();
+    QCOMPARE(model.rowCount(), 50);
+
+    model.setCaptureLimits(20, false);
+    QCOMPARE(model.getListReference()->count(), 20);
+    QCOMPARE(model.rowCount(), 20);
+    QCOMPARE(model.getListReference()->timeStampAt(0), static_cast<int64_t>(30));
+    QCOMPARE(model.getTrimmedFrames(), static_cast<quint64>(30));
+
+    model.setCaptureLimits(10, true);
+    QCOMPARE(model.getListReference()->ringCapacity(), 10);
+    QCOMPARE(model.getFilteredListReference()->ringCapacity(), 10);
+    QCOMPARE(model.rowCount(), 10);
+    QCOMPARE(model.getTrimmedFrames(), static_cast<quint64>(40));
+
+    batch.clear();
+    for (int n = 50; n < 55; n++) batch.append(makeFrame(static_cast<uint32_t>(n % 5), 0, n, 8));
+    model.addFrames(nullptr, batch);
+    model.sendBulkRefresh();
+    QCOMPARE(model.rowCount(), 10);
+    QCOMPARE(model.getFilteredListReference()->timeStampAt(0), static_cast<int64_t>(45));
+
+    model.setCaptureLimits(1000, false);
+    QCOMPARE(model.getListReference()->ringCapacity(), 0);
+    QCOMPARE(model.rowCount(), 10);
+    model.addFrames(nullptr, batch);
+    model.sendBulkRefresh();
+    QCOMPARE(model.rowCount(), 15);
+}
+
+//the memory ceiling counts what FD payloads really take up, not just the 24 byte records
+void TestCANFrameStore::modelMemoryCeiling()
+{
+    const quint64 ceiling = 100 * 1024;
+    const quint64 fdBatchBytes = 100 * 2 * (sizeof(PackedCANFrame) + sizeof(CANFDPayloadSlab));
+    CANFrameModel model;
+    model.setCaptureLimits(1000, false, ceiling);
+
+    for (int b = 0; b < 10; b++)
+    {
+        QVector<CANFrame> batch;
+        for (int n = b * 100; n < (b + 1) * 100; n++) batch.append(makeFrame(static_cast<uint32_t>(n % 7), 0, n, 64));
+        model.addFrames(nullptr, batch);
+        model.sendBulkRefresh();
+        QVERIFY(model.getListReference()->bytesUsed() + model.getFilteredListReference()->bytesUsed() <= ceiling + fdBatchBytes);
+    }
+    //well short of the frame limit, the ceiling did the trimming and kept the newest frames
+    QVERIFY(model.getListReference()->count() < 700);
+    QCOMPARE(model.getListReference()->timeStampAt(model.getListReference()->count() - 1), static_cast<int64_t>(999));
+    QCOMPARE(model.rowCount(), model.getFilteredListReference()->count());
+
+    //the same number of classic frames fits under it untouched
+    model.clearFrames();
+    for (int b = 0; b < 10; b++)
+    {
+        QVector<CANFrame> batch;
+        for (int n = b * 100; n < (b + 1) * 100; n++) batch.append(makeFrame(static_cast<uint32_t>(n % 7), 0, n, 8));
+        model.addFrames(nullptr, batch);
+    }
+    QCOMPARE(model.getListReference()->count(), 1000);
+}
+
+void TestCANFrameStore::benchmark_data()
+{
+    QTest::addColumn<bool>("throughModel");
+
+    QTest::newRow("store append")       << false;
+    QTest::newRow("model addFrames")    << true;
+}
+
+//ingest one synthetic million frame batch, the size a fast connection hands over in a few seconds
+void TestCANFrameStore::benchmark()
+{
+    QFETCH(bool, throughModel);
+
+    const int count = 1000000;
+    QVector<CANFrame> batch;
+    batch.reserve(count);
+    for (int i = 0; i < count; i++) batch.append(makeFrame(static_cast<uint32_t>((i * 7) & 0xFF) + 0x100, i & 3, i, 8));
+
+    CANFrameStore store;
+    CANFrameModel model;
+    //room for exactly the batch, whatever limits this machine's settings hold
+    model.setCaptureLimits(count, false);
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        if (throughModel) model.addFrames(nullptr, batch);
+        else store.append(batch);
+    }
+    qint64 elapsed = qMax(timer.elapsed(), 1ll);
+
+    if (throughModel)
+    {
+        QCOMPARE(model.getListReference()->count(), count);
+        QCOMPARE(model.getFilteredListReference()->count(), count);
+    }
+    else QCOMPARE(store.count(), count);
+    qDebug() << QTest::currentDataTag() << count << "frames in" << elapsed << "ms," << (count * 1000.0 / elapsed) << "frames/s";
+}
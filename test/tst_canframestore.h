@@ -0,0 +1,32 @@
+#ifndef TST_CANFRAMESTORE_H
+#define TST_CANFRAMESTORE_H
+
+#include <QObject>
+
+class TestCANFrameStore: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void roundTrip();
+    void fdSlab();
+    void overwriteStats();
+    void removeMiddle();
+    void appendFromStore();
+    void toVector();
+    void bytesPerFrame();
+    void ringWrap();
+    void ringRemoveFront();
+    void ringLinearize();
+    void ringSlabReuse();
+    void modelRingKeepsShownRows();
+    void modelRingInsertFrames();
+    void modelRingSortEvictsOldest();
+    void modelCaptureLimits();
+    void modelMemoryCeiling();
+    void benchmark_data();
+    void benchmark();
+};
+
+#endif // TST_CANFRAMESTORE_H
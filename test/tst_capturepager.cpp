@@ -0,0 +1,172 @@
+#include <QtTest>
+#include <QFileInfo>
+
+#include "framefileio.h"
+#include "nativebinaryfile.h"
+#include "utils/capturepager.h"
+#include "tst_capturepager.h"
+
+
+//small pages so even a test sized file is cut into a lot of them
+void TestCapturePager::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+    savedPageBytes = CapturePager::pageBytes;
+    savedCachedFrames = CapturePager::maxCachedFrames;
+    CapturePager::pageBytes = 16384;
+    CapturePager::maxCachedFrames = 5000;
+
+    quint32 seed = 0x5EEDu;
+    for (int i = 0; i < 40000; i++)
+    {
+        CANFrame frame;
+        seed = seed * 1103515245u + 12345u;
+        frame.setFrameId((seed >> 5) & 0x7FF);
+        frame.bus = static_cast<int>((seed >> 20) % 3);
+        frame.isReceived = (seed >> 24) & 1;
+        QByteArray data(static_cast<int>((seed >> 8) % 9), 0);
+        for (int d = 0; d < data.length(); d++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            data[d] = static_cast<char>(seed >> 16);
+        }
+        frame.setPayload(data);
+        //mostly in order with the odd frame a little late, the way a multi bus logger writes them
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, 1551774790000000ll + (i * 250ll) - ((i % 17 == 5) ? 400 : 0)));
+        frames.append(frame);
+    }
+}
+
+void TestCapturePager::cleanupTestCase()
+{
+    CapturePager::pageBytes = savedPageBytes;
+    CapturePager::maxCachedFrames = savedCachedFrames;
+}
+
+QString TestCapturePager::writeFile(const QString &format)
+{
+    QString filename = tempDir.filePath("capture." + format);
+    if (QFile::exists(filename)) return filename;
+    bool ok = false;
+    if (format == "csv") ok = FrameFileIO::saveNativeCSVFile(filename, &frames);
+    if (format == "log") ok = FrameFileIO::saveCanDumpFile(filename, &frames);
+    if (format == "asc") ok = FrameFileIO::saveCanalyzerASC(filename, &frames);
+    if (format == "scb") ok = NativeBinaryFile::save(filename, &frames);
+    if (format == "crtd") ok = FrameFileIO::saveCRTDFile(filename, &frames);
+    return ok ? filename : QString();
+}
+
+static bool sameFrame(const CANFrame &a, const CANFrame &b)
+{
+    return a.timeStamp().microSeconds() == b.timeStamp().microSeconds() && a.frameId() == b.frameId()
+        && a.bus == b.bus && a.isReceived == b.isReceived && a.payload() == b.payload();
+}
+
+void TestCapturePager::matchesFullLoad_data()
+{
+    QTest::addColumn<QString>("format");
+
+    QTest::newRow("native binary") << "scb";
+    QTest::newRow("native CSV")    << "csv";
+    QTest::newRow("candump")       << "log";
+    QTest::newRow("ASC")           << "asc";
+}
+
+//every frame handed out a page at a time has to be the frame a full load puts in that row
+void TestCapturePager::matchesFullLoad()
+{
+    QFETCH(QString, format);
+    QString filename = writeFile(format);
+    QVERIFY(!filename.isEmpty());
+
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::autoDetectLoadFile(filename, &loaded));
+
+    QScopedPointer<CapturePager> pager(FrameFileIO::openPagedFile(filename));
+    QVERIFY(pager);
+    QVERIFY(pager->frameCount() > 0); //the first page is there straight away
+    QTRY_VERIFY_WITH_TIMEOUT(pager->isIndexed(), 20000);
+    QCOMPARE(pager->frameCount(), loaded.count());
+    QCOMPARE(pager->indexProgress(), 1000);
+
+    for (int i = 0; i < loaded.count(); i++)
+    {
+        if (!sameFrame(pager->frameAt(i), loaded.at(i))) QFAIL(qPrintable(QString("row %1 differs").arg(i)));
+    }
+    //and backwards, which walks the cache the other way
+    for (int i = loaded.count() - 1; i >= 0; i -= 7)
+    {
+        if (!sameFrame(pager->frameAt(i), loaded.at(i))) QFAIL(qPrintable(QString("row %1 differs").arg(i)));
+    }
+    QCOMPARE(pager->frameAt(loaded.count()).frameId(), CANFrame().frameId());
+}
+
+void TestCapturePager::timeLookups_data()
+{
+    QTest::addColumn<QString>("format");
+
+    QTest::newRow("native binary") << "scb";
+    QTest::newRow("native CSV")    << "csv";
+}
+
+void TestCapturePager::timeLookups()
+{
+    QFETCH(QString, format);
+    QString filename = writeFile(format);
+    QScopedPointer<CapturePager> pager(FrameFileIO::openPagedFile(filename));
+    QVERIFY(pager);
+    QTRY_VERIFY_WITH_TIMEOUT(pager->isIndexed(), 20000);
+
+    int64_t from = frames.timeStampAt(12345);
+    int64_t to = from + 1000000;
+    int first = -1;
+    int inRange = 0;
+    for (int i = 0; i < frames.count(); i++)
+    {
+        int64_t ts = frames.timeStampAt(i);
+        if (first < 0 && ts >= from) first = i;
+        if (ts >= from && ts <= to) inRange++;
+    }
+
+    QCOMPARE(pager->findFrame(from), first);
+    QCOMPARE(pager->findFrame(frames.timeStampAt(0) - 1), 0);
+    QCOMPARE(pager->findFrame(to * 2), -1);
+
+    QVector<CANFrame> window;
+    QCOMPARE(pager->framesInTimeRange(from, to, &window), inRange);
+    QCOMPARE(window.count(), inRange);
+    for (int i = 0; i < window.count(); i++)
+    {
+        QVERIFY(window.at(i).timeStamp().microSeconds() >= from);
+        QVERIFY(window.at(i).timeStamp().microSeconds() <= to);
+    }
+}
+
+//scrolling through the whole file must not keep it all decoded
+void TestCapturePager::cacheStaysBounded()
+{
+    QString filename = writeFile("csv");
+    QScopedPointer<CapturePager> pager(FrameFileIO::openPagedFile(filename));
+    QVERIFY(pager);
+    QTRY_VERIFY_WITH_TIMEOUT(pager->isIndexed(), 20000);
+
+    for (int i = 0; i < pager->frameCount(); i++) pager->frameAt(i);
+
+    quint64 hits, misses;
+    int pages;
+    pager->getCacheStats(hits, misses, pages);
+    int filePages = static_cast<int>(QFileInfo(filename).size() / CapturePager::pageBytes);
+    QVERIFY(pages > 0);
+    QVERIFY(pages * 2 < filePages);
+    QVERIFY(misses >= static_cast<quint64>(filePages)); //every page decoded once
+    QVERIFY(hits > misses * 10);
+}
+
+//formats without a pager fall back to a normal load
+void TestCapturePager::unpageableFormat()
+{
+    QString filename = writeFile("crtd");
+    QVERIFY(!filename.isEmpty());
+    QVERIFY(FrameFileIO::openPagedFile(filename) == nullptr);
+    QVERIFY(FrameFileIO::openPagedFile(tempDir.filePath("does not exist")) == nullptr);
+}
@@ -0,0 +1,30 @@
+#ifndef TST_CAPTUREPAGER_H
+#define TST_CAPTUREPAGER_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include "canframestore.h"
+
+class TestCapturePager: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir tempDir;
+    CANFrameStore frames;
+    int savedPageBytes;
+    int savedCachedFrames;
+
+    QString writeFile(const QString &format);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void matchesFullLoad_data();
+    void matchesFullLoad();
+    void timeLookups_data();
+    void timeLookups();
+    void cacheStaysBounded();
+    void unpageableFormat();
+};
+
+#endif // TST_CAPTUREPAGER_H
@@ -0,0 +1,232 @@
+#include <QtTest>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include "canconmanager.h"
+#include "tst_conmanager.h"
+
+
+//a device with nothing behind it, the test queues frames the way a driver would
+class FakeConnection : public CANConnection
+{
+public:
+    FakeConnection(int buses) : CANConnection("fake", "fake", CANCon::NONE, 0, 0, false, 0, buses, 1000, false) {}
+
+    void push(int bus, uint32_t id)
+    {
+        CANFrame *frame_p;
+        while ((frame_p = getQueue().get()) == nullptr) QThread::usleep(100); //full, the manager will catch up
+        frame_p->setFrameId(id);
+        frame_p->bus = bus;
+        frame_p->setPayload(QByteArray(8, static_cast<char>(id)));
+        getQueue().queue();
+        notifyFramesQueued();
+    }
+
+    //what a driver does, the frame is dropped when there's no room for it
+    bool offer(int bus, uint32_t id)
+    {
+        CANFrame *frame_p = getQueue().get();
+        if (!frame_p)
+        {
+            getQueue().countDrop();
+            return false;
+        }
+        frame_p->setFrameId(id);
+        frame_p->bus = bus;
+        getQueue().queue();
+        notifyFramesQueued();
+        return true;
+    }
+
+    void parsed(int bytes, bool bad, qint64 nanos)
+    {
+        countBytesParsed(bytes);
+        if (bad) countParseError();
+        addDecodeTime(nanos);
+    }
+
+    void arrived(int bus, uint32_t id)
+    {
+        CANFrame frame;
+        frame.setFrameId(id);
+        frame.bus = bus;
+        checkTargettedFrame(frame);
+    }
+
+protected:
+    void piStarted() override {}
+    void piStop() override {}
+    void piSetBusSettings(int, CANBus) override {}
+    bool piGetBusSettings(int, CANBus&) override { return false; }
+    void piSuspend(bool) override {}
+    bool piSendFrame(const CANFrame&) override { return true; }
+};
+
+
+void TestConManager::init()
+{
+    received.clear();
+    batches = 0;
+    receiver = connect(CANConManager::getInstance(), &CANConManager::framesReceived, this,
+                       [this](CANConnection*, const QVector<CANFrame> &frames)
+    {
+        batches++;
+        received.append(frames);
+    });
+    CANConManager::getInstance()->resetLatencyStats();
+}
+
+void TestConManager::cleanup()
+{
+    disconnect(receiver);
+}
+
+//with nothing else going on a frame shouldn't sit around waiting for a timer
+void TestConManager::quietBusGoesStraightThrough()
+{
+    CANConManager *manager = CANConManager::getInstance();
+    FakeConnection first(2);
+    FakeConnection second(3);
+    manager->add(&first);
+    manager->add(&second);
+
+    QTest::qWait(CANConManager::minDeliveryInterval * 2);
+    second.push(1, 0x123);
+    QCOMPARE(received.count(), 1);
+    QCOMPARE(received.at(0).bus, 3); //after the two buses of the first connection
+    QCOMPARE(received.at(0).frameId(), 0x123u);
+
+    CANConManager::LatencyStats stats = manager->getLatencyStats();
+    QCOMPARE(stats.samples, 1);
+    QVERIFY(stats.p50 >= 0 && stats.p50 <= stats.p99 && stats.p99 <= stats.max);
+
+    manager->remove(&second);
+    manager->remove(&first);
+}
+
+//one signal per drain, not per frame: the first frame goes right away and the rest of the burst
+//follows in a single batch
+void TestConManager::burstIsBatched()
+{
+    CANConManager *manager = CANConManager::getInstance();
+    FakeConnection conn(1);
+    manager->add(&conn);
+
+    QTest::qWait(CANConManager::minDeliveryInterval * 2);
+    for (int i = 0; i < 500; i++) conn.push(0, static_cast<uint32_t>(i));
+    QTRY_COMPARE(received.count(), 500);
+    QVERIFY2(batches <= 3, qPrintable(QString::number(batches)));
+    for (int i = 0; i < received.count(); i++) QCOMPARE(received.at(i).frameId(), static_cast<uint32_t>(i));
+
+    manager->remove(&conn);
+}
+
+//the usual case, a device thread queueing while the GUI thread takes them
+void TestConManager::otherThread()
+{
+    CANConManager *manager = CANConManager::getInstance();
+    FakeConnection first(1);
+    FakeConnection conn(2);
+    manager->add(&first);
+    manager->add(&conn);
+
+    const int count = 20000;
+    QFuture<void> producer = QtConcurrent::run([&conn, count]()
+    {
+        for (int i = 0; i < count; i++)
+        {
+            conn.push(i & 1, static_cast<uint32_t>(i & 0x7FF));
+            if ((i % 1000) == 0) QThread::msleep(2);
+        }
+    });
+    QTRY_COMPARE_WITH_TIMEOUT(received.count(), count, 20000);
+    producer.waitForFinished();
+
+    QVERIFY(batches < count / 10);
+    for (int i = 0; i < count; i++)
+    {
+        QCOMPARE(received.at(i).frameId(), static_cast<uint32_t>(i & 0x7FF));
+        QCOMPARE(received.at(i).bus, 1 + (i & 1));
+    }
+    CANConManager::LatencyStats stats = manager->getLatencyStats();
+    QVERIFY(stats.samples > 0);
+    qDebug() << "hand-off latency p50" << stats.p50 << "us p99" << stats.p99 << "us over" << stats.samples << "batches";
+
+    manager->remove(&conn);
+    manager->remove(&first);
+}
+
+//nobody drains this one so the queue fills up and the rest is dropped
+void TestConManager::stats()
+{
+    FakeConnection conn(1);
+    int capacity = conn.getQueue().capacity();
+    QVERIFY(capacity >= 1000);
+
+    for (int i = 0; i < capacity + 100; i++) QCOMPARE(conn.offer(0, static_cast<uint32_t>(i)), i < capacity);
+    conn.parsed(4096, false, 2000);
+    conn.parsed(16, true, 500);
+
+    CANConStats stats = conn.getStats();
+    QCOMPARE(stats.framesQueued, static_cast<quint64>(capacity));
+    QCOMPARE(stats.framesDropped, 100ull);
+    QCOMPARE(stats.framesReceived, static_cast<quint64>(capacity + 100));
+    QCOMPARE(conn.getDroppedFrames(), 100ull);
+    QCOMPARE(stats.queueDepth, capacity);
+    QCOMPARE(stats.queueHighWater, capacity);
+    QCOMPARE(stats.queueCapacity, capacity);
+    QCOMPARE(stats.bytesParsed, 4112ull);
+    QCOMPARE(stats.parseErrors, 1ull);
+    QCOMPARE(stats.decodeNanos, 2500ull);
+
+    //the high water mark starts over from what's still waiting
+    int available;
+    conn.getQueue().peekSpan(available, 1000);
+    conn.getQueue().consume(available);
+    conn.resetStats();
+    stats = conn.getStats();
+    QCOMPARE(stats.framesReceived, 0ull);
+    QCOMPARE(stats.framesDropped, 0ull);
+    QCOMPARE(stats.bytesParsed, 0ull);
+    QCOMPARE(stats.queueHighWater, capacity - available);
+    QVERIFY(conn.offer(0, 1));
+    QCOMPARE(conn.getStats().framesQueued, 1ull);
+}
+
+//exact and masked filters, every match for a receiver comes in one call
+void TestConManager::targettedFrames()
+{
+    FakeConnection conn(2);
+    TargetObserver exact;
+    TargetObserver masked;
+    QVERIFY(conn.addTargettedFrame(0, 0x123, 0x7FF, &exact));
+    QVERIFY(conn.addTargettedFrame(-1, 0x700, 0x700, &masked));
+    QVERIFY(conn.addTargettedFrame(1, 0x7E8, 0x7FF, &masked)); //also matched by the masked one, sent only once
+
+    conn.arrived(0, 0x123);
+    conn.arrived(1, 0x123); //exact is only on the first bus
+    conn.arrived(0, 0x124);
+    conn.arrived(1, 0x7E8);
+    conn.arrived(0, 0x456);
+    conn.arrived(0, 0x123);
+    conn.arrived(2, 0x7E8); //past the last bus, not matched against any of them
+    conn.arrived(-1, 0x123);
+    QTRY_COMPARE(exact.batches.count(), 1);
+    QTRY_COMPARE(masked.batches.count(), 1);
+    QCOMPARE(exact.batches.at(0).count(), 2);
+    QCOMPARE(exact.batches.at(0).at(0).frameId(), 0x123u);
+    QCOMPARE(exact.batches.at(0).at(1).bus, 0);
+    QCOMPARE(masked.batches.at(0).count(), 1);
+    QCOMPARE(masked.batches.at(0).at(0).frameId(), 0x7E8u);
+
+    //after being removed nothing more arrives, even what was already matched
+    conn.arrived(0, 0x7FF);
+    QVERIFY(conn.removeTargettedFrame(-1, 0x700, 0x700, &masked));
+    conn.arrived(0, 0x7FF);
+    conn.arrived(1, 0x7E8);
+    QVERIFY(conn.removeAllTargettedFrames(&masked));
+    conn.arrived(0, 0x123);
+    QTRY_COMPARE(exact.batches.count(), 2);
+    QCOMPARE(masked.batches.count(), 1);
+}
@@ -0,0 +1,39 @@
+#ifndef TST_CONMANAGER_H
+#define TST_CONMANAGER_H
+
+#include <QObject>
+#include <QVector>
+#include "can_structs.h"
+
+class CANConnection;
+
+//stands in for a window that registered targetted frame filters
+class TargetObserver: public QObject
+{
+    Q_OBJECT
+public:
+    QVector<QVector<CANFrame>> batches;
+
+public slots:
+    void gotTargettedFrames(const QVector<CANFrame> &frames) { batches.append(frames); }
+};
+
+class TestConManager: public QObject
+{
+    Q_OBJECT
+private:
+    QVector<CANFrame> received;
+    int batches;
+    QMetaObject::Connection receiver;
+
+private slots:
+    void init();
+    void cleanup();
+    void quietBusGoesStraightThrough();
+    void burstIsBatched();
+    void otherThread();
+    void stats();
+    void targettedFrames();
+};
+
+#endif // TST_CONMANAGER_H
@@ -0,0 +1,204 @@
+#include <QtTest>
+
+#include "framefileio.h"
+#include "utils/frameexporter.h"
+#include "tst_export.h"
+
+
+//a few thousand frames with CAN-FD, remote frames and time stamps all over the place
+void TestExport::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+    savedBatchFrames = FrameExporter::framesPerBatch;
+
+    quint32 seed = 0xBADC0DEu;
+    for (int i = 0; i < 5000; i++)
+    {
+        CANFrame frame;
+        seed = seed * 1103515245u + 12345u;
+        bool extended = (seed >> 16) & 1;
+        frame.setFrameId(extended ? (((seed >> 3) & 0x1FFFFFFF) | 0x800) : ((seed >> 5) & 0x7FF));
+        frame.setExtendedFrameFormat(extended);
+        frame.bus = static_cast<int>((seed >> 20) % 3);
+        frame.isReceived = (seed >> 24) & 1;
+        int len = (i % 13 == 0) ? 12 + (i % 53) : static_cast<int>((seed >> 8) % 9);
+        QByteArray data(len, 0);
+        for (int d = 0; d < len; d++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            data[d] = static_cast<char>(seed >> 16);
+        }
+        frame.setPayload(data);
+        if (len > 8) frame.setFlexibleDataRateFormat(true);
+        if (i % 89 == 0) frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, (i & 1) ? 1551774790000000ll + (i * 1237ll) : 1000 + (seed % 100000000)));
+        frames.append(frame);
+    }
+}
+
+void TestExport::cleanupTestCase()
+{
+    FrameExporter::framesPerBatch = savedBatchFrames;
+}
+
+QByteArray TestExport::readFile(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll();
+}
+
+
+//the hand rolled formatting has to agree with the QString calls it replaced
+void TestExport::numberFormatting()
+{
+    ExportLine line;
+    QByteArray out;
+
+    line.hex(0x1A, 3);
+    line.put(' ');
+    line.hex(0x18DAF110, 3);
+    line.put(' ');
+    line.dec(-42);
+    line.put(' ');
+    line.dec(7, 4, '0');
+    line.put(' ');
+    line.seconds(1500250, 6);
+    line.put(' ');
+    line.seconds(-1, 6);
+    line.put(' ');
+    line.seconds(2096335255, 5, 10);
+    line.put(' ');
+    line.seconds(999999, 3);
+    line.appendTo(out);
+
+    QCOMPARE(out, QByteArray("01A 18DAF110 -42 0007 1.500250 -0.000001 2096.33526 1.000"));
+    QCOMPARE(out, QByteArray("01A 18DAF110 -42 0007 ") + QString::number(1.50025, 'f', 6).toUtf8() + " -0.000001 "
+                  + QString::number(2096.335255, 'f', 5).rightJustified(10, ' ').toUtf8() + " " + QString::number(0.999999, 'f', 3).toUtf8());
+}
+
+void TestExport::knownOutput()
+{
+    CANFrameStore store;
+    CANFrame frame;
+    frame.setFrameId(0x123);
+    frame.setPayload(QByteArray::fromHex("010203"));
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, 1000000));
+    frame.bus = 0;
+    frame.isReceived = true;
+    store.append(frame);
+
+    frame.setFrameId(0x18DAF110);
+    frame.setExtendedFrameFormat(true);
+    frame.setPayload(QByteArray::fromHex("DEADBEEF00112233"));
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, 1500250));
+    frame.bus = 1;
+    frame.isReceived = false;
+    store.append(frame);
+
+    frame.setFrameId(0x7DF);
+    frame.setExtendedFrameFormat(false);
+    frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+    frame.setPayload(QByteArray(2, 0));
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, 2000001));
+    frame.bus = 2;
+    frame.isReceived = true;
+    store.append(frame);
+
+    QString filename = tempDir.filePath("known.csv");
+    QVERIFY(FrameFileIO::saveNativeCSVFile(filename, &store));
+    QCOMPARE(readFile(filename), QByteArray("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n"
+                                            "1000000,00000123,false,Rx,0,3,01,02,03,00,00,00,00,00,\n"
+                                            "1500250,18DAF110,true,Tx,1,8,DE,AD,BE,EF,00,11,22,33,\n"
+                                            "2000001,000007DF,false,Rx,2,2,00,00,00,00,00,00,00,00,\n"));
+
+    filename = tempDir.filePath("known.log");
+    QVERIFY(FrameFileIO::saveCanDumpFile(filename, &store));
+    QCOMPARE(readFile(filename), QByteArray("(0000000001.000000) vcan0 123#010203\n"
+                                            "(0000000001.500250) vcan0 18DAF110#DEADBEEF00112233\n"
+                                            "(0000000002.000001) vcan0 7DF#R2\n"));
+
+    filename = tempDir.filePath("known.crtd");
+    QVERIFY(FrameFileIO::saveCRTDFile(filename, &store));
+    QCOMPARE(readFile(filename), "1.000000 CXX GVRET-PC Reverse Engineering Tool Output V" + QByteArray::number(VERSION) + "\n"
+                                 "1.000000 1R11 00000123 01 02 03 \n"
+                                 "1.500250 2T29 18DAF110 DE AD BE EF 00 11 22 33 \n"
+                                 "2.000001 3R11 000007DF 00 00 \n");
+}
+
+void TestExport::batchSizeDoesNotMatter_data()
+{
+    QTest::addColumn<QString>("format");
+
+    QTest::newRow("native CSV") << "csv";
+    QTest::newRow("candump")    << "candump";
+    QTest::newRow("cabana")     << "cabana";
+    QTest::newRow("CARBUS")     << "carbus";
+    QTest::newRow("CAN-DO")     << "cando";
+    QTest::newRow("pcapng")     << "pcapng";
+}
+
+//Lots of tiny batches give many windows in flight. The file must come out the same as one batch
+//holding everything, which is the same as formatting the frames one at a time
+void TestExport::batchSizeDoesNotMatter()
+{
+    QFETCH(QString, format);
+
+    QByteArray results[2];
+    int batchFrames[2] = {7, frames.count()};
+    for (int run = 0; run < 2; run++)
+    {
+        FrameExporter::framesPerBatch = batchFrames[run];
+        QString filename = tempDir.filePath(format + QString::number(run));
+        bool ok = false;
+        if (format == "csv") ok = FrameFileIO::saveNativeCSVFile(filename, &frames);
+        if (format == "candump") ok = FrameFileIO::saveCanDumpFile(filename, &frames);
+        if (format == "cabana") ok = FrameFileIO::saveCabanaFile(filename, &frames);
+        if (format == "carbus") ok = FrameFileIO::saveCARBUSAnalzyer(filename, &frames);
+        if (format == "cando") ok = FrameFileIO::saveCANDOFile(filename, &frames);
+        if (format == "pcapng") ok = FrameFileIO::saveWiresharkFile(filename, &frames);
+        QVERIFY(ok);
+        results[run] = readFile(filename);
+        QVERIFY(!results[run].isEmpty());
+    }
+    FrameExporter::framesPerBatch = savedBatchFrames;
+    QVERIFY(results[0] == results[1]);
+
+    //and it still reads back
+    if (format == "csv")
+    {
+        QVector<CANFrame> loaded;
+        QVERIFY(FrameFileIO::loadNativeCSVFile(tempDir.filePath("csv0"), &loaded));
+        QCOMPARE(loaded.count(), frames.count());
+        for (int i = 0; i < loaded.count(); i++)
+        {
+            QCOMPARE(loaded.at(i).timeStamp().microSeconds(), frames.timeStampAt(i));
+            QCOMPARE(loaded.at(i).frameId(), frames.frameIdAt(i));
+            QCOMPARE(loaded.at(i).payload(), frames.at(i).payload());
+        }
+    }
+}
+
+//used to read frame 0 without checking, now an empty capture just gives the header
+void TestExport::emptyStore()
+{
+    CANFrameStore empty;
+    QString filename = tempDir.filePath("empty.csv");
+    QVERIFY(FrameFileIO::saveNativeCSVFile(filename, &empty));
+    QCOMPARE(readFile(filename), QByteArray("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n"));
+
+    filename = tempDir.filePath("empty.asc");
+    QVERIFY(FrameFileIO::saveCanalyzerASC(filename, &empty));
+    filename = tempDir.filePath("empty.trc");
+    QVERIFY(FrameFileIO::saveCARBUSAnalzyer(filename, &empty));
+    filename = tempDir.filePath("empty.can");
+    QVERIFY(FrameFileIO::saveCANDOFile(filename, &empty));
+    QVERIFY(readFile(filename).isEmpty());
+}
+
+void TestExport::failedOpen()
+{
+    QString filename = tempDir.filePath("no/such/directory/out.csv");
+    QVERIFY(!FrameFileIO::saveNativeCSVFile(filename, &frames));
+    QVERIFY(!QFile::exists(filename));
+}
@@ -0,0 +1,29 @@
+#ifndef TST_EXPORT_H
+#define TST_EXPORT_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include "canframestore.h"
+
+class TestExport: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir tempDir;
+    CANFrameStore frames;
+    int savedBatchFrames;
+
+    QByteArray readFile(const QString &filename);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void numberFormatting();
+    void knownOutput();
+    void batchSizeDoesNotMatter_data();
+    void batchSizeDoesNotMatter();
+    void emptyStore();
+    void failedOpen();
+};
+
+#endif // TST_EXPORT_H
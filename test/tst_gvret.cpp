@@ -0,0 +1,163 @@
+#include <QtTest>
+#include <QtEndian>
+
+#include "gvretserial.h"
+#include "tst_gvret.h"
+
+
+//a GVRET connection that never opens a port, bytes are handed straight to its parser
+class GVRETReplay : public GVRetSerial
+{
+public:
+    GVRETReplay() : GVRetSerial("replay", false)
+    {
+        useSystemTime = false;
+    }
+
+    void feed(const QByteArray &bytes)
+    {
+        procRXData(reinterpret_cast<const unsigned char *>(bytes.constData()), bytes.length());
+    }
+
+    void setSuspended(bool suspend) { setCapSuspended(suspend); }
+
+    QVector<CANFrame> drain()
+    {
+        QVector<CANFrame> frames;
+        CANFrame *frame_p;
+        while ((frame_p = getQueue().peek()) != nullptr)
+        {
+            frames.append(*frame_p);
+            getQueue().dequeue();
+        }
+        return frames;
+    }
+};
+
+static void appendLE32(QByteArray &out, quint32 value)
+{
+    for (int i = 0; i < 4; i++) out.append(static_cast<char>((value >> (i * 8)) & 0xFF));
+}
+
+//the same bytes the firmware puts on the wire for a frame, trailing checksum included
+static QByteArray encodeFrame(const CANFrame &frame, bool fd)
+{
+    QByteArray out;
+    out.append(static_cast<char>(0xF1));
+    out.append(static_cast<char>(fd ? 20 : 0));
+    appendLE32(out, static_cast<quint32>(frame.timeStamp().microSeconds()));
+    appendLE32(out, frame.frameId() | (frame.hasExtendedFrameFormat() ? 0x80000000u : 0));
+    if (fd)
+    {
+        out.append(static_cast<char>(frame.payload().length()));
+        out.append(static_cast<char>(frame.bus));
+    }
+    else out.append(static_cast<char>(frame.payload().length() | (frame.bus << 4)));
+    out.append(frame.payload());
+    out.append('\0');
+    return out;
+}
+
+
+//Something like a busy GVRET sends: classic and FD frames of every length on a few buses mixed in
+//with validation and device info replies. Payloads are full of 0xF1 to make sure nothing inside a
+//frame gets taken for the start of a command
+void TestGVRET::initTestCase()
+{
+    quint32 seed = 0x6E5E7u;
+    quint32 timeStamp = 0xFFFF0000u; //close to the top so a time stamp with bit 31 set gets checked too
+    for (int i = 0; i < 300; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        bool fd = (i % 5) == 4;
+        bool ext = (seed >> 7) & 1;
+
+        CANFrame frame;
+        frame.setExtendedFrameFormat(ext);
+        frame.setFrameId(ext ? ((seed >> 3) & 0x1FFFFFFF) : ((seed >> 3) & 0x7FF));
+        frame.bus = fd ? static_cast<int>((seed >> 20) % 4) : static_cast<int>((seed >> 20) % 3);
+        frame.isReceived = true;
+        int length = fd ? static_cast<int>((seed >> 9) % 65) : static_cast<int>((seed >> 9) % 9);
+        QByteArray data(length, 0);
+        for (int d = 0; d < length; d++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            data[d] = (seed & 0x300) ? static_cast<char>(seed >> 16) : static_cast<char>(0xF1);
+        }
+        frame.setPayload(data);
+        frame.setFlexibleDataRateFormat(fd);
+        timeStamp += 137 + (seed % 1000);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, timeStamp));
+
+        expected.append(frame);
+        stream.append(encodeFrame(frame, fd));
+
+        if (i % 37 == 0) stream.append(QByteArray::fromHex("f109")); //validation reply
+        if (i % 101 == 0) stream.append(QByteArray::fromHex("f1073a0101000000")); //device info
+    }
+}
+
+void TestGVRET::compareFrames(const QVector<CANFrame> &got, const QVector<CANFrame> &want)
+{
+    QCOMPARE(got.count(), want.count());
+    for (int i = 0; i < got.count(); i++)
+    {
+        const CANFrame &a = got.at(i);
+        const CANFrame &b = want.at(i);
+        QCOMPARE(a.frameId(), b.frameId());
+        QCOMPARE(a.hasExtendedFrameFormat(), b.hasExtendedFrameFormat());
+        QCOMPARE(a.hasFlexibleDataRateFormat(), b.hasFlexibleDataRateFormat());
+        QCOMPARE(a.bus, b.bus);
+        QCOMPARE(a.payload(), b.payload());
+        QCOMPARE(a.timeStamp().microSeconds(), b.timeStamp().microSeconds());
+        QVERIFY(a.isReceived);
+    }
+}
+
+void TestGVRET::wholeStream()
+{
+    GVRETReplay gvret;
+    gvret.feed(stream);
+    compareFrames(gvret.drain(), expected);
+}
+
+void TestGVRET::splitReads_data()
+{
+    QTest::addColumn<int>("readSize");
+
+    //a byte at a time is all state machine, bigger reads cut frames and replies at every offset
+    QTest::newRow("1")   <<   1;
+    QTest::newRow("2")   <<   2;
+    QTest::newRow("3")   <<   3;
+    QTest::newRow("7")   <<   7;
+    QTest::newRow("11")  <<  11;
+    QTest::newRow("13")  <<  13;
+    QTest::newRow("64")  <<  64;
+    QTest::newRow("509") << 509;
+}
+
+void TestGVRET::splitReads()
+{
+    QFETCH(int, readSize);
+
+    GVRETReplay gvret;
+    for (int pos = 0; pos < stream.length(); pos += readSize) gvret.feed(stream.mid(pos, readSize));
+    compareFrames(gvret.drain(), expected);
+}
+
+//nothing gets queued while suspended but the parser has to stay in step for when capture resumes
+void TestGVRET::suspended()
+{
+    GVRETReplay gvret;
+    int half = stream.length() / 2;
+    gvret.setSuspended(true);
+    gvret.feed(stream.left(half));
+    QVERIFY(gvret.drain().isEmpty());
+
+    gvret.setSuspended(false);
+    gvret.feed(stream.mid(half));
+    QVector<CANFrame> got = gvret.drain();
+    QVERIFY(!got.isEmpty());
+    QVERIFY(got.count() < expected.count());
+    compareFrames(got, expected.mid(expected.count() - got.count()));
+}
@@ -0,0 +1,25 @@
+#ifndef TST_GVRET_H
+#define TST_GVRET_H
+
+#include <QObject>
+#include <QVector>
+#include "can_structs.h"
+
+class TestGVRET: public QObject
+{
+    Q_OBJECT
+private:
+    QByteArray stream;
+    QVector<CANFrame> expected;
+
+    void compareFrames(const QVector<CANFrame> &got, const QVector<CANFrame> &want);
+
+private slots:
+    void initTestCase();
+    void wholeStream();
+    void splitReads_data();
+    void splitReads();
+    void suspended();
+};
+
+#endif // TST_GVRET_H
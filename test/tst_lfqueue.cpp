@@ -1,6 +1,7 @@
 #include <QtTest>
 
 #include <QtConcurrent/qtconcurrentrun.h>
+#include <QElapsedTimer>
 
 #include "utils/lfqueue.h"
 #include "tst_lfqueue.h"
@@ -16,6 +17,7 @@ void TestLFQueue::setSize_data()
     QTest::newRow("0")      <<  0       << true;
     QTest::newRow("10")     << 10       << true;
     QTest::newRow("2000")   << 20000    << true;
+    QTest::newRow("too big") << (1<<30) + 1 << false;
 
 }
 
@@ -83,3 +85,264 @@ void TestLFQueue::exchange()
 
     thread.waitForFinished();
 }
+
+
+void TestLFQueue::capacity()
+{
+    LFQueue<int> queue;
+    QVERIFY(queue.setSize(10));
+    QCOMPARE(queue.capacity(), 16);
+
+    //every slot can be used, the next one is refused
+    for(int i=0; i<16 ; i++) {
+        int* val_p = queue.get();
+        QVERIFY(val_p);
+        *val_p = i;
+        queue.queue();
+    }
+    QVERIFY(!queue.get());
+    QCOMPARE(queue.count(), 16);
+
+    for(int i=0; i<16 ; i++) {
+        int* val_p = queue.peek();
+        QVERIFY(val_p);
+        QCOMPARE(*val_p, i);
+        queue.dequeue();
+    }
+    QVERIFY(!queue.peek());
+    QCOMPARE(queue.count(), 0);
+}
+
+
+void TestLFQueue::spans()
+{
+    LFQueue<int> queue;
+    QVERIFY(queue.setSize(8));
+
+    int granted;
+    int available;
+    int* vals_p = queue.reserve(5, granted);
+    QVERIFY(vals_p);
+    QCOMPARE(granted, 5);
+    for(int i=0; i<granted ; i++)
+        vals_p[i] = i;
+    queue.commit(vals_p, granted);
+
+    vals_p = queue.peekSpan(available, 3);
+    QCOMPARE(available, 3);
+    QCOMPARE(vals_p[0], 0);
+    queue.consume(3);
+
+    //only the 3 slots up to the end of the ring follow on, the rest comes from the front next time
+    vals_p = queue.reserve(6, granted);
+    QCOMPARE(granted, 3);
+    for(int i=0; i<granted ; i++)
+        vals_p[i] = 5 + i;
+    queue.commit(vals_p, granted);
+    vals_p = queue.reserve(6, granted);
+    QCOMPARE(granted, 3);
+    for(int i=0; i<granted ; i++)
+        vals_p[i] = 8 + i;
+    queue.commit(vals_p, granted);
+    QVERIFY(!queue.reserve(1, granted));
+    QCOMPARE(granted, 0);
+
+    vals_p = queue.peekSpan(available);
+    QCOMPARE(available, 5);
+    for(int i=0; i<available ; i++)
+        QCOMPARE(vals_p[i], 3 + i);
+    queue.consume(available);
+    vals_p = queue.peekSpan(available);
+    QCOMPARE(available, 3);
+    for(int i=0; i<available ; i++)
+        QCOMPARE(vals_p[i], 8 + i);
+    queue.consume(available);
+    QVERIFY(!queue.peekSpan(available));
+}
+
+
+void TestLFQueue::drops()
+{
+    LFQueue<int> queue;
+    QVERIFY(queue.setSize(4));
+    QCOMPARE(queue.dropped(), 0ull);
+
+    queue.countDrop();
+    queue.countDrop(9);
+    QCOMPARE(queue.dropped(), 10ull);
+
+    queue.flush();
+    QCOMPARE(queue.dropped(), 0ull);
+}
+
+
+//reads values counting up from 0 in spans of up to maxSpan, returns how many were out of order
+static int spanReader(LFQueue<int>* pQueue_p, int pCount, int pMaxSpan) {
+    int errors = 0;
+    int next = 0;
+    int available;
+
+    while(next < pCount) {
+        int* vals_p = pQueue_p->peekSpan(available, pMaxSpan);
+        if(!vals_p) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        for(int i=0; i<available ; i++)
+            if(vals_p[i] != next + i)
+                errors++;
+        next += available;
+        pQueue_p->consume(available);
+    }
+    return errors;
+}
+
+
+void TestLFQueue::stress_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("writeSpan");
+    QTest::addColumn<int>("readSpan");
+
+    QTest::newRow("tiny single")  << 2    << 1   << 1;
+    QTest::newRow("single")       << 256  << 1   << 1;
+    QTest::newRow("bulk write")   << 256  << 37  << 1;
+    QTest::newRow("bulk read")    << 256  << 1   << 64;
+    QTest::newRow("bulk both")    << 1000 << 100 << 300;
+}
+
+
+void TestLFQueue::stress()
+{
+    LFQueue<int> queue;
+    QFETCH(int, size);
+    QFETCH(int, writeSpan);
+    QFETCH(int, readSpan);
+    const int count = 1000000;
+
+    QVERIFY(queue.setSize(size));
+    QFuture<int> reader = QtConcurrent::run(spanReader, &queue, count, readSpan);
+
+    int next = 0;
+    int granted;
+    while(next < count) {
+        int* vals_p = queue.reserve(qMin(writeSpan, count - next), granted);
+        if(!vals_p) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        for(int i=0; i<granted ; i++)
+            vals_p[i] = next + i;
+        queue.commit(vals_p, granted);
+        next += granted;
+    }
+
+    QCOMPARE(reader.result(), 0);
+    QVERIFY(!queue.peek());
+}
+
+
+//each producer writes its number in the top byte and counts up in the rest
+static void mpscWriter(LFQueue<int>* pQueue_p, int pProducer, int pCount, int pSpan) {
+    int next = 0;
+    int granted;
+
+    while(next < pCount) {
+        int* vals_p = pQueue_p->reserve(qMin(pSpan, pCount - next), granted);
+        if(!vals_p) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        for(int i=0; i<granted ; i++)
+            vals_p[i] = (pProducer << 24) | (next + i);
+        pQueue_p->commit(vals_p, granted);
+        next += granted;
+    }
+}
+
+
+void TestLFQueue::multiProducer()
+{
+    LFQueue<int> queue;
+    const int producers = 4;
+    const int count = 250000;
+
+    QVERIFY(queue.setSize(512, LFQueue<int>::MPSC));
+
+    QList<QFuture<void>> writers;
+    for(int p=0; p<producers ; p++)
+        writers.append(QtConcurrent::run(mpscWriter, &queue, p, count, 1 + p * 7));
+
+    //every producer's values have to come out in the order it wrote them
+    QVector<int> next(producers, 0);
+    int errors = 0;
+    int total = 0;
+    int available;
+    while(total < producers * count) {
+        int* vals_p = queue.peekSpan(available);
+        if(!vals_p) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        for(int i=0; i<available ; i++) {
+            int producer = vals_p[i] >> 24;
+            if(producer < 0 || producer >= producers || (vals_p[i] & 0xFFFFFF) != next[producer]++)
+                errors++;
+        }
+        total += available;
+        queue.consume(available);
+    }
+
+    for(int p=0; p<producers ; p++)
+        writers[p].waitForFinished();
+
+    QCOMPARE(errors, 0);
+    QCOMPARE(total, producers * count);
+    QVERIFY(!queue.peek());
+}
+
+
+void TestLFQueue::throughput_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<int>("span");
+
+    QTest::newRow("spsc single") << int(LFQueue<int>::SPSC) << 1;
+    QTest::newRow("spsc bulk")   << int(LFQueue<int>::SPSC) << 64;
+    QTest::newRow("mpsc single") << int(LFQueue<int>::MPSC) << 1;
+    QTest::newRow("mpsc bulk")   << int(LFQueue<int>::MPSC) << 64;
+}
+
+
+//just reports the rate, how fast it goes depends too much on the machine to fail on it
+void TestLFQueue::throughput()
+{
+    LFQueue<int> queue;
+    QFETCH(int, mode);
+    QFETCH(int, span);
+    const int count = 4000000;
+
+    QVERIFY(queue.setSize(4096, LFQueue<int>::Mode(mode)));
+
+    QElapsedTimer timer;
+    timer.start();
+    QFuture<int> reader = QtConcurrent::run(spanReader, &queue, count, span);
+
+    int next = 0;
+    int granted;
+    while(next < count) {
+        int* vals_p = queue.reserve(qMin(span, count - next), granted);
+        if(!vals_p) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        for(int i=0; i<granted ; i++)
+            vals_p[i] = next + i;
+        queue.commit(vals_p, granted);
+        next += granted;
+    }
+
+    QCOMPARE(reader.result(), 0);
+    qint64 elapsed = qMax(timer.nsecsElapsed(), static_cast<qint64>(1));
+    qDebug() << QTest::currentDataTag() << ":" << count * 1000.0 / elapsed << "M values/s";
+}
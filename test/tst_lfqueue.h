@@ -13,6 +13,14 @@ private slots:
     void setSize();
     void exchange_data();
     void exchange();
+    void capacity();
+    void spans();
+    void drops();
+    void stress_data();
+    void stress();
+    void multiProducer();
+    void throughput_data();
+    void throughput();
 };
 
 #endif // TST_LFQUEUE_H
@@ -0,0 +1,225 @@
+#include <QtTest>
+#include <algorithm>
+
+#include "canframestore.h"
+#include "framefileio.h"
+#include "utils/capturepager.h"
+#include "tst_merge.h"
+
+
+//three loggers on three buses. CSV and candump get streamed, CRTD can only be loaded whole
+void TestMerge::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+    savedBlockFrames = CaptureMerger::blockFrames;
+    savedPageBytes = CapturePager::pageBytes;
+    CaptureMerger::blockFrames = 100;
+    CapturePager::pageBytes = 8192;
+
+    const int counts[] = {3000, 2500, 2000};
+    const int64_t steps[] = {300, 350, 500};
+    const char *formats[] = {"csv", "log", "crtd"};
+
+    quint32 seed = 0xC0FFEEu;
+    for (int f = 0; f < 3; f++)
+    {
+        CANFrameStore store;
+        for (int i = 0; i < counts[f]; i++)
+        {
+            CANFrame frame;
+            seed = seed * 1103515245u + 12345u;
+            frame.setFrameId((seed >> 5) & 0x7FF);
+            frame.bus = static_cast<int>((seed >> 20) % 3);
+            frame.isReceived = true;
+            QByteArray data(static_cast<int>((seed >> 8) % 9), 0);
+            for (int d = 0; d < data.length(); d++)
+            {
+                seed = seed * 1103515245u + 12345u;
+                data[d] = static_cast<char>(seed >> 16);
+            }
+            frame.setPayload(data);
+            //steps of 300 and 350us meet every 2100us so the first two files have time stamps in common
+            frame.setTimeStamp(QCanBusFrame::TimeStamp(0, 1551774790000000ll + i * steps[f]));
+            store.append(frame);
+        }
+
+        QString filename = tempDir.filePath(QString("bus%1.%2").arg(f).arg(formats[f]));
+        bool ok = false;
+        if (f == 0) ok = FrameFileIO::saveNativeCSVFile(filename, &store);
+        if (f == 1) ok = FrameFileIO::saveCanDumpFile(filename, &store);
+        if (f == 2) ok = FrameFileIO::saveCRTDFile(filename, &store);
+        QVERIFY(ok);
+        files.append(filename);
+    }
+}
+
+void TestMerge::cleanupTestCase()
+{
+    CaptureMerger::blockFrames = savedBlockFrames;
+    CapturePager::pageBytes = savedPageBytes;
+}
+
+//the slow way: load everything, fix up the frames, then a stable sort so ties stay in input order
+QVector<CANFrame> TestMerge::expectedMerge(const QVector<MergeInput> &inputs)
+{
+    QVector<CANFrame> all;
+    for (const MergeInput &input : inputs)
+    {
+        QVector<CANFrame> loaded;
+        if (!FrameFileIO::autoDetectLoadFile(input.filename, &loaded)) return QVector<CANFrame>();
+        for (CANFrame &frame : loaded)
+        {
+            if (input.bus >= 0) frame.bus = input.bus;
+            else frame.bus = input.busMap.value(frame.bus, frame.bus);
+            frame.setTimeStamp(QCanBusFrame::TimeStamp(0, frame.timeStamp().microSeconds() + input.timeOffset));
+        }
+        all.append(loaded);
+    }
+    std::stable_sort(all.begin(), all.end(), [](const CANFrame &a, const CANFrame &b)
+    {
+        return a.timeStamp().microSeconds() < b.timeStamp().microSeconds();
+    });
+    return all;
+}
+
+static bool sameFrame(const CANFrame &a, const CANFrame &b)
+{
+    return a.timeStamp().microSeconds() == b.timeStamp().microSeconds() && a.frameId() == b.frameId()
+        && a.bus == b.bus && a.payload() == b.payload();
+}
+
+void TestMerge::matchesSortedLoad_data()
+{
+    QTest::addColumn<qint64>("offset");
+
+    QTest::newRow("no offsets")      << 0ll;
+    QTest::newRow("second file late") << 1234567ll;
+    QTest::newRow("second file early") << -50ll;
+}
+
+void TestMerge::matchesSortedLoad()
+{
+    QFETCH(qint64, offset);
+
+    QVector<MergeInput> inputs;
+    CaptureMerger merger;
+    for (int f = 0; f < files.count(); f++)
+    {
+        MergeInput input;
+        input.filename = files[f];
+        input.bus = f;
+        if (f == 1) input.timeOffset = offset;
+        inputs.append(input);
+        merger.addInput(input);
+    }
+
+    QVector<CANFrame> merged;
+    int biggestBlock = 0;
+    QVERIFY(merger.run([&merged, &biggestBlock](const QVector<CANFrame> &block)
+    {
+        biggestBlock = qMax(biggestBlock, block.count());
+        merged.append(block);
+        return true;
+    }));
+
+    QVector<CANFrame> expected = expectedMerge(inputs);
+    QCOMPARE(expected.count(), 7500);
+    QCOMPARE(merged.count(), expected.count());
+    QCOMPARE(merger.framesMerged(), static_cast<quint64>(expected.count()));
+    QCOMPARE(biggestBlock, CaptureMerger::blockFrames);
+    for (int i = 0; i < merged.count(); i++)
+    {
+        if (!sameFrame(merged.at(i), expected.at(i))) QFAIL(qPrintable(QString("frame %1 differs").arg(i)));
+    }
+}
+
+void TestMerge::busAssignAndRemap()
+{
+    MergeInput remapped;
+    remapped.filename = files[0];
+    remapped.busMap.insert(0, 5);
+    remapped.busMap.insert(2, 7);
+
+    QVector<CANFrame> original;
+    QVERIFY(FrameFileIO::autoDetectLoadFile(files[0], &original));
+
+    CaptureMerger merger;
+    merger.addInput(remapped);
+    QVector<CANFrame> merged;
+    QVERIFY(merger.run([&merged](const QVector<CANFrame> &block) { merged.append(block); return true; }));
+    QCOMPARE(merged.count(), original.count());
+
+    int seen[3] = {0, 0, 0};
+    for (int i = 0; i < merged.count(); i++)
+    {
+        int bus = original.at(i).bus;
+        QVERIFY(bus >= 0 && bus < 3);
+        seen[bus]++;
+        QCOMPARE(merged.at(i).bus, (bus == 0) ? 5 : (bus == 2) ? 7 : 1);
+    }
+    QVERIFY(seen[0] > 0 && seen[1] > 0 && seen[2] > 0);
+}
+
+//written out as GVRET CSV and read back it has to be the same merge
+void TestMerge::toFile()
+{
+    QVector<MergeInput> inputs;
+    CaptureMerger merger;
+    for (int f = 0; f < files.count(); f++)
+    {
+        MergeInput input;
+        input.filename = files[f];
+        input.bus = f + 1;
+        input.timeOffset = f * 100;
+        inputs.append(input);
+        merger.addInput(input);
+    }
+
+    QString out = tempDir.filePath("merged.csv");
+    QVERIFY(merger.runToFile(out));
+
+    QVector<CANFrame> reloaded;
+    QVERIFY(FrameFileIO::loadNativeCSVFile(out, &reloaded));
+    QVector<CANFrame> expected = expectedMerge(inputs);
+    QCOMPARE(reloaded.count(), expected.count());
+    for (int i = 0; i < reloaded.count(); i++)
+    {
+        if (!sameFrame(reloaded.at(i), expected.at(i))) QFAIL(qPrintable(QString("frame %1 differs").arg(i)));
+    }
+}
+
+void TestMerge::sinkStops()
+{
+    CaptureMerger merger;
+    for (const QString &file : files)
+    {
+        MergeInput input;
+        input.filename = file;
+        merger.addInput(input);
+    }
+
+    int calls = 0;
+    QVERIFY(!merger.run([&calls](const QVector<CANFrame> &) { calls++; return calls < 3; }));
+    QCOMPARE(calls, 3);
+    QCOMPARE(merger.framesMerged(), static_cast<quint64>(3 * CaptureMerger::blockFrames));
+}
+
+void TestMerge::missingInput()
+{
+    CaptureMerger merger;
+    MergeInput good;
+    good.filename = files[0];
+    MergeInput missing;
+    missing.filename = tempDir.filePath("not_there.csv");
+    merger.addInput(good);
+    merger.addInput(missing);
+
+    bool sinkCalled = false;
+    QVERIFY(!merger.run([&sinkCalled](const QVector<CANFrame> &) { sinkCalled = true; return true; }));
+    QVERIFY(!sinkCalled);
+    QVERIFY(merger.errorString().contains("not_there.csv"));
+
+    QString out = tempDir.filePath("never.csv");
+    QVERIFY(!merger.runToFile(out));
+    QVERIFY(!QFile::exists(out));
+}
@@ -0,0 +1,32 @@
+#ifndef TST_MERGE_H
+#define TST_MERGE_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QVector>
+#include "can_structs.h"
+#include "utils/capturemerger.h"
+
+class TestMerge: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir tempDir;
+    QStringList files;
+    int savedBlockFrames;
+    int savedPageBytes;
+
+    QVector<CANFrame> expectedMerge(const QVector<MergeInput> &inputs);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void matchesSortedLoad_data();
+    void matchesSortedLoad();
+    void busAssignAndRemap();
+    void toFile();
+    void sinkStops();
+    void missingInput();
+};
+
+#endif // TST_MERGE_H
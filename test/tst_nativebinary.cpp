@@ -0,0 +1,156 @@
+#include <QtTest>
+
+#include "framefileio.h"
+#include "nativebinaryfile.h"
+#include "tst_nativebinary.h"
+
+
+//a bit over two blocks worth with a sprinkling of CAN-FD and remote frames
+void TestNativeBinary::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+
+    quint32 seed = 0xC0FFEEu;
+    for (int i = 0; i < (NativeBinaryFile::framesPerBlock * 2) + 123; i++)
+    {
+        CANFrame frame;
+        seed = seed * 1103515245u + 12345u;
+        bool extended = (seed >> 16) & 1;
+        frame.setFrameId(extended ? (((seed >> 3) & 0x1FFFFFFF) | 0x800) : ((seed >> 5) & 0x7FF));
+        frame.setExtendedFrameFormat(extended);
+        frame.bus = static_cast<int>((seed >> 20) % 3);
+        frame.isReceived = (seed >> 24) & 1;
+        int len = (i % 11 == 0) ? 12 + (i % 53) : static_cast<int>((seed >> 8) % 9);
+        QByteArray data(len, 0);
+        for (int d = 0; d < len; d++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            data[d] = static_cast<char>(seed >> 16);
+        }
+        frame.setPayload(data);
+        if (len > 8)
+        {
+            frame.setFlexibleDataRateFormat(true);
+            frame.setBitrateSwitch(i & 1);
+        }
+        if (i % 97 == 0) frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, 1000000ll + (i * 250ll)));
+        frames.append(frame);
+    }
+}
+
+
+//everything a frame carries must survive a save and load
+void TestNativeBinary::roundTrip()
+{
+    QString filename = tempDir.filePath("roundtrip.scb");
+    QVERIFY(FrameFileIO::saveNativeBinaryFile(filename, &frames));
+    QVERIFY(FrameFileIO::isNativeBinaryFile(filename));
+
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::autoDetectLoadFile(filename, &loaded));
+    QCOMPARE(loaded.count(), frames.count());
+    for (int i = 0; i < loaded.count(); i++)
+    {
+        CANFrame want = frames.at(i);
+        const CANFrame &got = loaded.at(i);
+        QCOMPARE(got.timeStamp().microSeconds(), want.timeStamp().microSeconds());
+        QCOMPARE(got.frameId(), want.frameId());
+        QCOMPARE(got.hasExtendedFrameFormat(), want.hasExtendedFrameFormat());
+        QCOMPARE(got.frameType(), want.frameType());
+        QCOMPARE(got.hasFlexibleDataRateFormat(), want.hasFlexibleDataRateFormat());
+        QCOMPARE(got.hasBitrateSwitch(), want.hasBitrateSwitch());
+        QCOMPARE(got.bus, want.bus);
+        QCOMPARE(got.isReceived, want.isReceived);
+        QCOMPARE(got.payload(), want.payload());
+    }
+}
+
+//CSV -> binary -> CSV has to give back the same file, CAN-FD payloads included
+void TestNativeBinary::csvRoundTrip()
+{
+    QString csvName = tempDir.filePath("first.csv");
+    QString binName = tempDir.filePath("middle.scb");
+    QString csvName2 = tempDir.filePath("second.csv");
+    QVERIFY(FrameFileIO::saveNativeCSVFile(csvName, &frames));
+
+    QVector<CANFrame> fromCSV;
+    QVERIFY(FrameFileIO::loadNativeCSVFile(csvName, &fromCSV));
+    CANFrameStore csvStore(fromCSV);
+    QVERIFY(FrameFileIO::saveNativeBinaryFile(binName, &csvStore));
+
+    QVector<CANFrame> fromBin;
+    QVERIFY(FrameFileIO::loadNativeBinaryFile(binName, &fromBin));
+    CANFrameStore binStore(fromBin);
+    QVERIFY(FrameFileIO::saveNativeCSVFile(csvName2, &binStore));
+
+    QFile first(csvName);
+    QFile second(csvName2);
+    QVERIFY(first.open(QIODevice::ReadOnly));
+    QVERIFY(second.open(QIODevice::ReadOnly));
+    QVERIFY(first.readAll() == second.readAll());
+}
+
+void TestNativeBinary::randomAccess()
+{
+    QString filename = tempDir.filePath("random.scb");
+    QVERIFY(NativeBinaryFile::save(filename, &frames));
+
+    NativeBinaryFile binFile;
+    QVERIFY(binFile.open(filename));
+    QCOMPARE(binFile.frameCount(), static_cast<quint64>(frames.count()));
+    QCOMPARE(binFile.blockCount(), 3);
+
+    for (int i = 0; i < frames.count(); i += 37)
+    {
+        CANFrame got = binFile.frameAt(static_cast<quint64>(i));
+        QCOMPARE(got.frameId(), frames.frameIdAt(i));
+        QCOMPARE(got.payload(), frames.at(i).payload());
+        QCOMPARE(binFile.timeStampAt(static_cast<quint64>(i)), frames.timeStampAt(i));
+    }
+
+    //time stamps climb 250us per frame so a block boundary is easy to aim at
+    int64_t secondBlockStart = 1000000ll + (NativeBinaryFile::framesPerBlock * 250ll);
+    QCOMPARE(binFile.findBlock(0), 0);
+    QCOMPARE(binFile.findBlock(secondBlockStart), 1);
+    QCOMPARE(binFile.findBlock(secondBlockStart - 1), 0);
+    QCOMPARE(binFile.findBlock(1ll << 40), -1);
+}
+
+void TestNativeBinary::idIndex()
+{
+    QString filename = tempDir.filePath("index.scb");
+    QVERIFY(NativeBinaryFile::save(filename, &frames));
+
+    NativeBinaryFile binFile;
+    QVERIFY(binFile.open(filename));
+    QVector<NativeBinaryIDInfo> index = binFile.idIndex();
+
+    quint64 total = 0;
+    for (int i = 0; i < index.count(); i++)
+    {
+        const NativeBinaryIDInfo &info = index.at(i);
+        total += info.count;
+        CANFrame first = binFile.frameAt(info.firstFrame);
+        CANFrame last = binFile.frameAt(info.lastFrame);
+        QCOMPARE(first.frameId(), info.frameId);
+        QCOMPARE(first.bus, info.bus);
+        QCOMPARE(last.frameId(), info.frameId);
+        QVERIFY(!info.blocks.isEmpty());
+        QCOMPARE(info.blocks.first(), static_cast<int>(info.firstFrame / NativeBinaryFile::framesPerBlock));
+        QCOMPARE(info.blocks.last(), static_cast<int>(info.lastFrame / NativeBinaryFile::framesPerBlock));
+    }
+    QCOMPARE(total, static_cast<quint64>(frames.count()));
+}
+
+void TestNativeBinary::rejectsTruncated()
+{
+    QString filename = tempDir.filePath("truncated.scb");
+    QVERIFY(NativeBinaryFile::save(filename, &frames));
+    QFile file(filename);
+    QVERIFY(file.resize(file.size() / 2));
+
+    NativeBinaryFile binFile;
+    QVERIFY(!binFile.open(filename));
+    QVERIFY(!FrameFileIO::isNativeBinaryFile(filename));
+}
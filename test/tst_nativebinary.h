@@ -0,0 +1,24 @@
+#ifndef TST_NATIVEBINARY_H
+#define TST_NATIVEBINARY_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include "canframestore.h"
+
+class TestNativeBinary: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir tempDir;
+    CANFrameStore frames;
+
+private slots:
+    void initTestCase();
+    void roundTrip();
+    void csvRoundTrip();
+    void randomAccess();
+    void idIndex();
+    void rejectsTruncated();
+};
+
+#endif // TST_NATIVEBINARY_H
@@ -0,0 +1,116 @@
+#include <QtTest>
+
+#include "utils/parallelsort.h"
+#include "tst_parallelsort.h"
+
+
+//few distinct keys so there are plenty of ties, seq tells equal keys apart
+struct SortItem
+{
+    int key;
+    int seq;
+    bool operator==(const SortItem &other) const { return key == other.key && seq == other.seq; }
+};
+
+static QVector<SortItem> makeItems(int count)
+{
+    QVector<SortItem> items(count);
+    quint32 rnd = 12345;
+    for (int i = 0; i < count; i++)
+    {
+        rnd = rnd * 1103515245 + 12345;
+        items[i] = SortItem{static_cast<int>((rnd >> 16) % 37), i};
+    }
+    return items;
+}
+
+static bool keyLess(const SortItem &a, const SortItem &b) { return a.key < b.key; }
+
+//chunk sorts plus one merge per pair of runs in each round
+static int stepsFor(int chunks)
+{
+    int steps = chunks;
+    for (int width = 1; width < chunks; width *= 2) steps += (chunks + (2 * width) - 1) / (2 * width);
+    return steps;
+}
+
+void TestParallelSort::matchesStdStableSort_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("chunks");
+    QTest::addColumn<bool>("descending");
+
+    QTest::newRow("one chunk") << 1000 << 1 << false;
+    QTest::newRow("two chunks") << 1000 << 2 << false;
+    QTest::newRow("three chunks") << 1001 << 3 << false;
+    QTest::newRow("five chunks") << 999 << 5 << false;
+    QTest::newRow("seven chunks") << 20000 << 7 << false;
+    QTest::newRow("seven chunks descending") << 20000 << 7 << true;
+    QTest::newRow("sixteen chunks") << 16 << 16 << false;
+    QTest::newRow("more chunks than items") << 5 << 8 << false;
+    QTest::newRow("single item") << 1 << 4 << false;
+    QTest::newRow("empty") << 0 << 4 << false;
+}
+
+void TestParallelSort::matchesStdStableSort()
+{
+    QFETCH(int, count);
+    QFETCH(int, chunks);
+    QFETCH(bool, descending);
+
+    auto lessThan = [descending](const SortItem &a, const SortItem &b) { return descending ? b.key < a.key : a.key < b.key; };
+    QVector<SortItem> items = makeItems(count);
+    QVector<SortItem> expected = items;
+    std::stable_sort(expected.begin(), expected.end(), lessThan);
+
+    QVERIFY(ParallelSort::stableSort(items, chunks, lessThan));
+    QCOMPARE(items.count(), expected.count());
+    for (int i = 0; i < items.count(); i++)
+    {
+        if (!(items.at(i) == expected.at(i)))
+            QFAIL(qPrintable(QString("item %1 is key %2 seq %3, expected key %4 seq %5").arg(i)
+                             .arg(items.at(i).key).arg(items.at(i).seq).arg(expected.at(i).key).arg(expected.at(i).seq)));
+    }
+}
+
+//the default cut reports exactly the steps stepCount() promised
+void TestParallelSort::progress()
+{
+    const int count = 200000;
+    QVector<SortItem> items = makeItems(count);
+    std::atomic<bool> cancel(false);
+    std::atomic<int> progress(0);
+    QVERIFY(ParallelSort::stableSort(items, keyLess, &cancel, &progress));
+    QCOMPARE(progress.load(), ParallelSort::stepCount(count));
+    QVERIFY(std::is_sorted(items.begin(), items.end(), keyLess));
+
+    progress = 0;
+    items = makeItems(count);
+    QVERIFY(ParallelSort::stableSort(items, 7, keyLess, &cancel, &progress));
+    QCOMPARE(progress.load(), stepsFor(7));
+}
+
+void TestParallelSort::cancel()
+{
+    const int count = 20000;
+    const int chunks = 7;
+
+    //already canceled, nothing is done
+    QVector<SortItem> items = makeItems(count);
+    std::atomic<bool> cancel(true);
+    std::atomic<int> progress(0);
+    QVERIFY(!ParallelSort::stableSort(items, chunks, keyLess, &cancel, &progress));
+    QCOMPARE(progress.load(), 0);
+
+    //canceled once the first chunk is done, the sort stops at the next boundary
+    cancel = false;
+    items = makeItems(count);
+    auto cancelingLess = [&cancel, &progress](const SortItem &a, const SortItem &b)
+    {
+        if (progress.load() > 0) cancel = true;
+        return a.key < b.key;
+    };
+    QVERIFY(!ParallelSort::stableSort(items, chunks, cancelingLess, &cancel, &progress));
+    QVERIFY(progress.load() >= 1);
+    QVERIFY2(progress.load() < stepsFor(chunks), qPrintable(QString::number(progress.load())));
+}
@@ -0,0 +1,18 @@
+#ifndef TST_PARALLELSORT_H
+#define TST_PARALLELSORT_H
+
+#include <QObject>
+
+class TestParallelSort: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void matchesStdStableSort_data();
+    void matchesStdStableSort();
+    void progress();
+    void cancel();
+};
+
+#endif // TST_PARALLELSORT_H
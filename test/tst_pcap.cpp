@@ -0,0 +1,259 @@
+#include <QtTest>
+
+#include "framefileio.h"
+#include "pcaplite.h"
+#include "tst_pcap.h"
+
+
+static void appendLE32(QByteArray &out, quint32 v)
+{
+    for (int i = 0; i < 4; i++) out.append(static_cast<char>(v >> (8 * i)));
+}
+
+static void appendLE16(QByteArray &out, quint32 v)
+{
+    for (int i = 0; i < 2; i++) out.append(static_cast<char>(v >> (8 * i)));
+}
+
+static void appendBE32(QByteArray &out, quint32 v)
+{
+    for (int i = 3; i >= 0; i--) out.append(static_cast<char>(v >> (8 * i)));
+}
+
+static void appendSectionHeader(QByteArray &out)
+{
+    appendLE32(out, 0x0A0D0D0A);
+    appendLE32(out, 28);
+    appendLE32(out, 0x1A2B3C4D);
+    appendLE16(out, 1);
+    appendLE16(out, 0);
+    appendLE32(out, 0xFFFFFFFF);
+    appendLE32(out, 0xFFFFFFFF);
+    appendLE32(out, 28);
+}
+
+//resolution < 0 leaves if_tsresol out so the microsecond default applies
+static void appendInterface(QByteArray &out, int linkType, int resolution, qint64 offset)
+{
+    QByteArray body;
+    appendLE16(body, static_cast<quint32>(linkType));
+    appendLE16(body, 0);
+    appendLE32(body, 0);
+    if (resolution >= 0)
+    {
+        appendLE16(body, 9);
+        appendLE16(body, 1);
+        body.append(static_cast<char>(resolution));
+        body.append(QByteArray(3, 0));
+    }
+    if (offset)
+    {
+        appendLE16(body, 14);
+        appendLE16(body, 8);
+        appendLE32(body, static_cast<quint32>(offset));
+        appendLE32(body, static_cast<quint32>(offset >> 32));
+    }
+    appendLE32(body, 0); //end of options
+    appendLE32(out, 1);
+    appendLE32(out, static_cast<quint32>(12 + body.count()));
+    out.append(body);
+    appendLE32(out, static_cast<quint32>(12 + body.count()));
+}
+
+static void appendCANPacket(QByteArray &out, int iface, quint64 ticks, quint32 id, int len, bool fd)
+{
+    QByteArray data;
+    appendBE32(data, id);
+    data.append(static_cast<char>(len));
+    data.append(static_cast<char>(fd ? 0x05 : 0)); //FDF | BRS
+    data.append(QByteArray(2, 0));
+    for (int i = 0; i < (fd ? 64 : 8); i++) data.append(static_cast<char>(i));
+    quint32 blockLen = static_cast<quint32>(32 + data.count());
+    appendLE32(out, 6);
+    appendLE32(out, blockLen);
+    appendLE32(out, static_cast<quint32>(iface));
+    appendLE32(out, static_cast<quint32>(ticks >> 32));
+    appendLE32(out, static_cast<quint32>(ticks));
+    appendLE32(out, static_cast<quint32>(data.count()));
+    appendLE32(out, static_cast<quint32>(data.count()));
+    out.append(data);
+    appendLE32(out, blockLen);
+}
+
+QString TestPcap::writeFile(const QString &name, const QByteArray &contents)
+{
+    QString filename = tempDir.filePath(name);
+    QFile out(filename);
+    if (!out.open(QIODevice::WriteOnly)) return QString();
+    out.write(contents);
+    return filename;
+}
+
+//four buses with classic, CAN-FD, remote and transmitted frames
+void TestPcap::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+
+    for (int i = 0; i < 50000; i++)
+    {
+        CANFrame frame;
+        bool extended = (i % 3) == 0;
+        frame.setFrameId(extended ? ((0x1234567 + i) & 0x1FFFFFFF) : (i & 0x7FF));
+        frame.setExtendedFrameFormat(extended);
+        frame.bus = i % 4;
+        frame.isReceived = (i % 5) != 0;
+        int len = (i % 9 == 0) ? 9 + (i % 56) : (i % 9);
+        QByteArray data(len, 0);
+        for (int d = 0; d < len; d++) data[d] = static_cast<char>((i * 7) + d);
+        frame.setPayload(data);
+        if (len > 8)
+        {
+            frame.setFlexibleDataRateFormat(true);
+            frame.setBitrateSwitch(i & 1);
+        }
+        else if (i % 77 == 0) frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, 1000000 + (i * 137)));
+        frames.append(frame);
+    }
+}
+
+void TestPcap::pcapngRoundTrip()
+{
+    QString filename = tempDir.filePath("roundtrip.pcapng");
+    QVERIFY(FrameFileIO::saveWiresharkFile(filename, &frames));
+    QVERIFY(FrameFileIO::isWiresharkSocketCANFile(filename));
+
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::autoDetectLoadFile(filename, &loaded));
+    QCOMPARE(loaded.count(), frames.count());
+    for (int i = 0; i < loaded.count(); i++)
+    {
+        CANFrame want = frames.at(i);
+        const CANFrame &got = loaded.at(i);
+        QCOMPARE(got.frameId(), want.frameId());
+        QCOMPARE(got.hasExtendedFrameFormat(), want.hasExtendedFrameFormat());
+        QCOMPARE(got.frameType(), want.frameType());
+        QCOMPARE(got.hasFlexibleDataRateFormat(), want.hasFlexibleDataRateFormat());
+        QCOMPARE(got.hasBitrateSwitch(), want.hasBitrateSwitch());
+        QCOMPARE(got.bus, want.bus);
+        QCOMPARE(got.isReceived, want.isReceived);
+        QCOMPARE(got.payload(), want.payload());
+        QCOMPARE(got.timeStamp().microSeconds(), static_cast<qint64>(i * 137)); //relative to the first frame
+    }
+}
+
+//a capture that starts on a later bus and skips some still comes back on the same buses
+void TestPcap::pcapngKeepsBusNumbers()
+{
+    const int buses[] = {2, 2, 5, 0, 5, 2};
+    CANFrameStore store;
+    for (int i = 0; i < 6; i++)
+    {
+        CANFrame frame;
+        frame.setFrameId(0x100 + i);
+        frame.bus = buses[i];
+        frame.isReceived = true;
+        frame.setPayload(QByteArray(1, static_cast<char>(i)));
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, i * 10));
+        store.append(frame);
+    }
+
+    QString filename = tempDir.filePath("buses.pcapng");
+    QVERIFY(FrameFileIO::saveWiresharkFile(filename, &store));
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::autoDetectLoadFile(filename, &loaded));
+    QCOMPARE(loaded.count(), 6);
+    for (int i = 0; i < 6; i++)
+    {
+        QCOMPARE(loaded.at(i).frameId(), static_cast<quint32>(0x100 + i));
+        QCOMPARE(loaded.at(i).bus, buses[i]);
+    }
+}
+
+//big endian classic pcap with the nanosecond magic
+void TestPcap::classicNanoseconds()
+{
+    QByteArray file;
+    appendBE32(file, 0xA1B23C4D);
+    file.append(QByteArray(16, 0));
+    appendBE32(file, PCAP_LINKTYPE_SOCKETCAN);
+    for (int i = 0; i < 3; i++)
+    {
+        appendBE32(file, static_cast<quint32>(100 + i));
+        appendBE32(file, static_cast<quint32>(500 + (i * 1000)));
+        appendBE32(file, 16);
+        appendBE32(file, 16);
+        appendBE32(file, static_cast<quint32>(0x123 + i));
+        file.append(static_cast<char>(2));
+        file.append(QByteArray(3, 0));
+        file.append(static_cast<char>(0xAA));
+        file.append(static_cast<char>(i));
+        file.append(QByteArray(6, 0));
+    }
+    QString filename = writeFile("nanoseconds.pcap", file);
+
+    PcapReader reader;
+    QVERIFY(reader.open(filename));
+    QCOMPARE(reader.linkType(), static_cast<int>(PCAP_LINKTYPE_SOCKETCAN));
+    pcap_packet packet;
+    for (int i = 0; i < 3; i++)
+    {
+        QVERIFY(reader.next(packet));
+        QCOMPARE(packet.timestamp, ((100ll + i) * 1000000000ll) + 500 + (i * 1000));
+    }
+    QVERIFY(!reader.next(packet));
+
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::loadWiresharkSocketCANFile(filename, &loaded));
+    QCOMPARE(loaded.count(), 3);
+    QCOMPARE(loaded.at(1).frameId(), 0x124u);
+    QCOMPARE(loaded.at(1).timeStamp().microSeconds(), 1000001ll);
+    QCOMPARE(loaded.at(2).payload(), QByteArray("\xAA\x02", 2));
+}
+
+//two sections, per interface time stamp resolution and offset, and an interface that isn't CAN
+void TestPcap::multipleInterfaces()
+{
+    QByteArray file;
+    appendSectionHeader(file);
+    appendInterface(file, PCAP_LINKTYPE_SOCKETCAN, 9, 0);        //bus 0, nanoseconds
+    appendInterface(file, 1, -1, 0);                             //ethernet, skipped
+    appendInterface(file, PCAP_LINKTYPE_SOCKETCAN, 0x80 | 10, 5); //bus 2, 1/1024 s plus 5 s
+    appendCANPacket(file, 0, 2000000000ull, 0x100, 8, false);
+    appendCANPacket(file, 2, (3ull << 10) | 512, 0x200, 20, true);
+    appendSectionHeader(file);
+    appendInterface(file, PCAP_LINKTYPE_SOCKETCAN, -1, 0);       //bus 3, microseconds
+    appendCANPacket(file, 0, 4000000, 0x300, 3, false);
+    QString filename = writeFile("multi.pcapng", file);
+
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::loadWiresharkSocketCANFile(filename, &loaded));
+    QCOMPARE(loaded.count(), 3);
+
+    QCOMPARE(loaded.at(0).bus, 0);
+    QCOMPARE(loaded.at(0).frameId(), 0x100u);
+    QCOMPARE(loaded.at(0).timeStamp().microSeconds(), 0ll);
+
+    QCOMPARE(loaded.at(1).bus, 2);
+    QVERIFY(loaded.at(1).hasFlexibleDataRateFormat());
+    QVERIFY(loaded.at(1).hasBitrateSwitch());
+    QCOMPARE(loaded.at(1).payload().count(), 20);
+    QCOMPARE(loaded.at(1).timeStamp().microSeconds(), 6500000ll); //8.5 s against 2 s
+
+    QCOMPARE(loaded.at(2).bus, 3);
+    QCOMPARE(loaded.at(2).payload().count(), 3);
+    QCOMPARE(loaded.at(2).timeStamp().microSeconds(), 2000000ll);
+}
+
+//a capture cut off mid packet loads up to the damage
+void TestPcap::truncatedFile()
+{
+    QString filename = tempDir.filePath("truncated.pcapng");
+    QVERIFY(FrameFileIO::saveWiresharkFile(filename, &frames));
+    QFile file(filename);
+    QVERIFY(file.resize(file.size() - 30));
+
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::loadWiresharkSocketCANFile(filename, &loaded));
+    QCOMPARE(loaded.count(), frames.count() - 1);
+}
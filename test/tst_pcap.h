@@ -0,0 +1,26 @@
+#ifndef TST_PCAP_H
+#define TST_PCAP_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include "canframestore.h"
+
+class TestPcap: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir tempDir;
+    CANFrameStore frames;
+
+    QString writeFile(const QString &name, const QByteArray &contents);
+
+private slots:
+    void initTestCase();
+    void pcapngRoundTrip();
+    void pcapngKeepsBusNumbers();
+    void classicNanoseconds();
+    void multipleInterfaces();
+    void truncatedFile();
+};
+
+#endif // TST_PCAP_H
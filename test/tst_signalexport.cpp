@@ -0,0 +1,668 @@
+#include <QtTest>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+
+#include "dbc/dbchandler.h"
+#include "utility.h"
+#include "tst_signalexport.h"
+
+
+//Just enough of a Parquet reader to check what ParquetWriter wrote: a Thrift compact protocol decoder
+//for the footer and page headers and an inflater for the gzip pages (qUncompress only takes zlib streams)
+namespace
+{
+    struct ThriftValue
+    {
+        qint64 i = 0;
+        QByteArray bin;
+        QVector<ThriftValue> list;
+        QMap<int, ThriftValue> fields;
+
+        const ThriftValue &field(int id) const
+        {
+            static const ThriftValue missing;
+            QMap<int, ThriftValue>::const_iterator it = fields.constFind(id);
+            return it == fields.constEnd() ? missing : it.value();
+        }
+        bool has(int id) const { return fields.contains(id); }
+    };
+
+    class CompactReader
+    {
+    public:
+        CompactReader(const QByteArray &data, int start = 0) : buf(data), pos(start), ok(true) {}
+
+        const QByteArray &buf;
+        int pos;
+        bool ok;
+
+        ThriftValue readStruct()
+        {
+            ThriftValue value;
+            int lastField = 0;
+            while (ok)
+            {
+                int b = byte();
+                if (b == 0) break; //stop field
+                int type = b & 0x0F;
+                int field = (b >> 4) ? lastField + (b >> 4) : static_cast<int>(zigzag());
+                value.fields[field] = readValue(type);
+                lastField = field;
+            }
+            return value;
+        }
+
+    private:
+        int byte()
+        {
+            if (pos >= buf.length())
+            {
+                ok = false;
+                return 0;
+            }
+            return static_cast<uchar>(buf.at(pos++));
+        }
+
+        quint64 varint()
+        {
+            quint64 value = 0;
+            for (int shift = 0; ok && shift < 64; shift += 7)
+            {
+                int b = byte();
+                value |= static_cast<quint64>(b & 0x7F) << shift;
+                if (!(b & 0x80)) return value;
+            }
+            ok = false;
+            return 0;
+        }
+
+        qint64 zigzag()
+        {
+            quint64 value = varint();
+            return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+        }
+
+        ThriftValue readValue(int type)
+        {
+            ThriftValue value;
+            switch (type)
+            {
+            case 1: //bool true
+            case 2: //bool false
+                value.i = (type == 1);
+                break;
+            case 5: //i32
+            case 6: //i64
+                value.i = zigzag();
+                break;
+            case 8: //binary
+            {
+                int len = static_cast<int>(varint());
+                if (len < 0 || pos + len > buf.length()) ok = false;
+                else value.bin = buf.mid(pos, len);
+                pos += len;
+                break;
+            }
+            case 9: //list
+            {
+                int b = byte();
+                int size = b >> 4;
+                if (size == 15) size = static_cast<int>(varint());
+                for (int e = 0; ok && e < size; e++) value.list.append(readValue(b & 0x0F));
+                break;
+            }
+            case 12:
+                value = readStruct();
+                break;
+            default: //nothing the writer uses
+                ok = false;
+            }
+            return value;
+        }
+    };
+
+    //RFC 1951 inflate done the simple way, a bit at a time with canonical Huffman tables
+    class Inflater
+    {
+    public:
+        Inflater(const char *data, int len) : pos(0), in(reinterpret_cast<const uchar *>(data)), inLen(len), bitBuf(0), bitCnt(0), ok(true) {}
+
+        QByteArray out;
+        int pos; //bytes of input used once run() is done
+
+        bool run()
+        {
+            int last;
+            do
+            {
+                last = bits(1);
+                int type = bits(2);
+                if (type == 0) stored();
+                else if (type == 1) fixed();
+                else if (type == 2) dynamic();
+                else ok = false;
+            } while (ok && !last);
+            return ok;
+        }
+
+    private:
+        struct Huffman
+        {
+            short count[16];
+            short symbol[288];
+        };
+
+        const uchar *in;
+        int inLen;
+        int bitBuf;
+        int bitCnt;
+        bool ok;
+
+        int bits(int need)
+        {
+            int value = bitBuf;
+            while (bitCnt < need)
+            {
+                if (pos >= inLen)
+                {
+                    ok = false;
+                    return 0;
+                }
+                value |= static_cast<int>(in[pos++]) << bitCnt;
+                bitCnt += 8;
+            }
+            bitBuf = value >> need;
+            bitCnt -= need;
+            return value & ((1 << need) - 1);
+        }
+
+        void stored()
+        {
+            bitBuf = 0;
+            bitCnt = 0;
+            if (pos + 4 > inLen)
+            {
+                ok = false;
+                return;
+            }
+            int len = in[pos] | (in[pos + 1] << 8);
+            int check = in[pos + 2] | (in[pos + 3] << 8);
+            pos += 4;
+            if (len != (~check & 0xFFFF) || pos + len > inLen)
+            {
+                ok = false;
+                return;
+            }
+            out.append(reinterpret_cast<const char *>(in + pos), len);
+            pos += len;
+        }
+
+        static bool build(Huffman &h, const short *lengths, int n)
+        {
+            for (int len = 0; len < 16; len++) h.count[len] = 0;
+            for (int s = 0; s < n; s++) h.count[lengths[s]]++;
+            if (h.count[0] == n) return true; //no codes at all
+            int left = 1;
+            for (int len = 1; len < 16; len++)
+            {
+                left <<= 1;
+                left -= h.count[len];
+                if (left < 0) return false; //over subscribed
+            }
+            short offs[16];
+            offs[1] = 0;
+            for (int len = 1; len < 15; len++) offs[len + 1] = offs[len] + h.count[len];
+            for (int s = 0; s < n; s++)
+            {
+                if (lengths[s]) h.symbol[offs[lengths[s]]++] = static_cast<short>(s);
+            }
+            return true;
+        }
+
+        int decode(const Huffman &h)
+        {
+            int code = 0;
+            int first = 0;
+            int index = 0;
+            for (int len = 1; len < 16; len++)
+            {
+                code |= bits(1);
+                int count = h.count[len];
+                if (code - count < first) return h.symbol[index + (code - first)];
+                index += count;
+                first += count;
+                first <<= 1;
+                code <<= 1;
+            }
+            ok = false;
+            return 0;
+        }
+
+        void codes(const Huffman &lencode, const Huffman &distcode)
+        {
+            static const short lenBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+            static const short lenExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+            static const short distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+            static const short distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+            while (ok)
+            {
+                int symbol = decode(lencode);
+                if (symbol < 256) out.append(static_cast<char>(symbol));
+                else if (symbol == 256) return;
+                else
+                {
+                    symbol -= 257;
+                    if (symbol >= 29)
+                    {
+                        ok = false;
+                        return;
+                    }
+                    int len = lenBase[symbol] + bits(lenExtra[symbol]);
+                    int distSym = decode(distcode);
+                    if (distSym >= 30)
+                    {
+                        ok = false;
+                        return;
+                    }
+                    int dist = distBase[distSym] + bits(distExtra[distSym]);
+                    if (dist > out.length())
+                    {
+                        ok = false;
+                        return;
+                    }
+                    for (int i = 0; i < len; i++) out.append(out.at(out.length() - dist));
+                }
+            }
+        }
+
+        void fixed()
+        {
+            Huffman lencode, distcode;
+            short lengths[288];
+            for (int s = 0; s < 144; s++) lengths[s] = 8;
+            for (int s = 144; s < 256; s++) lengths[s] = 9;
+            for (int s = 256; s < 280; s++) lengths[s] = 7;
+            for (int s = 280; s < 288; s++) lengths[s] = 8;
+            build(lencode, lengths, 288);
+            for (int s = 0; s < 30; s++) lengths[s] = 5;
+            build(distcode, lengths, 30);
+            codes(lencode, distcode);
+        }
+
+        void dynamic()
+        {
+            static const short order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+            short lengths[320];
+            int nlen = bits(5) + 257;
+            int ndist = bits(5) + 1;
+            int ncode = bits(4) + 4;
+            if (nlen > 286 || ndist > 30)
+            {
+                ok = false;
+                return;
+            }
+            for (int i = 0; i < 19; i++) lengths[order[i]] = i < ncode ? static_cast<short>(bits(3)) : 0;
+            Huffman lencode, distcode;
+            if (!build(lencode, lengths, 19))
+            {
+                ok = false;
+                return;
+            }
+
+            int index = 0;
+            while (ok && index < nlen + ndist)
+            {
+                int symbol = decode(lencode);
+                if (symbol < 16)
+                {
+                    lengths[index++] = static_cast<short>(symbol);
+                    continue;
+                }
+                short len = 0;
+                if (symbol == 16)
+                {
+                    if (index == 0)
+                    {
+                        ok = false;
+                        return;
+                    }
+                    len = lengths[index - 1];
+                    symbol = 3 + bits(2);
+                }
+                else if (symbol == 17) symbol = 3 + bits(3);
+                else symbol = 11 + bits(7);
+                if (index + symbol > nlen + ndist)
+                {
+                    ok = false;
+                    return;
+                }
+                while (symbol--) lengths[index++] = len;
+            }
+            if (!ok || lengths[256] == 0 || !build(lencode, lengths, nlen) || !build(distcode, lengths + nlen, ndist))
+            {
+                ok = false;
+                return;
+            }
+            codes(lencode, distcode);
+        }
+    };
+
+    //one gzip member as appendGzip writes it, checked against its CRC and length
+    bool gunzip(const char *data, int len, QByteArray &out)
+    {
+        const uchar *bytes = reinterpret_cast<const uchar *>(data);
+        if (len < 18 || bytes[0] != 0x1F || bytes[1] != 0x8B || bytes[2] != 8 || bytes[3] != 0) return false;
+        Inflater inflater(data + 10, len - 18);
+        if (!inflater.run()) return false;
+        out = inflater.out;
+        const uchar *trailer = bytes + len - 8;
+        quint32 crc = qFromLittleEndian<quint32>(trailer);
+        quint32 size = qFromLittleEndian<quint32>(trailer + 4);
+        return crc == Utility::crc32(out.constData(), out.length()) && size == static_cast<quint32>(out.length());
+    }
+}
+
+
+static const char testDBC[] =
+    "VERSION \"\"\n"
+    "\n"
+    "BU_: ECU\n"
+    "\n"
+    "BO_ 256 Engine: 8 ECU\n"
+    " SG_ RPM : 0|16@1+ (1,0) [0|65535] \"rpm\" Vector__XXX\n"
+    "\n"
+    "BO_ 512 Chassis: 8 ECU\n"
+    " SG_ Speed : 0|16@1+ (1,0) [0|65535] \"kph\" Vector__XXX\n";
+
+static CANFrame makeFrame(uint32_t id, int64_t timeStamp, int value)
+{
+    CANFrame frame;
+    frame.setFrameId(id);
+    frame.bus = 0;
+    frame.isReceived = true;
+    QByteArray data(8, 0);
+    data[0] = static_cast<char>(value & 0xFF);
+    data[1] = static_cast<char>((value >> 8) & 0xFF);
+    frame.setPayload(data);
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, timeStamp));
+    return frame;
+}
+
+
+//Engine every 10ms at 3ms past, Chassis every 20ms at 8ms past. Resampled every 10ms that gives
+//rows at 1.00 through 1.09s with samples on both sides of most of them
+void TestSignalExport::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+    savedBlockFrames = SignalExporter::blockFrames;
+    savedRowsPerGroup = SignalExporter::rowsPerGroup;
+    //small enough that blocks and row groups both get split up
+    SignalExporter::blockFrames = 3;
+    SignalExporter::rowsPerGroup = 4;
+
+    QString dbcName = tempDir.filePath("test.dbc");
+    QFile dbcFile(dbcName);
+    QVERIFY(dbcFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    dbcFile.write(testDBC);
+    dbcFile.close();
+    QVERIFY(DBCHandler::getReference()->loadDBCFile(dbcName) != nullptr);
+
+    QVector<CANFrame> list;
+    for (int i = 0; i < 10; i++)
+    {
+        list.append(makeFrame(0x100, 1000000 + i * 10000 + 3000, i));
+        if (i < 5) list.append(makeFrame(0x200, 1000000 + i * 20000 + 8000, 100 + i));
+    }
+    std::stable_sort(list.begin(), list.end(), [](const CANFrame &a, const CANFrame &b)
+    {
+        return a.timeStamp().microSeconds() < b.timeStamp().microSeconds();
+    });
+    frames.append(list);
+}
+
+void TestSignalExport::cleanupTestCase()
+{
+    SignalExporter::blockFrames = savedBlockFrames;
+    SignalExporter::rowsPerGroup = savedRowsPerGroup;
+    DBCHandler::getReference()->removeAllFiles();
+}
+
+bool TestSignalExport::setupExporter(SignalExporter &exporter)
+{
+    DBCFile *file = DBCHandler::getReference()->getFileByIdx(0);
+    if (!file) return false;
+    DBC_MESSAGE *engine = file->messageHandler->findMsgByName("Engine");
+    DBC_MESSAGE *chassis = file->messageHandler->findMsgByName("Chassis");
+    if (!engine || !chassis) return false;
+    exporter.setPeriod(10000);
+    return exporter.addSignal(engine, engine->sigHandler->findSignalByName("RPM"))
+        && exporter.addSignal(chassis, chassis->sigHandler->findSignalByName("Speed"));
+}
+
+QVector<QVector<QByteArray>> TestSignalExport::readCSV(const QString &filename)
+{
+    QVector<QVector<QByteArray>> rows;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return rows;
+    while (!file.atEnd())
+    {
+        QByteArray line = file.readLine().trimmed();
+        if (!line.isEmpty()) rows.append(line.split(',').toVector());
+    }
+    return rows;
+}
+
+//a row holds whatever came last at or before its time, nothing at all before the first sample
+void TestSignalExport::sampleAndHold()
+{
+    SignalExporter exporter(DBCHandler::getReference());
+    QVERIFY(setupExporter(exporter));
+    exporter.setJoinMode(SignalExporter::JOIN_HOLD);
+
+    QString filename = tempDir.filePath("hold.csv");
+    QVERIFY2(exporter.run(SignalExporter::storeSource(&frames), filename, SignalExporter::OUTPUT_CSV), qPrintable(exporter.errorString()));
+    QCOMPARE(exporter.framesRead(), static_cast<quint64>(frames.count()));
+    QCOMPARE(exporter.rowsWritten(), static_cast<quint64>(10));
+
+    QVector<QVector<QByteArray>> rows = readCSV(filename);
+    QCOMPARE(rows.count(), 11);
+    QCOMPARE(rows.at(0), QVector<QByteArray>() << "Time" << "Engine.RPM" << "Chassis.Speed");
+    for (int k = 0; k < 10; k++)
+    {
+        const QVector<QByteArray> &row = rows.at(k + 1);
+        QCOMPARE(row.count(), 3);
+        QCOMPARE(qRound64(row.at(0).toDouble() * 1000000.0), 1000000ll + k * 10000);
+        QCOMPARE(row.at(1), k == 0 ? QByteArray() : QByteArray::number(k - 1));
+        QCOMPARE(row.at(2), k == 0 ? QByteArray() : QByteArray::number(100 + (k * 10000 - 8000) / 20000));
+    }
+}
+
+//within half a period either way the closest sample wins, otherwise the held value stays
+void TestSignalExport::nearest()
+{
+    SignalExporter exporter(DBCHandler::getReference());
+    QVERIFY(setupExporter(exporter));
+    exporter.setJoinMode(SignalExporter::JOIN_NEAREST);
+
+    QString filename = tempDir.filePath("nearest.csv");
+    QVERIFY2(exporter.run(SignalExporter::storeSource(&frames), filename, SignalExporter::OUTPUT_CSV), qPrintable(exporter.errorString()));
+
+    QVector<QVector<QByteArray>> rows = readCSV(filename);
+    QCOMPARE(rows.count(), 11);
+    for (int k = 0; k < 10; k++)
+    {
+        const QVector<QByteArray> &row = rows.at(k + 1);
+        QCOMPARE(row.at(1), QByteArray::number(k));
+        QByteArray speed;
+        if (k & 1) speed = QByteArray::number(100 + (k - 1) / 2);
+        else if (k > 0) speed = QByteArray::number(100 + (k * 10000 - 8000) / 20000);
+        QCOMPARE(row.at(2), speed);
+    }
+}
+
+//the footer and every page are decoded again and the values compared with what sampleAndHold expects
+void TestSignalExport::parquet()
+{
+    SignalExporter exporter(DBCHandler::getReference());
+    QVERIFY(setupExporter(exporter));
+
+    QString filename = tempDir.filePath("signals.parquet");
+    QVERIFY2(exporter.run(SignalExporter::storeSource(&frames), filename, SignalExporter::OUTPUT_PARQUET), qPrintable(exporter.errorString()));
+    QCOMPARE(exporter.rowsWritten(), static_cast<quint64>(10));
+
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray data = file.readAll();
+    QVERIFY(data.length() > 12);
+    QCOMPARE(data.left(4), QByteArray("PAR1"));
+    QCOMPARE(data.right(4), QByteArray("PAR1"));
+    quint32 footerLen = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(data.constData() + data.length() - 8));
+    QVERIFY(footerLen > 0 && footerLen < static_cast<quint32>(data.length() - 12));
+
+    CompactReader footerReader(data, data.length() - 8 - static_cast<int>(footerLen));
+    ThriftValue meta = footerReader.readStruct();
+    QVERIFY(footerReader.ok);
+    QCOMPARE(footerReader.pos, data.length() - 8);
+    QCOMPARE(meta.field(1).i, 1ll); //version
+    QCOMPARE(meta.field(3).i, 10ll); //num_rows
+
+    //schema: the root and then a required double per column
+    const QStringList names = QStringList() << "Time" << "Engine.RPM" << "Chassis.Speed";
+    const QVector<ThriftValue> &schema = meta.field(2).list;
+    QCOMPARE(schema.count(), names.count() + 1);
+    QCOMPARE(schema.at(0).field(5).i, static_cast<qint64>(names.count())); //num_children
+    for (int c = 0; c < names.count(); c++)
+    {
+        const ThriftValue &element = schema.at(c + 1);
+        QCOMPARE(element.field(1).i, 5ll); //DOUBLE
+        QCOMPARE(element.field(3).i, 0ll); //REQUIRED
+        QCOMPARE(QString::fromUtf8(element.field(4).bin), names.at(c));
+    }
+
+    //rowsPerGroup is 4 so that's 4 + 4 + 2 rows
+    QVector<QVector<double>> columns(names.count());
+    const QVector<ThriftValue> &rowGroups = meta.field(4).list;
+    QCOMPARE(rowGroups.count(), 3);
+    for (int g = 0; g < rowGroups.count(); g++)
+    {
+        const ThriftValue &group = rowGroups.at(g);
+        qint64 rows = group.field(3).i;
+        QCOMPARE(rows, g < 2 ? 4ll : 2ll);
+        QCOMPARE(group.field(1).list.count(), names.count());
+        for (int c = 0; c < names.count(); c++)
+        {
+            const ThriftValue &chunk = group.field(1).list.at(c);
+            const ThriftValue &colMeta = chunk.field(3);
+            QCOMPARE(colMeta.field(1).i, 5ll); //DOUBLE
+            QCOMPARE(colMeta.field(3).list.count(), 1);
+            QCOMPARE(QString::fromUtf8(colMeta.field(3).list.at(0).bin), names.at(c)); //path_in_schema
+            QCOMPARE(colMeta.field(4).i, 2ll); //GZIP
+            QCOMPARE(colMeta.field(5).i, rows); //num_values
+            qint64 offset = colMeta.field(9).i; //data_page_offset
+            QCOMPARE(chunk.field(2).i, offset);
+            QVERIFY(offset >= 4 && offset + colMeta.field(7).i <= data.length() - 8 - static_cast<qint64>(footerLen));
+
+            CompactReader pageReader(data, static_cast<int>(offset));
+            ThriftValue page = pageReader.readStruct();
+            QVERIFY(pageReader.ok);
+            QCOMPARE(page.field(1).i, 0ll); //DATA_PAGE
+            QCOMPARE(page.field(2).i, rows * 8); //uncompressed_page_size
+            QCOMPARE(page.field(5).field(1).i, rows); //num_values
+            QCOMPARE(page.field(5).field(2).i, 0ll); //PLAIN
+            int headerLen = pageReader.pos - static_cast<int>(offset);
+            int compressedLen = static_cast<int>(page.field(3).i);
+            QCOMPARE(static_cast<qint64>(headerLen + compressedLen), colMeta.field(7).i); //total_compressed_size
+            QCOMPARE(static_cast<qint64>(headerLen) + page.field(2).i, colMeta.field(6).i); //total_uncompressed_size
+
+            QByteArray plain;
+            QVERIFY(gunzip(data.constData() + pageReader.pos, compressedLen, plain));
+            QCOMPARE(static_cast<qint64>(plain.length()), rows * 8);
+            for (int r = 0; r < rows; r++)
+            {
+                quint64 bits = qFromLittleEndian<quint64>(reinterpret_cast<const uchar *>(plain.constData() + r * 8));
+                double value;
+                memcpy(&value, &bits, sizeof(value));
+                columns[c].append(value);
+            }
+        }
+    }
+
+    for (int k = 0; k < 10; k++)
+    {
+        QCOMPARE(qRound64(columns.at(0).at(k) * 1000000.0), 1000000ll + k * 10000);
+        if (k == 0)
+        {
+            QVERIFY(qIsNaN(columns.at(1).at(k)));
+            QVERIFY(qIsNaN(columns.at(2).at(k)));
+            continue;
+        }
+        QCOMPARE(columns.at(1).at(k), static_cast<double>(k - 1));
+        QCOMPARE(columns.at(2).at(k), static_cast<double>(100 + (k * 10000 - 8000) / 20000));
+    }
+}
+
+void TestSignalExport::rejectsNothingToExport()
+{
+    SignalExporter exporter(DBCHandler::getReference());
+    QString filename = tempDir.filePath("empty.csv");
+    QVERIFY(!exporter.run(SignalExporter::storeSource(&frames), filename, SignalExporter::OUTPUT_CSV));
+    QVERIFY(!exporter.errorString().isEmpty());
+    QVERIFY(!QFile::exists(filename));
+
+    DBC_MESSAGE msg;
+    DBC_SIGNAL text;
+    text.valType = STRING;
+    QVERIFY(!exporter.addSignal(&msg, &text));
+    QCOMPARE(exporter.signalCount(), 0);
+}
+
+//the workers all decode the same signal at once. That may only read the decode plan, the signal's
+//cachedValue belongs to the GUI thread
+void TestSignalExport::decodeOnWorkers()
+{
+    DBCFile *file = DBCHandler::getReference()->getFileByIdx(0);
+    QVERIFY(file);
+    DBC_MESSAGE *engine = file->messageHandler->findMsgByName("Engine");
+    QVERIFY(engine);
+    DBC_SIGNAL *rpm = engine->sigHandler->findSignalByName("RPM");
+    QVERIFY(rpm);
+
+    QVector<CANFrame> list;
+    for (int i = 0; i < 20000; i++) list.append(makeFrame(0x100, 2000000 + i * 1000, i));
+
+    engine->decodePlan();
+    rpm->cachedValue = QString("untouched");
+    QVector<int> slices;
+    for (int s = 0; s < 16; s++) slices.append(s);
+    QAtomicInt wrong;
+    QtConcurrent::blockingMap(slices, [&list, engine, rpm, &wrong](int s)
+    {
+        DBC_SIGNAL_VALUE val;
+        //every slice covers all frames, so each frame is decoded by all the slices
+        for (int n = 0; n < list.count(); n++)
+        {
+            int i = (n + s * 1237) % list.count();
+            if (!engine->evaluateSignal(list.at(i), rpm, val) || !val.present || val.value != i) wrong.ref();
+        }
+    });
+    QCOMPARE(wrong.loadRelaxed(), 0);
+    QCOMPARE(rpm->cachedValue.toString(), QString("untouched"));
+
+    //and through the exporter with blocks big enough to be cut into a slice per core
+    int blockFrames = SignalExporter::blockFrames;
+    SignalExporter::blockFrames = 8192;
+    CANFrameStore store(list);
+    SignalExporter exporter(DBCHandler::getReference());
+    QVERIFY(exporter.addSignal(engine, rpm));
+    exporter.setPeriod(1000);
+    QString filename = tempDir.filePath("workers.csv");
+    bool ok = exporter.run(SignalExporter::storeSource(&store), filename, SignalExporter::OUTPUT_CSV);
+    SignalExporter::blockFrames = blockFrames;
+    QVERIFY2(ok, qPrintable(exporter.errorString()));
+    QCOMPARE(rpm->cachedValue.toString(), QString("untouched"));
+
+    QVector<QVector<QByteArray>> rows = readCSV(filename);
+    QCOMPARE(rows.count(), list.count() + 1);
+    for (int i = 0; i < list.count(); i++) QCOMPARE(rows.at(i + 1).at(1), QByteArray::number(i));
+}
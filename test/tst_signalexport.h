@@ -0,0 +1,31 @@
+#ifndef TST_SIGNALEXPORT_H
+#define TST_SIGNALEXPORT_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include "canframestore.h"
+#include "utils/signalexporter.h"
+
+class TestSignalExport: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir tempDir;
+    CANFrameStore frames;
+    int savedBlockFrames;
+    int savedRowsPerGroup;
+
+    bool setupExporter(SignalExporter &exporter);
+    QVector<QVector<QByteArray>> readCSV(const QString &filename);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void sampleAndHold();
+    void nearest();
+    void parquet();
+    void rejectsNothingToExport();
+    void decodeOnWorkers();
+};
+
+#endif // TST_SIGNALEXPORT_H
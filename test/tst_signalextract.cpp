@@ -0,0 +1,94 @@
+#include <QtTest>
+
+#include "utility.h"
+#include "tst_signalextract.h"
+
+
+static QByteArray makePayload(int length, bool allOnes)
+{
+    QByteArray data(length, 0);
+    quint32 seed = 0x12345678u + static_cast<quint32>(length);
+    for (int i = 0; i < length; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = allOnes ? static_cast<char>(0xFF) : static_cast<char>(seed >> 16);
+    }
+    return data;
+}
+
+
+void TestSignalExtract::matchesBitwise_data()
+{
+    QTest::addColumn<int>("length");
+    QTest::addColumn<bool>("allOnes");
+
+    //short payloads exercise the "signal runs off the end" paths, 64 is a full CAN-FD frame
+    QTest::newRow("0")          <<  0 << false;
+    QTest::newRow("3")          <<  3 << false;
+    QTest::newRow("8")          <<  8 << false;
+    QTest::newRow("8 ones")     <<  8 << true;
+    QTest::newRow("12")         << 12 << false;
+    QTest::newRow("20")         << 20 << false;
+    QTest::newRow("64")         << 64 << false;
+    QTest::newRow("64 ones")    << 64 << true;
+}
+
+
+//every start bit, size and byte order must come out exactly like the old bit at a time routine
+void TestSignalExtract::matchesBitwise()
+{
+    QFETCH(int, length);
+    QFETCH(bool, allOnes);
+
+    QByteArray data = makePayload(length, allOnes);
+
+    for (int startBit = 0; startBit < 520; startBit++)
+    {
+        for (int sigSize = 1; sigSize <= 64; sigSize++)
+        {
+            for (int order = 0; order < 4; order++)
+            {
+                bool littleEndian = (order & 1);
+                bool isSigned = (order & 2);
+                int64_t expected = Utility::processIntegerSignalBitwise(data, startBit, sigSize, littleEndian, isSigned);
+                int64_t actual = Utility::processIntegerSignal(data, startBit, sigSize, littleEndian, isSigned);
+                if (expected != actual)
+                {
+                    QFAIL(qPrintable(QString("start %1 size %2 intel %3 signed %4: expected %5 got %6")
+                                     .arg(startBit).arg(sigSize).arg(littleEndian).arg(isSigned)
+                                     .arg(expected).arg(actual)));
+                }
+            }
+        }
+    }
+}
+
+
+void TestSignalExtract::benchmark_data()
+{
+    QTest::addColumn<bool>("bitwise");
+
+    QTest::newRow("bitwise")    << true;
+    QTest::newRow("word")       << false;
+}
+
+
+//typical mix of 16 bit signals from classic frames. Compare the two rows for signals/s
+void TestSignalExtract::benchmark()
+{
+    QFETCH(bool, bitwise);
+
+    QByteArray data = makePayload(8, false);
+    int64_t sum = 0;
+
+    QBENCHMARK {
+        for (int i = 0; i < 10000; i++)
+        {
+            int startBit = (i * 7) & 31;
+            bool littleEndian = (i & 1);
+            if (bitwise) sum += Utility::processIntegerSignalBitwise(data, startBit, 16, littleEndian, true);
+            else sum += Utility::processIntegerSignal(data, startBit, 16, littleEndian, true);
+        }
+    }
+    QVERIFY(sum != 0x7FFFFFFFFFFFFFFFll); //keep the loop from being optimized away
+}
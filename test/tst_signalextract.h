@@ -0,0 +1,18 @@
+#ifndef TST_SIGNALEXTRACT_H
+#define TST_SIGNALEXTRACT_H
+
+#include <QObject>
+
+class TestSignalExtract: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void matchesBitwise_data();
+    void matchesBitwise();
+    void benchmark_data();
+    void benchmark();
+};
+
+#endif // TST_SIGNALEXTRACT_H
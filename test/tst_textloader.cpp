@@ -0,0 +1,298 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include "framefileio.h"
+#include "utils/chunkedtextloader.h"
+#include "utils/filesniff.h"
+#include "tst_textloader.h"
+
+
+static QVector<CANFrame> makeFrames(int count)
+{
+    QVector<CANFrame> frames;
+    quint32 seed = 0x1234567u;
+    for (int i = 0; i < count; i++)
+    {
+        CANFrame frame;
+        seed = seed * 1103515245u + 12345u;
+        bool extended = (seed >> 16) & 1;
+        frame.setFrameId(extended ? (((seed >> 3) & 0x1FFFFFFF) | 0x800) : ((seed >> 5) & 0x7FF));
+        frame.setExtendedFrameFormat(extended);
+        frame.bus = static_cast<int>((seed >> 20) % 3);
+        frame.isReceived = (seed >> 24) & 1;
+        QByteArray data(static_cast<int>((seed >> 8) % 9), 0);
+        for (int d = 0; d < data.length(); d++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            data[d] = static_cast<char>(seed >> 16);
+        }
+        frame.setPayload(data);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, 1551774790000000ll + (i * 137ll)));
+        frames.append(frame);
+    }
+    return frames;
+}
+
+
+//write the frames out the way each format's logger would
+QString TestTextLoader::writeFile(const QString &format, int numFrames)
+{
+    if (expected.count() < numFrames) expected = makeFrames(numFrames);
+    QString filename = tempDir.filePath(format + QString::number(numFrames));
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) return QString();
+
+    if (format == "native") file.write("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n");
+    if (format == "asc") file.write("date Mon Mar 4 09:13:10 am 2019\nbase hex  timestamps absolute\ninternal events logged\n// version 8.0.0\nBegin Triggerblock Mon Mar 4 09:13:10 am 2019\n");
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        const CANFrame &frame = expected.at(i);
+        qint64 stamp = frame.timeStamp().microSeconds();
+        QByteArray seconds = QByteArray::number(stamp / 1000000) + "." + QByteArray::number(stamp % 1000000).rightJustified(6, '0');
+        QByteArray id = QByteArray::number(frame.frameId(), 16).toUpper();
+        QByteArray line;
+        if (format == "native")
+        {
+            line = QByteArray::number(stamp) + "," + id.rightJustified(8, '0') + (frame.hasExtendedFrameFormat() ? ",true," : ",false,")
+                   + (frame.isReceived ? "Rx," : "Tx,") + QByteArray::number(frame.bus) + "," + QByteArray::number(frame.payload().length()) + ",";
+            for (int d = 0; d < 8; d++) line += (d < frame.payload().length() ? frame.payload().mid(d, 1).toHex().toUpper() : QByteArray("00")) + ",";
+        }
+        else if (format == "candump")
+        {
+            //alternate between the two candump layouts
+            line = "(" + seconds + ") can" + QByteArray::number(frame.bus) + " ";
+            if (i & 1) line += (frame.hasExtendedFrameFormat() ? id.rightJustified(8, '0') : id.rightJustified(3, '0')) + "#" + frame.payload().toHex();
+            else
+            {
+                line += id + " [" + QByteArray::number(frame.payload().length()) + "]";
+                for (int d = 0; d < frame.payload().length(); d++) line += " " + frame.payload().mid(d, 1).toHex().toUpper();
+            }
+        }
+        else if (format == "asc")
+        {
+            line = seconds + " " + QByteArray::number(frame.bus) + " " + id + (frame.hasExtendedFrameFormat() ? "x " : " ")
+                   + (frame.isReceived ? "Rx" : "Tx") + " d " + QByteArray::number(frame.payload().length());
+            for (int d = 0; d < frame.payload().length(); d++) line += " " + frame.payload().mid(d, 1).toHex().toUpper();
+        }
+        file.write(line + "\n");
+    }
+    if (format == "asc") file.write("End TriggerBlock\n");
+    file.close();
+    return filename;
+}
+
+bool TestTextLoader::load(const QString &format, const QString &filename, QVector<CANFrame> *frames)
+{
+    if (format == "native") return FrameFileIO::loadNativeCSVFile(filename, frames);
+    if (format == "candump") return FrameFileIO::loadCanDumpFile(filename, frames);
+    return FrameFileIO::loadCanalyzerASC(filename, frames);
+}
+
+
+void TestTextLoader::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+    savedChunkBytes = ChunkedTextLoader::minChunkBytes;
+}
+
+void TestTextLoader::cleanupTestCase()
+{
+    ChunkedTextLoader::minChunkBytes = savedChunkBytes;
+}
+
+
+void TestTextLoader::matchesWrittenFrames_data()
+{
+    QTest::addColumn<QString>("format");
+    QTest::addColumn<int>("chunkBytes");
+
+    //tiny chunks put plenty of chunk boundaries in the file, one huge chunk is the sequential case
+    QTest::newRow("native chunked")     << "native"  << 4096;
+    QTest::newRow("native whole")       << "native"  << 0x7FFFFFFF;
+    QTest::newRow("candump chunked")    << "candump" << 4096;
+    QTest::newRow("candump whole")      << "candump" << 0x7FFFFFFF;
+    QTest::newRow("asc chunked")        << "asc"     << 4096;
+    QTest::newRow("asc whole")          << "asc"     << 0x7FFFFFFF;
+}
+
+//every frame must come back in file order with the fields that format carries
+void TestTextLoader::matchesWrittenFrames()
+{
+    QFETCH(QString, format);
+    QFETCH(int, chunkBytes);
+
+    QString filename = writeFile(format, 5000);
+    QVERIFY(!filename.isEmpty());
+    ChunkedTextLoader::minChunkBytes = chunkBytes;
+
+    QVector<CANFrame> frames;
+    QVERIFY(load(format, filename, &frames));
+    QCOMPARE(frames.count(), 5000);
+    for (int i = 0; i < frames.count(); i++)
+    {
+        const CANFrame &want = expected.at(i);
+        const CANFrame &got = frames.at(i);
+        QCOMPARE(got.timeStamp().microSeconds(), want.timeStamp().microSeconds());
+        QCOMPARE(got.frameId(), want.frameId());
+        QCOMPARE(got.payload(), want.payload());
+        QCOMPARE(got.bus, want.bus);
+        if (format != "candump")
+        {
+            QCOMPARE(got.isReceived, want.isReceived);
+            QCOMPARE(got.hasExtendedFrameFormat(), want.hasExtendedFrameFormat());
+        }
+    }
+}
+
+
+void TestTextLoader::autoDetects_data()
+{
+    QTest::addColumn<QString>("format");
+    QTest::addColumn<QString>("detected");
+
+    QTest::newRow("native")     << "native"  << "native CSV";
+    QTest::newRow("candump")    << "candump" << "candump";
+    QTest::newRow("asc")        << "asc"     << "Canalyzer ASC";
+}
+
+//the best scoring probe should be right the first time, no other loader gets a go
+void TestTextLoader::autoDetects()
+{
+    QFETCH(QString, format);
+    QFETCH(QString, detected);
+
+    QString filename = writeFile(format, 2000);
+    QVERIFY(!filename.isEmpty());
+    ChunkedTextLoader::minChunkBytes = savedChunkBytes;
+
+    QVector<CANFrame> frames;
+    QVERIFY(FrameFileIO::autoDetectLoadFile(filename, &frames));
+    QCOMPARE(frames.count(), 2000);
+    const AutoDetectStats &stats = FrameFileIO::lastAutoDetect();
+    QCOMPARE(stats.format, detected);
+    QCOMPARE(stats.formatsTried, 1);
+    QVERIFY(stats.totalMicros >= stats.sniffMicros + stats.probeMicros);
+}
+
+//FD frames in either candump layout have to get past the probe, not just the parser
+void TestTextLoader::canDumpFD()
+{
+    QString filename = tempDir.filePath("candumpfd");
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QVector<QByteArray> payloads;
+    for (int i = 0; i < 40; i++)
+    {
+        static const int fdLengths[] = {12, 16, 20, 24, 32, 48, 64};
+        QByteArray data(fdLengths[i % 7], 0);
+        for (int d = 0; d < data.length(); d++) data[d] = static_cast<char>(i + d);
+        payloads.append(data);
+        QByteArray line = "(1551774790." + QByteArray::number(100000 + i) + ") can0 ";
+        if (i & 1) line += "1A3##" + QByteArray::number(i & 3, 16) + data.toHex();
+        else
+        {
+            line += "1A3 [" + QByteArray::number(data.length()).rightJustified(2, '0') + "]";
+            for (int d = 0; d < data.length(); d++) line += " " + data.mid(d, 1).toHex().toUpper();
+        }
+        file.write(line + "\n");
+    }
+    file.close();
+
+    QVERIFY(FrameFileIO::isCanDumpFile(filename));
+    ChunkedTextLoader::minChunkBytes = savedChunkBytes;
+    QVector<CANFrame> frames;
+    QVERIFY(FrameFileIO::autoDetectLoadFile(filename, &frames));
+    QCOMPARE(FrameFileIO::lastAutoDetect().format, QString("candump"));
+    QCOMPARE(frames.count(), 40);
+    for (int i = 0; i < frames.count(); i++)
+    {
+        QCOMPARE(frames.at(i).frameId(), 0x1A3u);
+        QCOMPARE(frames.at(i).payload(), payloads.at(i));
+        if (i & 1)
+        {
+            QVERIFY(frames.at(i).hasFlexibleDataRateFormat());
+            QVERIFY(frames.at(i).hasBitrateSwitch());
+            QCOMPARE(frames.at(i).hasErrorStateIndicator(), (i & 2) != 0);
+        }
+    }
+}
+
+//lines come out like readLine on a file opened in text mode, a line cut off by the sniff is left out
+void TestTextLoader::sniffLines()
+{
+    QString filename = tempDir.filePath("sniff");
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("first\r\nsecond\n\nlast");
+    file.close();
+
+    FileSniff whole(filename);
+    QVERIFY(whole.isOpen());
+    QVERIFY(whole.isComplete());
+    QCOMPARE(whole.lineCount(), 4);
+    QCOMPARE(whole.line(0), QByteArray("first\n"));
+    QCOMPARE(whole.line(2), QByteArray("\n"));
+    QCOMPARE(whole.line(3), QByteArray("last"));
+    QCOMPARE(whole.line(4), QByteArray());
+    QCOMPARE(whole.text(1), QString("second"));
+
+    int savedSniffBytes = FileSniff::sniffBytes;
+    FileSniff::sniffBytes = 10;
+    FileSniff partial(filename);
+    FileSniff::sniffBytes = savedSniffBytes;
+    QVERIFY(!partial.isComplete());
+    QCOMPARE(partial.fileSize(), 19ll);
+    QCOMPARE(partial.lineCount(), 1);
+    QCOMPARE(partial.end(), QByteArray("first\r\nsecond\n\nlast"));
+}
+
+//fields a short line doesn't have read as empty and convert to 0
+void TestTextLoader::missingTokens()
+{
+    const char line[] = "12 34";
+    TextTokens tokens;
+    tokens.splitWhitespace(line, line + 5);
+    QCOMPARE(tokens.count(), 2);
+    QCOMPARE(tokens[1].toHex(), static_cast<uint64_t>(0x34));
+    for (int idx : {-1, 2, TextTokens::maxTokens})
+    {
+        QVERIFY(tokens[idx].isEmpty());
+        QCOMPARE(tokens[idx].length(), 0);
+        QCOMPARE(tokens[idx].at(0), '\0');
+        bool ok = true;
+        QCOMPARE(tokens[idx].toHex(&ok), static_cast<uint64_t>(0));
+        QVERIFY(!ok);
+    }
+}
+
+void TestTextLoader::benchmark_data()
+{
+    QTest::addColumn<QString>("format");
+
+    QTest::newRow("native")     << "native";
+    QTest::newRow("candump")    << "candump";
+    QTest::newRow("asc")        << "asc";
+}
+
+//load a million frame capture with the default chunking and report the rate
+void TestTextLoader::benchmark()
+{
+    QFETCH(QString, format);
+
+    QString filename = writeFile(format, 1000000);
+    QVERIFY(!filename.isEmpty());
+    ChunkedTextLoader::minChunkBytes = savedChunkBytes;
+    double megabytes = QFileInfo(filename).size() / 1048576.0;
+
+    QVector<CANFrame> frames;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        load(format, filename, &frames);
+    }
+    qint64 elapsed = qMax(timer.elapsed(), 1ll);
+    QCOMPARE(frames.count(), 1000000);
+    qDebug() << format << megabytes << "MB in" << elapsed << "ms," << (megabytes * 1000.0 / elapsed) << "MB/s";
+}
@@ -0,0 +1,33 @@
+#ifndef TST_TEXTLOADER_H
+#define TST_TEXTLOADER_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include "can_structs.h"
+
+class TestTextLoader: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir tempDir;
+    QVector<CANFrame> expected;
+    int savedChunkBytes;
+
+    QString writeFile(const QString &format, int numFrames);
+    bool load(const QString &format, const QString &filename, QVector<CANFrame> *frames);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void matchesWrittenFrames_data();
+    void matchesWrittenFrames();
+    void autoDetects_data();
+    void autoDetects();
+    void canDumpFD();
+    void sniffLines();
+    void missingTokens();
+    void benchmark_data();
+    void benchmark();
+};
+
+#endif // TST_TEXTLOADER_H
@@ -4,6 +4,7 @@
 #include <Qt>
 #include <stdint.h>
 #include <QByteArray>
+#include <QtEndian>
 #include <QDateTime>
 #include <QDebug>
 #include <QApplication>
@@ -61,6 +62,22 @@ static constexpr std::array<QRgb, 32> kRowPalette = {{
     0xFF5D4037,  // 31  Brown 700
 }};
 
+/*
+ * Where a signal's bits sit in a payload as worked out by Utility::locateSignal. Holding on to one of
+ * these lets repeated extractions of the same signal skip straight to the load, shift and mask.
+ */
+struct SignalLocation
+{
+    int startBit;
+    int sigSize;
+    bool littleEndian;
+    bool wordPath;  //false for parameters only the bitwise routine handles
+    int firstByte;  //first payload byte holding signal bits
+    int shift;      //bit offset of the signal within that byte (big endian numbering for motorola)
+    int numBits;    //bits actually read. Fewer than sigSize if the signal runs past bit 511
+    int minBytes;   //shorter payloads decode as 0
+};
+
 class Utility
 {
 public:
@@ -285,10 +302,28 @@ public:
         return (value1 * (1.0 - samplePoint)) + (value2 * samplePoint);
     }
 
-    /* A unified function that can extract a signal from the (up to) 64 bits of data bytes in a CAN frame
-     * handles both little and big endian signals (and floats too).
+    //Load up to 8 bytes starting at byte offset as a word. Bytes past the end of the data read as zero.
+    static uint64_t loadLittleEndianWord(const uchar *bytes, int numBytes, int offset)
+    {
+        if (offset + 8 <= numBytes) return qFromLittleEndian<quint64>(bytes + offset);
+        uint64_t word = 0;
+        for (int i = 0; offset + i < numBytes && i < 8; i++) word |= static_cast<uint64_t>(bytes[offset + i]) << (8 * i);
+        return word;
+    }
+
+    static uint64_t loadBigEndianWord(const uchar *bytes, int numBytes, int offset)
+    {
+        if (offset + 8 <= numBytes) return qFromBigEndian<quint64>(bytes + offset);
+        uint64_t word = 0;
+        for (int i = 0; offset + i < numBytes && i < 8; i++) word |= static_cast<uint64_t>(bytes[offset + i]) << (56 - 8 * i);
+        return word;
+    }
+
+    /* The original bit at a time extraction. processIntegerSignal below must return exactly what this
+     * does for every input. It is kept as the fallback for parameters the fast path doesn't take
+     * (negative start bits, sizes outside 1 - 64) and as the reference the unit tests compare against.
     */
-    static int64_t processIntegerSignal(const QByteArray data, int startBit, int sigSize, bool littleEndian, bool isSigned)
+    static int64_t processIntegerSignalBitwise(const QByteArray data, int startBit, int sigSize, bool littleEndian, bool isSigned)
     {
 
         uint64_t result = 0;
@@ -355,7 +390,7 @@ public:
             }
         }
 
-        if (isSigned)
+        if (isSigned && sigSize < 64) //a full 64 bit signal already carries its own sign bit in the right place
         {
             uint64_t mask = (1ULL << (sigSize - 1));
             if ((result & mask) == mask) //is the highest bit possible for this signal size set?
@@ -386,6 +421,126 @@ public:
         return result;
     }
 
+    /* A unified function that can extract a signal from the (up to) 64 bits of data bytes in a CAN frame
+     * handles both little and big endian signals (and floats too).
+     *
+     * Rather than walking the signal one bit at a time the bytes covering it are loaded as a 64 bit
+     * word (plus one spill over byte when a signal is not byte aligned), shifted into place and masked.
+     * Motorola signals count their bits in the usual DBC saw tooth. Renumbering them as a straight
+     * big endian bit stream (byte * 8 + 7 - bit) turns them into a contiguous run too.
+     * Edge cases (data too short, bits past 512) are handled the same way the bitwise routine does.
+     * Code that extracts the same signal over and over can call locateSignal once and then
+     * extractSignal per frame.
+    */
+    static int64_t processIntegerSignal(const QByteArray &data, int startBit, int sigSize, bool littleEndian, bool isSigned)
+    {
+        return extractSignal(data, locateSignal(startBit, sigSize, littleEndian), isSigned);
+    }
+
+    static SignalLocation locateSignal(int startBit, int sigSize, bool littleEndian)
+    {
+        SignalLocation loc;
+        loc.startBit = startBit;
+        loc.sigSize = sigSize;
+        loc.littleEndian = littleEndian;
+        loc.wordPath = !(startBit < 0 || sigSize < 1 || sigSize > 64);
+        loc.firstByte = 0;
+        loc.shift = 0;
+        loc.numBits = 0;
+        loc.minBytes = 0;
+        if (!loc.wordPath) return loc;
+
+        //in big endian numbering the signal is a contiguous run starting at its most significant bit
+        int firstPos = littleEndian ? startBit : (startBit & ~7) + (7 - (startBit & 7));
+        //bits 512 and up read as zero, any other bit that isn't in data is an error
+        int lastPos = qMin(firstPos + sigSize - 1, 511);
+        //if signal extends past the end of data then abort
+        loc.minBytes = (startBit + sigSize) / 8;
+        if (firstPos <= lastPos)
+        {
+            loc.firstByte = firstPos / 8;
+            loc.shift = firstPos & 7;
+            loc.numBits = lastPos - firstPos + 1;
+            loc.minBytes = qMax(loc.minBytes, (lastPos / 8) + 1);
+        }
+        return loc;
+    }
+
+    static int64_t extractSignal(const QByteArray &data, const SignalLocation &loc, bool isSigned)
+    {
+        if (!loc.wordPath)
+            return processIntegerSignalBitwise(data, loc.startBit, loc.sigSize, loc.littleEndian, isSigned);
+
+        if (data.size() < loc.minBytes) return 0;
+
+        uint64_t result = 0;
+        if (loc.numBits > 0)
+        {
+            const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+            int numBytes = data.size();
+            if (loc.littleEndian)
+            {
+                result = loadLittleEndianWord(bytes, numBytes, loc.firstByte) >> loc.shift;
+                if (loc.shift + loc.numBits > 64) result |= static_cast<uint64_t>(bytes[loc.firstByte + 8]) << (64 - loc.shift);
+                if (loc.numBits < 64) result &= (1ULL << loc.numBits) - 1;
+            }
+            else //motorola / big endian mode
+            {
+                uint64_t word = loadBigEndianWord(bytes, numBytes, loc.firstByte) << loc.shift;
+                if (loc.shift + loc.numBits > 64) word |= static_cast<uint64_t>(bytes[loc.firstByte + 8]) >> (8 - loc.shift);
+                result = word >> (64 - loc.numBits);
+                //bits that would have come from past bit 511 are zero but still hold their place
+                result <<= (loc.sigSize - loc.numBits);
+            }
+        }
+
+        if (isSigned && loc.sigSize < 64)
+        {
+            //see processIntegerSignalBitwise for the reasoning here
+            uint64_t mask = (1ULL << (loc.sigSize - 1));
+            if ((result & mask) == mask) result |= ~((1ULL << loc.sigSize) - 1);
+        }
+
+        return static_cast<int64_t>(result);
+    }
+
+    //the CRC-32 gzip and zip use
+    static quint32 crc32(const char *data, int len)
+    {
+        static const std::array<quint32, 256> table = []()
+        {
+            std::array<quint32, 256> t;
+            for (quint32 i = 0; i < 256; i++)
+            {
+                quint32 c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                t[i] = c;
+            }
+            return t;
+        }();
+        quint32 crc = 0xFFFFFFFFu;
+        for (int i = 0; i < len; i++) crc = table[(crc ^ static_cast<uchar>(data[i])) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    //Appends data to out as one gzip member. Qt only exposes zlib through qCompress. Its output is a
+    //4 byte length, a 2 byte zlib header, the raw deflate stream and a 4 byte adler32, so the deflate
+    //stream gets a gzip header and trailer instead. False if compression failed
+    static bool appendGzip(const QByteArray &data, QByteArray &out, int level = 6)
+    {
+        static const char gzipHeader[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff'};
+        QByteArray deflated = qCompress(data, level);
+        if (deflated.length() < 10) return false;
+        out.append(gzipHeader, 10);
+        out.append(deflated.constData() + 6, deflated.length() - 10);
+        quint32 trailer[2] = {crc32(data.constData(), data.length()), static_cast<quint32>(data.length())};
+        for (int w = 0; w < 2; w++)
+        {
+            for (int i = 0; i < 4; i++) out.append(static_cast<char>((trailer[w] >> (i * 8)) & 0xFF));
+        }
+        return true;
+    }
+
     // FNV-1a 32-bit hash — fast, good distribution, no dependencies.
     static quint32 hashString(const QString &s)
     {
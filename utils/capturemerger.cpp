@@ -0,0 +1,192 @@
+#include "capturemerger.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProgressDialog>
+#include <QThread>
+#include <algorithm>
+#include <vector>
+#include "canframestore.h"
+#include "capturepager.h"
+#include "framefileio.h"
+
+int CaptureMerger::blockFrames = 4096;
+
+CaptureMerger::CaptureMerger()
+{
+    merged = 0;
+    canceled = false;
+}
+
+bool CaptureMerger::openSource(Source &src)
+{
+    const MergeInput &input = inputs.at(src.input);
+    src.pager = FrameFileIO::openPagedFile(input.filename);
+    src.pos = 0;
+    src.next = 0;
+    if (src.pager)
+    {
+        //only ever read front to back so a single decoded page is all the cache needs
+        src.pager->setCacheFrames(1);
+        refill(src);
+        return true;
+    }
+
+    if (!FrameFileIO::autoDetectLoadFile(input.filename, &src.block))
+    {
+        if (src.block.isEmpty())
+        {
+            error = "Could not load " + input.filename;
+            return false;
+        }
+        qDebug() << "Merging the" << src.block.count() << "frames that could be loaded from" << input.filename;
+    }
+    adjustBlock(input, src.block);
+    return true;
+}
+
+//false once the input has nothing more to give
+bool CaptureMerger::refill(Source &src)
+{
+    src.block.resize(0);
+    src.pos = 0;
+    if (!src.pager) return false;
+
+    //the file may still be indexing past where the merge has read up to
+    while (src.pager->frameCount() <= src.next && !src.pager->isIndexed())
+    {
+        if (qApp && QThread::currentThread() == qApp->thread()) qApp->processEvents();
+        QThread::msleep(5);
+    }
+
+    int got = src.pager->copyFrames(src.next, blockFrames, &src.block);
+    src.next += got;
+    adjustBlock(inputs.at(src.input), src.block);
+    return got > 0;
+}
+
+void CaptureMerger::adjustBlock(const MergeInput &input, QVector<CANFrame> &block) const
+{
+    if (input.bus < 0 && input.busMap.isEmpty() && input.timeOffset == 0) return;
+    for (int i = 0; i < block.count(); i++)
+    {
+        CANFrame &frame = block[i];
+        if (input.bus >= 0) frame.bus = input.bus;
+        else frame.bus = input.busMap.value(frame.bus, frame.bus);
+        if (input.timeOffset != 0)
+        {
+            frame.setTimeStamp(QCanBusFrame::TimeStamp(0, frame.timeStamp().microSeconds() + input.timeOffset));
+        }
+    }
+}
+
+bool CaptureMerger::keepGoing(QProgressDialog *progress)
+{
+    if (!progress) return true;
+    progress->setLabelText(QString("Merged %1 frames...").arg(merged));
+    qApp->processEvents();
+    if (progress->wasCanceled()) canceled = true;
+    return !canceled;
+}
+
+bool CaptureMerger::run(const BlockSink &sink, QProgressDialog *progress)
+{
+    QElapsedTimer timer;
+    timer.start();
+    merged = 0;
+    canceled = false;
+    error.clear();
+
+    if (progress)
+    {
+        progress->setRange(0, 0);
+        progress->setValue(0);
+    }
+
+    QVector<Source> sources(inputs.count());
+    bool ok = true;
+    for (int i = 0; i < sources.count() && ok; i++)
+    {
+        sources[i].input = i;
+        sources[i].pager = nullptr;
+        ok = openSource(sources[i]) && keepGoing(progress);
+    }
+
+    //min heap of the inputs that still have frames, keyed on the time stamp at the head of their
+    //block. The input number breaks ties so equal time stamps keep the order the inputs were added in
+    auto later = [&sources](int a, int b)
+    {
+        const Source &srcA = sources.at(a);
+        const Source &srcB = sources.at(b);
+        int64_t tsA = srcA.block.at(srcA.pos).timeStamp().microSeconds();
+        int64_t tsB = srcB.block.at(srcB.pos).timeStamp().microSeconds();
+        if (tsA != tsB) return tsA > tsB;
+        return a > b;
+    };
+
+    std::vector<int> heap;
+    for (int i = 0; i < sources.count() && ok; i++)
+    {
+        if (!sources.at(i).block.isEmpty()) heap.push_back(i);
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    QVector<CANFrame> out;
+    out.reserve(blockFrames);
+    while (ok && !heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Source &src = sources[heap.back()];
+        out.append(src.block.at(src.pos++));
+
+        if (src.pos < src.block.count() || refill(src)) std::push_heap(heap.begin(), heap.end(), later);
+        else heap.pop_back();
+
+        if (out.count() >= blockFrames)
+        {
+            merged += static_cast<quint64>(out.count());
+            ok = sink(out) && keepGoing(progress);
+            out.resize(0);
+        }
+    }
+    if (ok && !out.isEmpty())
+    {
+        merged += static_cast<quint64>(out.count());
+        ok = sink(out);
+    }
+
+    for (int i = 0; i < sources.count(); i++) delete sources.at(i).pager;
+
+    if (canceled) qDebug() << "Merge canceled after" << merged << "frames";
+    else if (ok) qDebug() << "Merged" << merged << "frames from" << inputs.count() << "files in" << timer.elapsed() << "ms";
+    return ok;
+}
+
+bool CaptureMerger::runToFile(const QString &filename, QProgressDialog *progress)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        error = "Could not open " + filename + " for writing";
+        return false;
+    }
+
+    QByteArray text(FrameFileIO::nativeCSVHeader);
+    bool ok = file.write(text) == text.length();
+    if (!ok) error = "Could not write " + filename + ": " + file.errorString();
+    ok = ok && run([this, &file, &text](const QVector<CANFrame> &block)
+    {
+        CANFrameStore store(block);
+        text.resize(0);
+        FrameFileIO::formatNativeCSV(&store, 0, store.count(), text);
+        if (file.write(text) == text.length()) return true;
+        error = "Could not write " + file.fileName() + ": " + file.errorString();
+        return false;
+    }, progress);
+
+    file.close();
+    if (!ok) file.remove();
+    return ok;
+}
@@ -0,0 +1,86 @@
+#ifndef CAPTUREMERGER_H
+#define CAPTUREMERGER_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "can_structs.h"
+
+class CapturePager;
+class QProgressDialog;
+
+//one file going into a merge and what to do to its frames on the way
+struct MergeInput
+{
+    MergeInput() : bus(-1), timeOffset(0) {}
+
+    QString filename;
+    int bus;                //every frame of the file goes onto this bus, -1 keeps the buses in the file
+    QHash<int, int> busMap; //file bus -> merged bus when bus is -1. Buses not listed are kept
+    int64_t timeOffset;     //microseconds added to every time stamp of the file
+};
+
+/*
+ * Merges several captures into one, in time stamp order, without loading them all first. Typically
+ * one logger per bus recorded the same car and the files get lined up by time.
+ *
+ * Each input is read a block of blockFrames frames at a time and the block heads go through a k-way
+ * merge on a min heap, so at most one block per input plus the output block are in memory however
+ * big the files are. Merged frames are handed to the sink a block at a time, in order. Frames with
+ * the same time stamp come out in the order the inputs were added.
+ *
+ * Inputs are opened like a huge file would be: a format FrameFileIO can page is streamed through a
+ * CapturePager holding a single page. Anything else can only be loaded whole by its loader so such
+ * a file is one big block.
+ *
+ * Every input is expected to be in time order on its own, which is how loggers write. One that isn't
+ * still has all of its frames merged, just not sorted.
+ *
+ * Usage:
+ *   CaptureMerger merger;
+ *   merger.addInput(input); ...
+ *   merger.run([](const QVector<CANFrame> &block) { ...; return true; });
+ */
+class CaptureMerger
+{
+public:
+    typedef std::function<bool(const QVector<CANFrame> &block)> BlockSink; //return false to stop the merge
+
+    static int blockFrames;
+
+    CaptureMerger();
+
+    void addInput(const MergeInput &input) { inputs.append(input); }
+    const QVector<MergeInput> &getInputs() const { return inputs; }
+
+    //with a progress dialog the events keep flowing and canceling it stops the merge
+    bool run(const BlockSink &sink, QProgressDialog *progress = nullptr);
+    bool runToFile(const QString &filename, QProgressDialog *progress = nullptr); //as a GVRET native CSV
+
+    quint64 framesMerged() const { return merged; }
+    bool wasCanceled() const { return canceled; }
+    const QString &errorString() const { return error; }
+
+private:
+    struct Source
+    {
+        int input;
+        CapturePager *pager; //null when the file had to be loaded whole
+        QVector<CANFrame> block;
+        int pos;  //next frame of block to merge
+        int next; //next frame of the file to read into a block
+    };
+
+    bool openSource(Source &src);
+    bool refill(Source &src);
+    void adjustBlock(const MergeInput &input, QVector<CANFrame> &block) const;
+    bool keepGoing(QProgressDialog *progress);
+
+    QVector<MergeInput> inputs;
+    quint64 merged;
+    bool canceled;
+    QString error;
+};
+
+#endif // CAPTUREMERGER_H
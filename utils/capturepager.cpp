@@ -0,0 +1,366 @@
+#include "capturepager.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <climits>
+#include <cstring>
+
+int CapturePager::pageBytes = 4 * 1024 * 1024;
+int CapturePager::maxCachedFrames = 1000000;
+
+CapturePager::CapturePager()
+{
+    opened = false;
+    isBinary = false;
+    cacheHits = 0;
+    cacheMisses = 0;
+    cache.setMaxCost(maxCachedFrames);
+}
+
+CapturePager::~CapturePager()
+{
+    stopIndexing.storeRelease(1);
+    indexer.waitForFinished();
+}
+
+bool CapturePager::openNativeBinary(const QString &filename)
+{
+    if (opened || !binary.open(filename)) return false;
+    name = filename;
+    isBinary = true;
+    opened = true;
+
+    //rows are counted in an int by the model so anything past that can't be shown anyway
+    quint64 total = qMin(binary.frameCount(), static_cast<quint64>(INT_MAX));
+    for (int b = 0; b < binary.blockCount() && binary.blockFirstFrame(b) < total; b++)
+    {
+        Page page;
+        page.begin = 0;
+        page.end = 0;
+        page.firstFrame = static_cast<int>(binary.blockFirstFrame(b));
+        page.frameCount = static_cast<int>(qMin(static_cast<quint64>(binary.blockFrameCount(b)), total - binary.blockFirstFrame(b)));
+        page.minTimeStamp = binary.blockMinTimeStamp(b);
+        page.maxTimeStamp = binary.blockMaxTimeStamp(b);
+        pages.append(page);
+    }
+    indexedPages.storeRelease(pages.count());
+    indexedFrames.storeRelease(static_cast<int>(total));
+    indexDone.storeRelease(1);
+    return true;
+}
+
+bool CapturePager::openText(const QString &filename)
+{
+    if (opened || !text.open(filename)) return false;
+    name = filename;
+    isBinary = false;
+    opened = true;
+    return true;
+}
+
+void CapturePager::startIndexing(qint64 from, const LineParser &parseLine)
+{
+    if (!opened || isBinary || !pages.isEmpty() || isIndexed()) return;
+    parser = parseLine;
+    splitPages(from);
+    if (pages.isEmpty())
+    {
+        indexDone.storeRelease(1);
+        return;
+    }
+    indexer = QtConcurrent::run([this]() { buildIndex(); });
+}
+
+void CapturePager::splitPages(qint64 from)
+{
+    const char *base = text.data();
+    qint64 length = text.size();
+    qint64 pos = from;
+    while (pos < length)
+    {
+        qint64 end = length;
+        if (length - pos > pageBytes)
+        {
+            qint64 target = pos + pageBytes;
+            const char *nl = static_cast<const char *>(memchr(base + target, '\n', static_cast<size_t>(length - target)));
+            if (nl) end = (nl - base) + 1;
+        }
+        Page page;
+        page.begin = pos;
+        page.end = end;
+        page.firstFrame = 0;
+        page.frameCount = 0;
+        page.minTimeStamp = 0;
+        page.maxTimeStamp = 0;
+        pages.append(page);
+        pos = end;
+    }
+}
+
+void CapturePager::pageChunk(const Page &page, ChunkedTextLoader::Chunk &chunk) const
+{
+    chunk.begin = text.data() + page.begin;
+    chunk.end = text.data() + page.end;
+    chunk.foundErrors = false;
+    chunk.aborted = false;
+}
+
+//Runs on its own thread. Each batch of pages is parsed on all cores but only the count and time span
+//of the frames are kept, then the batch is published in file order.
+void CapturePager::buildIndex()
+{
+    struct PageScan
+    {
+        int page;
+        int frameCount;
+        int64_t minTimeStamp;
+        int64_t maxTimeStamp;
+        bool aborted;
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+
+    Page *index = pages.data();
+    int batch = qMax(QThread::idealThreadCount(), 1);
+    int total = 0;
+    bool stop = false;
+
+    for (int first = 0; first < pages.count() && !stop; first += batch)
+    {
+        if (stopIndexing.loadAcquire()) break;
+
+        QVector<PageScan> scans;
+        for (int p = first; p < qMin(first + batch, pages.count()); p++)
+        {
+            PageScan scan = {p, 0, 0, 0, false};
+            scans.append(scan);
+        }
+
+        QtConcurrent::blockingMap(scans, [this](PageScan &scan)
+        {
+            //fold the frames into the scan every so often so a page never sits in memory whole
+            auto fold = [&scan](QVector<CANFrame> &frames)
+            {
+                for (int i = 0; i < frames.count(); i++)
+                {
+                    int64_t ts = frames.at(i).timeStamp().microSeconds();
+                    if (scan.frameCount == 0 || ts < scan.minTimeStamp) scan.minTimeStamp = ts;
+                    if (scan.frameCount == 0 || ts > scan.maxTimeStamp) scan.maxTimeStamp = ts;
+                    scan.frameCount++;
+                }
+                frames.resize(0);
+            };
+
+            ChunkedTextLoader::Chunk chunk;
+            pageChunk(pages.at(scan.page), chunk);
+            const LineParser &parseLine = parser;
+            ChunkedTextLoader::parseChunk(chunk, [&parseLine, &fold](const char *begin, const char *end, ChunkedTextLoader::Chunk &c)
+            {
+                parseLine(begin, end, c);
+                if (c.frames.count() >= 1024) fold(c.frames);
+            });
+            fold(chunk.frames);
+            scan.aborted = chunk.aborted;
+        });
+
+        for (int s = 0; s < scans.count(); s++)
+        {
+            const PageScan &scan = scans.at(s);
+            Page &page = index[scan.page];
+            page.firstFrame = total;
+            page.frameCount = qMin(scan.frameCount, INT_MAX - total);
+            page.minTimeStamp = scan.minTimeStamp;
+            page.maxTimeStamp = scan.maxTimeStamp;
+            total += page.frameCount;
+            //the page has to be visible before any of its frames are
+            indexedPages.storeRelease(scan.page + 1);
+            indexedFrames.storeRelease(total);
+            //a line the format can't get past ends the capture, same as a full load
+            if (scan.aborted || total == INT_MAX)
+            {
+                stop = true;
+                break;
+            }
+        }
+    }
+
+    indexDone.storeRelease(1);
+    qDebug() << "Indexed" << total << "frames in" << indexedPages.loadAcquire() << "pages of" << name << "in" << timer.elapsed() << "ms";
+}
+
+void CapturePager::waitForFirstPage()
+{
+    while (indexedPages.loadAcquire() == 0 && !isIndexed())
+    {
+        if (qApp && QThread::currentThread() == qApp->thread()) qApp->processEvents();
+        QThread::msleep(5);
+    }
+}
+
+int CapturePager::indexProgress() const
+{
+    if (isIndexed() || pages.isEmpty()) return 1000;
+    return static_cast<int>((static_cast<qint64>(indexedPages.loadAcquire()) * 1000) / pages.count());
+}
+
+//last published page whose first frame is at or before idx
+int CapturePager::pageOfFrame(int idx) const
+{
+    int lo = 0;
+    int hi = indexedPages.loadAcquire() - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (pages.at(mid).firstFrame <= idx) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+//cacheMutex has to be held. The pointer is good until the next page is decoded
+const QVector<CANFrame> *CapturePager::decodedPage(int page)
+{
+    QVector<CANFrame> *frames = cache.object(page);
+    if (frames)
+    {
+        cacheHits++;
+        return frames;
+    }
+    cacheMisses++;
+
+    ChunkedTextLoader::Chunk chunk;
+    pageChunk(pages.at(page), chunk);
+    ChunkedTextLoader::parseChunk(chunk, parser);
+    frames = new QVector<CANFrame>();
+    frames->swap(chunk.frames);
+
+    //QCache throws away anything that costs more than it may ever hold
+    int cost = qMax(frames->count(), 1);
+    if (cost > cache.maxCost()) cache.setMaxCost(cost);
+    cache.insert(page, frames, cost);
+    return frames;
+}
+
+CANFrame CapturePager::frameAt(int idx)
+{
+    if (idx < 0 || idx >= frameCount()) return CANFrame();
+    if (isBinary) return binary.frameAt(static_cast<quint64>(idx));
+
+    int page = pageOfFrame(idx);
+    QMutexLocker locker(&cacheMutex);
+    const QVector<CANFrame> *frames = decodedPage(page);
+    int inPage = idx - pages.at(page).firstFrame;
+    if (inPage >= frames->count()) return CANFrame();
+    return frames->at(inPage);
+}
+
+int CapturePager::copyFrames(int first, int count, QVector<CANFrame> *out)
+{
+    int last = qMin(first + count, frameCount());
+    if (first < 0 || first >= last) return 0;
+    if (isBinary)
+    {
+        for (int idx = first; idx < last; idx++) out->append(binary.frameAt(static_cast<quint64>(idx)));
+        return last - first;
+    }
+
+    //a page at a time so the cache is only asked once per page
+    QMutexLocker locker(&cacheMutex);
+    int idx = first;
+    while (idx < last)
+    {
+        int page = pageOfFrame(idx);
+        const QVector<CANFrame> *frames = decodedPage(page);
+        int inPage = idx - pages.at(page).firstFrame;
+        int num = qMin(last - idx, frames->count() - inPage);
+        if (num <= 0) break;
+        for (int i = 0; i < num; i++) out->append(frames->at(inPage + i));
+        idx += num;
+    }
+    return idx - first;
+}
+
+int CapturePager::findFrame(int64_t timeStamp)
+{
+    int numPages = indexedPages.loadAcquire();
+    for (int p = 0; p < numPages; p++)
+    {
+        const Page &page = pages.at(p);
+        if (page.frameCount == 0 || page.maxTimeStamp < timeStamp) continue;
+
+        //the page holds a match, logs aren't always in time order though so it has to be looked for
+        if (isBinary)
+        {
+            for (int i = 0; i < page.frameCount; i++)
+            {
+                if (binary.timeStampAt(static_cast<quint64>(page.firstFrame + i)) >= timeStamp) return page.firstFrame + i;
+            }
+        }
+        else
+        {
+            QMutexLocker locker(&cacheMutex);
+            const QVector<CANFrame> *frames = decodedPage(p);
+            for (int i = 0; i < frames->count(); i++)
+            {
+                if (frames->at(i).timeStamp().microSeconds() >= timeStamp) return page.firstFrame + i;
+            }
+        }
+    }
+    return -1;
+}
+
+int CapturePager::framesInTimeRange(int64_t from, int64_t to, QVector<CANFrame> *out)
+{
+    int found = 0;
+    int numPages = indexedPages.loadAcquire();
+    for (int p = 0; p < numPages; p++)
+    {
+        const Page &page = pages.at(p);
+        if (page.frameCount == 0 || page.maxTimeStamp < from || page.minTimeStamp > to) continue;
+
+        if (isBinary)
+        {
+            for (int i = 0; i < page.frameCount; i++)
+            {
+                quint64 idx = static_cast<quint64>(page.firstFrame + i);
+                int64_t ts = binary.timeStampAt(idx);
+                if (ts < from || ts > to) continue;
+                out->append(binary.frameAt(idx));
+                found++;
+            }
+        }
+        else
+        {
+            QMutexLocker locker(&cacheMutex);
+            const QVector<CANFrame> *frames = decodedPage(p);
+            for (int i = 0; i < frames->count(); i++)
+            {
+                int64_t ts = frames->at(i).timeStamp().microSeconds();
+                if (ts < from || ts > to) continue;
+                out->append(frames->at(i));
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+void CapturePager::setCacheFrames(int frames)
+{
+    QMutexLocker locker(&cacheMutex);
+    cache.setMaxCost(qMax(frames, 1));
+}
+
+void CapturePager::getCacheStats(quint64 &hits, quint64 &misses, int &cachedPages) const
+{
+    QMutexLocker locker(&cacheMutex);
+    hits = cacheHits;
+    misses = cacheMisses;
+    cachedPages = cache.count();
+}
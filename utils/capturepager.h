@@ -0,0 +1,104 @@
+#ifndef CAPTUREPAGER_H
+#define CAPTUREPAGER_H
+
+#include <QAtomicInt>
+#include <QCache>
+#include <QFuture>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "can_structs.h"
+#include "chunkedtextloader.h"
+#include "nativebinaryfile.h"
+
+/*
+ * Random access to a capture file too big to load. Instead of decoding every frame up front the
+ * file is cut into pages and only an index is kept: where each page starts, which frames it holds
+ * and the time span they cover. Frames are decoded a page at a time when asked for and the decoded
+ * pages are kept in a cache of bounded size, least recently used page dropped first.
+ *
+ * Native binary captures already carry such an index in their footer and can read any frame
+ * straight out of the mapped file, so they are ready as soon as they are opened. Line based text
+ * logs are memory mapped and cut into pages of pageBytes on line breaks. Their index is built on
+ * a background thread, pages parsed on all cores a batch at a time and published in file order,
+ * so frameCount() grows while the rest of the file is indexed and the start of the file can be
+ * looked at right away.
+ *
+ * Index lookups and frameAt() may be called from any thread.
+ *
+ * Usage for a text log:
+ *   CapturePager *pager = new CapturePager;
+ *   if (!pager->openText(filename)) ...
+ *   qint64 pos = 0; //read any header with pager->textFile().readLine() first
+ *   pager->startIndexing(pos, parseLine);
+ *   pager->waitForFirstPage();
+ */
+class CapturePager
+{
+public:
+    typedef std::function<void(const char *begin, const char *end, ChunkedTextLoader::Chunk &chunk)> LineParser;
+
+    static int pageBytes;       //text pages are cut this size, on the next line break
+    static int maxCachedFrames; //decoded frames kept in the page cache
+
+    CapturePager();
+    ~CapturePager();
+
+    bool openNativeBinary(const QString &filename); //the footer is the index, nothing else to do
+    bool openText(const QString &filename);
+    const ChunkedTextLoader &textFile() const { return text; } //for reading a header before indexing
+    void startIndexing(qint64 from, const LineParser &parseLine);
+    void waitForFirstPage(); //returns once some frames can be shown or the whole file is indexed
+
+    bool isOpen() const { return opened; }
+    const QString &fileName() const { return name; }
+    bool isIndexed() const { return indexDone.loadAcquire() != 0; }
+    int indexProgress() const; //per mille of the file indexed
+
+    int frameCount() const { return indexedFrames.loadAcquire(); } //frames indexed so far
+    CANFrame frameAt(int idx);
+    int copyFrames(int first, int count, QVector<CANFrame> *out); //appends up to count frames, returns how many
+    int findFrame(int64_t timeStamp); //first indexed frame at or after timeStamp, -1 if none
+    int framesInTimeRange(int64_t from, int64_t to, QVector<CANFrame> *out); //appends, returns how many
+    void getCacheStats(quint64 &hits, quint64 &misses, int &cachedPages) const;
+    void setCacheFrames(int frames); //for readers that only go forward, a page is always kept whatever this says
+
+private:
+    struct Page
+    {
+        qint64 begin; //byte range of a text page
+        qint64 end;
+        int firstFrame;
+        int frameCount;
+        int64_t minTimeStamp;
+        int64_t maxTimeStamp;
+    };
+
+    void splitPages(qint64 from);
+    void buildIndex();
+    void pageChunk(const Page &page, ChunkedTextLoader::Chunk &chunk) const;
+    int pageOfFrame(int idx) const;
+    const QVector<CANFrame> *decodedPage(int page);
+
+    QString name;
+    bool opened;
+    bool isBinary;
+    NativeBinaryFile binary;
+    ChunkedTextLoader text;
+    LineParser parser;
+
+    QVector<Page> pages; //sized before indexing starts and never resized while the indexer runs
+    QAtomicInt indexedPages; //pages [0, indexedPages) are final and safe to read from any thread
+    QAtomicInt indexedFrames;
+    QAtomicInt indexDone;
+    QAtomicInt stopIndexing;
+    QFuture<void> indexer;
+
+    mutable QMutex cacheMutex;
+    QCache<int, QVector<CANFrame>> cache; //page number -> decoded frames, cost is the frame count
+    quint64 cacheHits;
+    quint64 cacheMisses;
+};
+
+#endif // CAPTUREPAGER_H
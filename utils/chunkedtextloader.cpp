@@ -0,0 +1,301 @@
+#include "chunkedtextloader.h"
+
+#include <QApplication>
+#include <QThread>
+#include <QDebug>
+
+static const char emptyText = 0;
+const TextToken TextTokens::emptyToken = {&emptyText, &emptyText}; //one address, two "" literals needn't share one
+int ChunkedTextLoader::minChunkBytes = 1048576;
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+static inline char upper(char c)
+{
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 32) : c;
+}
+
+static inline void trim(const char *&begin, const char *&end)
+{
+    while (begin < end && isSpace(*begin)) begin++;
+    while (end > begin && isSpace(*(end - 1))) end--;
+}
+
+bool TextToken::startsWith(const char *text) const
+{
+    size_t len = strlen(text);
+    return static_cast<size_t>(length()) >= len && memcmp(begin, text, len) == 0;
+}
+
+bool TextToken::equals(const char *text) const
+{
+    size_t len = strlen(text);
+    return static_cast<size_t>(length()) == len && memcmp(begin, text, len) == 0;
+}
+
+bool TextToken::contains(const char *text) const
+{
+    int len = static_cast<int>(strlen(text));
+    for (int i = 0; i + len <= length(); i++)
+    {
+        if (memcmp(begin + i, text, static_cast<size_t>(len)) == 0) return true;
+    }
+    return false;
+}
+
+bool TextToken::containsNoCase(const char *text) const
+{
+    int len = static_cast<int>(strlen(text));
+    for (int i = 0; i + len <= length(); i++)
+    {
+        int j = 0;
+        while (j < len && upper(begin[i + j]) == upper(text[j])) j++;
+        if (j == len) return true;
+    }
+    return false;
+}
+
+uint64_t TextToken::toHex(bool *ok) const
+{
+    const char *p = begin;
+    const char *e = end;
+    trim(p, e);
+    if (e - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) p += 2;
+    if (p == e)
+    {
+        if (ok) *ok = false;
+        return 0;
+    }
+    uint64_t val = 0;
+    for (; p < e; p++)
+    {
+        char c = *p;
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else
+        {
+            if (ok) *ok = false;
+            return 0;
+        }
+        val = (val << 4) | static_cast<uint64_t>(digit);
+    }
+    if (ok) *ok = true;
+    return val;
+}
+
+int64_t TextToken::toDecimal(bool *ok) const
+{
+    const char *p = begin;
+    const char *e = end;
+    trim(p, e);
+    bool negative = false;
+    if (p < e && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    if (p == e)
+    {
+        if (ok) *ok = false;
+        return 0;
+    }
+    uint64_t val = 0;
+    for (; p < e; p++)
+    {
+        if (*p < '0' || *p > '9')
+        {
+            if (ok) *ok = false;
+            return 0;
+        }
+        val = (val * 10) + static_cast<uint64_t>(*p - '0');
+    }
+    if (ok) *ok = true;
+    return negative ? -static_cast<int64_t>(val) : static_cast<int64_t>(val);
+}
+
+int64_t TextToken::toMicroseconds(bool *ok) const
+{
+    const char *p = begin;
+    const char *e = end;
+    trim(p, e);
+    bool negative = false;
+    if (p < e && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    int64_t seconds = 0;
+    int64_t micros = 0;
+    int intDigits = 0;
+    int fracDigits = 0;
+    for (; p < e && *p >= '0' && *p <= '9'; p++, intDigits++) seconds = (seconds * 10) + (*p - '0');
+    if (p < e && *p == '.')
+    {
+        for (p++; p < e && *p >= '0' && *p <= '9'; p++, fracDigits++)
+        {
+            if (fracDigits < 6) micros = (micros * 10) + (*p - '0');
+        }
+    }
+    if (p != e || (intDigits + fracDigits) == 0)
+    {
+        if (ok) *ok = false;
+        return 0;
+    }
+    for (int i = fracDigits; i < 6; i++) micros *= 10;
+    if (ok) *ok = true;
+    int64_t val = (seconds * 1000000) + micros;
+    return negative ? -val : val;
+}
+
+void TextTokens::split(const char *begin, const char *end, char separator)
+{
+    num = 0;
+    trim(begin, end);
+    if (begin == end) return;
+    const char *tokStart = begin;
+    for (const char *p = begin; num < maxTokens; p++)
+    {
+        if (p == end || *p == separator)
+        {
+            const char *b = tokStart;
+            const char *e = p;
+            trim(b, e);
+            tokens[num].begin = b;
+            tokens[num].end = e;
+            num++;
+            if (p == end) break;
+            tokStart = p + 1;
+        }
+    }
+}
+
+void TextTokens::splitWhitespace(const char *begin, const char *end)
+{
+    num = 0;
+    const char *p = begin;
+    while (num < maxTokens)
+    {
+        while (p < end && isSpace(*p)) p++;
+        if (p == end) break;
+        tokens[num].begin = p;
+        while (p < end && !isSpace(*p)) p++;
+        tokens[num].end = p;
+        num++;
+    }
+}
+
+ChunkedTextLoader::ChunkedTextLoader()
+{
+    base = nullptr;
+    length = 0;
+}
+
+ChunkedTextLoader::~ChunkedTextLoader()
+{
+    file.close(); //also drops the mapping
+}
+
+bool ChunkedTextLoader::open(const QString &filename)
+{
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    length = file.size();
+    base = "";
+    if (length == 0) return true;
+
+    base = reinterpret_cast<const char *>(file.map(0, length));
+    if (!base)
+    {
+        qDebug() << "Could not map" << filename << "reading it into memory instead";
+        fallback = file.readAll();
+        base = fallback.constData();
+        length = fallback.length();
+    }
+    return true;
+}
+
+bool ChunkedTextLoader::readLine(qint64 &pos, const char *&lineBegin, const char *&lineEnd) const
+{
+    if (pos >= length) return false;
+    lineBegin = base + pos;
+    const char *fileEnd = base + length;
+    const char *nl = static_cast<const char *>(memchr(lineBegin, '\n', static_cast<size_t>(fileEnd - lineBegin)));
+    lineEnd = nl ? nl : fileEnd;
+    pos = (nl ? (nl + 1) : fileEnd) - base;
+    if (lineEnd > lineBegin && *(lineEnd - 1) == '\r') lineEnd--;
+    return true;
+}
+
+void ChunkedTextLoader::splitChunks(qint64 from)
+{
+    chunks.clear();
+    if (from >= length) return;
+
+    qint64 remaining = length - from;
+    qint64 numChunks = remaining / minChunkBytes;
+    int maxChunks = QThread::idealThreadCount() * 4; //a few per core so one slow chunk doesn't hold up the rest
+    if (maxChunks < 1) maxChunks = 1;
+    if (numChunks > maxChunks) numChunks = maxChunks;
+    if (numChunks < 1) numChunks = 1;
+
+    const char *fileEnd = base + length;
+    const char *pos = base + from;
+    for (qint64 c = 1; c <= numChunks && pos < fileEnd; c++)
+    {
+        const char *chunkEnd = fileEnd;
+        if (c < numChunks)
+        {
+            const char *target = base + from + ((remaining * c) / numChunks);
+            if (target < pos) target = pos;
+            const char *nl = static_cast<const char *>(memchr(target, '\n', static_cast<size_t>(fileEnd - target)));
+            chunkEnd = nl ? nl + 1 : fileEnd;
+        }
+        Chunk chunk;
+        chunk.begin = pos;
+        chunk.end = chunkEnd;
+        chunk.foundErrors = false;
+        chunk.aborted = false;
+        chunks.append(chunk);
+        pos = chunkEnd;
+    }
+}
+
+//keep the GUI alive the way the old line by line loaders did with processEvents
+void ChunkedTextLoader::waitFor(QFuture<void> &future)
+{
+    if (!qApp || QThread::currentThread() != qApp->thread())
+    {
+        future.waitForFinished();
+        return;
+    }
+    while (!future.isFinished())
+    {
+        qApp->processEvents();
+        QThread::msleep(5);
+    }
+}
+
+bool ChunkedTextLoader::collect(QVector<CANFrame> *frames, QVector<int> *untimedFrames)
+{
+    int total = 0;
+    for (int c = 0; c < chunks.count(); c++)
+    {
+        total += chunks.at(c).frames.count();
+        if (chunks.at(c).aborted) break;
+    }
+    frames->reserve(frames->count() + total);
+
+    bool foundErrors = false;
+    for (int c = 0; c < chunks.count(); c++)
+    {
+        Chunk &chunk = chunks[c];
+        int offset = frames->count();
+        frames->append(chunk.frames);
+        if (untimedFrames)
+        {
+            for (int i = 0; i < chunk.untimedFrames.count(); i++) untimedFrames->append(offset + chunk.untimedFrames.at(i));
+        }
+        chunk.frames.clear();
+        chunk.frames.squeeze(); //don't hold two copies of everything for longer than needed
+        if (chunk.foundErrors) foundErrors = true;
+        if (chunk.aborted) return false;
+    }
+    return !foundErrors;
+}
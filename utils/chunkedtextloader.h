@@ -0,0 +1,146 @@
+#ifndef CHUNKEDTEXTLOADER_H
+#define CHUNKEDTEXTLOADER_H
+
+#include <QFile>
+#include <QVector>
+#include <QString>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cstring>
+#include "can_structs.h"
+
+/*
+ * One token of a line, pointing straight into the file data. Nothing is copied or allocated, the
+ * token is only good for as long as the loader that handed out the line.
+ */
+struct TextToken
+{
+    const char *begin;
+    const char *end;
+
+    int length() const { return static_cast<int>(end - begin); }
+    bool isEmpty() const { return begin == end; }
+    char at(int idx) const { return (idx >= 0 && idx < length()) ? begin[idx] : '\0'; } //past the end reads as 0 instead of asserting
+    bool startsWith(const char *text) const;
+    bool endsWith(char c) const { return begin != end && *(end - 1) == c; }
+    bool contains(char c) const { return memchr(begin, c, static_cast<size_t>(end - begin)) != nullptr; }
+    bool contains(const char *text) const;
+    bool containsNoCase(const char *text) const;
+    bool equals(const char *text) const;
+
+    //Number conversion in the spirit of QByteArray::toInt and friends. Surrounding white space is
+    //skipped, a malformed number yields 0 and sets ok to false if given.
+    uint64_t toHex(bool *ok = nullptr) const;
+    int64_t toDecimal(bool *ok = nullptr) const;
+    //decimal seconds like 1551774790.942758 converted to microseconds. Done in integer math so no
+    //precision is lost to a double on large time stamps and the C locale doesn't matter.
+    int64_t toMicroseconds(bool *ok = nullptr) const;
+};
+
+/*
+ * Splits a line into tokens without allocating. Asking for a token past the end gives an empty
+ * token, which converts to 0, so a short line reads as missing fields rather than crashing.
+ */
+class TextTokens
+{
+public:
+    static const int maxTokens = 96; //enough for an ASC CAN-FD line with 64 data bytes and its trailing fields
+
+    TextTokens() : num(0) {}
+    void split(const char *begin, const char *end, char separator); //like simplified().split(separator), tokens come back trimmed
+    void splitWhitespace(const char *begin, const char *end);      //like simplified().split(' ')
+    int count() const { return num; }
+    const TextToken &operator[](int idx) const { return (idx >= 0 && idx < num) ? tokens[idx] : emptyToken; }
+
+private:
+    TextToken tokens[maxTokens];
+    int num;
+    static const TextToken emptyToken;
+};
+
+/*
+ * Loader core for the line based log formats. The file is memory mapped, cut into chunks that
+ * always end on a line break and the chunks are parsed on all cores at once. Each chunk collects
+ * its own frames and collect() then stitches them together in file order, so the result is the
+ * same as reading the file a line at a time.
+ *
+ * A format supplies a line parser: void parseLine(const char *begin, const char *end, Chunk &chunk).
+ * It gets one line without its line break (or carriage return) and appends whatever frames it finds
+ * to chunk.frames. It runs on worker threads so it must not touch anything shared.
+ *
+ * Usage:
+ *   ChunkedTextLoader loader;
+ *   if (!loader.open(filename)) return false;
+ *   qint64 pos = 0; //read any header with readLine() first, then hand the rest over
+ *   loader.parse(pos, parseLine);
+ *   return loader.collect(frames);
+ */
+class ChunkedTextLoader
+{
+public:
+    struct Chunk
+    {
+        const char *begin;
+        const char *end;
+        QVector<CANFrame> frames;
+        QVector<int> untimedFrames; //frames the file gave no time stamp. collect() reports them in file order
+        bool foundErrors;           //at least one line was malformed but loading went on
+        bool aborted;               //a line the format can't get past, nothing after it is loaded
+    };
+
+    ChunkedTextLoader();
+    ~ChunkedTextLoader();
+
+    bool open(const QString &filename);
+    const char *data() const { return base; }
+    qint64 size() const { return length; }
+
+    //sequential access for headers. Returns false once pos is at the end of the file
+    bool readLine(qint64 &pos, const char *&lineBegin, const char *&lineEnd) const;
+
+    template<typename LineParser>
+    void parse(qint64 from, LineParser parseLine)
+    {
+        splitChunks(from);
+        QFuture<void> future = QtConcurrent::map(chunks, [parseLine](Chunk &chunk)
+        {
+            parseChunk(chunk, parseLine);
+        });
+        waitFor(future);
+    }
+
+    //Runs the line parser over the lines from chunk.begin to chunk.end, which has to sit right after
+    //a line break (or at the end of the file). For callers that cut the file up themselves
+    template<typename LineParser>
+    static void parseChunk(Chunk &chunk, LineParser parseLine)
+    {
+        const char *pos = chunk.begin;
+        while (pos < chunk.end && !chunk.aborted)
+        {
+            const char *lineEnd = static_cast<const char *>(memchr(pos, '\n', static_cast<size_t>(chunk.end - pos)));
+            if (!lineEnd) lineEnd = chunk.end;
+            const char *next = (lineEnd < chunk.end) ? lineEnd + 1 : chunk.end;
+            if (lineEnd > pos && *(lineEnd - 1) == '\r') lineEnd--;
+            parseLine(pos, lineEnd, chunk);
+            pos = next;
+        }
+    }
+
+    //Append the frames of all chunks in file order. untimedFrames, if given, receives the indexes
+    //into frames of the frames without a time stamp. Returns false if any line was bad.
+    bool collect(QVector<CANFrame> *frames, QVector<int> *untimedFrames = nullptr);
+
+    static int minChunkBytes; //smaller chunks cost more in thread handoff than they gain
+
+private:
+    void splitChunks(qint64 from);
+    void waitFor(QFuture<void> &future);
+
+    QFile file;
+    QByteArray fallback; //file contents if the file system won't let us map it
+    const char *base;
+    qint64 length;
+    QVector<Chunk> chunks;
+};
+
+#endif // CHUNKEDTEXTLOADER_H
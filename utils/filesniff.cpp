@@ -0,0 +1,58 @@
+#include "filesniff.h"
+
+#include <QFile>
+#include <QtGlobal>
+#include <cstring>
+
+int FileSniff::sniffBytes = 65536;
+const QByteArray FileSniff::noLine;
+
+FileSniff::FileSniff(const QString &filename)
+{
+    name = filename;
+    size = 0;
+    QFile inFile(filename);
+    opened = inFile.open(QIODevice::ReadOnly);
+    if (!opened) return;
+
+    size = inFile.size();
+    head = inFile.read(sniffBytes);
+    if (size > head.length())
+    {
+        inFile.seek(qMax(size - tailBytes, 0ll));
+        tail = inFile.read(tailBytes);
+    }
+    else
+    {
+        size = head.length(); //sequential devices report no size
+        tail = head.right(tailBytes);
+    }
+    inFile.close();
+
+    splitLines();
+}
+
+void FileSniff::splitLines()
+{
+    const char *base = head.constData();
+    const char *end = base + head.length();
+    const char *pos = base;
+    while (pos < end && lines.count() < maxLines)
+    {
+        const char *nl = static_cast<const char *>(memchr(pos, '\n', static_cast<size_t>(end - pos)));
+        if (!nl && !isComplete()) break; //partial line at the end of the sniff
+        const char *lineEnd = nl ? nl : end;
+        int len = static_cast<int>(lineEnd - pos);
+        if (len > 0 && pos[len - 1] == '\r') len--;
+        QByteArray line(pos, len);
+        if (nl) line.append('\n');
+        lines.append(line);
+        pos = nl ? nl + 1 : end;
+    }
+}
+
+QString FileSniff::text(int idx) const
+{
+    const QByteArray &l = line(idx);
+    return QString::fromUtf8(l.constData(), l.endsWith('\n') ? l.length() - 1 : l.length());
+}
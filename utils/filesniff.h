@@ -0,0 +1,52 @@
+#ifndef FILESNIFF_H
+#define FILESNIFF_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/*
+ * The start (and the last few bytes) of a file, read once so that every format probe in
+ * FrameFileIO can look at it without opening the file again. That matters most on network
+ * storage where each open and read is a round trip.
+ *
+ * line() hands out lines the way QIODevice::readLine does on a file opened with QIODevice::Text:
+ * the line break is included and \r\n comes back as \n. Only whole lines are split out, a line
+ * cut off by the end of the sniffed bytes is left out unless it is also the end of the file.
+ * Everything is read up front and nothing changes afterwards so a FileSniff can be shared by
+ * any number of threads.
+ */
+class FileSniff
+{
+public:
+    static int sniffBytes;               //how much of the start of the file is read
+    static const int tailBytes = 64;
+    static const int maxLines = 256;
+
+    explicit FileSniff(const QString &filename);
+
+    bool isOpen() const { return opened; }
+    const QString &fileName() const { return name; }
+    qint64 fileSize() const { return size; }
+    bool isComplete() const { return size == head.length(); } //the whole file fit in the sniff
+
+    const QByteArray &start() const { return head; }
+    const QByteArray &end() const { return tail; } //last tailBytes of the file, or all of it if shorter
+
+    int lineCount() const { return lines.count(); }
+    const QByteArray &line(int idx) const { return (idx >= 0 && idx < lines.count()) ? lines.at(idx) : noLine; } //past the end is empty
+    QString text(int idx) const; //the line without its line break, like QTextStream::readLine
+
+private:
+    void splitLines();
+
+    QString name;
+    bool opened;
+    qint64 size;
+    QByteArray head;
+    QByteArray tail;
+    QVector<QByteArray> lines;
+    static const QByteArray noLine;
+};
+
+#endif // FILESNIFF_H
@@ -0,0 +1,280 @@
+#include "frameexporter.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFuture>
+#include <QProgressDialog>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <cmath>
+#include <cstring>
+
+const char ExportLine::hexDigits[] = "0123456789ABCDEF";
+int FrameExporter::framesPerBatch = 16384;
+
+void ExportLine::justify(char *start, int width, char fill)
+{
+    int len = static_cast<int>(end - start);
+    if (len >= width) return;
+    int pad = width - len;
+    memmove(start + pad, start, static_cast<size_t>(len));
+    memset(start, fill, static_cast<size_t>(pad));
+    end += pad;
+}
+
+void ExportLine::hex(uint64_t value, int width, char fill)
+{
+    char *start = end;
+    char digits[16];
+    int num = 0;
+    do
+    {
+        digits[num++] = hexDigits[value & 0xF];
+        value >>= 4;
+    } while (value);
+    while (num > 0) *end++ = digits[--num];
+    justify(start, width, fill);
+}
+
+void ExportLine::decUnsigned(uint64_t value, int width, char fill)
+{
+    char *start = end;
+    char digits[20];
+    int num = 0;
+    do
+    {
+        digits[num++] = static_cast<char>('0' + (value % 10));
+        value /= 10;
+    } while (value);
+    while (num > 0) *end++ = digits[--num];
+    justify(start, width, fill);
+}
+
+void ExportLine::dec(int64_t value, int width, char fill)
+{
+    char *start = end;
+    if (value < 0)
+    {
+        *end++ = '-';
+        decUnsigned(0 - static_cast<uint64_t>(value));
+    }
+    else decUnsigned(static_cast<uint64_t>(value));
+    justify(start, width, fill);
+}
+
+void ExportLine::seconds(int64_t micros, int decimals, int width, char fill)
+{
+    static const uint64_t powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+    char *start = end;
+    if (micros < 0) *end++ = '-';
+    uint64_t value = (micros < 0) ? 0 - static_cast<uint64_t>(micros) : static_cast<uint64_t>(micros);
+    if (decimals < 0) decimals = 6; //what QString::number does with a negative precision
+
+    int fracDigits = qMin(decimals, 6);
+    uint64_t divisor = powers[6 - fracDigits];
+    uint64_t remainder = value % divisor;
+    value /= divisor;
+    if (remainder > divisor / 2) value++;
+    else if (remainder == divisor / 2 && divisor > 1)
+    {
+        //Exactly half way in decimal. The double the old QString::number code rounded is a hair
+        //above or below that, fma tells which without losing the sign to rounding
+        double exact = static_cast<double>(value * divisor + remainder);
+        double err = std::fma(exact / 1000000.0, 1000000.0, -exact);
+        if (err > 0 || (err == 0 && (value & 1))) value++;
+    }
+    decUnsigned(value / powers[fracDigits]);
+    if (decimals > 0)
+    {
+        *end++ = '.';
+        if (fracDigits > 0) decUnsigned(value % powers[fracDigits], fracDigits, '0');
+        for (int i = fracDigits; i < decimals; i++) *end++ = '0';
+    }
+    justify(start, width, fill);
+}
+
+void ExportLine::justifyLeft(int from, int width, char fill)
+{
+    while (length() - from < width) *end++ = fill;
+}
+
+void ExportLine::trimRight(int from)
+{
+    while (end > text + from && (end[-1] == ' ' || end[-1] == '\t')) end--;
+}
+
+int LocalClock::msOfDay(int64_t msSinceEpoch)
+{
+    static const int64_t msPerHour = 3600000;
+    static const int64_t msPerDay = 86400000;
+
+    int64_t hour = msSinceEpoch / msPerHour;
+    if (msSinceEpoch < 0 && (msSinceEpoch % msPerHour)) hour--;
+
+    int64_t offset;
+    if (haveCache && hour == cachedHour) offset = cachedOffset;
+    else
+    {
+        offset = QDateTime::fromMSecsSinceEpoch(msSinceEpoch).offsetFromUtc() * 1000ll;
+        //only trust the offset for the whole hour if it doesn't change anywhere inside it
+        int64_t hourStart = hour * msPerHour;
+        haveCache = QDateTime::fromMSecsSinceEpoch(hourStart).offsetFromUtc() * 1000ll == offset
+                 && QDateTime::fromMSecsSinceEpoch(hourStart + msPerHour - 1).offsetFromUtc() * 1000ll == offset;
+        cachedHour = hour;
+        cachedOffset = offset;
+    }
+
+    int64_t local = (msSinceEpoch + offset) % msPerDay;
+    if (local < 0) local += msPerDay;
+    return static_cast<int>(local);
+}
+
+namespace
+{
+    struct ExportBatch
+    {
+        int first;
+        int count;
+        QByteArray out; //kept between windows so the memory is reused
+    };
+}
+
+FrameExporter::FrameExporter(const CANFrameStore *frames, QProgressDialog *progress)
+{
+    store = frames;
+    progressDialog = progress;
+    openMode = QIODevice::WriteOnly | QIODevice::Text;
+    batchSize = framesPerBatch;
+    canceled = false;
+}
+
+bool FrameExporter::run(const QString &filename, const QByteArray &header, const BatchFormatter &format,
+                        const TrailerBuilder &trailer)
+{
+    QElapsedTimer timer;
+    timer.start();
+    canceled = false;
+
+    QFile file(filename);
+    if (!file.open(openMode)) return false;
+
+    if (progressDialog)
+    {
+        progressDialog->setRange(0, 1000);
+        progressDialog->setValue(0);
+    }
+
+    int total = store->count();
+    int numBatches = (total + batchSize - 1) / batchSize;
+    QVector<ExportBatch> windows[2];
+    framesWritten.storeRelease(0);
+
+    //a single writer thread keeps the batches in order and never blocks the formatting
+    QThreadPool writerPool;
+    writerPool.setMaxThreadCount(1);
+    QFuture<bool> writing;
+    bool writerStarted = false;
+
+    bool ok = file.write(header) == header.length();
+
+    int nextBatch = 0;
+    for (int w = 0; ok && !canceled && nextBatch < numBatches; w++)
+    {
+        QVector<ExportBatch> &window = windows[w & 1];
+        window.resize(qMin(batchesPerWindow, numBatches - nextBatch));
+        for (int b = 0; b < window.count(); b++)
+        {
+            window[b].first = (nextBatch + b) * batchSize;
+            window[b].count = qMin(batchSize, total - window[b].first);
+        }
+        nextBatch += window.count();
+
+        QFuture<void> formatting = QtConcurrent::map(window, [&format](ExportBatch &batch)
+        {
+            batch.out.resize(0);
+            format(batch.first, batch.count, batch.out);
+            batch.out.reserve(batch.out.size()); //marks the capacity as reserved so resize(0) holds on to it
+        });
+        waitFor(formatting);
+
+        //the window before this one has to be on disk before its buffers are formatted into again
+        if (writerStarted)
+        {
+            waitFor(writing);
+            if (!writing.result()) ok = false;
+        }
+        if (!ok || canceled) break;
+
+        const QVector<ExportBatch> *batches = &window;
+        QAtomicInt *written = &framesWritten;
+        writing = QtConcurrent::run(&writerPool, [&file, batches, written]()
+        {
+            for (int b = 0; b < batches->count(); b++)
+            {
+                const ExportBatch &batch = batches->at(b);
+                if (file.write(batch.out) != batch.out.length()) return false;
+                written->fetchAndAddRelease(batch.count);
+            }
+            return true;
+        });
+        writerStarted = true;
+    }
+
+    if (writerStarted)
+    {
+        waitFor(writing);
+        if (!writing.result()) ok = false;
+    }
+
+    if (ok && !canceled && trailer)
+    {
+        QByteArray tail = trailer();
+        ok = file.write(tail) == tail.length();
+    }
+
+    if (canceled) qDebug() << "Export to" << filename << "canceled";
+    else if (!ok) qDebug() << "Export to" << filename << "failed:" << file.errorString();
+    file.close();
+    if (!ok || canceled)
+    {
+        file.remove();
+        return false;
+    }
+
+    updateProgress(total);
+    qDebug() << "Exported" << total << "frames to" << filename << "in" << timer.elapsed() << "ms";
+    return true;
+}
+
+//Waits for work to finish. On the GUI thread events keep being processed so the progress dialog
+//stays live and can be canceled. Canceling only stops new work from starting, whatever is already
+//running is always waited for since it points at buffers and the file owned by run()
+template<typename Future>
+void FrameExporter::waitFor(Future &future)
+{
+    if (!qApp || QThread::currentThread() != qApp->thread())
+    {
+        future.waitForFinished();
+        return;
+    }
+    while (!future.isFinished())
+    {
+        qApp->processEvents();
+        updateProgress(framesWritten.loadAcquire());
+        if (progressDialog && progressDialog->wasCanceled()) canceled = true;
+        QThread::msleep(5);
+    }
+}
+
+void FrameExporter::updateProgress(int framesDone)
+{
+    if (!progressDialog || store->count() == 0) return;
+    progressDialog->setValue(static_cast<int>((static_cast<qint64>(framesDone) * 1000) / store->count()));
+}
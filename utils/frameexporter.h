@@ -0,0 +1,121 @@
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <functional>
+#include "canframestore.h"
+
+class QProgressDialog;
+
+/*
+ * One line of export text built on the stack, then appended to the batch buffer in a single go.
+ * Number formatting is done by hand since QString::number and friends allocate on every call and
+ * that is most of the time spent exporting. Everything is plain ASCII. The buffer is big enough
+ * for the longest line any format writes for a 64 byte CAN-FD payload, nothing is bounds checked.
+ *
+ * The padded variants behave like QString::rightJustified: the number is never cut down to the
+ * width, it is only padded in front when shorter.
+ */
+class ExportLine
+{
+public:
+    ExportLine() : end(text) {}
+
+    void clear() { end = text; }
+    int length() const { return static_cast<int>(end - text); }
+    void appendTo(QByteArray &out) const { out.append(text, length()); }
+
+    void put(char c) { *end++ = c; }
+    void put(const char *str) { while (*str) *end++ = *str++; }
+    void hexByte(uint8_t byte) { *end++ = hexDigits[byte >> 4]; *end++ = hexDigits[byte & 0xF]; }
+    void hex(uint64_t value, int width = 0, char fill = '0'); //upper case like the old toUpper() calls
+    void dec(int64_t value, int width = 0, char fill = ' ');
+    void decUnsigned(uint64_t value, int width = 0, char fill = ' ');
+    //micros / 1000000.0 printed like QString::number(x, 'f', decimals). Past 6 decimals only zeros follow
+    //where the double would show its rounding noise
+    void seconds(int64_t micros, int decimals, int width = 0, char fill = ' ');
+    void justifyLeft(int from, int width, char fill = ' '); //pads what was written since from like leftJustified
+    void trimRight(int from); //drops white space written since from
+
+private:
+    void justify(char *start, int width, char fill);
+
+    static const char hexDigits[];
+    char text[1024];
+    char *end;
+};
+
+/*
+ * Local wall clock time for millisecond time stamps. Asking QDateTime for the local time of every
+ * frame costs a time zone lookup each time, so the offset from UTC is remembered for the hour the
+ * last frame was in and only looked up again when a frame lands in another hour. One per thread.
+ */
+class LocalClock
+{
+public:
+    LocalClock() : cachedHour(0), cachedOffset(0), haveCache(false) {}
+    int msOfDay(int64_t msSinceEpoch); //local time of day
+
+private:
+    int64_t cachedHour;
+    int64_t cachedOffset; //ms
+    bool haveCache;
+};
+
+/*
+ * Shared engine behind the FrameFileIO savers. Frames are cut into batches that are formatted into
+ * their own reused buffers on all cores at once. A window of batches is formatted while the window
+ * before it is written out, in order, by a single writer thread, so the disk and the formatting run
+ * side by side and the GUI thread only waits. The output is byte for byte what formatting the frames
+ * one at a time would give.
+ *
+ * A format supplies a batch formatter: void format(int first, int count, QByteArray &out). It appends
+ * frames [first, first + count) in whatever encoding the format uses to out, which comes in empty.
+ * It runs on worker threads for several batches at the same time so it must only read shared state
+ * or write to something that belongs to that one batch.
+ *
+ * With a progress dialog the exporter keeps it updated and stops when it is canceled. A canceled or
+ * failed export deletes the partial file and run() returns false.
+ *
+ * The frames must not change until run() returns. Events are processed while it waits, so a store
+ * that is still being added to (like the main frame list) has to be copied first.
+ *
+ * Usage:
+ *   FrameExporter exporter(frames, progress);
+ *   return exporter.run(filename, header, [frames](int first, int count, QByteArray &out) { ... });
+ */
+class FrameExporter
+{
+public:
+    typedef std::function<void(int first, int count, QByteArray &out)> BatchFormatter;
+    typedef std::function<QByteArray()> TrailerBuilder; //called once every batch has been formatted
+
+    static int framesPerBatch;
+    static const int batchesPerWindow = 16;
+
+    FrameExporter(const CANFrameStore *frames, QProgressDialog *progress = nullptr);
+
+    //binary formats open without QIODevice::Text so no line endings get translated
+    void setOpenMode(QIODevice::OpenMode mode) { openMode = mode; }
+    void setBatchSize(int frames) { batchSize = frames; } //for formats with their own block size
+
+    bool run(const QString &filename, const QByteArray &header, const BatchFormatter &format,
+             const TrailerBuilder &trailer = TrailerBuilder());
+    bool wasCanceled() const { return canceled; }
+
+private:
+    template<typename Future> void waitFor(Future &future);
+    void updateProgress(int framesDone);
+
+    const CANFrameStore *store;
+    QProgressDialog *progressDialog;
+    QIODevice::OpenMode openMode;
+    int batchSize;
+    bool canceled;
+    QAtomicInt framesWritten; //by the writer thread, read for progress
+};
+
+#endif // FRAMEEXPORTER_H
@@ -3,89 +3,271 @@
 
 #include <QObject>
 #include <QDebug>
+#include <climits>
 
-
-/* macros */
-#define IS_EMPTY()  (  mWIdx.loadAcquire()             == mRIdx.loadAcquire() )
-#define IS_FULL()   ( (mWIdx.loadAcquire()+1)%mSize    == mRIdx.loadAcquire() )
+//assumed size of a cache line, the indices the producer and the consumer each write are kept this far apart
+#define LFQUEUE_CACHE_LINE 64
 
 
+/*
+ * Lock free ring of preallocated slots. Frames are written in place by the producer and read in
+ * place by the consumer so nothing is allocated or copied on the way through.
+ *
+ * The capacity is rounded up to a power of two so an index is just masked, and every slot can be
+ * used. The head and tail are free running counters, each on its own cache line together with the
+ * producer's (or consumer's) cached copy of the other one, so the two threads only touch each other's
+ * line when the cached copy says the ring looks full or empty.
+ *
+ * Modes:
+ *   SPSC  one producer thread and one consumer thread. get()/queue() or reserve()/commit() to write,
+ *         peek()/dequeue() or peekSpan()/consume() to read.
+ *   MPSC  any number of producer threads, still one consumer. Producers claim slots with a CAS and
+ *         mark each one written with a per slot sequence number, so they must use reserve()/commit().
+ *         get()/queue() only work in SPSC mode.
+ *
+ * A producer that finds the ring full is expected to drop what it had and say so with countDrop().
+ */
 template<class T>
 class LFQueue
 {
 public:
-    LFQueue() : mSize(0), mArray(nullptr){}
+    enum Mode
+    {
+        SPSC,
+        MPSC
+    };
+
+    LFQueue() : mArray(nullptr), mSeq(nullptr), mCapacity(0), mMask(0), mMode(SPSC), mCachedTail(0), mCachedHead(0) {}
 
     ~LFQueue() {setSize(0);}
 
-    bool setSize(int size) {
-        if(size<0)
+    //holds at least size frames afterwards, 0 frees the ring
+    bool setSize(int size, Mode mode = SPSC) {
+        if(size<0 || size>(1<<30))
             return false;
 
-        if(mArray) {
-            delete[] mArray;
-            mArray = nullptr;
-        }
+        delete[] mArray;
+        delete[] mSeq;
+        mArray = nullptr;
+        mSeq = nullptr;
+        mCapacity = 0;
+        mMask = 0;
+        mMode = mode;
 
         if(size>0) {
-            mArray = new T[size];
-            if(mArray)
-                mSize = size;
-            return ( mArray != nullptr );
+            quint32 capacity = 1;
+            while(capacity < static_cast<quint32>(size))
+                capacity <<= 1;
+
+            mArray = new T[capacity];
+            if(mode == MPSC)
+                mSeq = new QAtomicInteger<quint32>[capacity];
+            mCapacity = capacity;
+            mMask = capacity - 1;
         }
 
+        flush();
         return true;
     }
 
+    int capacity() const { return static_cast<int>(mCapacity); }
+    Mode mode() const { return mMode; }
+
+    //frames waiting to be read. Only a snapshot since both ends keep moving
+    int count() const {
+        return static_cast<int>(mHead.loadAcquire() - mTail.loadAcquire());
+    }
+
+    //not safe while either end is being used
     void flush() {
-        mRIdx.storeRelease(0);
-        mWIdx.storeRelease(0);
+        mHead.storeRelease(0);
+        mTail.storeRelease(0);
+        mCachedTail = 0;
+        mCachedHead = 0;
+        mDropped.storeRelease(0);
+        for(quint32 i=0; mSeq && i<mCapacity ; i++)
+            mSeq[i].storeRelaxed(i);
     }
 
-    T* get() {
-        if(IS_FULL())
-            return nullptr;
+    //frames the producer couldn't find room for since the last flush
+    void countDrop(quint64 frames = 1) { mDropped.fetchAndAddRelaxed(frames); }
+    quint64 dropped() const { return mDropped.loadRelaxed(); }
+    void resetDropped() { mDropped.fetchAndStoreRelaxed(0); }
 
-        return &(mArray[mWIdx.loadAcquire()]); /* prevent memory reordering (belt and braces) */
-    }
 
+    /* producer, one slot (SPSC only) */
+
+    T* get() {
+        int granted;
+        return reserve(1, granted);
+    }
 
     void queue() {
         #ifdef QT_DEBUG
-        if(IS_FULL())
+        if(mMode != SPSC)
+            qCritical() << "BUG: queue() on a multi producer queue, use commit()";
+        if(mHead.loadRelaxed() - mTail.loadAcquire() >= mCapacity)
             qCritical() << "BUG: queueing in full queue";
         #endif
 
-        int wIdx = mWIdx.loadAcquire();
-        mWIdx.storeRelease((wIdx+1)%mSize);
+        mHead.storeRelease(mHead.loadRelaxed() + 1);
     }
 
 
-    T* peek() {
-        if(IS_EMPTY())
+    /* producer, several slots */
+
+    //up to wanted slots that follow each other in memory. Fewer are granted when the ring is nearly
+    //full or the free space wraps around the end, nullptr when there is no room at all
+    T* reserve(int wanted, int &granted) {
+        granted = 0;
+        if(wanted <= 0 || !mCapacity)
             return nullptr;
 
-        return &(mArray[mRIdx.loadAcquire()]); /* prevent memory reordering (belt and braces) */
+        if(mMode == SPSC) {
+            quint32 head = mHead.loadRelaxed();
+            quint32 space = mCapacity - (head - mCachedTail);
+            if(space < static_cast<quint32>(wanted)) {
+                mCachedTail = mTail.loadAcquire();
+                space = mCapacity - (head - mCachedTail);
+                if(!space)
+                    return nullptr;
+            }
+            quint32 idx = head & mMask;
+            granted = static_cast<int>(qMin(qMin(space, static_cast<quint32>(wanted)), mCapacity - idx));
+            return &mArray[idx];
+        }
+
+        for(;;) {
+            quint32 head = mHead.loadRelaxed();
+            quint32 idx = head & mMask;
+            qint32 state = static_cast<qint32>(mSeq[idx].loadAcquire() - head);
+            if(state < 0)
+                return nullptr; //still holds a frame from the last time around
+            if(state > 0)
+                continue; //another producer got in first
+
+            //the slot is free, take as many of the ones after it as are free too
+            quint32 limit = qMin(static_cast<quint32>(wanted), mCapacity - idx);
+            quint32 n = 1;
+            while(n < limit && mSeq[idx + n].loadAcquire() == head + n)
+                n++;
+
+            if(mHead.testAndSetRelaxed(head, head + n)) {
+                granted = static_cast<int>(n);
+                return &mArray[idx];
+            }
+        }
     }
 
+    //hands count slots starting at first (as returned by reserve()) over to the consumer
+    void commit(T *first, int count) {
+        if(count <= 0)
+            return;
+
+        if(mMode == SPSC) {
+            #ifdef QT_DEBUG
+            if(first != &mArray[mHead.loadRelaxed() & mMask])
+                qCritical() << "BUG: committing slots that weren't reserved";
+            #else
+            Q_UNUSED(first)
+            #endif
+            mHead.storeRelease(mHead.loadRelaxed() + static_cast<quint32>(count));
+            return;
+        }
+
+        quint32 idx = static_cast<quint32>(first - mArray);
+        for(quint32 i=0; i<static_cast<quint32>(count) ; i++)
+            mSeq[idx + i].storeRelease(mSeq[idx + i].loadRelaxed() + 1);
+    }
+
+
+    /* consumer, one slot */
+
+    T* peek() {
+        int available;
+        return peekSpan(available, 1);
+    }
 
     void dequeue() {
         #ifdef QT_DEBUG
-        if(IS_EMPTY())
+        if(mHead.loadAcquire() == mTail.loadRelaxed())
             qCritical() << "BUG: dequeueing an empty queue";
         #endif
 
-        int rIdx = mRIdx.loadAcquire();
-        mRIdx.storeRelease((rIdx+1)%mSize);
+        consume(1);
+    }
+
+
+    /* consumer, several slots */
+
+    //the frames ready to be read that follow each other in memory, at most limit of them. A span
+    //stops at the end of the ring (the rest comes with the next call) and in MPSC mode at the first
+    //slot that is claimed but not committed yet. nullptr when nothing is ready
+    T* peekSpan(int &available, int limit = INT_MAX) {
+        available = 0;
+        if(!mCapacity || limit <= 0)
+            return nullptr;
+
+        quint32 tail = mTail.loadRelaxed();
+        quint32 idx = tail & mMask;
+        quint32 max = qMin(static_cast<quint32>(limit), mCapacity - idx);
+        quint32 n = 0;
+
+        if(mMode == SPSC) {
+            if(mCachedHead - tail < max) {
+                mCachedHead = mHead.loadAcquire();
+                if(mCachedHead == tail)
+                    return nullptr;
+            }
+            n = qMin(mCachedHead - tail, max);
+        }
+        else {
+            while(n < max && mSeq[idx + n].loadAcquire() == tail + n + 1)
+                n++;
+            if(!n)
+                return nullptr;
+        }
+
+        available = static_cast<int>(n);
+        return &mArray[idx];
+    }
+
+    //gives the first count slots returned by peekSpan() back to the producers
+    void consume(int count) {
+        if(count <= 0)
+            return;
+
+        quint32 tail = mTail.loadRelaxed();
+        if(mMode == MPSC) {
+            quint32 idx = tail & mMask;
+            for(quint32 i=0; i<static_cast<quint32>(count) ; i++)
+                mSeq[idx + i].storeRelease(tail + i + mCapacity);
+        }
+        mTail.storeRelease(tail + static_cast<quint32>(count));
     }
 
 
 private:
-    int mSize;
+    LFQueue(const LFQueue &);
+    LFQueue &operator=(const LFQueue &);
+
     T*  mArray;
+    QAtomicInteger<quint32>* mSeq; //MPSC only, head value that may claim the slot or that value + 1 once it's written
+    quint32 mCapacity;
+    quint32 mMask;
+    Mode mMode;
+    char mPadShared[LFQUEUE_CACHE_LINE];
+
+    /* written by the producer(s) */
+    QAtomicInteger<quint32> mHead;
+    quint32 mCachedTail;
+    QAtomicInteger<quint64> mDropped;
+    char mPadProducer[LFQUEUE_CACHE_LINE];
 
-    QAtomicInt mRIdx;
-    QAtomicInt mWIdx;
+    /* written by the consumer */
+    QAtomicInteger<quint32> mTail;
+    quint32 mCachedHead;
+    char mPadConsumer[LFQUEUE_CACHE_LINE];
 };
 
 #endif // LFQUEUE_H
@@ -0,0 +1,95 @@
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+
+#include <QVector>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <atomic>
+
+/*
+ * Stable sort spread over all cores. The items are cut into chunks which are sorted on their own,
+ * then merged pairwise with each round of merges also running in parallel. Meant for small flat
+ * records like (key, row) pairs which are cheap to move, not for sorting heavy objects in place.
+ *
+ * If progress is given it is bumped once per finished chunk sort and once per merge, stepCount()
+ * says how many of those there will be. Setting cancel stops the sort at the next chunk or merge
+ * boundary and stableSort returns false, the items are then left in an unspecified state.
+ */
+class ParallelSort
+{
+public:
+    static int chunkCount(int count)
+    {
+        const int minChunk = 16384; //smaller than this and the threading costs more than it saves
+        int chunks = QThread::idealThreadCount() * 4; //a few per core so progress moves smoothly
+        if (chunks < 1) chunks = 1;
+        if (count / minChunk < chunks) chunks = count / minChunk;
+        if (chunks < 1) chunks = 1;
+        return chunks;
+    }
+
+    static int stepCount(int count)
+    {
+        int chunks = chunkCount(count);
+        int steps = chunks;
+        for (int width = 1; width < chunks; width *= 2) steps += (chunks + (2 * width) - 1) / (2 * width);
+        return steps;
+    }
+
+    template<typename T, typename LessThan>
+    static bool stableSort(QVector<T> &items, LessThan lessThan, const std::atomic<bool> *cancel = nullptr, std::atomic<int> *progress = nullptr)
+    {
+        return stableSort(items, chunkCount(items.count()), lessThan, cancel, progress);
+    }
+
+    //the same cut into a given number of chunks, at most one per item
+    template<typename T, typename LessThan>
+    static bool stableSort(QVector<T> &items, int chunks, LessThan lessThan, const std::atomic<bool> *cancel = nullptr, std::atomic<int> *progress = nullptr)
+    {
+        int count = items.count();
+        if (count < 2) return true;
+
+        chunks = qBound(1, chunks, count);
+        QVector<int> bounds(chunks + 1);
+        for (int c = 0; c <= chunks; c++) bounds[c] = static_cast<int>((static_cast<qint64>(count) * c) / chunks);
+
+        T *data = items.data();
+        QVector<int> work;
+        for (int c = 0; c < chunks; c++) work.append(c);
+        QtConcurrent::blockingMap(work, [&](int c)
+        {
+            if (cancel && cancel->load()) return;
+            std::stable_sort(data + bounds[c], data + bounds[c + 1], lessThan);
+            if (progress) (*progress)++;
+        });
+        if (cancel && cancel->load()) return false;
+        if (chunks == 1) return true;
+
+        //ping pong between items and a scratch buffer, one round of merges per pass
+        QVector<T> scratch(count);
+        T *src = data;
+        T *dst = scratch.data();
+        for (int width = 1; width < chunks; width *= 2)
+        {
+            work.clear();
+            for (int c = 0; c < chunks; c += 2 * width) work.append(c);
+            QtConcurrent::blockingMap(work, [&](int c)
+            {
+                if (cancel && cancel->load()) return;
+                int lo = bounds[c];
+                int mid = bounds[qMin(c + width, chunks)];
+                int hi = bounds[qMin(c + (2 * width), chunks)];
+                //std::merge takes from the first range on ties which keeps this stable
+                std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, lessThan);
+                if (progress) (*progress)++;
+            });
+            if (cancel && cancel->load()) return false;
+            std::swap(src, dst);
+        }
+        if (src != data) std::copy(src, src + count, data);
+        return true;
+    }
+};
+
+#endif // PARALLELSORT_H
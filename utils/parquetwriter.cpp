@@ -0,0 +1,272 @@
+#include "parquetwriter.h"
+
+#include <QStack>
+#include <QtConcurrent/QtConcurrentMap>
+#include "utility.h"
+
+namespace
+{
+    //Thrift compact protocol, only the parts Parquet metadata needs
+    enum CompactType
+    {
+        CT_I32 = 5,
+        CT_I64 = 6,
+        CT_BINARY = 8,
+        CT_LIST = 9,
+        CT_STRUCT = 12
+    };
+
+    //parquet.thrift enums
+    enum ParquetType { PQ_INT64 = 2, PQ_DOUBLE = 5 };
+    enum ParquetRepetition { PQ_REQUIRED = 0 };
+    enum ParquetEncoding { PQ_PLAIN = 0, PQ_RLE = 3 };
+    enum ParquetCodec { PQ_GZIP = 2 };
+    enum ParquetPageType { PQ_DATA_PAGE = 0 };
+
+    class CompactWriter
+    {
+    public:
+        CompactWriter() : lastField(0) {}
+
+        QByteArray out;
+
+        void i32(int field, int32_t value) { header(field, CT_I32); varint(zigzag(value)); }
+        void i64(int field, int64_t value) { header(field, CT_I64); varint(zigzag(value)); }
+        void binary(int field, const QByteArray &value) { header(field, CT_BINARY); listBinary(value); }
+        void beginStruct(int field) { header(field, CT_STRUCT); beginListStruct(); }
+        void endStruct() { out.append('\0'); lastField = fieldStack.pop(); }
+        void beginList(int field, CompactType element, int size)
+        {
+            header(field, CT_LIST);
+            if (size < 15) out.append(static_cast<char>((size << 4) | element));
+            else
+            {
+                out.append(static_cast<char>(0xF0 | element));
+                varint(static_cast<uint64_t>(size));
+            }
+        }
+        void listI32(int32_t value) { varint(zigzag(value)); }
+        void listBinary(const QByteArray &value) { varint(static_cast<uint64_t>(value.length())); out.append(value); }
+        void beginListStruct() { fieldStack.push(lastField); lastField = 0; }
+        void endMessage() { out.append('\0'); } //stop field of the outermost struct
+
+    private:
+        static uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+
+        void varint(uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.append(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.append(static_cast<char>(value));
+        }
+
+        void header(int field, CompactType type)
+        {
+            int delta = field - lastField;
+            if (delta > 0 && delta <= 15) out.append(static_cast<char>((delta << 4) | type));
+            else
+            {
+                out.append(static_cast<char>(type));
+                varint(zigzag(field));
+            }
+            lastField = field;
+        }
+
+        int lastField;
+        QStack<int> fieldStack;
+    };
+
+    struct CompressedChunk
+    {
+        int column;
+        QByteArray page; //page header followed by the compressed values
+        qint64 uncompressedSize;
+        bool ok;
+    };
+}
+
+ParquetWriter::ParquetWriter()
+{
+    filePos = 0;
+    totalRows = 0;
+}
+
+ParquetWriter::~ParquetWriter()
+{
+    if (file.isOpen()) abort();
+}
+
+void ParquetWriter::addColumn(const QString &name, ColumnType type)
+{
+    Column col;
+    col.name = name.toUtf8();
+    col.type = type;
+    columns.append(col);
+}
+
+bool ParquetWriter::open(const QString &filename)
+{
+    rowGroups.clear();
+    totalRows = 0;
+    file.setFileName(filename);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        error = "Could not open " + filename + " for writing";
+        return false;
+    }
+    filePos = file.write("PAR1", 4);
+    if (filePos != 4)
+    {
+        error = "Could not write " + filename + ": " + file.errorString();
+        abort();
+        return false;
+    }
+    return true;
+}
+
+bool ParquetWriter::writeRowGroup(const QVector<QByteArray> &values, int rows)
+{
+    if (!file.isOpen() || values.count() != columns.count()) return false;
+    if (rows <= 0) return true;
+
+    QVector<CompressedChunk> chunks(columns.count());
+    for (int c = 0; c < chunks.count(); c++) chunks[c].column = c;
+
+    QtConcurrent::blockingMap(chunks, [&values, rows](CompressedChunk &chunk)
+    {
+        const QByteArray &plain = values.at(chunk.column);
+        QByteArray compressed;
+        chunk.ok = Utility::appendGzip(plain, compressed);
+
+        CompactWriter header;
+        header.i32(1, PQ_DATA_PAGE);
+        header.i32(2, plain.length());
+        header.i32(3, compressed.length());
+        header.beginStruct(5); //DataPageHeader
+        header.i32(1, rows);
+        header.i32(2, PQ_PLAIN);
+        header.i32(3, PQ_RLE);
+        header.i32(4, PQ_RLE);
+        header.endStruct();
+        header.endMessage();
+
+        chunk.uncompressedSize = header.out.length() + plain.length();
+        chunk.page = header.out;
+        chunk.page.append(compressed);
+    });
+
+    RowGroupInfo group;
+    group.rows = rows;
+    for (int c = 0; c < chunks.count(); c++)
+    {
+        const CompressedChunk &chunk = chunks.at(c);
+        if (!chunk.ok)
+        {
+            error = "Compressing column " + QString::fromUtf8(columns.at(c).name) + " failed";
+            return false;
+        }
+        if (file.write(chunk.page) != chunk.page.length())
+        {
+            error = "Could not write " + file.fileName() + ": " + file.errorString();
+            return false;
+        }
+        ChunkInfo info;
+        info.offset = filePos;
+        info.compressedSize = chunk.page.length();
+        info.uncompressedSize = chunk.uncompressedSize;
+        group.chunks.append(info);
+        filePos += chunk.page.length();
+    }
+    rowGroups.append(group);
+    totalRows += rows;
+    return true;
+}
+
+QByteArray ParquetWriter::footer() const
+{
+    CompactWriter meta;
+    meta.i32(1, 1); //version
+
+    meta.beginList(2, CT_STRUCT, columns.count() + 1); //schema, the root then one leaf per column
+    meta.beginListStruct();
+    meta.binary(4, "schema");
+    meta.i32(5, columns.count());
+    meta.endStruct();
+    for (int c = 0; c < columns.count(); c++)
+    {
+        meta.beginListStruct();
+        meta.i32(1, columns.at(c).type == COLUMN_DOUBLE ? PQ_DOUBLE : PQ_INT64);
+        meta.i32(3, PQ_REQUIRED);
+        meta.binary(4, columns.at(c).name);
+        meta.endStruct();
+    }
+
+    meta.i64(3, totalRows);
+
+    meta.beginList(4, CT_STRUCT, rowGroups.count());
+    for (int g = 0; g < rowGroups.count(); g++)
+    {
+        const RowGroupInfo &group = rowGroups.at(g);
+        qint64 totalBytes = 0;
+        qint64 totalCompressed = 0;
+
+        meta.beginListStruct();
+        meta.beginList(1, CT_STRUCT, group.chunks.count());
+        for (int c = 0; c < group.chunks.count(); c++)
+        {
+            const ChunkInfo &chunk = group.chunks.at(c);
+            totalBytes += chunk.uncompressedSize;
+            totalCompressed += chunk.compressedSize;
+
+            meta.beginListStruct(); //ColumnChunk
+            meta.i64(2, chunk.offset);
+            meta.beginStruct(3); //ColumnMetaData
+            meta.i32(1, columns.at(c).type == COLUMN_DOUBLE ? PQ_DOUBLE : PQ_INT64);
+            meta.beginList(2, CT_I32, 1);
+            meta.listI32(PQ_PLAIN);
+            meta.beginList(3, CT_BINARY, 1);
+            meta.listBinary(columns.at(c).name);
+            meta.i32(4, PQ_GZIP);
+            meta.i64(5, group.rows);
+            meta.i64(6, chunk.uncompressedSize);
+            meta.i64(7, chunk.compressedSize);
+            meta.i64(9, chunk.offset);
+            meta.endStruct();
+            meta.endStruct();
+        }
+        meta.i64(2, totalBytes);
+        meta.i64(3, group.rows);
+        if (!group.chunks.isEmpty()) meta.i64(5, group.chunks.first().offset);
+        meta.i64(6, totalCompressed);
+        meta.endStruct();
+    }
+
+    meta.binary(6, "SavvyCAN");
+    meta.endMessage();
+    return meta.out;
+}
+
+bool ParquetWriter::close()
+{
+    if (!file.isOpen()) return false;
+
+    QByteArray tail = footer();
+    quint32 length = static_cast<quint32>(tail.length());
+    for (int i = 0; i < 4; i++) tail.append(static_cast<char>((length >> (i * 8)) & 0xFF));
+    tail.append("PAR1", 4);
+
+    bool ok = file.write(tail) == tail.length();
+    if (!ok) error = "Could not write " + file.fileName() + ": " + file.errorString();
+    file.close();
+    if (!ok) file.remove();
+    return ok;
+}
+
+void ParquetWriter::abort()
+{
+    file.close();
+    file.remove();
+}
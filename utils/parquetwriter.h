@@ -0,0 +1,79 @@
+#ifndef PARQUETWRITER_H
+#define PARQUETWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+/*
+ * Just enough of Apache Parquet to hand a table to pandas (read_parquet) or anything else that reads
+ * the format. The schema is flat, every column is a required 8 byte number, values are PLAIN encoded
+ * and each column of a row group is a single gzip compressed data page. The file is written a row
+ * group at a time and only the footer is kept until close(), so any number of rows can be written
+ * with the memory of one row group.
+ *
+ * The footer and page headers are Thrift compact protocol structs, encoded by hand here since it's
+ * only a handful of them.
+ *
+ * Usage:
+ *   ParquetWriter writer;
+ *   writer.addColumn("Time", ParquetWriter::COLUMN_DOUBLE); ...
+ *   writer.open(filename);
+ *   writer.writeRowGroup(columns, rows); ... //column c holds rows little endian values
+ *   writer.close();
+ */
+class ParquetWriter
+{
+public:
+    enum ColumnType
+    {
+        COLUMN_INT64,
+        COLUMN_DOUBLE
+    };
+
+    ParquetWriter();
+    ~ParquetWriter();
+
+    void addColumn(const QString &name, ColumnType type); //all of them before open()
+    int columnCount() const { return columns.count(); }
+
+    bool open(const QString &filename);
+    //the columns are compressed on all cores at once
+    bool writeRowGroup(const QVector<QByteArray> &values, int rows);
+    bool close(); //writes the footer, without it the file can't be read
+    void abort(); //closes and removes a file that isn't going to be finished
+
+    const QString &errorString() const { return error; }
+
+private:
+    struct Column
+    {
+        QByteArray name;
+        ColumnType type;
+    };
+
+    struct ChunkInfo
+    {
+        qint64 offset; //of the data page header
+        qint64 compressedSize; //header included
+        qint64 uncompressedSize;
+    };
+
+    struct RowGroupInfo
+    {
+        QVector<ChunkInfo> chunks;
+        qint64 rows;
+    };
+
+    QByteArray footer() const;
+
+    QVector<Column> columns;
+    QVector<RowGroupInfo> rowGroups;
+    QFile file;
+    qint64 filePos;
+    qint64 totalRows;
+    QString error;
+};
+
+#endif // PARQUETWRITER_H
@@ -0,0 +1,511 @@
+#include "signalexporter.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPair>
+#include <QProgressDialog>
+#include <QThread>
+#include <QtEndian>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "canframestore.h"
+#include "capturepager.h"
+#include "dbc/dbchandler.h"
+#include "frameexporter.h"
+#include "parquetwriter.h"
+
+int SignalExporter::blockFrames = 65536;
+int SignalExporter::rowsPerGroup = 65536;
+
+//Rows are collected here until there's a row group worth, then the format writes them out
+class SignalExporter::Output
+{
+public:
+    Output(int numSignals) : width(numSignals) {}
+    virtual ~Output() {}
+
+    virtual bool open(const QString &filename, const QVector<QString> &names) = 0;
+    virtual bool writeRows() = 0; //everything in times/values
+    virtual bool close() = 0;
+    virtual void abort() = 0;
+
+    bool addRow(int64_t time, const double *rowValues)
+    {
+        times.append(time);
+        for (int c = 0; c < width; c++) values.append(rowValues[c]);
+        if (times.count() < rowsPerGroup) return true;
+        return flush();
+    }
+
+    bool flush()
+    {
+        if (times.isEmpty()) return true;
+        bool ok = writeRows();
+        times.resize(0);
+        values.resize(0);
+        return ok;
+    }
+
+    QString error;
+
+protected:
+    int width;
+    QVector<int64_t> times;
+    QVector<double> values; //row after row, width per row
+};
+
+class SignalExporter::CSVOutput : public SignalExporter::Output
+{
+public:
+    CSVOutput(int numSignals) : Output(numSignals) {}
+
+    bool open(const QString &filename, const QVector<QString> &names) override
+    {
+        file.setFileName(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            error = "Could not open " + filename + " for writing";
+            return false;
+        }
+        QByteArray header("Time");
+        for (int c = 0; c < names.count(); c++)
+        {
+            header.append(',');
+            header.append(names.at(c).toUtf8());
+        }
+        header.append('\n');
+        return write(header);
+    }
+
+    //the rows are cut into slices that are formatted on all cores, then written in order
+    bool writeRows() override
+    {
+        int numRows = times.count();
+        int numSlices = qMin(qMax(QThread::idealThreadCount(), 1), numRows);
+        QVector<QPair<int, QByteArray>> slices(numSlices);
+        for (int s = 0; s < numSlices; s++) slices[s].first = s;
+
+        QtConcurrent::blockingMap(slices, [this, numRows, numSlices](QPair<int, QByteArray> &slice)
+        {
+            int first = static_cast<int>((static_cast<qint64>(numRows) * slice.first) / numSlices);
+            int last = static_cast<int>((static_cast<qint64>(numRows) * (slice.first + 1)) / numSlices);
+            ExportLine line;
+            for (int r = first; r < last; r++)
+            {
+                line.clear();
+                line.seconds(times.at(r), 6);
+                line.appendTo(slice.second);
+                const double *rowValues = values.constData() + static_cast<qint64>(r) * width;
+                for (int c = 0; c < width; c++)
+                {
+                    slice.second.append(',');
+                    if (!std::isnan(rowValues[c])) slice.second.append(QByteArray::number(rowValues[c], 'g', 12));
+                }
+                slice.second.append('\n');
+            }
+        });
+
+        for (int s = 0; s < numSlices; s++)
+        {
+            if (!write(slices.at(s).second)) return false;
+        }
+        return true;
+    }
+
+    bool close() override
+    {
+        file.close();
+        return true;
+    }
+
+    void abort() override
+    {
+        file.close();
+        file.remove();
+    }
+
+private:
+    bool write(const QByteArray &text)
+    {
+        if (file.write(text) == text.length()) return true;
+        error = "Could not write " + file.fileName() + ": " + file.errorString();
+        return false;
+    }
+
+    QFile file;
+};
+
+class SignalExporter::ParquetOutput : public SignalExporter::Output
+{
+public:
+    ParquetOutput(int numSignals) : Output(numSignals) {}
+
+    bool open(const QString &filename, const QVector<QString> &names) override
+    {
+        writer.addColumn("Time", ParquetWriter::COLUMN_DOUBLE);
+        for (int c = 0; c < names.count(); c++) writer.addColumn(names.at(c), ParquetWriter::COLUMN_DOUBLE);
+        if (writer.open(filename)) return true;
+        error = writer.errorString();
+        return false;
+    }
+
+    //Parquet is by column, the rows get turned around into one buffer of little endian doubles each
+    bool writeRows() override
+    {
+        int numRows = times.count();
+        QVector<QByteArray> columns(width + 1);
+        for (int c = 0; c <= width; c++) columns[c].resize(numRows * static_cast<int>(sizeof(double)));
+
+        for (int r = 0; r < numRows; r++) putDouble(columns[0], r, static_cast<double>(times.at(r)) / 1000000.0);
+        for (int c = 0; c < width; c++)
+        {
+            for (int r = 0; r < numRows; r++) putDouble(columns[c + 1], r, values.at(static_cast<qint64>(r) * width + c));
+        }
+
+        if (writer.writeRowGroup(columns, numRows)) return true;
+        error = writer.errorString();
+        return false;
+    }
+
+    bool close() override
+    {
+        if (writer.close()) return true;
+        error = writer.errorString();
+        return false;
+    }
+
+    void abort() override
+    {
+        writer.abort();
+    }
+
+private:
+    static void putDouble(QByteArray &column, int row, double value)
+    {
+        quint64 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        qToLittleEndian(bits, column.data() + row * static_cast<int>(sizeof(bits)));
+    }
+
+    ParquetWriter writer;
+};
+
+SignalExporter::FrameSource SignalExporter::storeSource(const CANFrameStore *store)
+{
+    int pos = 0;
+    return [store, pos](QVector<CANFrame> &block) mutable
+    {
+        block.resize(0);
+        int last = qMin(pos + blockFrames, store->count());
+        for (; pos < last; pos++) block.append(store->at(pos));
+        return !block.isEmpty();
+    };
+}
+
+SignalExporter::FrameSource SignalExporter::pagerSource(CapturePager *pager)
+{
+    int pos = 0;
+    return [pager, pos](QVector<CANFrame> &block) mutable
+    {
+        block.resize(0);
+        //the file may still be indexing past where the export has read up to
+        while (pager->frameCount() <= pos && !pager->isIndexed())
+        {
+            if (qApp && QThread::currentThread() == qApp->thread()) qApp->processEvents();
+            QThread::msleep(5);
+        }
+        pos += pager->copyFrames(pos, blockFrames, &block);
+        return !block.isEmpty();
+    };
+}
+
+SignalExporter::SignalExporter(DBCHandler *handler)
+{
+    dbcHandler = handler;
+    period = 10000;
+    joinMode = JOIN_HOLD;
+    frames = 0;
+    rows = 0;
+    canceled = false;
+}
+
+bool SignalExporter::addSignal(DBC_MESSAGE *msg, DBC_SIGNAL *sig)
+{
+    if (!msg || !sig || sig->valType == STRING) return false;
+
+    int idx = 0;
+    while (idx < messages.count() && messages.at(idx).msg != msg) idx++;
+    if (idx == messages.count())
+    {
+        ExportMessage expMsg;
+        expMsg.msg = msg;
+        messages.append(expMsg);
+    }
+
+    //two DBC files can both have a Msg.Sig, the second one gets numbered so the columns stay apart
+    QString name = msg->name + "." + sig->name;
+    QString unique = name;
+    for (int n = 2; columnNames.contains(unique); n++) unique = name + "_" + QString::number(n);
+
+    messages[idx].sigs.append(sig);
+    messages[idx].columns.append(columnNames.count());
+    columnNames.append(unique);
+    slotCache.clear();
+    return true;
+}
+
+int SignalExporter::messageSlot(const CANFrame &frame)
+{
+    quint64 key = (static_cast<quint64>(static_cast<uint32_t>(frame.bus)) << 32) | frame.frameId();
+    QHash<quint64, int>::const_iterator cached = slotCache.constFind(key);
+    if (cached != slotCache.constEnd()) return cached.value();
+
+    int slot = -1;
+    DBC_MESSAGE *msg = dbcHandler->findMessage(frame);
+    for (int m = 0; msg && m < messages.count(); m++)
+    {
+        if (messages.at(m).msg == msg) slot = m;
+    }
+    slotCache.insert(key, slot);
+    return slot;
+}
+
+//Message lookups go through the DBC handler's caches so they are done up front on this thread. Only
+//the decoding itself runs on the worker threads, through evaluateSignal which only reads the decode
+//plans. decodeSignal would also store each value in the signal's cachedValue, from every worker at once
+void SignalExporter::decodeBlock(const QVector<CANFrame> &block, QVector<QVector<Sample>> &slices)
+{
+    QVector<int> msgSlots(block.count());
+    for (int i = 0; i < block.count(); i++) msgSlots[i] = messageSlot(block.at(i));
+
+    struct Slice
+    {
+        int first;
+        int last;
+        QVector<Sample> *samples;
+    };
+    int numSlices = qMin(qMax(QThread::idealThreadCount(), 1), qMax(block.count(), 1));
+    slices.resize(numSlices);
+    QVector<Slice> work(numSlices);
+    for (int s = 0; s < numSlices; s++)
+    {
+        work[s].first = static_cast<int>((static_cast<qint64>(block.count()) * s) / numSlices);
+        work[s].last = static_cast<int>((static_cast<qint64>(block.count()) * (s + 1)) / numSlices);
+        work[s].samples = &slices[s];
+        slices[s].resize(0);
+    }
+
+    const QVector<ExportMessage> &msgs = messages;
+    QtConcurrent::blockingMap(work, [&block, &msgSlots, &msgs](Slice &slice)
+    {
+        DBC_SIGNAL_VALUE val;
+        for (int i = slice.first; i < slice.last; i++)
+        {
+            if (msgSlots.at(i) < 0) continue;
+            const CANFrame &frame = block.at(i);
+            const ExportMessage &expMsg = msgs.at(msgSlots.at(i));
+            for (int s = 0; s < expMsg.sigs.count(); s++)
+            {
+                if (!expMsg.msg->evaluateSignal(frame, expMsg.sigs.at(s), val) || !val.present) continue;
+                Sample sample;
+                sample.timeStamp = frame.timeStamp().microSeconds();
+                sample.column = expMsg.columns.at(s);
+                sample.value = val.value;
+                slice.samples->append(sample);
+            }
+        }
+    });
+}
+
+bool SignalExporter::openRow(int64_t time, Output &out)
+{
+    int width = columnNames.count();
+    int64_t half = period / 2;
+
+    PendingRow row;
+    row.time = time;
+    row.held.resize(width);
+    if (joinMode == JOIN_NEAREST)
+    {
+        row.nearest.resize(width);
+        row.nearestDist.resize(width);
+    }
+    for (int c = 0; c < width; c++)
+    {
+        //every sample so far is at or before time, the latest one is what's held
+        row.held[c] = haveLast.at(c) ? lastValue.at(c) : std::numeric_limits<double>::quiet_NaN();
+        if (joinMode == JOIN_NEAREST)
+        {
+            bool inWindow = haveLast.at(c) && time - lastTime.at(c) <= half;
+            row.nearest[c] = row.held.at(c);
+            row.nearestDist[c] = inWindow ? time - lastTime.at(c) : -1;
+        }
+    }
+
+    //sample and hold has nothing more to wait for
+    if (joinMode == JOIN_HOLD) return emitRow(row, out);
+    pending.append(row);
+    return true;
+}
+
+bool SignalExporter::finishRows(int64_t before, Output &out)
+{
+    int64_t half = period / 2;
+    int done = 0;
+    while (done < pending.count() && pending.at(done).time + half < before)
+    {
+        if (!emitRow(pending.at(done), out)) return false;
+        done++;
+    }
+    if (done) pending.remove(0, done);
+    return true;
+}
+
+bool SignalExporter::emitRow(const PendingRow &row, Output &out)
+{
+    const double *rowValues = row.held.constData();
+    QVector<double> merged;
+    if (joinMode == JOIN_NEAREST)
+    {
+        merged = row.held;
+        for (int c = 0; c < merged.count(); c++)
+        {
+            if (row.nearestDist.at(c) >= 0) merged[c] = row.nearest.at(c);
+        }
+        rowValues = merged.constData();
+    }
+    rows++;
+    return out.addRow(row.time, rowValues);
+}
+
+bool SignalExporter::addSample(const Sample &sample, Output &out)
+{
+    int64_t ts = sample.timeStamp;
+    if (!started)
+    {
+        //line the rows up on multiples of the period
+        nextRow = ts - (((ts % period) + period) % period);
+        started = true;
+    }
+
+    //rows before this sample are settled as far as holding goes, open them
+    while (nextRow < ts)
+    {
+        if (!openRow(nextRow, out)) return false;
+        nextRow += period;
+        if (!finishRows(ts, out)) return false;
+    }
+    if (!finishRows(ts, out)) return false;
+
+    if (joinMode == JOIN_NEAREST)
+    {
+        int64_t half = period / 2;
+        for (int r = 0; r < pending.count(); r++)
+        {
+            PendingRow &row = pending[r];
+            int64_t dist = qAbs(ts - row.time);
+            if (dist > half) continue;
+            if (row.nearestDist.at(sample.column) < 0 || dist < row.nearestDist.at(sample.column))
+            {
+                row.nearest[sample.column] = sample.value;
+                row.nearestDist[sample.column] = dist;
+            }
+        }
+    }
+
+    lastValue[sample.column] = sample.value;
+    lastTime[sample.column] = ts;
+    haveLast[sample.column] = true;
+    if (ts > lastSample) lastSample = ts;
+    return true;
+}
+
+bool SignalExporter::keepGoing(QProgressDialog *progress)
+{
+    if (!progress) return true;
+    progress->setLabelText(QString("Decoded %1 frames into %2 rows...").arg(frames).arg(rows));
+    qApp->processEvents();
+    if (progress->wasCanceled()) canceled = true;
+    return !canceled;
+}
+
+bool SignalExporter::run(const FrameSource &source, const QString &filename, OutputFormat format, QProgressDialog *progress)
+{
+    QElapsedTimer timer;
+    timer.start();
+    frames = 0;
+    rows = 0;
+    canceled = false;
+    error.clear();
+
+    if (columnNames.isEmpty())
+    {
+        error = "No signals to export";
+        return false;
+    }
+
+    int width = columnNames.count();
+    lastValue.fill(0.0, width);
+    lastTime.fill(0, width);
+    haveLast.fill(false, width);
+    pending.clear();
+    started = false;
+    nextRow = 0;
+    lastSample = std::numeric_limits<int64_t>::min();
+
+    //decode plans get built on first use, that has to happen here and not on the worker threads
+    for (int m = 0; m < messages.count(); m++) messages[m].msg->decodePlan();
+    slotCache.clear();
+
+    if (progress)
+    {
+        progress->setRange(0, 0);
+        progress->setValue(0);
+    }
+
+    Output *out;
+    if (format == OUTPUT_PARQUET) out = new ParquetOutput(width);
+    else out = new CSVOutput(width);
+
+    bool ok = out->open(filename, columnNames);
+    QVector<CANFrame> block;
+    QVector<QVector<Sample>> slices;
+    while (ok && source(block))
+    {
+        frames += static_cast<quint64>(block.count());
+        decodeBlock(block, slices);
+        for (int s = 0; s < slices.count() && ok; s++)
+        {
+            const QVector<Sample> &samples = slices.at(s);
+            for (int i = 0; i < samples.count() && ok; i++) ok = addSample(samples.at(i), *out);
+        }
+        ok = ok && keepGoing(progress);
+    }
+
+    if (ok && started)
+    {
+        //a last row lands right on the final sample when it's on the period
+        while (ok && nextRow <= lastSample)
+        {
+            ok = openRow(nextRow, *out);
+            nextRow += period;
+        }
+        ok = ok && finishRows(std::numeric_limits<int64_t>::max(), *out);
+    }
+    ok = ok && out->flush() && out->close();
+
+    if (!ok)
+    {
+        if (error.isEmpty()) error = out->error;
+        out->abort();
+    }
+    delete out;
+
+    if (canceled) qDebug() << "Signal export to" << filename << "canceled";
+    else if (ok) qDebug() << "Exported" << width << "signals from" << frames << "frames as" << rows << "rows to" << filename << "in" << timer.elapsed() << "ms";
+    return ok;
+}
@@ -0,0 +1,136 @@
+#ifndef SIGNALEXPORTER_H
+#define SIGNALEXPORTER_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "can_structs.h"
+
+class CANFrameStore;
+class CapturePager;
+class DBCHandler;
+class DBC_MESSAGE;
+class DBC_SIGNAL;
+class QProgressDialog;
+
+/*
+ * Decodes DBC signals out of a capture into one wide table with a row every period and a column
+ * per signal, written as CSV or as Parquet for pandas. Nothing needs to be graphed first and the
+ * frames only go through once however many signals are picked.
+ *
+ * Frames come from a FrameSource a block at a time. The block is decoded on all cores and the
+ * samples are folded into rows in time order. Rows go out a row group at a time, so memory depends
+ * on the block and row group sizes and not on how long the capture is.
+ *
+ * A row at time t gets for every signal:
+ *   JOIN_HOLD     the last value at or before t (sample and hold)
+ *   JOIN_NEAREST  the value closest to t within half a period either way, the earlier one on a tie.
+ *                 With nothing that close it falls back to the held value
+ * A signal that hasn't been seen yet is empty in CSV and NaN in Parquet. Rows run from the first
+ * decoded sample, rounded down to the period, to the last one.
+ *
+ * Frames are expected in time order like a capture or a merge gives them.
+ *
+ * Usage:
+ *   SignalExporter exporter(DBCHandler::getReference());
+ *   exporter.addSignal(msg, sig); ...
+ *   exporter.setPeriod(10000);
+ *   exporter.run(SignalExporter::storeSource(frames), filename, SignalExporter::OUTPUT_PARQUET);
+ */
+class SignalExporter
+{
+public:
+    enum JoinMode
+    {
+        JOIN_HOLD,
+        JOIN_NEAREST
+    };
+
+    enum OutputFormat
+    {
+        OUTPUT_CSV,
+        OUTPUT_PARQUET
+    };
+
+    typedef std::function<bool(QVector<CANFrame> &block)> FrameSource; //fills the next block, false once there are no more frames
+
+    static int blockFrames;  //frames decoded per pass
+    static int rowsPerGroup; //rows built up before they are written out
+
+    static FrameSource storeSource(const CANFrameStore *store);
+    static FrameSource pagerSource(CapturePager *pager);
+
+    explicit SignalExporter(DBCHandler *handler);
+
+    bool addSignal(DBC_MESSAGE *msg, DBC_SIGNAL *sig); //false for string signals, they have no number to export
+    int signalCount() const { return columnNames.count(); }
+    void setPeriod(int64_t micros) { period = qMax(micros, static_cast<int64_t>(1)); }
+    void setJoinMode(JoinMode mode) { joinMode = mode; }
+
+    //with a progress dialog the events keep flowing and canceling it stops the export and removes the file
+    bool run(const FrameSource &source, const QString &filename, OutputFormat format, QProgressDialog *progress = nullptr);
+
+    quint64 framesRead() const { return frames; }
+    quint64 rowsWritten() const { return rows; }
+    bool wasCanceled() const { return canceled; }
+    const QString &errorString() const { return error; }
+
+private:
+    struct ExportMessage
+    {
+        DBC_MESSAGE *msg;
+        QVector<DBC_SIGNAL *> sigs;
+        QVector<int> columns;
+    };
+
+    struct Sample
+    {
+        int64_t timeStamp;
+        int column;
+        double value;
+    };
+
+    struct PendingRow
+    {
+        int64_t time;
+        QVector<double> held;
+        QVector<double> nearest;
+        QVector<int64_t> nearestDist; //-1 while there is no value within half a period
+    };
+
+    class Output;
+    class CSVOutput;
+    class ParquetOutput;
+
+    int messageSlot(const CANFrame &frame);
+    void decodeBlock(const QVector<CANFrame> &block, QVector<QVector<Sample>> &slices);
+    bool addSample(const Sample &sample, Output &out);
+    bool openRow(int64_t time, Output &out);
+    bool finishRows(int64_t before, Output &out); //every pending row whose window closed before that time
+    bool emitRow(const PendingRow &row, Output &out);
+    bool keepGoing(QProgressDialog *progress);
+
+    DBCHandler *dbcHandler;
+    QVector<ExportMessage> messages;
+    QVector<QString> columnNames;
+    QHash<quint64, int> slotCache; //bus << 32 | id -> messages index, -1 for frames nothing is exported from
+    int64_t period;
+    JoinMode joinMode;
+
+    //resampling state
+    QVector<double> lastValue;
+    QVector<int64_t> lastTime;
+    QVector<bool> haveLast;
+    QVector<PendingRow> pending;
+    int64_t nextRow;
+    int64_t lastSample;
+    bool started;
+
+    quint64 frames;
+    quint64 rows;
+    bool canceled;
+    QString error;
+};
+
+#endif // SIGNALEXPORTER_H